@@ -1,14 +1,20 @@
 # -*- mode: shell-script -*-
-# Copyright 2015-2016 Los Alamos National Security, LLC. All rights
+# Copyright 2015-2017 Los Alamos National Security, LLC. All rights
 #                     reserved.
 
 AC_DEFUN([HIO_CHECK_DATAWARP],[
     # Check for datawarp availability
-    AC_ARG_WITH(datawarp, [AS_HELP_STRING([--with-datawarp=DIR], [enable support for Cray datawarp @<:@default=auto@:>@])],
+    AC_ARG_WITH(datawarp, [AS_HELP_STRING([--with-datawarp=DIR], [enable support for Cray datawarp. Use
+                                           --with-datawarp=emulate to build against a local emulation of the
+                                           datawarp staging API @<:@default=auto@:>@])],
                 [], [with_datawarp=auto])
 
     use_datawarp=0
-    if test "$with_datawarp" = "auto" ; then
+    emulate_datawarp=0
+    if test "$with_datawarp" = "emulate" ; then
+        use_datawarp=1
+        emulate_datawarp=1
+    elif test "$with_datawarp" = "auto" ; then
         PKG_CHECK_MODULES(datawarp, cray-datawarp >= 1.0, [use_datawarp=1], [use_datawarp=0])
         if test $use_datawarp = 1 ; then
             # PKG_CHECK_MODULES sets the CFLAGS variable but it only adds -I/path/to/datawarp so
@@ -27,11 +33,13 @@ AC_DEFUN([HIO_CHECK_DATAWARP],[
         use_datawarp=1
     fi
 
-    if test $use_datawarp = 1 ; then
+    if test $use_datawarp = 1 -a $emulate_datawarp = 0 ; then
         AC_CHECK_HEADERS([datawarp.h])
         AC_CHECK_LIB([datawarp], [dw_stage_file_out], [use_datawarp=1], [use_datawarp=0])
     fi
 
     AC_DEFINE_UNQUOTED([HIO_USE_DATAWARP], [$use_datawarp], [Whether to use datawarp for bb])
+    AC_DEFINE_UNQUOTED([HIO_DATAWARP_EMULATE], [$emulate_datawarp], [Whether to use the local datawarp emulation])
     AM_CONDITIONAL([DATAWARP_AVAILABLE], [test x$use_datawarp = x1])
+    AM_CONDITIONAL([DATAWARP_EMULATE], [test x$emulate_datawarp = x1])
 ])
@@ -1,6 +1,6 @@
 /* -*- Mode: C; c-basic-offset:2 ; indent-tabs-mode:nil -*- */
 /*
- * Copyright (c) 2016      Los Alamos National Security, LLC.  All rights
+ * Copyright (c) 2016-2017 Los Alamos National Security, LLC.  All rights
  *                         reserved.
  * $COPYRIGHT$
  *
@@ -28,29 +28,53 @@ static int hioi_get_numnodes (void) {
   return strtol (num_nodes, NULL, 10);
 }
 
-static uint64_t hioi_calculate_interval (hio_context_t context, uint64_t write_time) {
+/**
+ * Calculate the optimal checkpoint interval
+ *
+ * @param[in] context    hio context
+ * @param[in] write_time expected time to write a checkpoint in seconds
+ *
+ * @returns optimal interval between checkpoints in seconds
+ *
+ * Uses Daly's higher order approximation of the optimum checkpoint interval. The mean
+ * time to interrupt is calculated from the configured job interrupt rates.
+ */
+static double hioi_calculate_interval (hio_context_t context, double write_time) {
   int nodes = hioi_get_numnodes ();
-  double mtti, d;
-
-  /* NTH -- TODO: calculate the approximate time to write a checkpoint based on:
-   *  1) number of nodes
-   *  2) average memory/node
-   *  3) filesystem bandwidth
-   * The filesystem bandwidth will probably have to be an additional system parameter. */
-
-  /* write_time is in us. calculate in minutes */
-  d = (double) write_time;
+  double mtti, d = write_time;
 
+  /* interrupt rates are in failures per 10^9 hours. calculate the mtti in seconds */
   mtti = 3600.0e9 / ((double) (context->c_job_sys_int_rate + (context->c_job_node_int_rate + context->c_job_node_sw_rate) * nodes));
 
   if (d < 2.0 * mtti) {
-    return (uint64_t) floor (sqrt (2.0 * d * mtti) * (1.0 + sqrt (d / (2.0 * mtti)) / 3.0 + (d / (18.0 * mtti))) - d);
+    return sqrt (2.0 * d * mtti) * (1.0 + sqrt (d / (2.0 * mtti)) / 3.0 + (d / (18.0 * mtti))) - d;
   }
 
-  return (int64_t) floor(mtti);
+  return mtti;
 }
 
-hio_recommendation_t hio_dataset_should_checkpoint (hio_context_t context, const char *name) {
+/**
+ * Estimate the time needed to write the next member of a dataset
+ *
+ * @param[in] ds_data persistent dataset data
+ *
+ * @returns expected write time in seconds
+ *
+ * The estimate is the expected size of the dataset (or the measured size of the last
+ * member written) divided by the weighted average bandwidth observed when writing
+ * prior members. This adapts the estimate to the current load on the filesystem.
+ */
+static double hioi_expected_write_time (hio_dataset_data_t *ds_data) {
+  uint64_t size = ds_data->dd_average_size ? ds_data->dd_average_size : ds_data->dd_last_size;
+
+  if (ds_data->dd_bandwidth > 0.0 && size) {
+    return (double) size / ds_data->dd_bandwidth * 1.0e-6;
+  }
+
+  return (double) ds_data->dd_average_write_time * 1.0e-6;
+}
+
+static hio_recommendation_t hioi_should_checkpoint (hio_context_t context, hio_dataset_data_t *ds_data) {
   int recommendation = HIO_SCP_NOT_NOW;
 
   if (hioi_signal_time) {
@@ -60,28 +84,41 @@ hio_recommendation_t hio_dataset_should_checkpoint (hio_context_t context, const
     context->c_end_time = hioi_signal_time + context->c_job_sigusr1_warning_time;
   }
 
-  if (time (NULL) > context->c_end_time) {
-    return HIO_SCP_NOT_NOW;
-  }
-
   if (0 == context->c_rank) {
-    uint64_t interval, since_last, current_time, left, write_time;
-    hio_dataset_data_t *ds_data = NULL;
+    time_t current_time = time (NULL);
+    double interval, since_last, write_time, left = -1.0;
 
-    current_time = time (NULL);
-    left = context->c_end_time - current_time;
-
-    (void) hioi_dataset_data_lookup (context, name, &ds_data);
-
-    /* calculate write time in seconds */
-    write_time = ds_data->dd_average_write_time / 1000000;
+    if (context->c_end_time) {
+      left = (double) context->c_end_time - (double) current_time;
+    }
 
-    interval = hioi_calculate_interval (context, write_time);
-    since_last = (current_time - ds_data->dd_last_completion);
+    write_time = interval = since_last = 0.0;
 
-    if ((since_last / 60) >= interval || (left > ((write_time * 11) / 10) && left < ((write_time * 12) / 10))) {
+    if (context->c_end_time && left <= 0.0) {
+      /* past the end of the job */
+      recommendation = HIO_SCP_NOT_NOW;
+    } else if (NULL == ds_data || 0 > ds_data->dd_last_id) {
+      /* no member of this dataset has been written by this context. checkpoint now to
+       * get a measurement of the write time */
       recommendation = HIO_SCP_MUST_CHECKPOINT;
+    } else {
+      write_time = hioi_expected_write_time (ds_data);
+      interval = hioi_calculate_interval (context, write_time);
+      since_last = (double) (current_time - ds_data->dd_last_completion);
+
+      if (left >= 0.0 && left < write_time * 1.1) {
+        /* not enough time left to complete the checkpoint */
+        recommendation = HIO_SCP_NOT_NOW;
+      } else if (since_last >= interval || (left >= 0.0 && left < write_time * 1.2)) {
+        /* the optimal interval has elapsed or this is the last chance to checkpoint
+         * before the end of the job */
+        recommendation = HIO_SCP_MUST_CHECKPOINT;
+      }
     }
+
+    hioi_log (context, HIO_VERBOSE_DEBUG_LOW, "should_checkpoint: expected write time: %g s, interval: %g s, "
+              "since last: %g s, time left: %g s, recommendation: %d", write_time, interval, since_last, left,
+              recommendation);
   }
 
 #if HIO_MPI_HAVE(1)
@@ -92,3 +129,49 @@ hio_recommendation_t hio_dataset_should_checkpoint (hio_context_t context, const
 
   return recommendation;
 }
+
+hio_recommendation_t hio_dataset_should_checkpoint (hio_context_t context, const char *name) {
+  hio_dataset_data_t *ds_data = NULL;
+
+  if (HIO_OBJECT_NULL == context || NULL == name) {
+    return HIO_SCP_NOT_NOW;
+  }
+
+  if (0 == context->c_rank) {
+    if (!context->c_history_loaded) {
+      /* the data roots may have been set after the context was created */
+      (void) hioi_history_load (context);
+    }
+
+    (void) hioi_dataset_data_lookup (context, name, &ds_data);
+  }
+
+  return hioi_should_checkpoint (context, ds_data);
+}
+
+hio_return_t hio_should_checkpoint (hio_context_t context, int *hint) {
+  hio_dataset_data_t *ds_data, *last = NULL;
+
+  if (HIO_OBJECT_NULL == context || NULL == hint) {
+    return HIO_ERR_BAD_PARAM;
+  }
+
+  if (0 == context->c_rank) {
+    if (!context->c_history_loaded) {
+      (void) hioi_history_load (context);
+    }
+
+    /* base the recommendation on the most recently written dataset */
+    hioi_object_lock (&context->c_object);
+    hioi_list_foreach (ds_data, context->c_ds_data, hio_dataset_data_t, dd_list) {
+      if (0 <= ds_data->dd_last_id && (NULL == last || ds_data->dd_last_completion > last->dd_last_completion)) {
+        last = ds_data;
+      }
+    }
+    hioi_object_unlock (&context->c_object);
+  }
+
+  *hint = hioi_should_checkpoint (context, last);
+
+  return HIO_SUCCESS;
+}
@@ -15,7 +15,8 @@ int hio_dataset_close (hio_dataset_t dataset) {
   hio_dataset_data_t *ds_data;
   uint64_t tmp[6];
   hio_context_t context;
-  uint64_t rctime;
+  hio_module_t *module;
+  uint64_t rctime, cstime, io_time;
   int rc;
 
   if (HIO_OBJECT_NULL == dataset) {
@@ -34,20 +35,28 @@ int hio_dataset_close (hio_dataset_t dataset) {
   hioi_log (context, HIO_VERBOSE_DEBUG_LOW, "Closing dataset %s::%" PRIu64,
             hioi_object_identifier (dataset), dataset->ds_id);
 
+  /* sum the statistics shards */
+  hioi_dataset_perf_update (&dataset->ds_object);
+
   tmp[0] = dataset->ds_stat.s_bread;
   tmp[1] = dataset->ds_stat.s_bwritten;
   tmp[2] = dataset->ds_stat.s_rtime;
   tmp[3] = dataset->ds_stat.s_wtime;
-  tmp[4] = atomic_load(&dataset->ds_stat.s_rcount);
-  tmp[5] = atomic_load(&dataset->ds_stat.s_wcount);
+  tmp[4] = dataset->ds_stat.s_rcount;
+  tmp[5] = dataset->ds_stat.s_wcount;
 
   context->c_bread += dataset->ds_stat.s_bread;
   context->c_bwritten += dataset->ds_stat.s_bwritten;
 
+  module = dataset->ds_module;
+  cstime = hioi_gettime ();
+
   rc = hioi_dataset_close_internal (dataset);
 
   rctime = hioi_gettime ();
 
+  hioi_latency_record (dataset->ds_stat.s_latency + HIO_LATENCY_OP_CLOSE, (rctime - cstime) * 1000);
+
   ds_data = dataset->ds_data;
 
   /* keep track of the last time any operation completed on this dataset. this will prevent
@@ -57,20 +66,25 @@ int hio_dataset_close (hio_dataset_t dataset) {
   if (HIO_SUCCESS == rc && (HIO_FLAG_WRITE & dataset->ds_flags)) {
     /* update dataset data */
     ds_data->dd_last_id = dataset->ds_id;
-
-    if (0 == ds_data->dd_average_write_time) {
-      ds_data->dd_average_write_time = rctime - dataset->ds_rotime;
-    } else {
-      ds_data->dd_average_write_time = (uint64_t) ((float) ds_data->dd_average_write_time * 0.8);
-      ds_data->dd_average_write_time += (uint64_t) ((float) (rctime - dataset->ds_rotime) * 0.2);
-    }
   }
+
+  /* time actually spent doing I/O. the time between open and close also includes any time
+   * the application spent computing so it can not be used to model the write time */
+  io_time = dataset->ds_stat.s_wtime + (rctime - cstime);
+
 #if HIO_MPI_HAVE(1)
   if (1 != context->c_size) {
     MPI_Reduce (0 == context->c_rank ? MPI_IN_PLACE : tmp, tmp, 6, MPI_UINT64_T, MPI_SUM, 0, context->c_comm);
+    if (HIO_FLAG_WRITE & dataset->ds_flags) {
+      /* the dataset is not written until the slowest rank finishes */
+      MPI_Reduce (0 == context->c_rank ? MPI_IN_PLACE : &io_time, &io_time, 1, MPI_UINT64_T, MPI_MAX, 0,
+                  context->c_comm);
+    }
   }
 #endif
 
+  hioi_dataset_latency_aggregate (dataset);
+
   /* store global statistics */
   dataset->ds_stat.s_abread = tmp[0];
   dataset->ds_stat.s_abwritten = tmp[1];
@@ -79,6 +93,38 @@ int hio_dataset_close (hio_dataset_t dataset) {
   dataset->ds_stat.s_arcount = tmp[4];
   dataset->ds_stat.s_awcount = tmp[5];
 
+  if (HIO_FLAG_WRITE & dataset->ds_flags) {
+    if (HIO_SUCCESS == rc) {
+      /* update the write model used by hio_dataset_should_checkpoint(). only valid on rank 0 */
+      ds_data->dd_last_size = tmp[1];
+      ds_data->dd_last_write_time = io_time;
+
+      if (0 == ds_data->dd_average_write_time) {
+        ds_data->dd_average_write_time = io_time;
+      } else {
+        ds_data->dd_average_write_time = (uint64_t) ((double) ds_data->dd_average_write_time * 0.8 +
+                                                     (double) io_time * 0.2);
+      }
+
+      if (io_time && tmp[1]) {
+        double bandwidth = (double) tmp[1] / (double) io_time;
+
+        if (ds_data->dd_bandwidth > 0.0) {
+          ds_data->dd_bandwidth = ds_data->dd_bandwidth * 0.8 + bandwidth * 0.2;
+        } else {
+          ds_data->dd_bandwidth = bandwidth;
+        }
+      }
+    }
+
+    /* update the data root statistics used to select the data root for the next dataset */
+    hioi_context_update_module_stats (context, module, rc, tmp[1], cstime - dataset->ds_rotime,
+                                      rctime - cstime);
+
+    /* save the updated statistics for future jobs */
+    (void) hioi_history_save (context);
+  }
+
   if (0 == context->c_rank && context->c_print_stats) {
     printf ("hio.dataset.stat %s.%s.%" PRIu64 " RW_Bytes %" PRIu64 " B %" PRIu64 " B, RW_Ops %" PRIu64 " ops %" PRIu64 " ops, "
             "RW_API_Time %" PRIu64 " us %" PRIu64 " us, Walltime %" PRIu64 " us\n", hioi_object_identifier (&context->c_object),
@@ -0,0 +1,583 @@
+/* -*- Mode: C; c-basic-offset:2 ; indent-tabs-mode:nil -*- */
+/*
+ * Copyright (c) 2017      Los Alamos National Security, LLC.  All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+#include "hio_internal.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+/** size of the buffer used when data can not be copied by the kernel */
+#define HIOI_CONSTRUCT_BUFFER_SIZE (8ul << 20)
+
+/** largest single copy request */
+#define HIOI_CONSTRUCT_MAX_COPY    (1ul << 30)
+
+typedef struct hioi_construct_state_t {
+  /** bounce buffer (allocated on first use) */
+  char    *cs_buffer;
+  /** use copy_file_range () until it fails with an unsupported error */
+  bool     cs_use_copy_range;
+  /** number of bytes copied in the kernel */
+  uint64_t cs_kernel_bytes;
+  /** number of bytes copied through cs_buffer */
+  uint64_t cs_user_bytes;
+} hioi_construct_state_t;
+
+/**
+ * Copy data between files
+ *
+ * @returns number of bytes copied, 0 at the end of the source file, or -1 on error
+ */
+static ssize_t hioi_construct_copy (hioi_construct_state_t *state, int in_fd, uint64_t in_offset, int out_fd,
+                                    uint64_t out_offset, size_t length) {
+  ssize_t ret;
+
+#if defined(HAVE_COPY_FILE_RANGE)
+  if (state->cs_use_copy_range) {
+    loff_t in_off = in_offset, out_off = out_offset;
+
+    ret = copy_file_range (in_fd, &in_off, out_fd, &out_off, length, 0);
+    if (0 <= ret) {
+      state->cs_kernel_bytes += ret;
+      return ret;
+    }
+
+    if (EXDEV != errno && ENOSYS != errno && EINVAL != errno && EOPNOTSUPP != errno) {
+      return -1;
+    }
+
+    /* the filesystem(s) do not support copying in the kernel */
+    state->cs_use_copy_range = false;
+  }
+#endif
+
+  if (NULL == state->cs_buffer) {
+    state->cs_buffer = malloc (HIOI_CONSTRUCT_BUFFER_SIZE);
+    if (NULL == state->cs_buffer) {
+      errno = ENOMEM;
+      return -1;
+    }
+  }
+
+  if (length > HIOI_CONSTRUCT_BUFFER_SIZE) {
+    length = HIOI_CONSTRUCT_BUFFER_SIZE;
+  }
+
+  ret = pread (in_fd, state->cs_buffer, length, in_offset);
+  if (0 >= ret) {
+    return ret;
+  }
+
+  for (ssize_t written = 0, actual ; written < ret ; written += actual) {
+    actual = pwrite (out_fd, state->cs_buffer + written, ret - written, out_offset + written);
+    if (0 > actual) {
+      return -1;
+    }
+  }
+
+  state->cs_user_bytes += ret;
+
+  return ret;
+}
+
+/**
+ * Copy element data through the hio read path (modules without ds_element_locate)
+ */
+static int hioi_construct_range_read (hioi_construct_state_t *state, hio_element_t element, int out_fd,
+                                      uint64_t offset, uint64_t end) {
+  if (NULL == state->cs_buffer) {
+    state->cs_buffer = malloc (HIOI_CONSTRUCT_BUFFER_SIZE);
+    if (NULL == state->cs_buffer) {
+      return HIO_ERR_OUT_OF_RESOURCE;
+    }
+  }
+
+  while (offset < end) {
+    size_t length = end - offset;
+    ssize_t ret;
+
+    if (length > HIOI_CONSTRUCT_BUFFER_SIZE) {
+      length = HIOI_CONSTRUCT_BUFFER_SIZE;
+    }
+
+    ret = hio_element_read (element, offset, 0, state->cs_buffer, 1, length);
+    if (0 >= ret) {
+      return ret ? (int) ret : HIO_ERR_TRUNCATE;
+    }
+
+    for (ssize_t written = 0, actual ; written < ret ; written += actual) {
+      actual = pwrite (out_fd, state->cs_buffer + written, ret - written, offset + written);
+      if (0 > actual) {
+        return hioi_err_errno (errno);
+      }
+    }
+
+    state->cs_user_bytes += ret;
+    offset += ret;
+  }
+
+  return HIO_SUCCESS;
+}
+
+/**
+ * Copy the element data in [offset, end) to the same offsets in the output file
+ */
+static int hioi_construct_range (hioi_construct_state_t *state, hio_element_t element, int out_fd,
+                                 uint64_t offset, uint64_t end) {
+  hio_dataset_t dataset = hioi_element_dataset (element);
+  int rc = HIO_SUCCESS;
+
+  if (NULL == dataset->ds_element_locate) {
+    return hioi_construct_range_read (state, element, out_fd, offset, end);
+  }
+
+  while (offset < end) {
+    size_t length = end - offset;
+    uint64_t file_offset;
+    ssize_t ret;
+    int in_fd;
+
+    if (length > HIOI_CONSTRUCT_MAX_COPY) {
+      length = HIOI_CONSTRUCT_MAX_COPY;
+    }
+
+    rc = dataset->ds_element_locate (element, offset, &length, &in_fd, &file_offset);
+    if (HIO_ERR_NOT_FOUND == rc && length) {
+      /* nothing was written here. the output file is already sparse */
+      offset += length;
+      rc = HIO_SUCCESS;
+      continue;
+    }
+
+    if (HIO_SUCCESS != rc) {
+      hioi_err_push (rc, &dataset->ds_object, "construct: could not locate data for element %s at offset %"
+                     PRIu64, hioi_object_identifier (element), offset);
+      break;
+    }
+
+    ret = hioi_construct_copy (state, in_fd, file_offset, out_fd, offset, length);
+    if (0 > ret) {
+      rc = hioi_err_errno (errno);
+      hioi_err_push (rc, &dataset->ds_object, "construct: error copying element %s data. errno: %d",
+                     hioi_object_identifier (element), errno);
+      break;
+    }
+
+    if (0 == ret) {
+      /* end of the backing file. the remainder of the range was never written */
+      break;
+    }
+
+    offset += ret;
+  }
+
+  return rc;
+}
+
+static int hioi_construct_open_output (hio_dataset_t dataset, const char *destination, const char *name,
+                                       int rank, int flags, int *fd_out) {
+  char *path;
+  int rc, fd;
+
+  if (HIO_SET_ELEMENT_UNIQUE == dataset->ds_mode) {
+    rc = asprintf (&path, "%s/%s.%d", destination, name, rank);
+  } else {
+    rc = asprintf (&path, "%s/%s", destination, name);
+  }
+
+  if (0 > rc) {
+    return HIO_ERR_OUT_OF_RESOURCE;
+  }
+
+  fd = open (path, flags, 0644);
+  if (0 > fd) {
+    rc = hioi_err_errno (errno);
+    hioi_err_push (rc, &dataset->ds_object, "construct: could not open output file %s", path);
+    free (path);
+    return rc;
+  }
+
+  free (path);
+  *fd_out = fd;
+
+  return HIO_SUCCESS;
+}
+
+/**
+ * Construct the files for this rank's elements of a unique dataset
+ */
+static int hioi_construct_unique (hioi_construct_state_t *state, hio_dataset_t dataset, const char *destination,
+                                  char **names, size_t count) {
+  hio_context_t context = hioi_object_context (&dataset->ds_object);
+  hio_element_t element;
+  int rc = HIO_SUCCESS, out_fd;
+
+  for (size_t i = 0 ; i < count && HIO_SUCCESS == rc ; ++i) {
+    if (i && 0 == strcmp (names[i], names[i - 1])) {
+      continue;
+    }
+
+    rc = hioi_construct_open_output (dataset, destination, names[i], context->c_rank,
+                                     O_CREAT | O_EXCL | O_WRONLY, &out_fd);
+    if (HIO_SUCCESS != rc) {
+      break;
+    }
+
+    rc = hioi_element_open_internal (dataset, &element, names[i], HIO_FLAG_READ, context->c_rank);
+    if (HIO_SUCCESS != rc) {
+      hioi_err_push (rc, &dataset->ds_object, "construct: could not open element %s", names[i]);
+      close (out_fd);
+      break;
+    }
+
+    hioi_log (context, HIO_VERBOSE_DEBUG_MED, "construct: writing element %s (%" PRId64 " bytes)", names[i],
+              element->e_size);
+
+    rc = hioi_construct_range (state, element, out_fd, 0, element->e_size);
+    if (HIO_SUCCESS == rc && 0 != ftruncate (out_fd, element->e_size)) {
+      rc = hioi_err_errno (errno);
+    }
+
+    if (0 != close (out_fd) && HIO_SUCCESS == rc) {
+      rc = hioi_err_errno (errno);
+    }
+
+    (void) hio_element_close (&element);
+  }
+
+  return rc;
+}
+
+static int hioi_construct_name_compare (const void *a, const void *b) {
+  return strcmp (*(const char **) a, *(const char **) b);
+}
+
+/**
+ * Construct the files for the elements of a shared dataset
+ *
+ * Elements whose data is described by segments are converted by the ranks that loaded the
+ * segments (each node holds part of the data manifests). The segments are split among the
+ * ranks on the node. Other elements are converted by a single rank each.
+ */
+static int hioi_construct_shared (hioi_construct_state_t *state, hio_dataset_t dataset, const char *destination,
+                                  char **names, size_t count) {
+  hio_context_t context = hioi_object_context (&dataset->ds_object);
+  int shared_rank = 0, shared_size = 1;
+  hio_element_t *elements, element;
+  int64_t *sizes, *segmented;
+  int rc = HIO_SUCCESS, out_fd;
+  bool *local;
+
+  elements = calloc (count, sizeof (elements[0]));
+  sizes = calloc (2 * count, sizeof (sizes[0]));
+  local = calloc (count, sizeof (local[0]));
+  if ((NULL == elements || NULL == sizes || NULL == local) && count) {
+    rc = HIO_ERR_OUT_OF_RESOURCE;
+  }
+
+  segmented = sizes + count;
+
+#if HIO_MPI_HAVE(3)
+  if (hioi_context_using_mpi (context)) {
+    shared_rank = context->c_shared_rank;
+    shared_size = context->c_shared_size;
+  }
+#endif
+
+  /* find the elements with data segments known to this rank */
+  if (HIO_SUCCESS == rc) {
+    hioi_object_lock (&dataset->ds_object);
+    hioi_list_foreach (element, dataset->ds_elist, struct hio_element, e_list) {
+      const char *name = hioi_object_identifier (element);
+      char **match;
+
+      if (0 == element->e_scount) {
+        continue;
+      }
+
+      match = bsearch (&name, names, count, sizeof (names[0]), hioi_construct_name_compare);
+      if (NULL != match) {
+        local[match - names] = true;
+      }
+    }
+    hioi_object_unlock (&dataset->ds_object);
+  }
+
+  for (size_t i = 0 ; i < count && HIO_SUCCESS == rc ; ++i) {
+    if (!local[i] && (int) (i % context->c_size) != context->c_rank) {
+      continue;
+    }
+
+    rc = hioi_element_open_internal (dataset, elements + i, names[i], HIO_FLAG_READ, context->c_rank);
+    if (HIO_SUCCESS != rc) {
+      hioi_err_push (rc, &dataset->ds_object, "construct: could not open element %s", names[i]);
+      elements[i] = NULL;
+      break;
+    }
+
+    sizes[i] = elements[i]->e_size;
+    segmented[i] = local[i];
+  }
+
+#if HIO_MPI_HAVE(1)
+  if (hioi_context_using_mpi (context)) {
+    MPI_Allreduce (MPI_IN_PLACE, &rc, 1, MPI_INT, MPI_MIN, context->c_comm);
+    if (HIO_SUCCESS == rc) {
+      /* element sizes and whether any rank holds segments for each element */
+      MPI_Allreduce (MPI_IN_PLACE, sizes, 2 * count, MPI_INT64_T, MPI_MAX, context->c_comm);
+    }
+  }
+#endif
+
+  if (HIO_SUCCESS == rc && 0 == context->c_rank) {
+    /* create all of the output files before any data is written */
+    for (size_t i = 0 ; i < count ; ++i) {
+      rc = hioi_construct_open_output (dataset, destination, names[i], -1, O_CREAT | O_EXCL | O_WRONLY,
+                                       &out_fd);
+      if (HIO_SUCCESS != rc) {
+        break;
+      }
+
+      if (0 != ftruncate (out_fd, sizes[i])) {
+        rc = hioi_err_errno (errno);
+      }
+
+      close (out_fd);
+      if (HIO_SUCCESS != rc) {
+        break;
+      }
+    }
+  }
+
+#if HIO_MPI_HAVE(1)
+  if (hioi_context_using_mpi (context)) {
+    MPI_Bcast (&rc, 1, MPI_INT, 0, context->c_comm);
+  }
+#endif
+
+  for (size_t i = 0 ; i < count && HIO_SUCCESS == rc ; ++i) {
+    element = elements[i];
+    if (NULL == element || (segmented[i] && !local[i])) {
+      continue;
+    }
+
+    rc = hioi_construct_open_output (dataset, destination, names[i], -1, O_WRONLY, &out_fd);
+    if (HIO_SUCCESS != rc) {
+      break;
+    }
+
+    hioi_log (context, HIO_VERBOSE_DEBUG_MED, "construct: writing element %s (%" PRId64 " bytes)", names[i],
+              sizes[i]);
+
+    if (segmented[i]) {
+      for (int j = shared_rank ; j < element->e_scount && HIO_SUCCESS == rc ; j += shared_size) {
+        hio_manifest_segment_t *segment = element->e_sarray + j;
+
+        rc = hioi_construct_range (state, element, out_fd, segment->seg_offset,
+                                   segment->seg_offset + segment->seg_length);
+      }
+    } else {
+      rc = hioi_construct_range (state, element, out_fd, 0, sizes[i]);
+    }
+
+    if (0 != close (out_fd) && HIO_SUCCESS == rc) {
+      rc = hioi_err_errno (errno);
+    }
+  }
+
+  for (size_t i = 0 ; i < count && elements ; ++i) {
+    if (NULL != elements[i]) {
+      (void) hio_element_close (elements + i);
+    }
+  }
+
+  free (elements);
+  free (sizes);
+  free (local);
+
+  return rc;
+}
+
+/**
+ * List the elements described by the dataset manifest (modules without ds_element_list)
+ */
+static int hioi_construct_manifest_list (hio_dataset_t dataset, char ***names_out, int **ranks_out,
+                                         size_t *count_out) {
+  size_t count = 0, size = 0;
+  hio_element_t element;
+  char **names = NULL;
+  int *ranks = NULL;
+  int rc;
+
+  /* make sure every element described by the manifest is on the element list */
+  rc = hioi_manifest_directory_load_all (dataset);
+  if (HIO_SUCCESS != rc) {
+    return rc;
+  }
+
+  hioi_object_lock (&dataset->ds_object);
+  hioi_list_foreach (element, dataset->ds_elist, struct hio_element, e_list) {
+    if (count == size) {
+      void *tmp;
+
+      size = size ? size * 2 : 64;
+      tmp = realloc (names, size * sizeof (names[0]));
+      if (NULL != tmp) {
+        names = tmp;
+        tmp = realloc (ranks, size * sizeof (ranks[0]));
+      }
+
+      if (NULL == tmp) {
+        rc = HIO_ERR_OUT_OF_RESOURCE;
+        break;
+      }
+      ranks = tmp;
+    }
+
+    names[count] = strdup (hioi_object_identifier (element));
+    if (NULL == names[count]) {
+      rc = HIO_ERR_OUT_OF_RESOURCE;
+      break;
+    }
+    ranks[count++] = element->e_rank;
+  }
+  hioi_object_unlock (&dataset->ds_object);
+
+  if (HIO_SUCCESS != rc) {
+    for (size_t i = 0 ; i < count ; ++i) {
+      free (names[i]);
+    }
+    free (names);
+    free (ranks);
+    return rc;
+  }
+
+  *names_out = names;
+  *ranks_out = ranks;
+  *count_out = count;
+
+  return HIO_SUCCESS;
+}
+
+hio_return_t hio_dataset_construct (hio_dataset_t dataset, const char *destination, int flags) {
+  hioi_construct_state_t state = {.cs_buffer = NULL, .cs_use_copy_range = true};
+  hio_context_t context;
+  size_t name_count = 0, element_count = 0;
+  char **names = NULL, **order = NULL;
+  uint64_t start, stop;
+  int *ranks = NULL;
+  int rc;
+
+  if (HIO_OBJECT_NULL == dataset || NULL == destination || '\0' == destination[0]) {
+    return HIO_ERR_BAD_PARAM;
+  }
+
+  if (!(dataset->ds_flags & HIO_FLAG_READ) || NULL == dataset->ds_module) {
+    /* the dataset must be open for reading */
+    return HIO_ERR_PERM;
+  }
+
+  context = hioi_object_context (&dataset->ds_object);
+  start = hioi_gettime ();
+
+  rc = HIO_SUCCESS;
+  if (0 == context->c_rank) {
+    if (0 != hioi_mkpath (context, destination, 0755) && EEXIST != errno) {
+      rc = hioi_err_errno (errno);
+      hioi_err_push (rc, &dataset->ds_object, "construct: could not create destination directory %s",
+                     destination);
+    }
+  }
+
+#if HIO_MPI_HAVE(1)
+  if (hioi_context_using_mpi (context)) {
+    MPI_Bcast (&rc, 1, MPI_INT, 0, context->c_comm);
+  }
+#endif
+
+  if (HIO_SUCCESS != rc) {
+    return rc;
+  }
+
+  if (NULL != dataset->ds_element_list) {
+    rc = dataset->ds_element_list (dataset, &names, &ranks, &name_count);
+  } else {
+    rc = hioi_construct_manifest_list (dataset, &names, &ranks, &name_count);
+  }
+
+  if (HIO_SUCCESS == rc) {
+    order = malloc (name_count * sizeof (order[0]));
+    if (NULL == order && name_count) {
+      rc = HIO_ERR_OUT_OF_RESOURCE;
+    }
+  }
+
+#if HIO_MPI_HAVE(1)
+  if (HIO_SET_ELEMENT_SHARED == dataset->ds_mode && hioi_context_using_mpi (context)) {
+    /* constructing a shared dataset is collective */
+    MPI_Allreduce (MPI_IN_PLACE, &rc, 1, MPI_INT, MPI_MIN, context->c_comm);
+  }
+#endif
+
+  if (HIO_SUCCESS == rc) {
+    for (size_t i = 0 ; i < name_count ; ++i) {
+      /* unique elements are constructed by the rank that wrote them */
+      if (HIO_SET_ELEMENT_SHARED == dataset->ds_mode || ranks[i] == context->c_rank) {
+        order[element_count++] = names[i];
+      }
+    }
+
+    /* every rank has the same list of shared elements. sort them so every rank agrees on the
+     * element order */
+    qsort (order, element_count, sizeof (order[0]), hioi_construct_name_compare);
+
+    if (HIO_SET_ELEMENT_SHARED == dataset->ds_mode) {
+      size_t unique_count = 0;
+
+      for (size_t i = 0 ; i < element_count ; ++i) {
+        if (0 == i || strcmp (order[i], order[unique_count - 1])) {
+          order[unique_count++] = order[i];
+        }
+      }
+
+      rc = hioi_construct_shared (&state, dataset, destination, order, unique_count);
+    } else {
+      rc = hioi_construct_unique (&state, dataset, destination, order, element_count);
+    }
+  }
+
+  for (size_t i = 0 ; i < name_count ; ++i) {
+    free (names[i]);
+  }
+  free (names);
+  free (ranks);
+  free (order);
+  free (state.cs_buffer);
+
+#if HIO_MPI_HAVE(1)
+  if (hioi_context_using_mpi (context)) {
+    MPI_Allreduce (MPI_IN_PLACE, &rc, 1, MPI_INT, MPI_MIN, context->c_comm);
+  }
+#endif
+
+  stop = hioi_gettime ();
+
+  hioi_log (context, HIO_VERBOSE_DEBUG_LOW, "construct: finished constructing dataset %s::%" PRIu64 " in %s. "
+            "rc: %d, time: %" PRIu64 " usec, kernel copied: %" PRIu64 " bytes, buffer copied: %" PRIu64
+            " bytes", hioi_object_identifier (dataset), dataset->ds_id, destination, rc, stop - start,
+            state.cs_kernel_bytes, state.cs_user_bytes);
+
+  return rc;
+}
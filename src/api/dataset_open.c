@@ -13,6 +13,16 @@
 
 #include <stdlib.h>
 
+static int hioi_dataset_module_index (hio_context_t context, hio_module_t *module) {
+  for (int i = 0 ; i < context->c_mcount ; ++i) {
+    if (context->c_modules[i] == module) {
+      return i;
+    }
+  }
+
+  return context->c_mcount;
+}
+
 static int hioi_dataset_open_last (hio_dataset_t dataset) {
   hio_context_t context = hioi_object_context ((hio_object_t) dataset);
   hio_dataset_header_t *headers = NULL;
@@ -20,23 +30,51 @@ static int hioi_dataset_open_last (hio_dataset_t dataset) {
   hio_module_t *module;
   int rc, count = 0;
 
-  for (int i = 0 ; i < context->c_mcount ; ++i) {
-    module = context->c_modules[i];
+  /* list the available datasets once on rank 0 and share the sorted result. this avoids having
+   * every rank scan the data roots and read the manifests at the same time */
+  if (0 == context->c_rank) {
+    for (int i = 0 ; i < context->c_mcount ; ++i) {
+      module = context->c_modules[i];
+
+      rc = module->dataset_list (module, hioi_object_identifier (dataset), &headers, &count);
+      if (HIO_SUCCESS != rc && HIO_ERR_NOT_FOUND != rc) {
+        hioi_err_push (rc, &dataset->ds_object, "dataset_open: error listing datasets on data root %s",
+                       module->data_root);
+      }
+    }
 
-    rc = module->dataset_list (module, hioi_object_identifier (dataset), &headers, &count);
-    if (HIO_SUCCESS != rc && HIO_ERR_NOT_FOUND != rc) {
-      hioi_err_push (rc, &dataset->ds_object, "dataset_open: error listing datasets on data root %s",
-                     module->data_root);
+    hioi_dataset_headers_sort (headers, count, id);
+
+    /* the same id may be on more than one data root (ex: a checkpoint prefetched into datawarp
+     * from the pfs). the headers are tried from last to first so order copies of an id so the
+     * one on the first listed (fastest) data root is tried first */
+    for (bool swapped = true ; swapped ; ) {
+      swapped = false;
+      for (int i = 1 ; i < count ; ++i) {
+        if (headers[i].ds_id == headers[i-1].ds_id && headers[i].ds_mtime == headers[i-1].ds_mtime &&
+            hioi_dataset_module_index (context, headers[i].module) >
+            hioi_dataset_module_index (context, headers[i-1].module)) {
+          hio_dataset_header_t tmp = headers[i];
+
+          headers[i] = headers[i-1];
+          headers[i-1] = tmp;
+          swapped = true;
+        }
+      }
     }
   }
 
+  rc = hioi_dataset_headers_scatter (context, &headers, &count);
+  if (HIO_SUCCESS != rc) {
+    free (headers);
+    return rc;
+  }
+
   if (0 == count) {
     free (headers);
     return HIO_ERR_NOT_FOUND;
   }
 
-  hioi_dataset_headers_sort (headers, count, id);
-
   /* debug output */
   if (0 == context->c_rank && HIO_VERBOSE_DEBUG_MED <= context->c_verbose) {
     hioi_log (context, HIO_VERBOSE_DEBUG_MED, "found %d dataset ids accross all data roots:", count);
@@ -48,10 +86,12 @@ static int hioi_dataset_open_last (hio_dataset_t dataset) {
     }
   }
 
+  rc = HIO_ERR_NOT_FOUND;
+
   for (int i = count - 1 ; i >= 0 ; --i) {
     module = headers[i].module;
 
-    if (0 != headers[i].ds_status) {
+    if (0 != headers[i].ds_status || NULL == module) {
       hioi_log (context, HIO_VERBOSE_DEBUG_MED, "skipping dataset with non-zero status: %s::%" PRId64
                 ". status = %d", hioi_object_identifier (&dataset->ds_object), headers[i].ds_id,
                 headers[i].ds_status);
@@ -79,8 +119,14 @@ static int hioi_dataset_open_last (hio_dataset_t dataset) {
 }
 
 static int hioi_dataset_open_specific (hio_context_t context, hio_dataset_t dataset) {
+  bool creating = !!(dataset->ds_flags & HIO_FLAG_CREAT);
   int rc = HIO_ERR_NOT_FOUND;
 
+  if (creating) {
+    /* pick the data root with the best expected write time for this dataset */
+    (void) hioi_context_select_module (context, dataset);
+  }
+
   for (int i = 0 ; i <= context->c_mcount ; ++i) {
     int module_index = (context->c_cur_module + i) % context->c_mcount;
 
@@ -91,7 +137,21 @@ static int hioi_dataset_open_specific (hio_context_t context, hio_dataset_t data
     }
 
     rc = hioi_dataset_open_internal (module, dataset);
+    if (creating) {
+      hioi_context_update_module_stats (context, module, rc, 0, 0, 0);
+      if (HIO_SUCCESS == rc && 0 == context->c_rank && dataset->ds_fsattr.fs_bsize) {
+        /* the module refreshed the filesystem attributes during the open */
+        context->c_module_stats[module_index].ms_bavail = dataset->ds_fsattr.fs_bavail *
+          dataset->ds_fsattr.fs_bsize;
+      }
+    }
+
     if (HIO_SUCCESS == rc) {
+      if (creating && module_index != context->c_cur_module) {
+        /* record the data root that was actually used */
+        context->c_cur_module = module_index;
+        context->c_module_failovers++;
+      }
       break;
     }
   }
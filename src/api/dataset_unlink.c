@@ -1,6 +1,6 @@
 /* -*- Mode: C; c-basic-offset:2 ; indent-tabs-mode:nil -*- */
 /*
- * Copyright (c) 2015-2016 Los Alamos National Security, LLC.  All rights
+ * Copyright (c) 2015-2017 Los Alamos National Security, LLC.  All rights
  *                         reserved. 
  * $COPYRIGHT$
  * 
@@ -12,10 +12,12 @@
 #include "hio_internal.h"
 
 int hio_dataset_unlink (hio_context_t ctx, const char *name, int64_t set_id, hio_unlink_mode_t mode) {
+  int flags = mode & (HIO_UNLINK_MODE_ASYNC | HIO_UNLINK_MODE_COLLECTIVE);
   hio_module_t *module;
   int rc = HIO_ERR_NOT_FOUND;
 
-  if (NULL == ctx || NULL == name || '\0' == name[0] || 0 > set_id) {
+  if (NULL == ctx || NULL == name || '\0' == name[0] || 0 > set_id ||
+      (HIO_UNLINK_MODE_ASYNC | HIO_UNLINK_MODE_COLLECTIVE) == flags) {
     return HIO_ERR_BAD_PARAM;
   }
 
@@ -27,16 +29,18 @@ int hio_dataset_unlink (hio_context_t ctx, const char *name, int64_t set_id, hio
     }
   }
 
+  mode &= ~flags;
+
   if (HIO_UNLINK_MODE_CURRENT == mode) {
     module = ctx->c_modules[ctx->c_cur_module];
-    return module->dataset_unlink (module, name, set_id);
+    return module->dataset_unlink (module, name, set_id, flags);
   }
 
 
   for (int i = 0 ; i < ctx->c_mcount ; ++i) {
     module = ctx->c_modules[i];
 
-    if (HIO_SUCCESS == module->dataset_unlink (module, name, set_id)) {
+    if (HIO_SUCCESS == module->dataset_unlink (module, name, set_id, flags)) {
       rc = HIO_SUCCESS;
       if (HIO_UNLINK_MODE_FIRST == mode) {
         break;
@@ -46,3 +50,21 @@ int hio_dataset_unlink (hio_context_t ctx, const char *name, int64_t set_id, hio
 
   return rc;
 }
+
+int hio_dataset_unlink_wait (hio_context_t ctx) {
+  if (NULL == ctx) {
+    return HIO_ERR_BAD_PARAM;
+  }
+
+  return hioi_unlink_wait (ctx);
+}
+
+int hio_dataset_unlink_pending (hio_context_t ctx, int *count) {
+  if (NULL == ctx || NULL == count) {
+    return HIO_ERR_BAD_PARAM;
+  }
+
+  *count = hioi_unlink_pending (ctx);
+
+  return HIO_SUCCESS;
+}
@@ -47,10 +47,23 @@ int hio_element_read_strided_nb (hio_element_t element, hio_request_t *request,
     return HIO_ERR_BAD_PARAM;
   }
 
-  (void) atomic_fetch_add (&dataset->ds_stat.s_rcount, 1);
+  hioi_dataset_stat_add (dataset, HIO_STAT_RCOUNT, 1);
 
   hioi_internal_request_init (&req, element, offset, ptr, count, size, stride,
                               HIO_REQUEST_TYPE_READ, request);
 
   return dataset->ds_process_reqs (dataset, (hio_internal_request_t **) &reqs, 1);
 }
+
+int hio_complete (hio_element_t element) {
+  if (HIO_OBJECT_NULL == element) {
+    return HIO_ERR_BAD_PARAM;
+  }
+
+  if (NULL == element->e_complete) {
+    /* backend completes reads when they are issued */
+    return HIO_SUCCESS;
+  }
+
+  return element->e_complete (element);
+}
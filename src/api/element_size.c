@@ -9,7 +9,7 @@
  * $HEADER$
  */
 
-#include "hio_types.h"
+#include "hio_internal.h"
 
 int hio_element_size (hio_element_t element, int64_t *e_size) {
   if (HIO_OBJECT_NULL == element || NULL == e_size) {
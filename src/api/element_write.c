@@ -18,7 +18,7 @@ int hioi_dataset_buffer_append (hio_dataset_t dataset, hio_element_t element, of
   hio_buffer_t *buffer = &dataset->ds_buffer;
   hio_internal_request_t *req;
   int rc = HIO_SUCCESS;
-  uint64_t start, stop;
+  uint64_t start, stop, append_start = hioi_gettime_ns (), flush_time = 0;
 
   hioi_object_lock (&dataset->ds_object);
 
@@ -61,10 +61,13 @@ int hioi_dataset_buffer_append (hio_dataset_t dataset, hio_element_t element, of
       stop = hioi_gettime ();
 
       /* add buffering time to the overall write time */
-      dataset->ds_stat.s_wtime += stop - start;
+      hioi_dataset_stat_add (dataset, HIO_STAT_WTIME, stop - start);
 
       if (block - to_write) {
+        uint64_t flush_start = hioi_gettime_ns ();
+
         rc = hioi_dataset_buffer_flush (dataset);
+        flush_time += hioi_gettime_ns () - flush_start;
         if (HIO_SUCCESS != rc) {
           break;
         }
@@ -75,6 +78,10 @@ int hioi_dataset_buffer_append (hio_dataset_t dataset, hio_element_t element, of
     ptr = (const void *) ((intptr_t) ptr + stride);
   }
 
+  /* flushes are timed separately */
+  hioi_latency_record (dataset->ds_stat.s_latency + HIO_LATENCY_OP_APPEND,
+                       hioi_gettime_ns () - append_start - flush_time);
+
   hioi_object_unlock (&dataset->ds_object);
 
   return rc;
@@ -121,7 +128,7 @@ int hio_element_write_strided_nb (hio_element_t element, hio_request_t *request,
     return HIO_ERR_PERM;
   }
 
-  (void) atomic_fetch_add (&dataset->ds_stat.s_wcount, 1);
+  hioi_dataset_stat_add (dataset, HIO_STAT_WCOUNT, 1);
 
   if (size * count < (dataset->ds_buffer.b_size >> 2)) {
     rc = hioi_dataset_buffer_append (dataset, element, offset, ptr, count, size, stride);
@@ -20,10 +20,16 @@
 #include <dirent.h>
 #include <errno.h>
 #include <assert.h>
+#include <pthread.h>
+#include <time.h>
 
 #include <sys/stat.h>
 
+#if HIO_DATAWARP_EMULATE
+#include "builtin-datawarp_emulate.h"
+#else
 #include <datawarp.h>
+#endif
 
 #ifdef HIO_DATAWARP_DEBUG_LOG
   #include <datawarpLogger.h>
@@ -32,6 +38,9 @@
 
 #define HIO_DATAWARP_MAX_KEEP 128
 
+/** default time between stage queries made by the stage tracker (ms) */
+#define HIO_DATAWARP_POLL_INTERVAL 100
+
 /**
  * builtin datawarp module
  *
@@ -45,6 +54,19 @@ typedef struct builtin_datawarp_module_t {
   hio_module_dataset_unlink_fn_t posix_unlink;
   hio_module_fini_fn_t posix_fini;
   char *pfs_path;
+
+  /** protects the stage tracker state and serializes dataset removal (recursive) */
+  pthread_mutex_t tracker_lock;
+  /** wakes up the stage tracker */
+  pthread_cond_t tracker_cond;
+  /** stage tracker thread (rank 0 only) */
+  pthread_t tracker_thread;
+  bool tracker_running;
+  bool tracker_stop;
+  /** resident ids with a stage in progress (builtin_datawarp_resident_id_t) */
+  hio_list_t tracked_ids;
+  /** time between stage queries (ms) */
+  int32_t poll_interval;
 } builtin_datawarp_module_t;
 
 typedef struct builtin_datawarp_module_dataset_t {
@@ -52,16 +74,37 @@ typedef struct builtin_datawarp_module_dataset_t {
   char *pfs_path;
   int stage_mode;
   int keep_last;
+  int32_t poll_interval;
 
   hio_dataset_close_fn_t posix_ds_close;
 } builtin_datawarp_module_dataset_t;
 
+struct builtin_datawarp_dataset_backend_data_t;
+
 typedef struct builtin_datawarp_resident_id_t {
   hio_list_t dwrid_list;
   /** dataset identifier */
   int64_t dwrid_id;
   /** active stage mode */
   int dwrid_stage_mode;
+
+  /** stage tracker list entry. the fields below are protected by the module's tracker lock */
+  hio_list_t dwrid_track_list;
+  /** stage of this id is being tracked */
+  bool dwrid_tracked;
+  /** id has been removed from the resident list. unlink it when the stage completes */
+  bool dwrid_unlink;
+  /** dataset name (set while tracked) */
+  char *dwrid_name;
+  /** burst-buffer path of the dataset id (set while tracked) */
+  char *dwrid_path;
+  /** final burst-buffer path of an id being prefetched from the PFS. dwrid_path is the
+   * hidden directory the id is staged into. cleared once the id has been moved into place */
+  char *dwrid_prefetch_path;
+  /** backend data the stage statistics are reported in */
+  struct builtin_datawarp_dataset_backend_data_t *dwrid_be_data;
+  /** last queried stage state (files) */
+  int dwrid_complete, dwrid_pending, dwrid_failed;
 } builtin_datawarp_resident_id_t;
 
 typedef struct builtin_datawarp_dataset_backend_data_t {
@@ -75,6 +118,20 @@ typedef struct builtin_datawarp_dataset_backend_data_t {
    * length of the resident_ids list. this field exists to
    * expose the length as a performance variable. */
   int32_t num_resident;
+
+  /** stage statistics maintained by the stage tracker. exposed as performance variables */
+  /** number of stages in progress */
+  int32_t stages_active;
+  /** number of stages that have finished since the context was created */
+  int32_t stages_complete;
+  /** number of finished stages with at least one failed file */
+  int32_t stages_failed;
+  /** number of ids waiting on their stage before they can be removed */
+  int32_t unlinks_deferred;
+  /** file counts of the stages in progress */
+  uint64_t stage_files_pending;
+  uint64_t stage_files_complete;
+  uint64_t stage_files_failed;
 } builtin_datawarp_dataset_backend_data_t;
 
 enum {
@@ -111,11 +168,12 @@ static void datawarp_debug_logger(uint64_t flags, void *data, char *file,
 }
 #endif
 
-static void builtin_datawarp_add_resident (builtin_datawarp_dataset_backend_data_t *be_data, int64_t id, int stage_mode, bool append) {
+static builtin_datawarp_resident_id_t *builtin_datawarp_add_resident (builtin_datawarp_dataset_backend_data_t *be_data,
+                                                                        int64_t id, int stage_mode, bool append) {
   builtin_datawarp_resident_id_t *rid = calloc (1, sizeof (*rid));
 
   if (NULL == rid) {
-    return;
+    return NULL;
   }
 
   hioi_list_init (rid->dwrid_list);
@@ -129,6 +187,15 @@ static void builtin_datawarp_add_resident (builtin_datawarp_dataset_backend_data
   }
 
   ++be_data->num_resident;
+
+  return rid;
+}
+
+static void builtin_datawarp_rid_free (builtin_datawarp_resident_id_t *rid) {
+  free (rid->dwrid_name);
+  free (rid->dwrid_path);
+  free (rid->dwrid_prefetch_path);
+  free (rid);
 }
 
 static void builtin_datawarp_bed_release (hio_dataset_backend_data_t *data) {
@@ -137,7 +204,7 @@ static void builtin_datawarp_bed_release (hio_dataset_backend_data_t *data) {
 
   hioi_list_foreach_safe (resident_id, next, be_data->resident_ids, builtin_datawarp_resident_id_t, dwrid_list) {
     hioi_list_remove(resident_id, dwrid_list);
-    free (resident_id);
+    builtin_datawarp_rid_free (resident_id);
   }
 }
 
@@ -196,7 +263,7 @@ static int builtin_datawarp_revoke_stage (hio_module_t *module, const char *ds_n
   free (dataset_path);
 
   /* remove the last end-of-job dataset from the burst buffer */
-  (void) datawarp_module->posix_unlink (module, ds_name, ds_id);
+  (void) datawarp_module->posix_unlink (module, ds_name, ds_id, HIO_UNLINK_MODE_ASYNC);
 
   /* remove created directories on pfs */
   rc = asprintf (&pfs_path, "%s/%s.hio/%s/%llu", datawarp_module->pfs_path, hioi_object_identifier (context),
@@ -214,7 +281,215 @@ static int builtin_datawarp_revoke_stage (hio_module_t *module, const char *ds_n
   return HIO_SUCCESS;
 }
 
-static int builtin_datawarp_module_dataset_unlink (struct hio_module_t *module, const char *name, int64_t set_id) {
+/**
+ * Query the stage of every tracked id and finish the ids whose stage is complete
+ *
+ * Must be called with the tracker lock held. Ids that were unlinked while their stage
+ * was in progress are removed from the burst buffer once the stage completes. If any
+ * file failed to stage the burst-buffer copy is kept as it may be the only complete
+ * copy of the data. Prefetched ids are moved into place once every file has been staged
+ * in. An incomplete prefetch is discarded as the PFS still holds the data. A discarded
+ * prefetch is also removed from the resident list so it does not count towards
+ * datawarp_keep_last. The tracker lock protects the resident lists for this reason.
+ */
+static void builtin_datawarp_tracker_poll (builtin_datawarp_module_t *datawarp_module) {
+  hio_context_t context = datawarp_module->posix_module.base.context;
+  builtin_datawarp_resident_id_t *rid, *next;
+
+  hioi_list_foreach_safe (rid, next, datawarp_module->tracked_ids, builtin_datawarp_resident_id_t, dwrid_track_list) {
+    builtin_datawarp_dataset_backend_data_t *be_data = rid->dwrid_be_data;
+    int complete = 0, pending = 0, deferred = 0, failed = 0, rc;
+
+    rc = dw_query_directory_stage (rid->dwrid_path, &complete, &pending, &deferred, &failed);
+    if (0 != rc) {
+      hioi_log (context, HIO_VERBOSE_WARN, "builtin-datawarp/stage_tracker: could not query stage of %s. rc: %d",
+                rid->dwrid_path, rc);
+      complete = pending = failed = 0;
+    }
+
+    be_data->stage_files_pending += pending - rid->dwrid_pending;
+    be_data->stage_files_complete += complete - rid->dwrid_complete;
+    be_data->stage_files_failed += failed - rid->dwrid_failed;
+    rid->dwrid_pending = pending;
+    rid->dwrid_complete = complete;
+    rid->dwrid_failed = failed;
+
+    if (0 == rc && (pending || (0 == complete && 0 == failed))) {
+      /* stage still in progress */
+      continue;
+    }
+
+    /* stage finished. it no longer counts towards the in-progress statistics */
+    hioi_list_remove (rid, dwrid_track_list);
+    rid->dwrid_tracked = false;
+    be_data->stage_files_pending -= pending;
+    be_data->stage_files_complete -= complete;
+    be_data->stage_files_failed -= failed;
+    --be_data->stages_active;
+    ++be_data->stages_complete;
+
+    if (failed) {
+      ++be_data->stages_failed;
+      hioi_log (context, HIO_VERBOSE_ERROR, "builtin-datawarp/stage_tracker: %d file(s) failed to stage from %s",
+                failed, rid->dwrid_path);
+    } else {
+      hioi_log (context, HIO_VERBOSE_DEBUG_MED, "builtin-datawarp/stage_tracker: stage of %s complete. files: %d",
+                rid->dwrid_path, complete);
+    }
+
+    if (NULL != rid->dwrid_prefetch_path) {
+      if (0 == rc && 0 == failed && !rid->dwrid_unlink && 0 == rename (rid->dwrid_path, rid->dwrid_prefetch_path)) {
+        hioi_log (context, HIO_VERBOSE_DEBUG_LOW, "builtin-datawarp/stage_tracker: prefetched dataset %s::%" PRIi64
+                  " is available on datawarp", rid->dwrid_name, rid->dwrid_id);
+        free (rid->dwrid_prefetch_path);
+        rid->dwrid_prefetch_path = NULL;
+        continue;
+      }
+
+      hioi_log (context, HIO_VERBOSE_WARN, "builtin-datawarp/stage_tracker: discarding prefetch of dataset %s::%"
+                PRIi64, rid->dwrid_name, rid->dwrid_id);
+      (void) hioi_unlink_tree (context, rid->dwrid_path, true);
+      if (rid->dwrid_unlink) {
+        /* already removed from the resident list */
+        --be_data->unlinks_deferred;
+      } else {
+        /* nothing is on the burst buffer so this id is no longer resident */
+        hioi_list_remove (rid, dwrid_list);
+        --be_data->num_resident;
+      }
+
+      builtin_datawarp_rid_free (rid);
+      continue;
+    }
+
+    if (!rid->dwrid_unlink) {
+      continue;
+    }
+
+    --be_data->unlinks_deferred;
+
+    if (0 == rc && 0 == failed) {
+      hioi_log (context, HIO_VERBOSE_DEBUG_LOW, "builtin-datawarp/stage_tracker: removing staged dataset %s::%"
+                PRIi64 " from datawarp", rid->dwrid_name, rid->dwrid_id);
+      (void) datawarp_module->posix_unlink (&datawarp_module->posix_module.base, rid->dwrid_name, rid->dwrid_id,
+                                            HIO_UNLINK_MODE_ASYNC);
+    } else {
+      hioi_log (context, HIO_VERBOSE_ERROR, "builtin-datawarp/stage_tracker: keeping dataset %s::%" PRIi64
+                " on datawarp as its stage did not complete", rid->dwrid_name, rid->dwrid_id);
+    }
+
+    builtin_datawarp_rid_free (rid);
+  }
+}
+
+static void *builtin_datawarp_tracker_thread (void *arg) {
+  builtin_datawarp_module_t *datawarp_module = (builtin_datawarp_module_t *) arg;
+
+  pthread_mutex_lock (&datawarp_module->tracker_lock);
+  while (!datawarp_module->tracker_stop) {
+    struct timespec deadline;
+
+    if (hioi_list_empty (&datawarp_module->tracked_ids)) {
+      pthread_cond_wait (&datawarp_module->tracker_cond, &datawarp_module->tracker_lock);
+      continue;
+    }
+
+    builtin_datawarp_tracker_poll (datawarp_module);
+
+    clock_gettime (CLOCK_REALTIME, &deadline);
+    deadline.tv_nsec += (long) datawarp_module->poll_interval * 1000000l;
+    deadline.tv_sec += deadline.tv_nsec / 1000000000l;
+    deadline.tv_nsec %= 1000000000l;
+    (void) pthread_cond_timedwait (&datawarp_module->tracker_cond, &datawarp_module->tracker_lock, &deadline);
+  }
+  pthread_mutex_unlock (&datawarp_module->tracker_lock);
+
+  return NULL;
+}
+
+/**
+ * Start tracking the stage of a resident id
+ *
+ * The stage tracker thread is started the first time a stage is tracked.
+ */
+static int builtin_datawarp_track (builtin_datawarp_module_t *datawarp_module, builtin_datawarp_dataset_backend_data_t *be_data,
+                                   builtin_datawarp_resident_id_t *rid, const char *name, const char *path) {
+  hio_context_t context = datawarp_module->posix_module.base.context;
+  int rc = HIO_SUCCESS;
+
+  pthread_mutex_lock (&datawarp_module->tracker_lock);
+  if (!datawarp_module->tracker_running) {
+    rc = pthread_create (&datawarp_module->tracker_thread, NULL, builtin_datawarp_tracker_thread, datawarp_module);
+    if (0 != rc) {
+      pthread_mutex_unlock (&datawarp_module->tracker_lock);
+      hioi_log (context, HIO_VERBOSE_WARN, "builtin-datawarp: could not start stage tracker. errno: %d", rc);
+      return hioi_err_errno (rc);
+    }
+
+    datawarp_module->tracker_running = true;
+  }
+
+  rid->dwrid_name = strdup (name);
+  rid->dwrid_path = strdup (path);
+  if (NULL == rid->dwrid_name || NULL == rid->dwrid_path) {
+    pthread_mutex_unlock (&datawarp_module->tracker_lock);
+    return HIO_ERR_OUT_OF_RESOURCE;
+  }
+
+  rid->dwrid_be_data = be_data;
+  rid->dwrid_tracked = true;
+  ++be_data->stages_active;
+  hioi_list_append (rid, datawarp_module->tracked_ids, dwrid_track_list);
+  pthread_cond_signal (&datawarp_module->tracker_cond);
+  pthread_mutex_unlock (&datawarp_module->tracker_lock);
+
+  return rc;
+}
+
+/**
+ * Stop the stage tracker
+ *
+ * Stages that are still in progress are not waited on. Ids that were waiting for their
+ * stage to finish stay on the burst buffer and will be found the next time the data root
+ * is scanned. Prefetches that are still in progress are terminated and removed.
+ */
+static void builtin_datawarp_tracker_fini (builtin_datawarp_module_t *datawarp_module) {
+  hio_context_t context = datawarp_module->posix_module.base.context;
+  builtin_datawarp_resident_id_t *rid, *next;
+
+  pthread_mutex_lock (&datawarp_module->tracker_lock);
+  if (datawarp_module->tracker_running) {
+    /* one last look so ids whose stage has finished are removed */
+    builtin_datawarp_tracker_poll (datawarp_module);
+
+    datawarp_module->tracker_stop = true;
+    pthread_cond_signal (&datawarp_module->tracker_cond);
+    pthread_mutex_unlock (&datawarp_module->tracker_lock);
+    pthread_join (datawarp_module->tracker_thread, NULL);
+    pthread_mutex_lock (&datawarp_module->tracker_lock);
+    datawarp_module->tracker_running = false;
+  }
+
+  hioi_list_foreach_safe (rid, next, datawarp_module->tracked_ids, builtin_datawarp_resident_id_t, dwrid_track_list) {
+    hioi_list_remove (rid, dwrid_track_list);
+    rid->dwrid_tracked = false;
+    if (NULL != rid->dwrid_prefetch_path) {
+      /* do not leave a partial copy on the burst buffer */
+      (void) dw_terminate_directory_stage (rid->dwrid_path);
+      (void) dw_wait_directory_stage (rid->dwrid_path);
+      (void) hioi_unlink_tree (context, rid->dwrid_path, true);
+    }
+
+    if (rid->dwrid_unlink) {
+      /* no longer on the resident list */
+      builtin_datawarp_rid_free (rid);
+    }
+  }
+  pthread_mutex_unlock (&datawarp_module->tracker_lock);
+}
+
+static int builtin_datawarp_module_dataset_unlink (struct hio_module_t *module, const char *name, int64_t set_id,
+                                                   int flags) {
   builtin_datawarp_module_t *datawarp_module = (builtin_datawarp_module_t *) module;
   builtin_datawarp_dataset_backend_data_t *be_data;
   builtin_datawarp_resident_id_t *rid, *next;
@@ -233,6 +508,7 @@ static int builtin_datawarp_module_dataset_unlink (struct hio_module_t *module,
     return HIO_ERR_NOT_FOUND;
   }
 
+  pthread_mutex_lock (&datawarp_module->tracker_lock);
   hioi_list_foreach_safe (rid, next, be_data->resident_ids, builtin_datawarp_resident_id_t, dwrid_list) {
     if (set_id == rid->dwrid_id) {
       hioi_list_remove (rid, dwrid_list);
@@ -242,46 +518,52 @@ static int builtin_datawarp_module_dataset_unlink (struct hio_module_t *module,
   }
 
   if (!found) {
+    pthread_mutex_unlock (&datawarp_module->tracker_lock);
     return HIO_ERR_NOT_FOUND;
   }
 
   stage_mode = rid->dwrid_stage_mode;
+  --be_data->num_resident;
 
-  if (DW_STAGE_IMMEDIATE == stage_mode) {
-    int complete = 0, pending, deferred, failed;
-    char *dw_path;
-
-    rc = asprintf (&dw_path, "%s/%s.hio/%s/%llu", module->data_root, hioi_object_identifier (context), name, set_id);
-    do {
-      rc = dw_query_directory_stage (dw_path, &complete, &pending, &deferred, &failed);
-      if (!complete) {
-        const struct timespec interval = {.tv_sec = 0, .tv_nsec = 1000000};
-        nanosleep (&interval, NULL);
-      }
-    } while (!complete);
+  if (rid->dwrid_tracked) {
+    /* the stage has not finished. the stage tracker will remove this id once it has */
+    hioi_log (context, HIO_VERBOSE_DEBUG_MED, "builtin-datawarp/dataset_unlink: deferring removal of %s::%"
+              PRIi64 " until its stage completes", name, set_id);
+    rid->dwrid_unlink = true;
+    ++be_data->unlinks_deferred;
+    pthread_mutex_unlock (&datawarp_module->tracker_lock);
+    return HIO_SUCCESS;
+  }
 
-    rc = datawarp_module->posix_unlink (module, name, set_id);
+  if (NULL != rid->dwrid_prefetch_path) {
+    /* prefetch did not complete. the partial copy has already been discarded */
+    rc = HIO_SUCCESS;
+  } else if (DW_STAGE_IMMEDIATE == stage_mode) {
+    /* stage has completed */
+    rc = datawarp_module->posix_unlink (module, name, set_id, flags);
   } else if (HIO_DATAWARP_STAGE_MODE_DISABLE == stage_mode) {
     /* this dataset was detected at init time */
-    rc = datawarp_module->posix_unlink (module, name, set_id);
+    rc = datawarp_module->posix_unlink (module, name, set_id, flags);
   } else {
     rc = builtin_datawarp_revoke_stage (module, name, set_id);
   }
+  pthread_mutex_unlock (&datawarp_module->tracker_lock);
 
-  free (rid);
-  --be_data->num_resident;
+  builtin_datawarp_rid_free (rid);
 
   return rc;
 }
 
 static void builtin_datawarp_cleanup (hio_dataset_t dataset, builtin_datawarp_dataset_backend_data_t *be_data) {
   hio_context_t context = hioi_object_context (&dataset->ds_object);
+  builtin_datawarp_module_t *datawarp_module = (builtin_datawarp_module_t *) dataset->ds_module;
   builtin_datawarp_resident_id_t *resident_id, *next;
   hio_module_t *module = dataset->ds_module;
 
   hioi_log (context, HIO_VERBOSE_DEBUG_MED, "builtin_datawarp_cleanup: there are %d resident dataset ids. keeping at most %d",
             be_data->num_resident, be_data->keep_last);
 
+  pthread_mutex_lock (&datawarp_module->tracker_lock);
   hioi_list_foreach_safe (resident_id, next, be_data->resident_ids, builtin_datawarp_resident_id_t, dwrid_list) {
     int64_t ds_id = resident_id->dwrid_id;
 
@@ -292,8 +574,10 @@ static void builtin_datawarp_cleanup (hio_dataset_t dataset, builtin_datawarp_da
     hioi_log (context, HIO_VERBOSE_DEBUG_MED, "deleting dataset %s::%"PRIi64" from datawarp", hioi_object_identifier (dataset),
               ds_id);
 
-    builtin_datawarp_module_dataset_unlink (module, hioi_object_identifier (dataset), ds_id);
+    /* old ids are removed in the background so the checkpoint is not held up */
+    builtin_datawarp_module_dataset_unlink (module, hioi_object_identifier (dataset), ds_id, HIO_UNLINK_MODE_ASYNC);
   }
+  pthread_mutex_unlock (&datawarp_module->tracker_lock);
 }
 
 static void builtin_datawarp_keep_last_set_cb (hio_object_t object, struct hio_var_t *variable) {
@@ -339,8 +623,11 @@ static int builtin_datawarp_module_dataset_open (struct hio_module_t *module, hi
     }
   #endif
 
-  /* open the posix dataset */
+  /* open the posix dataset. the tracker lock serializes dataset catalog updates with removals
+   * made by the stage tracker */
+  pthread_mutex_lock (&datawarp_module->tracker_lock);
   rc = datawarp_module->posix_open (&posix_module->base, dataset);
+  pthread_mutex_unlock (&datawarp_module->tracker_lock);
   if (HIO_SUCCESS != rc) {
     return rc;
   }
@@ -357,6 +644,24 @@ static int builtin_datawarp_module_dataset_open (struct hio_module_t *module, hi
       hioi_perf_add (context, &dataset->ds_object, &be_data->num_resident, "resident_id_count",
                      HIO_CONFIG_TYPE_INT32, NULL, "Total number of resident dataset ids for this "
                      "dataset kind", 0);
+      hioi_perf_add (context, &dataset->ds_object, &be_data->stages_active, "stage_active_count",
+                     HIO_CONFIG_TYPE_INT32, NULL, "Number of stages of this dataset kind in progress", 0);
+      hioi_perf_add (context, &dataset->ds_object, &be_data->stages_complete, "stage_complete_count",
+                     HIO_CONFIG_TYPE_INT32, NULL, "Number of stages of this dataset kind that have finished", 0);
+      hioi_perf_add (context, &dataset->ds_object, &be_data->stages_failed, "stage_failed_count",
+                     HIO_CONFIG_TYPE_INT32, NULL, "Number of finished stages of this dataset kind in which "
+                     "at least one file failed to stage", 0);
+      hioi_perf_add (context, &dataset->ds_object, &be_data->unlinks_deferred, "stage_deferred_unlink_count",
+                     HIO_CONFIG_TYPE_INT32, NULL, "Number of dataset ids waiting for their stage to finish "
+                     "before they are removed from datawarp", 0);
+      hioi_perf_add (context, &dataset->ds_object, &be_data->stage_files_pending, "stage_files_pending",
+                     HIO_CONFIG_TYPE_UINT64, NULL, "Number of files waiting to be staged in the stages in "
+                     "progress", 0);
+      hioi_perf_add (context, &dataset->ds_object, &be_data->stage_files_complete, "stage_files_complete",
+                     HIO_CONFIG_TYPE_UINT64, NULL, "Number of files staged in the stages in progress", 0);
+      hioi_perf_add (context, &dataset->ds_object, &be_data->stage_files_failed, "stage_files_failed",
+                     HIO_CONFIG_TYPE_UINT64, NULL, "Number of files that failed to stage in the stages in "
+                     "progress", 0);
 
       /* default to auto mode */
       datawarp_dataset->stage_mode = HIO_DATAWARP_STAGE_MODE_AUTO;
@@ -376,6 +681,17 @@ static int builtin_datawarp_module_dataset_open (struct hio_module_t *module, hi
         be_data->keep_last = datawarp_dataset->keep_last;
       }
 
+      datawarp_dataset->poll_interval = datawarp_module->poll_interval;
+      hioi_config_add (context, &dataset->ds_object, &datawarp_dataset->poll_interval,
+                       "datawarp_stage_poll_interval", NULL, HIO_CONFIG_TYPE_INT32, NULL,
+                       "Time in milliseconds between queries of the stages in progress (default: "
+                       STRINGIFY(HIO_DATAWARP_POLL_INTERVAL) ")", 0);
+      if (datawarp_dataset->poll_interval > 0) {
+        pthread_mutex_lock (&datawarp_module->tracker_lock);
+        datawarp_module->poll_interval = datawarp_dataset->poll_interval;
+        pthread_mutex_unlock (&datawarp_module->tracker_lock);
+      }
+
       builtin_datawarp_cleanup (dataset, be_data);
     }
   }
@@ -395,6 +711,7 @@ static int builtin_datawarp_module_dataset_close (hio_dataset_t dataset) {
   builtin_datawarp_dataset_backend_data_t *be_data;
   mode_t pfs_mode = posix_module->access_mode;
   hio_context_t context = hioi_object_context (&dataset->ds_object);
+  builtin_datawarp_resident_id_t *rid;
   char *dataset_path = NULL;
   int rc, stage_mode, num_resident;
 
@@ -408,7 +725,9 @@ static int builtin_datawarp_module_dataset_close (hio_dataset_t dataset) {
   }
 
   /* close the dataset with the underlying posix module */
+  pthread_mutex_lock (&datawarp_module->tracker_lock);
   rc = datawarp_dataset->posix_ds_close (dataset);
+  pthread_mutex_unlock (&datawarp_module->tracker_lock);
   if (HIO_SUCCESS != rc) {
     free (dataset_path);
     return rc;
@@ -467,13 +786,18 @@ static int builtin_datawarp_module_dataset_close (hio_dataset_t dataset) {
       return HIO_ERROR;
     }
     free (pfs_path);
-    free (dataset_path);
 
     be_data = builtin_datawarp_get_dbd (dataset->ds_data);
     /* backend data should have created when this dataset was opened */
     assert (NULL != be_data);
 
-    builtin_datawarp_add_resident (be_data, dataset->ds_id, stage_mode, true);
+    pthread_mutex_lock (&datawarp_module->tracker_lock);
+    rid = builtin_datawarp_add_resident (be_data, dataset->ds_id, stage_mode, true);
+    if (NULL != rid && DW_STAGE_IMMEDIATE == stage_mode) {
+      /* follow the stage in the background so this id can be removed without waiting on it */
+      (void) builtin_datawarp_track (datawarp_module, be_data, rid, hioi_object_identifier (dataset), dataset_path);
+    }
+    free (dataset_path);
 
     num_resident = be_data->num_resident;
 
@@ -481,16 +805,17 @@ static int builtin_datawarp_module_dataset_close (hio_dataset_t dataset) {
               be_data->keep_last);
 
     if (num_resident > be_data->keep_last) {
-      builtin_datawarp_resident_id_t *rid = (builtin_datawarp_resident_id_t *) be_data->resident_ids.next;
+      rid = (builtin_datawarp_resident_id_t *) be_data->resident_ids.next;
 
       hioi_log (context, HIO_VERBOSE_DEBUG_LOW, "builtin-datawarp/dataset_close: removing resident dataset with id %"PRIi64,
                 rid->dwrid_id);
 
       rc = builtin_datawarp_module_dataset_unlink (&posix_module->base, hioi_object_identifier (&dataset->ds_object),
-                                                   rid->dwrid_id);
+                                                   rid->dwrid_id, HIO_UNLINK_MODE_ASYNC);
       hioi_log (context, HIO_VERBOSE_DEBUG_LOW, "builtin-datawarp/dataset_close: builtin_datawarp_module_dataset_unlink returned %d. "
                 "resident ids %d", rc, num_resident - 1);
     }
+    pthread_mutex_unlock (&datawarp_module->tracker_lock);
   }
 
   return rc;
@@ -503,6 +828,13 @@ static int builtin_datawarp_module_fini (struct hio_module_t *module) {
   hioi_log (context, HIO_VERBOSE_DEBUG_LOW, "Finalizing datawarp filesystem module for data root %s",
 	    module->data_root);
 
+  builtin_datawarp_tracker_fini (datawarp_module);
+  /* the stage tracker may have started background removals */
+  (void) hioi_unlink_wait (context);
+
+  pthread_mutex_destroy (&datawarp_module->tracker_lock);
+  pthread_cond_destroy (&datawarp_module->tracker_cond);
+
   free (datawarp_module->pfs_path);
 
   if (datawarp_module->posix_fini) {
@@ -542,6 +874,7 @@ static int builtin_datawarp_component_fini (void) {
 static int builtin_datawarp_scan_datasets (builtin_datawarp_module_t *datawarp_module) {
   hio_context_t context = datawarp_module->posix_module.base.context;
   builtin_datawarp_dataset_backend_data_t *be_data;
+  builtin_datawarp_resident_id_t *rid;
   struct dirent context_entry, *tmp = NULL;
   hio_dataset_header_t *headers = NULL;
   hio_dataset_data_t *ds_data;
@@ -608,7 +941,6 @@ static int builtin_datawarp_scan_datasets (builtin_datawarp_module_t *datawarp_m
       }
 
       rc = dw_query_directory_stage (ds_path, &complete, &pending, &deferred, &failed);
-      free (ds_path);
 
       if (0 == rc) {
         /* end of job stages will have all files in the deferred stage. anything else will be
@@ -619,7 +951,12 @@ static int builtin_datawarp_scan_datasets (builtin_datawarp_module_t *datawarp_m
       hioi_log (context, HIO_VERBOSE_DEBUG_MED, "builtin-datawarp: found resident dataset %s::%"PRIi64" with status "
                 "%d. stage mode %d", context_entry.d_name, headers[i].ds_id, headers[i].ds_status, stage_mode);
 
-      builtin_datawarp_add_resident (be_data, headers[i].ds_id, stage_mode, true);
+      rid = builtin_datawarp_add_resident (be_data, headers[i].ds_id, stage_mode, true);
+      if (NULL != rid && DW_STAGE_IMMEDIATE == stage_mode && 0 == rc && pending > 0) {
+        /* a stage started by an earlier job is still running */
+        (void) builtin_datawarp_track (datawarp_module, be_data, rid, context_entry.d_name, ds_path);
+      }
+      free (ds_path);
     }
 
     free (headers);
@@ -632,6 +969,159 @@ static int builtin_datawarp_scan_datasets (builtin_datawarp_module_t *datawarp_m
   return HIO_SUCCESS;
 }
 
+/**
+ * @brief Start staging the newest complete id of each dataset on the parallel file system
+ *        into the burst buffer.
+ *
+ * This is used on restart when the checkpoint to be read only exists on the PFS. Each id is
+ * staged into a hidden directory and moved into place by the stage tracker once every file
+ * has arrived. Until then the id is not visible on datawarp and hio_dataset_open() reads it
+ * from the PFS.
+ */
+static int builtin_datawarp_prefetch (builtin_datawarp_module_t *datawarp_module) {
+  hio_context_t context = datawarp_module->posix_module.base.context;
+  const char *data_root = datawarp_module->posix_module.base.data_root;
+  builtin_datawarp_dataset_backend_data_t *be_data;
+  builtin_datawarp_resident_id_t *rid;
+  hio_dataset_header_t *headers = NULL;
+  hio_module_t *pfs_module;
+  hio_dataset_data_t *ds_data;
+  char *context_path, *pfs_path, *ds_path, *staging_path;
+  struct dirent *dp;
+  DIR *context_dir;
+  int rc = HIO_SUCCESS, count;
+
+  if (0 != context->c_rank || !context->c_dw_prefetch || NULL == datawarp_module->pfs_path) {
+    /* nothing to do */
+    return HIO_SUCCESS;
+  }
+
+  if (0 > asprintf (&context_path, "%s/%s.hio", datawarp_module->pfs_path, hioi_object_identifier (context))) {
+    return HIO_ERR_OUT_OF_RESOURCE;
+  }
+
+  context_dir = opendir (context_path);
+  if (NULL == context_dir) {
+    /* no context directory == nothing to prefetch */
+    free (context_path);
+    return HIO_SUCCESS;
+  }
+
+  /* a posix module on the pfs is used to find the newest complete ids */
+  rc = builtin_posix_component.query (context, datawarp_module->pfs_path, NULL, &pfs_module);
+  if (HIO_SUCCESS != rc) {
+    closedir (context_dir);
+    free (context_path);
+    return rc;
+  }
+
+  while (NULL != (dp = readdir (context_dir))) {
+    int64_t ds_id = -1;
+    bool resident = false;
+
+    if ('.' == dp->d_name[0]) {
+      continue;
+    }
+
+    count = 0;
+    rc = builtin_posix_module_dataset_list_internal (pfs_module, dp->d_name, &headers, &count);
+    if (HIO_SUCCESS == rc && count > 0) {
+      hioi_dataset_headers_sort (headers, count, HIO_DATASET_ID_NEWEST);
+      for (int i = count - 1 ; i >= 0 ; --i) {
+        if (0 == headers[i].ds_status) {
+          ds_id = headers[i].ds_id;
+          break;
+        }
+      }
+    }
+
+    free (headers);
+    headers = NULL;
+    rc = HIO_SUCCESS;
+
+    if (0 > ds_id) {
+      continue;
+    }
+
+    rc = hioi_dataset_data_lookup (context, dp->d_name, &ds_data);
+    if (HIO_SUCCESS != rc) {
+      break;
+    }
+
+    be_data = builtin_datawarp_get_dbd (ds_data);
+    if (NULL == be_data) {
+      rc = HIO_ERR_OUT_OF_RESOURCE;
+      break;
+    }
+
+    pthread_mutex_lock (&datawarp_module->tracker_lock);
+    hioi_list_foreach (rid, be_data->resident_ids, builtin_datawarp_resident_id_t, dwrid_list) {
+      if (ds_id == rid->dwrid_id) {
+        resident = true;
+        break;
+      }
+    }
+    pthread_mutex_unlock (&datawarp_module->tracker_lock);
+
+    if (resident) {
+      hioi_log (context, HIO_VERBOSE_DEBUG_MED, "builtin-datawarp/prefetch: dataset %s::%" PRIi64 " is already "
+                "resident on datawarp", dp->d_name, ds_id);
+      continue;
+    }
+
+    pfs_path = ds_path = staging_path = NULL;
+    if (0 > asprintf (&pfs_path, "%s/%s/%" PRIi64, context_path, dp->d_name, ds_id) ||
+        0 > asprintf (&ds_path, "%s/%s.hio/%s/%" PRIi64, data_root, hioi_object_identifier (context),
+                      dp->d_name, ds_id) ||
+        0 > asprintf (&staging_path, "%s/%s.hio/%s/.%" PRIi64 ".prefetch", data_root,
+                      hioi_object_identifier (context), dp->d_name, ds_id)) {
+      free (pfs_path);
+      free (ds_path);
+      rc = HIO_ERR_OUT_OF_RESOURCE;
+      break;
+    }
+
+    if (0 == access (staging_path, F_OK)) {
+      /* left over from a job that ended before its prefetch completed */
+      (void) hioi_unlink_tree (context, staging_path, false);
+    }
+
+    rc = hioi_mkpath (context, staging_path, datawarp_module->posix_module.access_mode);
+    if (HIO_SUCCESS == rc) {
+      rc = dw_stage_directory_in (staging_path, pfs_path);
+    }
+
+    if (0 != rc) {
+      hioi_log (context, HIO_VERBOSE_WARN, "builtin-datawarp/prefetch: could not start stage-in of %s to %s. "
+                "rc: %d", pfs_path, staging_path, rc);
+      rc = HIO_SUCCESS;
+    } else {
+      hioi_log (context, HIO_VERBOSE_DEBUG_LOW, "builtin-datawarp/prefetch: staging dataset %s::%" PRIi64 " into "
+                "datawarp. pfs dir: %s burst-buffer dir: %s", dp->d_name, ds_id, pfs_path, ds_path);
+
+      /* the prefetched id takes part in space management like any other resident id */
+      pthread_mutex_lock (&datawarp_module->tracker_lock);
+      rid = builtin_datawarp_add_resident (be_data, ds_id, HIO_DATAWARP_STAGE_MODE_DISABLE, true);
+      if (NULL != rid) {
+        rid->dwrid_prefetch_path = ds_path;
+        ds_path = NULL;
+        (void) builtin_datawarp_track (datawarp_module, be_data, rid, dp->d_name, staging_path);
+      }
+      pthread_mutex_unlock (&datawarp_module->tracker_lock);
+    }
+
+    free (pfs_path);
+    free (ds_path);
+    free (staging_path);
+  }
+
+  closedir (context_dir);
+  free (context_path);
+  pfs_module->fini (pfs_module);
+
+  return rc;
+}
+
 static int builtin_datawarp_component_query (hio_context_t context, const char *data_root,
                                              const char *next_data_root, hio_module_t **module) {
   builtin_datawarp_module_t *new_module;
@@ -701,6 +1191,15 @@ static int builtin_datawarp_component_query (hio_context_t context, const char *
 
   memcpy (&new_module->posix_module, posix_module, sizeof (new_module->posix_module));
 
+  pthread_mutexattr_t mutex_attr;
+  pthread_mutexattr_init (&mutex_attr);
+  pthread_mutexattr_settype (&mutex_attr, PTHREAD_MUTEX_RECURSIVE);
+  pthread_mutex_init (&new_module->tracker_lock, &mutex_attr);
+  pthread_mutexattr_destroy (&mutex_attr);
+  pthread_cond_init (&new_module->tracker_cond, NULL);
+  hioi_list_init (new_module->tracked_ids);
+  new_module->poll_interval = HIO_DATAWARP_POLL_INTERVAL;
+
   new_module->posix_open = posix_module->dataset_open;
   new_module->posix_unlink = posix_module->dataset_unlink;
   new_module->posix_fini = posix_module->fini;
@@ -728,6 +1227,9 @@ static int builtin_datawarp_component_query (hio_context_t context, const char *
   /* scan for existing dataset(s) for space management */
   (void) builtin_datawarp_scan_datasets (new_module);
 
+  /* start staging in the checkpoint a restart will read */
+  (void) builtin_datawarp_prefetch (new_module);
+
   return HIO_SUCCESS;
 }
 
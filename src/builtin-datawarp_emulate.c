@@ -0,0 +1,677 @@
+/* -*- Mode: C; c-basic-offset:2 ; indent-tabs-mode:nil -*- */
+/*
+ * Copyright (c) 2017      Los Alamos National Security, LLC.  All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/**
+ * @file builtin-datawarp_emulate.c
+ * @brief Local stand-in for the Cray DataWarp staging API
+ *
+ * Each stage is a list of files to move from a source tree to a destination tree.
+ * Stages are kept on a global list keyed by their burst-buffer path. A small pool of
+ * threads takes files from stages in the order the stages were started and copies
+ * them. All threads share a single bandwidth limit so the time a stage takes is
+ * similar to a stage on a real burst buffer. End-of-job stages are held until they
+ * are activated, revoked, or the process exits.
+ */
+
+#include "hio_internal.h"
+#include "builtin-datawarp_emulate.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <time.h>
+
+#include <sys/stat.h>
+
+#define HIOI_DWE_BUFFER_SIZE (1ul << 20)
+
+typedef enum hioi_dwe_file_state_t {
+  HIOI_DWE_FILE_PENDING,
+  HIOI_DWE_FILE_COMPLETE,
+  HIOI_DWE_FILE_FAILED,
+} hioi_dwe_file_state_t;
+
+typedef struct hioi_dwe_file_t {
+  /** path relative to the root of the stage */
+  char *path;
+  hioi_dwe_file_state_t state;
+} hioi_dwe_file_t;
+
+typedef struct hioi_dwe_stage_t {
+  hio_list_t stage_list;
+  /** burst buffer path (stages are looked up by this path) */
+  char *dw_path;
+  /** parallel file system path */
+  char *pfs_path;
+  /** copy from the pfs to the burst buffer */
+  bool stage_in;
+  /** stage is waiting for activation (end of job) */
+  bool deferred;
+  /** stage was terminated. files that have not been started are failed */
+  bool terminated;
+  /** files in this stage */
+  hioi_dwe_file_t *files;
+  int file_count;
+  /** index of the next file to hand to a stage thread */
+  int next_file;
+  /** number of files being copied right now */
+  int active;
+  int complete;
+  int failed;
+} hioi_dwe_stage_t;
+
+static struct {
+  pthread_mutex_t lock;
+  /** signalled when there is work for the stage threads */
+  pthread_cond_t work_cond;
+  /** signalled when a file finishes */
+  pthread_cond_t done_cond;
+  hio_list_t stages;
+  pthread_t *threads;
+  int thread_count;
+  bool stop;
+  bool job_end;
+  bool link;
+  /** bandwidth limit in bytes per usec (0 for unlimited) */
+  double bandwidth;
+  /** time (usec) at which the bandwidth limiter is next free */
+  uint64_t throttle_time;
+  int stripe_size;
+  int stripe_width;
+} hioi_dwe = {.lock = PTHREAD_MUTEX_INITIALIZER, .work_cond = PTHREAD_COND_INITIALIZER,
+              .done_cond = PTHREAD_COND_INITIALIZER};
+
+static pthread_once_t hioi_dwe_once = PTHREAD_ONCE_INIT;
+
+static long hioi_dwe_env (const char *name, long default_value) {
+  char *value = getenv (name);
+
+  return value ? strtol (value, NULL, 0) : default_value;
+}
+
+/**
+ * Wait until the bandwidth limiter allows another {bytes} to be moved
+ */
+static void hioi_dwe_throttle (size_t bytes) {
+  uint64_t now, wake;
+
+  if (0.0 == hioi_dwe.bandwidth) {
+    return;
+  }
+
+  pthread_mutex_lock (&hioi_dwe.lock);
+  now = hioi_gettime ();
+  if (hioi_dwe.throttle_time < now) {
+    hioi_dwe.throttle_time = now;
+  }
+  hioi_dwe.throttle_time += (uint64_t) ((double) bytes / hioi_dwe.bandwidth);
+  wake = hioi_dwe.throttle_time;
+  pthread_mutex_unlock (&hioi_dwe.lock);
+
+  if (wake > now) {
+    struct timespec interval = {.tv_sec = (wake - now) / 1000000, .tv_nsec = ((wake - now) % 1000000) * 1000};
+    nanosleep (&interval, NULL);
+  }
+}
+
+/** create all parent directories of {path} */
+static int hioi_dwe_mkparent (const char *path, mode_t mode) {
+  char *tmp = strdup (path);
+
+  if (NULL == tmp) {
+    return -ENOMEM;
+  }
+
+  for (char *sep = strchr (tmp + 1, '/') ; sep ; sep = strchr (sep + 1, '/')) {
+    *sep = '\0';
+    if (0 != mkdir (tmp, mode) && EEXIST != errno) {
+      int rc = -errno;
+      free (tmp);
+      return rc;
+    }
+    *sep = '/';
+  }
+
+  free (tmp);
+
+  return 0;
+}
+
+static int hioi_dwe_copy (const char *src, const char *dst) {
+  int fd_in, fd_out, rc = 0;
+  struct stat statinfo;
+  char *buffer;
+  ssize_t got;
+
+  fd_in = open (src, O_RDONLY);
+  if (0 > fd_in) {
+    return -errno;
+  }
+
+  if (0 != fstat (fd_in, &statinfo)) {
+    rc = -errno;
+    close (fd_in);
+    return rc;
+  }
+
+  (void) hioi_dwe_mkparent (dst, 0755);
+
+  if (hioi_dwe.link) {
+    (void) unlink (dst);
+    if (0 == link (src, dst)) {
+      close (fd_in);
+      return 0;
+    }
+    /* fall back on copying (different filesystems) */
+  }
+
+  fd_out = open (dst, O_WRONLY | O_CREAT | O_TRUNC, statinfo.st_mode & 07777);
+  if (0 > fd_out) {
+    rc = -errno;
+    close (fd_in);
+    return rc;
+  }
+
+  buffer = malloc (HIOI_DWE_BUFFER_SIZE);
+  if (NULL == buffer) {
+    close (fd_in);
+    close (fd_out);
+    return -ENOMEM;
+  }
+
+  while (0 < (got = read (fd_in, buffer, HIOI_DWE_BUFFER_SIZE))) {
+    hioi_dwe_throttle (got);
+
+    for (ssize_t done = 0, ret ; done < got ; done += ret) {
+      ret = write (fd_out, buffer + done, got - done);
+      if (0 > ret) {
+        rc = -errno;
+        break;
+      }
+    }
+
+    if (rc) {
+      break;
+    }
+  }
+
+  if (0 > got) {
+    rc = -errno;
+  }
+
+  free (buffer);
+  close (fd_in);
+  if (0 != close (fd_out) && 0 == rc) {
+    rc = -errno;
+  }
+
+  return rc;
+}
+
+/** full path of a file in a stage (NULL if out of memory) */
+static char *hioi_dwe_path (const char *root, const char *relative) {
+  char *path;
+
+  if ('\0' == relative[0]) {
+    return strdup (root);
+  }
+
+  return (0 > asprintf (&path, "%s/%s", root, relative)) ? NULL : path;
+}
+
+/* must be called with the lock held */
+static hioi_dwe_stage_t *hioi_dwe_next_work (int *index) {
+  hioi_dwe_stage_t *stage;
+
+  hioi_list_foreach (stage, hioi_dwe.stages, hioi_dwe_stage_t, stage_list) {
+    if (!stage->deferred && stage->next_file < stage->file_count) {
+      *index = stage->next_file++;
+      return stage;
+    }
+  }
+
+  return NULL;
+}
+
+static void *hioi_dwe_thread (void *arg) {
+  (void) arg;
+
+  pthread_mutex_lock (&hioi_dwe.lock);
+  while (!hioi_dwe.stop) {
+    hioi_dwe_stage_t *stage;
+    char *src, *dst;
+    int index, rc;
+
+    stage = hioi_dwe_next_work (&index);
+    if (NULL == stage) {
+      pthread_cond_wait (&hioi_dwe.work_cond, &hioi_dwe.lock);
+      continue;
+    }
+
+    if (stage->terminated) {
+      stage->files[index].state = HIOI_DWE_FILE_FAILED;
+      ++stage->failed;
+      pthread_cond_broadcast (&hioi_dwe.done_cond);
+      continue;
+    }
+
+    ++stage->active;
+    src = hioi_dwe_path (stage->stage_in ? stage->pfs_path : stage->dw_path, stage->files[index].path);
+    dst = hioi_dwe_path (stage->stage_in ? stage->dw_path : stage->pfs_path, stage->files[index].path);
+    pthread_mutex_unlock (&hioi_dwe.lock);
+
+    rc = (src && dst) ? hioi_dwe_copy (src, dst) : -ENOMEM;
+    free (src);
+    free (dst);
+
+    pthread_mutex_lock (&hioi_dwe.lock);
+    --stage->active;
+    if (0 == rc) {
+      stage->files[index].state = HIOI_DWE_FILE_COMPLETE;
+      ++stage->complete;
+    } else {
+      stage->files[index].state = HIOI_DWE_FILE_FAILED;
+      ++stage->failed;
+    }
+    pthread_cond_broadcast (&hioi_dwe.done_cond);
+  }
+  pthread_mutex_unlock (&hioi_dwe.lock);
+
+  return NULL;
+}
+
+static void hioi_dwe_stage_free (hioi_dwe_stage_t *stage) {
+  for (int i = 0 ; i < stage->file_count ; ++i) {
+    free (stage->files[i].path);
+  }
+
+  free (stage->files);
+  free (stage->dw_path);
+  free (stage->pfs_path);
+  free (stage);
+}
+
+static bool hioi_dwe_stage_busy (hioi_dwe_stage_t *stage) {
+  return stage->active || (!stage->deferred && stage->next_file < stage->file_count);
+}
+
+/**
+ * Carry out end-of-job stages and stop the stage threads
+ */
+static void hioi_dwe_fini (void) {
+  hioi_dwe_stage_t *stage, *next;
+
+  pthread_mutex_lock (&hioi_dwe.lock);
+  hioi_list_foreach (stage, hioi_dwe.stages, hioi_dwe_stage_t, stage_list) {
+    if (stage->deferred && hioi_dwe.job_end) {
+      stage->deferred = false;
+    }
+  }
+  pthread_cond_broadcast (&hioi_dwe.work_cond);
+
+  for (bool busy = true ; busy ; ) {
+    busy = false;
+    hioi_list_foreach (stage, hioi_dwe.stages, hioi_dwe_stage_t, stage_list) {
+      busy |= hioi_dwe_stage_busy (stage);
+    }
+
+    if (busy) {
+      pthread_cond_wait (&hioi_dwe.done_cond, &hioi_dwe.lock);
+    }
+  }
+
+  hioi_dwe.stop = true;
+  pthread_cond_broadcast (&hioi_dwe.work_cond);
+  pthread_mutex_unlock (&hioi_dwe.lock);
+
+  for (int i = 0 ; i < hioi_dwe.thread_count ; ++i) {
+    pthread_join (hioi_dwe.threads[i], NULL);
+  }
+
+  hioi_list_foreach_safe (stage, next, hioi_dwe.stages, hioi_dwe_stage_t, stage_list) {
+    hioi_list_remove (stage, stage_list);
+    hioi_dwe_stage_free (stage);
+  }
+
+  free (hioi_dwe.threads);
+  hioi_dwe.threads = NULL;
+  hioi_dwe.thread_count = 0;
+}
+
+static void hioi_dwe_init (void) {
+  const char *mode = getenv ("HIO_DW_EMULATE_MODE");
+  int thread_count;
+
+  hioi_list_init (hioi_dwe.stages);
+  hioi_dwe.link = mode && 0 == strcasecmp (mode, "link");
+  hioi_dwe.job_end = 0 != hioi_dwe_env ("HIO_DW_EMULATE_JOB_END", 1);
+  /* MB/s == bytes/usec */
+  hioi_dwe.bandwidth = (double) hioi_dwe_env ("HIO_DW_EMULATE_BANDWIDTH", 0);
+  hioi_dwe.stripe_size = (int) hioi_dwe_env ("HIO_DW_EMULATE_STRIPE_SIZE", 8 << 20);
+  hioi_dwe.stripe_width = (int) hioi_dwe_env ("HIO_DW_EMULATE_STRIPE_WIDTH", 1);
+
+  thread_count = (int) hioi_dwe_env ("HIO_DW_EMULATE_THREADS", 2);
+  if (thread_count < 1) {
+    thread_count = 1;
+  }
+
+  hioi_dwe.threads = calloc (thread_count, sizeof (pthread_t));
+  if (NULL == hioi_dwe.threads) {
+    return;
+  }
+
+  for (int i = 0 ; i < thread_count ; ++i) {
+    if (0 != pthread_create (hioi_dwe.threads + i, NULL, hioi_dwe_thread, NULL)) {
+      break;
+    }
+    ++hioi_dwe.thread_count;
+  }
+
+  atexit (hioi_dwe_fini);
+}
+
+static int hioi_dwe_file_add (hioi_dwe_stage_t *stage, const char *path) {
+  if (0 == (stage->file_count & 63)) {
+    void *tmp = realloc (stage->files, (stage->file_count + 64) * sizeof (stage->files[0]));
+    if (NULL == tmp) {
+      return -ENOMEM;
+    }
+    stage->files = tmp;
+  }
+
+  stage->files[stage->file_count].path = strdup (path);
+  if (NULL == stage->files[stage->file_count].path) {
+    return -ENOMEM;
+  }
+
+  stage->files[stage->file_count++].state = HIOI_DWE_FILE_PENDING;
+
+  return 0;
+}
+
+/**
+ * Add all regular files under {root}/{relative} to the stage
+ */
+static int hioi_dwe_scan (hioi_dwe_stage_t *stage, const char *root, const char *relative) {
+  struct dirent *entry;
+  char *path;
+  DIR *dir;
+  int rc = 0;
+
+  rc = asprintf (&path, "%s/%s", root, relative);
+  if (0 > rc) {
+    return -ENOMEM;
+  }
+
+  dir = opendir (path);
+  free (path);
+  if (NULL == dir) {
+    return -errno;
+  }
+
+  rc = 0;
+  while (0 == rc && NULL != (entry = readdir (dir))) {
+    struct stat statinfo;
+    char *child;
+
+    if (0 == strcmp (entry->d_name, ".") || 0 == strcmp (entry->d_name, "..")) {
+      continue;
+    }
+
+    if (0 > asprintf (&child, "%s%s%s", relative, relative[0] ? "/" : "", entry->d_name)) {
+      rc = -ENOMEM;
+      break;
+    }
+
+    if (0 > asprintf (&path, "%s/%s", root, child)) {
+      free (child);
+      rc = -ENOMEM;
+      break;
+    }
+
+    if (0 == stat (path, &statinfo)) {
+      if (S_ISDIR(statinfo.st_mode)) {
+        rc = hioi_dwe_scan (stage, root, child);
+      } else if (S_ISREG(statinfo.st_mode)) {
+        rc = hioi_dwe_file_add (stage, child);
+      }
+    }
+
+    free (path);
+    free (child);
+  }
+
+  closedir (dir);
+
+  return rc;
+}
+
+/* must be called with the lock held */
+static hioi_dwe_stage_t *hioi_dwe_lookup (const char *dw_path) {
+  hioi_dwe_stage_t *stage;
+
+  hioi_list_foreach (stage, hioi_dwe.stages, hioi_dwe_stage_t, stage_list) {
+    if (0 == strcmp (stage->dw_path, dw_path)) {
+      return stage;
+    }
+  }
+
+  return NULL;
+}
+
+static int hioi_dwe_stage (const char *dw_path, const char *pfs_path, bool stage_in, bool directory,
+                           enum dw_stage_type stage_type) {
+  hioi_dwe_stage_t *stage, *old;
+  int rc;
+
+  pthread_once (&hioi_dwe_once, hioi_dwe_init);
+
+  if (NULL == dw_path) {
+    return -EINVAL;
+  }
+
+  if (DW_REVOKE_STAGE_AT_JOB_END == stage_type || DW_ACTIVATE_DEFERRED_STAGE == stage_type) {
+    pthread_mutex_lock (&hioi_dwe.lock);
+    stage = hioi_dwe_lookup (dw_path);
+    if (NULL == stage || !stage->deferred) {
+      pthread_mutex_unlock (&hioi_dwe.lock);
+      return -ENOENT;
+    }
+
+    if (DW_REVOKE_STAGE_AT_JOB_END == stage_type) {
+      hioi_list_remove (stage, stage_list);
+      hioi_dwe_stage_free (stage);
+    } else {
+      stage->deferred = false;
+      pthread_cond_broadcast (&hioi_dwe.work_cond);
+    }
+    pthread_mutex_unlock (&hioi_dwe.lock);
+
+    return 0;
+  }
+
+  if (NULL == pfs_path || (DW_STAGE_IMMEDIATE != stage_type && DW_STAGE_AT_JOB_END != stage_type)) {
+    return -EINVAL;
+  }
+
+  stage = calloc (1, sizeof (*stage));
+  if (NULL == stage) {
+    return -ENOMEM;
+  }
+
+  stage->dw_path = strdup (dw_path);
+  stage->pfs_path = strdup (pfs_path);
+  stage->stage_in = stage_in;
+  stage->deferred = DW_STAGE_AT_JOB_END == stage_type;
+  if (NULL == stage->dw_path || NULL == stage->pfs_path) {
+    hioi_dwe_stage_free (stage);
+    return -ENOMEM;
+  }
+
+  if (directory) {
+    rc = hioi_dwe_scan (stage, stage_in ? pfs_path : dw_path, "");
+  } else {
+    /* a file stage has a single entry with an empty relative path */
+    rc = hioi_dwe_file_add (stage, "");
+  }
+
+  if (0 != rc) {
+    hioi_dwe_stage_free (stage);
+    return rc;
+  }
+
+  pthread_mutex_lock (&hioi_dwe.lock);
+  old = hioi_dwe_lookup (dw_path);
+  if (NULL != old) {
+    if (hioi_dwe_stage_busy (old)) {
+      pthread_mutex_unlock (&hioi_dwe.lock);
+      hioi_dwe_stage_free (stage);
+      return -EBUSY;
+    }
+
+    hioi_list_remove (old, stage_list);
+    hioi_dwe_stage_free (old);
+  }
+
+  hioi_list_append (stage, hioi_dwe.stages, stage_list);
+  pthread_cond_broadcast (&hioi_dwe.work_cond);
+  pthread_mutex_unlock (&hioi_dwe.lock);
+
+  return 0;
+}
+
+int dw_stage_file_in (const char *dw_file_path, const char *pfs_file_path) {
+  return hioi_dwe_stage (dw_file_path, pfs_file_path, true, false, DW_STAGE_IMMEDIATE);
+}
+
+int dw_stage_file_out (const char *dw_file_path, const char *pfs_file_path, enum dw_stage_type stage_type) {
+  return hioi_dwe_stage (dw_file_path, pfs_file_path, false, false, stage_type);
+}
+
+int dw_stage_directory_in (const char *dw_directory_path, const char *pfs_directory_path) {
+  return hioi_dwe_stage (dw_directory_path, pfs_directory_path, true, true, DW_STAGE_IMMEDIATE);
+}
+
+int dw_stage_directory_out (const char *dw_directory_path, const char *pfs_directory_path,
+                            enum dw_stage_type stage_type) {
+  return hioi_dwe_stage (dw_directory_path, pfs_directory_path, false, true, stage_type);
+}
+
+int dw_query_directory_stage (const char *dw_directory_path, int *complete, int *pending, int *deferred,
+                              int *failed) {
+  hioi_dwe_stage_t *stage;
+
+  pthread_once (&hioi_dwe_once, hioi_dwe_init);
+
+  *complete = *pending = *deferred = *failed = 0;
+
+  pthread_mutex_lock (&hioi_dwe.lock);
+  stage = hioi_dwe_lookup (dw_directory_path);
+  if (NULL == stage) {
+    pthread_mutex_unlock (&hioi_dwe.lock);
+    return -ENOENT;
+  }
+
+  if (0 == stage->file_count) {
+    *complete = 1;
+  } else if (stage->deferred) {
+    *deferred = stage->file_count;
+  } else {
+    *complete = stage->complete;
+    *failed = stage->failed;
+    *pending = stage->file_count - stage->complete - stage->failed;
+  }
+  pthread_mutex_unlock (&hioi_dwe.lock);
+
+  return 0;
+}
+
+int dw_query_file_stage (const char *dw_file_path, int *complete, int *pending, int *deferred, int *failed) {
+  return dw_query_directory_stage (dw_file_path, complete, pending, deferred, failed);
+}
+
+int dw_wait_directory_stage (const char *dw_directory_path) {
+  hioi_dwe_stage_t *stage;
+  int rc;
+
+  pthread_once (&hioi_dwe_once, hioi_dwe_init);
+
+  pthread_mutex_lock (&hioi_dwe.lock);
+  while (NULL != (stage = hioi_dwe_lookup (dw_directory_path)) && !stage->deferred &&
+         hioi_dwe_stage_busy (stage)) {
+    pthread_cond_wait (&hioi_dwe.done_cond, &hioi_dwe.lock);
+  }
+
+  rc = (NULL == stage) ? -ENOENT : ((stage->failed) ? -EIO : 0);
+  pthread_mutex_unlock (&hioi_dwe.lock);
+
+  return rc;
+}
+
+int dw_wait_file_stage (const char *dw_file_path) {
+  return dw_wait_directory_stage (dw_file_path);
+}
+
+int dw_terminate_directory_stage (const char *dw_directory_path) {
+  hioi_dwe_stage_t *stage;
+
+  pthread_once (&hioi_dwe_once, hioi_dwe_init);
+
+  pthread_mutex_lock (&hioi_dwe.lock);
+  stage = hioi_dwe_lookup (dw_directory_path);
+  if (NULL == stage) {
+    pthread_mutex_unlock (&hioi_dwe.lock);
+    return -ENOENT;
+  }
+
+  /* files that have not been started will be marked as failed by the stage threads */
+  stage->terminated = true;
+  stage->deferred = false;
+  pthread_cond_broadcast (&hioi_dwe.work_cond);
+  pthread_mutex_unlock (&hioi_dwe.lock);
+
+  return 0;
+}
+
+int dw_terminate_file_stage (const char *dw_file_path) {
+  return dw_terminate_directory_stage (dw_file_path);
+}
+
+int dw_get_stripe_configuration (int fd, int *stripe_size, int *stripe_width, int *starting_index) {
+  struct stat statinfo;
+
+  pthread_once (&hioi_dwe_once, hioi_dwe_init);
+
+  if (0 != fstat (fd, &statinfo)) {
+    return -errno;
+  }
+
+  *stripe_size = hioi_dwe.stripe_size;
+  *stripe_width = hioi_dwe.stripe_width;
+  *starting_index = 0;
+
+  return 0;
+}
+
+int dw_set_stripe_configuration (int fd, int stripe_size, int stripe_width) {
+  struct stat statinfo;
+
+  /* striping is not emulated */
+  (void) stripe_size;
+  (void) stripe_width;
+
+  return (0 == fstat (fd, &statinfo)) ? 0 : -errno;
+}
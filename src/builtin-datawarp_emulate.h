@@ -0,0 +1,89 @@
+/* -*- Mode: C; c-basic-offset:2 ; indent-tabs-mode:nil -*- */
+/*
+ * Copyright (c) 2017      Los Alamos National Security, LLC.  All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/**
+ * @file builtin-datawarp_emulate.h
+ * @brief Local stand-in for the Cray DataWarp staging API
+ *
+ * When libhio is configured with --with-datawarp=emulate this header replaces
+ * datawarp.h. It provides the subset of libdatawarp used by libhio with the same
+ * signatures and return conventions (0 on success, -errno on failure). Stages are
+ * carried out on the local machine by background threads that copy (or hard link)
+ * files between the "burst buffer" directory and the "PFS" directory.
+ *
+ * The emulation is configured with environment variables:
+ *
+ *  - HIO_DW_EMULATE_THREADS   - number of stage threads (default: 2)
+ *  - HIO_DW_EMULATE_BANDWIDTH - aggregate stage bandwidth in MB/s, 0 for unlimited
+ *                               (default: 0)
+ *  - HIO_DW_EMULATE_MODE      - copy or link. link hard links files instead of copying
+ *                               them when both paths are on the same filesystem
+ *                               (default: copy)
+ *  - HIO_DW_EMULATE_JOB_END   - if non-zero end-of-job stages are carried out when the
+ *                               process exits (default: 1)
+ *  - HIO_DW_EMULATE_STRIPE_SIZE / HIO_DW_EMULATE_STRIPE_WIDTH - striping reported by
+ *                               dw_get_stripe_configuration (default: 8 MiB / 1)
+ */
+
+#if !defined(BUILTIN_DATAWARP_EMULATE_H)
+#define BUILTIN_DATAWARP_EMULATE_H
+
+/* keep the emulated symbols out of the dw_ namespace */
+#define dw_stage_file_in             hioi_dwe_stage_file_in
+#define dw_stage_file_out            hioi_dwe_stage_file_out
+#define dw_stage_directory_in        hioi_dwe_stage_directory_in
+#define dw_stage_directory_out       hioi_dwe_stage_directory_out
+#define dw_query_file_stage          hioi_dwe_query_file_stage
+#define dw_query_directory_stage     hioi_dwe_query_directory_stage
+#define dw_wait_file_stage           hioi_dwe_wait_file_stage
+#define dw_wait_directory_stage      hioi_dwe_wait_directory_stage
+#define dw_terminate_file_stage      hioi_dwe_terminate_file_stage
+#define dw_terminate_directory_stage hioi_dwe_terminate_directory_stage
+#define dw_get_stripe_configuration  hioi_dwe_get_stripe_configuration
+#define dw_set_stripe_configuration  hioi_dwe_set_stripe_configuration
+
+enum dw_stage_type {
+  /** start the stage now */
+  DW_STAGE_IMMEDIATE = 0,
+  /** stage when the job ends */
+  DW_STAGE_AT_JOB_END = 1,
+  /** cancel a pending end-of-job stage */
+  DW_REVOKE_STAGE_AT_JOB_END = 2,
+  /** start a pending end-of-job stage now */
+  DW_ACTIVATE_DEFERRED_STAGE = 3,
+};
+
+int dw_stage_file_in (const char *dw_file_path, const char *pfs_file_path);
+int dw_stage_file_out (const char *dw_file_path, const char *pfs_file_path, enum dw_stage_type stage_type);
+int dw_stage_directory_in (const char *dw_directory_path, const char *pfs_directory_path);
+int dw_stage_directory_out (const char *dw_directory_path, const char *pfs_directory_path,
+                            enum dw_stage_type stage_type);
+
+/**
+ * Query the state of a stage
+ *
+ * Counts are in files. A stage of an empty directory is reported as a single complete
+ * file so callers polling for completion terminate. Returns -ENOENT if no stage exists
+ * for the path.
+ */
+int dw_query_file_stage (const char *dw_file_path, int *complete, int *pending, int *deferred, int *failed);
+int dw_query_directory_stage (const char *dw_directory_path, int *complete, int *pending, int *deferred,
+                              int *failed);
+
+int dw_wait_file_stage (const char *dw_file_path);
+int dw_wait_directory_stage (const char *dw_directory_path);
+int dw_terminate_file_stage (const char *dw_file_path);
+int dw_terminate_directory_stage (const char *dw_directory_path);
+
+int dw_get_stripe_configuration (int fd, int *stripe_size, int *stripe_width, int *starting_index);
+int dw_set_stripe_configuration (int fd, int stripe_size, int stripe_width);
+
+#endif /* BUILTIN_DATAWARP_EMULATE_H */
@@ -16,7 +16,6 @@
 #include <stdio.h>
 #include <fcntl.h>
 #include <stdarg.h>
-#include <ftw.h>
 #include <assert.h>
 
 #include <string.h>
@@ -61,34 +60,352 @@ static hio_var_enum_t hioi_dataset_file_modes = {
   },
 };
 
+static hio_var_enum_t builtin_posix_manifest_formats = {
+  .count  = 2,
+  .values = (hio_var_enum_value_t []){
+    {.string_value = "json", .value = HIO_MANIFEST_FORMAT_JSON},
+    {.string_value = "binary", .value = HIO_MANIFEST_FORMAT_BINARY},
+  },
+};
+
+/* true/false are accepted for compatibility with the boolean form of dataset_use_bzip */
+static hio_var_enum_t builtin_posix_manifest_codecs = {
+  .count  = 5,
+  .values = (hio_var_enum_value_t []){
+    {.string_value = "none", .value = HIO_MANIFEST_CODEC_NONE},
+    {.string_value = "bzip2", .value = HIO_MANIFEST_CODEC_BZIP2},
+    {.string_value = "lz", .value = HIO_MANIFEST_CODEC_LZ},
+    {.string_value = "false", .value = HIO_MANIFEST_CODEC_NONE},
+    {.string_value = "true", .value = HIO_MANIFEST_CODEC_BZIP2},
+  },
+};
+
+/** file name suffix for binary manifests */
+#define HIO_POSIX_MANIFEST_BINARY_SUFFIX ".hbin"
+
+/** name of the dataset catalog (stored in the directory of each dataset name). the name
+ * starts with a '.' so it is skipped when scanning for dataset ids. */
+#define HIO_POSIX_CATALOG_NAME ".catalog"
+#define HIO_POSIX_CATALOG_MAGIC "HIOCATLG"
+#define HIO_POSIX_CATALOG_VERSION 1
+
+/**
+ * Dataset catalog
+ *
+ * The catalog caches the header of each dataset id so listing datasets does not
+ * require reading every top-level manifest. It is a fixed header followed by
+ * fixed-size records sorted by dataset id. The catalog is updated by rank 0 when a
+ * dataset is closed or unlinked and is always replaced atomically (write to a
+ * temporary file then rename). Ids found in the dataset directory but not in the
+ * catalog are read from their manifest and the catalog is rewritten.
+ */
+typedef struct builtin_posix_catalog_header_t {
+  char     ch_magic[8];
+  uint32_t ch_version;
+  uint32_t ch_record_size;
+  uint64_t ch_count;
+} builtin_posix_catalog_header_t;
+
+typedef struct builtin_posix_catalog_record_t {
+  int64_t  cr_id;
+  int64_t  cr_mtime;
+  int32_t  cr_mode;
+  int32_t  cr_status;
+} builtin_posix_catalog_record_t;
+
 /** static functions */
-static int builtin_posix_module_dataset_unlink (struct hio_module_t *module, const char *name, int64_t set_id);
+static int builtin_posix_module_dataset_unlink (struct hio_module_t *module, const char *name, int64_t set_id,
+                                                int flags);
 static int builtin_posix_module_dataset_close (hio_dataset_t dataset);
 static int builtin_posix_module_element_open (hio_dataset_t dataset, hio_element_t element);
 static int builtin_posix_module_element_flush (hio_element_t element, hio_flush_mode_t mode);
 static int builtin_posix_module_element_complete (hio_element_t element);
 static int builtin_posix_module_process_reqs (hio_dataset_t dataset, hio_internal_request_t **reqs, int req_count);
+static int builtin_posix_module_element_locate (hio_element_t element, uint64_t offset, size_t *size, int *fd,
+                                                uint64_t *file_offset);
+static int builtin_posix_module_element_list (hio_dataset_t dataset, char ***names_out, int **ranks_out,
+                                              size_t *count_out);
 static int builtin_posix_module_dataset_manifest_list_all (const char *path, int **manifest_ids, size_t *count, size_t nnodes);
 
+/**
+ * @brief Locate a dataset manifest
+ *
+ * @param[in]  base_path dataset directory
+ * @param[in]  id        manifest id (-1 for the top-level manifest)
+ * @param[out] path_out  location of the manifest
+ *
+ * Manifests may be stored in any of the supported formats. This function looks for
+ * a binary manifest then a compressed json manifest (bzip2 or lz) and finally an
+ * uncompressed json manifest. If no manifest is found path_out is set to the
+ * uncompressed json path and HIO_ERR_NOT_FOUND is returned.
+ */
+static int builtin_posix_manifest_path (const char *base_path, int id, char **path_out) {
+  const int codecs[] = {HIO_MANIFEST_CODEC_BZIP2, HIO_MANIFEST_CODEC_LZ, HIO_MANIFEST_CODEC_NONE};
+  char *path = NULL;
+  int rc;
+
+  for (int i = 0 ; i < 4 ; ++i) {
+    const char *format_suffix = i ? ".json" : HIO_POSIX_MANIFEST_BINARY_SUFFIX;
+    const char *codec_suffix = i ? hioi_manifest_codec_suffix (codecs[i - 1]) : "";
+
+    free (path);
+
+    if (0 > id) {
+      rc = asprintf (&path, "%s/manifest%s%s", base_path, format_suffix, codec_suffix);
+    } else {
+      rc = asprintf (&path, "%s/manifest.%x%s%s", base_path, id, format_suffix, codec_suffix);
+    }
+
+    if (0 > rc) {
+      return HIO_ERR_OUT_OF_RESOURCE;
+    }
+
+    if (F_OK == access (path, R_OK)) {
+      *path_out = path;
+      return HIO_SUCCESS;
+    }
+  }
+
+  *path_out = path;
+
+  return HIO_ERR_NOT_FOUND;
+}
+
+static int builtin_posix_catalog_path (struct hio_module_t *module, const char *name, char **path) {
+  int rc = asprintf (path, "%s/%s.hio/%s/" HIO_POSIX_CATALOG_NAME, module->data_root,
+                     hioi_object_identifier(module->context), name);
+  return (0 > rc) ? HIO_ERR_OUT_OF_RESOURCE : HIO_SUCCESS;
+}
+
+static int builtin_posix_catalog_record_compare (const void *a, const void *b) {
+  const builtin_posix_catalog_record_t *recorda = (const builtin_posix_catalog_record_t *) a;
+  const builtin_posix_catalog_record_t *recordb = (const builtin_posix_catalog_record_t *) b;
+
+  return (recorda->cr_id > recordb->cr_id) - (recorda->cr_id < recordb->cr_id);
+}
+
+/**
+ * @brief Read the dataset catalog
+ *
+ * @param[in]  module  posix module
+ * @param[in]  name    dataset name
+ * @param[out] records catalog records sorted by id (allocated)
+ * @param[out] count   number of records
+ *
+ * Returns HIO_ERR_NOT_FOUND if the catalog does not exist or is not valid.
+ */
+static int builtin_posix_catalog_read (struct hio_module_t *module, const char *name,
+                                       builtin_posix_catalog_record_t **records, size_t *count) {
+  builtin_posix_catalog_header_t header;
+  char *path;
+  FILE *fh;
+  int rc;
+
+  *records = NULL;
+  *count = 0;
+
+  rc = builtin_posix_catalog_path (module, name, &path);
+  if (HIO_SUCCESS != rc) {
+    return rc;
+  }
+
+  fh = fopen (path, "r");
+  free (path);
+  if (NULL == fh) {
+    return HIO_ERR_NOT_FOUND;
+  }
+
+  if (1 != fread (&header, sizeof (header), 1, fh) || memcmp (header.ch_magic, HIO_POSIX_CATALOG_MAGIC, 8) ||
+      HIO_POSIX_CATALOG_VERSION != header.ch_version ||
+      sizeof (builtin_posix_catalog_record_t) != header.ch_record_size) {
+    fclose (fh);
+    return HIO_ERR_NOT_FOUND;
+  }
+
+  if (header.ch_count) {
+    *records = malloc (header.ch_count * sizeof (**records));
+    if (NULL == *records) {
+      fclose (fh);
+      return HIO_ERR_OUT_OF_RESOURCE;
+    }
+
+    if (header.ch_count != fread (*records, sizeof (**records), header.ch_count, fh)) {
+      free (*records);
+      *records = NULL;
+      fclose (fh);
+      return HIO_ERR_NOT_FOUND;
+    }
+  }
+
+  fclose (fh);
+  *count = header.ch_count;
+
+  return HIO_SUCCESS;
+}
+
+/**
+ * @brief Replace the dataset catalog
+ *
+ * @param[in]  module  posix module
+ * @param[in]  name    dataset name
+ * @param[in]  records catalog records sorted by id
+ * @param[in]  count   number of records
+ */
+static int builtin_posix_catalog_write (struct hio_module_t *module, const char *name,
+                                        const builtin_posix_catalog_record_t *records, size_t count) {
+  builtin_posix_catalog_header_t header = {.ch_version = HIO_POSIX_CATALOG_VERSION,
+                                           .ch_record_size = sizeof (builtin_posix_catalog_record_t),
+                                           .ch_count = count};
+  char *path, *tmp_path;
+  FILE *fh;
+  int rc;
+
+  memcpy (header.ch_magic, HIO_POSIX_CATALOG_MAGIC, 8);
+
+  rc = builtin_posix_catalog_path (module, name, &path);
+  if (HIO_SUCCESS != rc) {
+    return rc;
+  }
+
+  rc = hioi_tmp_path (path, &tmp_path);
+  if (HIO_SUCCESS != rc) {
+    free (path);
+    return rc;
+  }
+
+  fh = fopen (tmp_path, "w");
+  if (NULL == fh) {
+    rc = hioi_err_errno (errno);
+  } else {
+    if (1 != fwrite (&header, sizeof (header), 1, fh) ||
+        (count && count != fwrite (records, sizeof (*records), count, fh))) {
+      rc = HIO_ERR_TRUNCATE;
+    } else {
+      rc = HIO_SUCCESS;
+    }
+
+    if (0 != fclose (fh) && HIO_SUCCESS == rc) {
+      rc = hioi_err_errno (errno);
+    }
+
+    if (HIO_SUCCESS == rc && 0 != rename (tmp_path, path)) {
+      rc = hioi_err_errno (errno);
+    }
+
+    if (HIO_SUCCESS != rc) {
+      (void) unlink (tmp_path);
+    }
+  }
+
+  hioi_log (module->context, HIO_VERBOSE_DEBUG_MED, "posix:catalog: wrote %lu records to catalog %s. rc: %d",
+            (unsigned long) count, path, rc);
+
+  free (tmp_path);
+  free (path);
+
+  return rc;
+}
+
+/**
+ * @brief Add, replace, or remove a dataset in the catalog
+ *
+ * @param[in]  module  posix module
+ * @param[in]  name    dataset name
+ * @param[in]  id      dataset id
+ * @param[in]  header  new dataset header (NULL to remove the dataset)
+ *
+ * Errors are not fatal. The catalog is rebuilt from the manifests the next time
+ * the datasets are listed.
+ */
+static void builtin_posix_catalog_update (struct hio_module_t *module, const char *name, int64_t id,
+                                          const hio_dataset_header_t *header) {
+  builtin_posix_catalog_record_t key = {.cr_id = id}, *records, *record, *tmp;
+  size_t count;
+  int rc;
+
+  rc = builtin_posix_catalog_read (module, name, &records, &count);
+  if (HIO_SUCCESS != rc) {
+    /* a new catalog can not be created without scanning all ids. it will be created the next
+     * time the datasets are listed */
+    return;
+  }
+
+  record = bsearch (&key, records, count, sizeof (*records), builtin_posix_catalog_record_compare);
+  if (NULL == header) {
+    if (NULL == record) {
+      free (records);
+      return;
+    }
+
+    memmove (record, record + 1, (count - (record - records) - 1) * sizeof (*records));
+    --count;
+  } else {
+    if (NULL == record) {
+      tmp = realloc (records, (count + 1) * sizeof (*records));
+      if (NULL == tmp) {
+        free (records);
+        return;
+      }
+
+      records = tmp;
+      record = records + count++;
+    }
+
+    record->cr_id = id;
+    record->cr_mtime = (int64_t) header->ds_mtime;
+    record->cr_mode = header->ds_mode;
+    record->cr_status = header->ds_status;
+    qsort (records, count, sizeof (*records), builtin_posix_catalog_record_compare);
+  }
+
+  (void) builtin_posix_catalog_write (module, name, records, count);
+  free (records);
+}
+
+/**
+ * @brief Update the manifest codec performance variables
+ *
+ * @param[in] posix_dataset posix dataset
+ * @param[in] manifest      manifest that was compressed or decompressed (may be NULL)
+ *
+ * Codec statistics are accumulated in the dataset and removed from the manifest. If
+ * manifest is NULL the performance variables are refreshed from the accumulated
+ * statistics (loading a manifest overwrites them with the values of the writer).
+ */
+static void builtin_posix_codec_stats (builtin_posix_module_dataset_t *posix_dataset,
+                                       hio_manifest_codec_stats_t *stats) {
+  if (NULL != stats) {
+    posix_dataset->ds_codec_raw_bytes += stats->cs_raw_bytes;
+    posix_dataset->ds_codec_coded_bytes += stats->cs_coded_bytes;
+    posix_dataset->ds_codec_time_total += stats->cs_time_usec;
+    memset (stats, 0, sizeof (*stats));
+  }
+
+  posix_dataset->ds_codec_time = posix_dataset->ds_codec_time_total;
+  posix_dataset->ds_codec_ratio = posix_dataset->ds_codec_coded_bytes ?
+    (double) posix_dataset->ds_codec_raw_bytes / (double) posix_dataset->ds_codec_coded_bytes : 0.0;
+}
 
-static void builtin_posix_trace (builtin_posix_module_dataset_t *posix_dataset, const char *event,
-                                 int64_t value, uint64_t value2, uint64_t start, uint64_t stop) {
-  if (NULL == posix_dataset->ds_trace_fh) {
+/**
+ * Record a trace event (times in nsec)
+ */
+static inline void builtin_posix_trace (builtin_posix_module_dataset_t *posix_dataset, hio_trace_event_t event,
+                                        int64_t value, uint64_t value2, uint64_t start, uint64_t stop) {
+  if (NULL == posix_dataset->ds_trace) {
     return;
   }
 
-  fprintf (posix_dataset->ds_trace_fh, "%s::%" PRId64 ":%s:%" PRIu64 ":%" PRIu64 ":%" PRIu64 ":%" PRIu64 ":%" PRIu64 "\n",
-           hioi_object_identifier (&posix_dataset->base), posix_dataset->base.ds_id, event, value, value2, start, stop,
-           stop - start);
+  hioi_trace_event (posix_dataset->ds_trace, event, value, value2, start, stop);
 }
 
-#define POSIX_TRACE_CALL(ds, c, e, v, v2)                       \
-  do {                                                          \
-    uint64_t _start, _stop;                                     \
-    _start = hioi_gettime ();                                   \
-    c;                                                          \
-    _stop = hioi_gettime ();                                    \
-    builtin_posix_trace ((ds), e, v, v2, _start, _stop);        \
+/* only read the clock when tracing is enabled */
+#define POSIX_TRACE_CALL(ds, c, e, v, v2)                               \
+  do {                                                                  \
+    uint64_t _start = (ds)->ds_trace ? hioi_gettime_ns () : 0;          \
+    c;                                                                  \
+    if ((ds)->ds_trace) {                                               \
+      builtin_posix_trace ((ds), e, v, v2, _start, hioi_gettime_ns ()); \
+    }                                                                   \
   } while (0)
 
 static int builtin_posix_dataset_path (struct hio_module_t *module, char **path, const char *name, uint64_t set_id) {
@@ -100,6 +417,223 @@ static int builtin_posix_dataset_path (struct hio_module_t *module, char **path,
   return (0 > rc) ? hioi_err_errno (errno) : HIO_SUCCESS;
 }
 
+static int builtin_posix_stripe_path (const char *data_root, hio_context_t context, char **path, const char *name,
+                                      uint64_t set_id) {
+  int rc;
+
+  /* data files on secondary data roots are kept in a hidden directory so the dataset id is
+   * not listed on those data roots */
+  rc = asprintf (path, "%s/%s.hio/%s/.stripe.%lu", data_root, hioi_object_identifier(context), name,
+                 (unsigned long) set_id);
+  return (0 > rc) ? hioi_err_errno (errno) : HIO_SUCCESS;
+}
+
+/**
+ * Build the table of dataset paths on each data root listed in ds_data_roots
+ */
+static int builtin_posix_parse_data_roots (builtin_posix_module_dataset_t *posix_dataset) {
+  hio_context_t context = hioi_object_context (&posix_dataset->base.ds_object);
+  char *data_roots, *data_root, *last;
+  int count = 1, rc = HIO_SUCCESS;
+
+  if (NULL != posix_dataset->ds_root_paths) {
+    return HIO_SUCCESS;
+  }
+
+  if (NULL == posix_dataset->ds_data_roots || '\0' == posix_dataset->ds_data_roots[0]) {
+    return HIO_ERR_NOT_FOUND;
+  }
+
+  for (const char *tmp = posix_dataset->ds_data_roots ; *tmp ; ++tmp) {
+    count += (',' == *tmp);
+  }
+
+  posix_dataset->ds_root_paths = calloc (count, sizeof (char *));
+  data_roots = strdup (posix_dataset->ds_data_roots);
+  if (NULL == posix_dataset->ds_root_paths || NULL == data_roots) {
+    free (posix_dataset->ds_root_paths);
+    posix_dataset->ds_root_paths = NULL;
+    free (data_roots);
+    return HIO_ERR_OUT_OF_RESOURCE;
+  }
+
+  posix_dataset->ds_root_paths[0] = strdup (posix_dataset->base_path);
+  posix_dataset->ds_root_count = 1;
+
+  /* the first entry is always the dataset's own data root */
+  (void) strtok_r (data_roots, ",", &last);
+
+  while (HIO_SUCCESS == rc && NULL != (data_root = strtok_r (NULL, ",", &last))) {
+    rc = builtin_posix_stripe_path (data_root, context, posix_dataset->ds_root_paths + posix_dataset->ds_root_count,
+                                    hioi_object_identifier (&posix_dataset->base.ds_object), posix_dataset->base.ds_id);
+    posix_dataset->ds_root_count++;
+  }
+
+  free (data_roots);
+
+  return rc;
+}
+
+static void builtin_posix_release_data_roots (builtin_posix_module_dataset_t *posix_dataset) {
+  for (int i = 0 ; i < posix_dataset->ds_root_count ; ++i) {
+    free (posix_dataset->ds_root_paths[i]);
+  }
+
+  free (posix_dataset->ds_root_paths);
+  posix_dataset->ds_root_paths = NULL;
+  posix_dataset->ds_root_count = 0;
+
+  free (posix_dataset->ds_data_roots);
+  posix_dataset->ds_data_roots = NULL;
+}
+
+/**
+ * Select the data roots that will hold data files for a new dataset
+ *
+ * Rank 0 picks all data roots that are directories and have not recently failed and
+ * weighs them by their measured write bandwidth (see hioi_context_select_module).
+ * Each node then writes its data file to a data root chosen by its position in the
+ * job so that the amount of data sent to each root is roughly proportional to its
+ * bandwidth. This function is collective.
+ */
+static int builtin_posix_setup_data_roots (builtin_posix_module_t *posix_module,
+                                           builtin_posix_module_dataset_t *posix_dataset) {
+  hio_dataset_t dataset = &posix_dataset->base;
+  hio_context_t context = hioi_object_context (&dataset->ds_object);
+  double weights[HIO_MAX_DATA_ROOTS], position, total = 0.0;
+  int rc = HIO_SUCCESS, count = 0;
+
+  if (0 == context->c_rank) {
+    double known_bandwidth = 0.0;
+    size_t roots_len = 0;
+    int roots[HIO_MAX_DATA_ROOTS], known = 0;
+
+    /* the dataset's data root is always first */
+    for (int i = 0 ; i < context->c_mcount ; ++i) {
+      if (&posix_module->base == context->c_modules[i]) {
+        roots[count++] = i;
+        break;
+      }
+    }
+
+    for (int i = 0 ; i < context->c_mcount ; ++i) {
+      hio_module_stats_t *stats = context->c_module_stats + i;
+      struct stat statinfo;
+
+      if (&posix_module->base == context->c_modules[i] || stats->ms_failures || 0 == stats->ms_bavail ||
+          stat (context->c_modules[i]->data_root, &statinfo) || !S_ISDIR(statinfo.st_mode)) {
+        continue;
+      }
+
+      roots[count++] = i;
+    }
+
+    for (int i = 0 ; i < count ; ++i) {
+      if (context->c_module_stats[roots[i]].ms_bandwidth > 0.0) {
+        known_bandwidth += context->c_module_stats[roots[i]].ms_bandwidth;
+        ++known;
+      }
+    }
+
+    /* data roots that have not been measured are assumed to perform like the average data root */
+    known_bandwidth = known ? known_bandwidth / (double) known : 1.0;
+
+    for (int i = 0 ; i < count ; ++i) {
+      double bandwidth = context->c_module_stats[roots[i]].ms_bandwidth;
+      weights[i] = (bandwidth > 0.0) ? bandwidth : known_bandwidth;
+      roots_len += strlen (context->c_modules[roots[i]]->data_root) + 1;
+    }
+
+    free (posix_dataset->ds_data_roots);
+    posix_dataset->ds_data_roots = calloc (1, roots_len + 1);
+    assert (NULL != posix_dataset->ds_data_roots);
+
+    for (int i = 0 ; i < count ; ++i) {
+      if (i) {
+        strcat (posix_dataset->ds_data_roots, ",");
+
+        /* create the data directory on the secondary data root */
+        char *path;
+        rc = builtin_posix_stripe_path (context->c_modules[roots[i]]->data_root, context, &path,
+                                        hioi_object_identifier (&dataset->ds_object), dataset->ds_id);
+        if (HIO_SUCCESS == rc) {
+          char *data_path;
+
+          rc = asprintf (&data_path, "%s/data", path);
+          free (path);
+          if (0 > rc) {
+            rc = HIO_ERR_OUT_OF_RESOURCE;
+            break;
+          }
+
+          rc = hioi_mkpath (context, data_path, posix_module->access_mode);
+          if (0 > rc && EEXIST != errno) {
+            hioi_err_push (hioi_err_errno (errno), &context->c_object, "posix: error creating data directory: %s",
+                           data_path);
+            rc = hioi_err_errno (errno);
+          } else {
+            rc = HIO_SUCCESS;
+          }
+          free (data_path);
+        }
+
+        if (HIO_SUCCESS != rc) {
+          break;
+        }
+      }
+
+      strcat (posix_dataset->ds_data_roots, context->c_modules[roots[i]]->data_root);
+    }
+
+    if (HIO_SUCCESS != rc) {
+      /* fall back on writing everything to the dataset's data root */
+      posix_dataset->ds_data_roots[0] = '\0';
+      count = 0;
+      rc = HIO_SUCCESS;
+    }
+
+    hioi_log (context, HIO_VERBOSE_DEBUG_LOW, "posix:dataset_open: distributing data files across data roots: %s",
+              posix_dataset->ds_data_roots);
+  }
+
+#if HIO_MPI_HAVE(1)
+  if (hioi_context_using_mpi (context)) {
+    (void) hioi_string_scatter (context, &posix_dataset->ds_data_roots);
+    MPI_Bcast (&count, 1, MPI_INT, 0, context->c_comm);
+    MPI_Bcast (weights, count, MPI_DOUBLE, 0, context->c_comm);
+  }
+#endif
+
+  posix_dataset->ds_write_root = 0;
+
+  if (count < 2) {
+    /* nothing to distribute */
+    return HIO_SUCCESS;
+  }
+
+  rc = builtin_posix_parse_data_roots (posix_dataset);
+  if (HIO_SUCCESS != rc) {
+    return rc;
+  }
+
+  /* every rank on a node must pick the same data root as the node's file is shared */
+  position = ((double) dataset->ds_shared_control->s_master + 0.5) / (double) context->c_size;
+
+  for (int i = 0 ; i < count ; ++i) {
+    total += weights[i];
+  }
+
+  for (int i = 0 ; i < count ; ++i) {
+    position -= weights[i] / total;
+    if (position < 0.0 || i == count - 1) {
+      posix_dataset->ds_write_root = i;
+      break;
+    }
+  }
+
+  return HIO_SUCCESS;
+}
+
 static int builtin_posix_create_dataset_dirs (builtin_posix_module_t *posix_module, builtin_posix_module_dataset_t *posix_dataset) {
   mode_t access_mode = posix_module->access_mode;
   hio_context_t context = posix_module->base.context;
@@ -167,7 +701,10 @@ int builtin_posix_module_dataset_list_internal (struct hio_module_t *module, con
                                                 hio_dataset_header_t **headers, int *count) {
   hio_context_t context = module->context;
   int num_set_ids = 0, set_id_index = *count;
+  builtin_posix_catalog_record_t *catalog, key;
+  size_t catalog_count, catalog_hits = 0;
   hio_manifest_t manifest = NULL;
+  bool catalog_stale, catalog_valid;
   int rc = HIO_SUCCESS;
   void *tmp;
   struct dirent *dp;
@@ -182,6 +719,13 @@ int builtin_posix_module_dataset_list_internal (struct hio_module_t *module, con
     return HIO_ERR_OUT_OF_RESOURCE;
   }
 
+  rc = HIO_SUCCESS;
+
+  /* the catalog is used for all ids that are in it. it is rewritten if the directory scan
+   * finds ids that are not in the catalog or ids in the catalog have been removed */
+  catalog_valid = HIO_SUCCESS == builtin_posix_catalog_read (module, name, &catalog, &catalog_count);
+  catalog_stale = !catalog_valid;
+
   do {
     dir = opendir (path);
     if (NULL == dir) {
@@ -229,13 +773,31 @@ int builtin_posix_module_dataset_list_internal (struct hio_module_t *module, con
       hioi_log (context, HIO_VERBOSE_DEBUG_MED, "posix:dataset_list: processing dataset %s::%" PRId64,
                 name, ds_id);
 
-      rc = asprintf (&manifest_path, "%s/%s/manifest.json.bz2", path, dp->d_name);
+      key.cr_id = ds_id;
+      if (catalog_count) {
+        builtin_posix_catalog_record_t *record = bsearch (&key, catalog, catalog_count, sizeof (*catalog),
+                                                          builtin_posix_catalog_record_compare);
+        if (NULL != record) {
+          snprintf (header->ds_name, sizeof (header->ds_name), "%s", name);
+          header->ds_id = ds_id;
+          header->ds_mtime = (time_t) record->cr_mtime;
+          header->ds_mode = record->cr_mode;
+          header->ds_status = record->cr_status;
+          ++catalog_hits;
+          ++set_id_index;
+          continue;
+        }
+      }
+
+      catalog_stale = true;
+
+      rc = asprintf (&tmp, "%s/%s", path, dp->d_name);
       assert (0 <= rc);
 
-      if (F_OK != access (manifest_path, R_OK)) {
-        free (manifest_path);
-        rc = asprintf (&manifest_path, "%s/%s/manifest.json", path, dp->d_name);
-        assert (0 <= rc);
+      rc = builtin_posix_manifest_path (tmp, -1, &manifest_path);
+      free (tmp);
+      if (HIO_ERR_OUT_OF_RESOURCE == rc) {
+        break;
       }
 
       rc = hioi_manifest_read (context, manifest_path, &manifest);
@@ -252,7 +814,7 @@ int builtin_posix_module_dataset_list_internal (struct hio_module_t *module, con
         }
 
         /* directory exists but there is a broken/no manifest. still include this manifest in the list */
-        strncpy (header->ds_name, name, sizeof (header->ds_name));
+        snprintf (header->ds_name, sizeof (header->ds_name), "%s", name);
         header->ds_id = ds_id;
         header->ds_status = HIO_ERR_NOT_AVAILABLE;
         header->ds_mtime = 0;
@@ -267,85 +829,92 @@ int builtin_posix_module_dataset_list_internal (struct hio_module_t *module, con
     }
 
     num_set_ids = set_id_index;
+
+    if (HIO_SUCCESS == rc && (catalog_stale || catalog_hits != catalog_count)) {
+      builtin_posix_catalog_record_t *records;
+      size_t record_count = 0;
+
+      /* rebuild the catalog. ids without a valid manifest (incomplete or broken datasets) are
+       * left out so they are checked again the next time */
+      records = malloc ((num_set_ids - *count + 1) * sizeof (*records));
+      if (NULL != records) {
+        for (int i = *count ; i < num_set_ids ; ++i) {
+          hio_dataset_header_t *header = headers[0] + i;
+
+          if (HIO_ERR_NOT_AVAILABLE == header->ds_status) {
+            continue;
+          }
+
+          records[record_count].cr_id = header->ds_id;
+          records[record_count].cr_mtime = (int64_t) header->ds_mtime;
+          records[record_count].cr_mode = header->ds_mode;
+          records[record_count++].cr_status = header->ds_status;
+        }
+
+        qsort (records, record_count, sizeof (*records), builtin_posix_catalog_record_compare);
+
+        /* incomplete ids are never in the catalog so only write it if the contents changed */
+        if (!catalog_valid || record_count != catalog_count ||
+            (record_count && memcmp (records, catalog, record_count * sizeof (*records)))) {
+          (void) builtin_posix_catalog_write (module, name, records, record_count);
+        }
+
+        free (records);
+      }
+    }
   } while (0);
 
+  free (catalog);
+
   if (dir) {
     closedir (dir);
   }
 
   free (path);
 
-  *count = num_set_ids;
+  /* keep the headers found on other data roots if this data root has no ids */
+  *count = set_id_index;
 
   return rc;
 }
 
 static int builtin_posix_module_dataset_list (struct hio_module_t *module, const char *name,
                                               hio_dataset_header_t **headers, int *count) {
-  int rc = HIO_SUCCESS, num_sets = *count, new_sets;
   hio_context_t context = module->context;
+  int rc = HIO_SUCCESS, num_sets = *count;
   struct dirent *dp;
   char *path = NULL;
   DIR *dir;
 
-  if (0 == context->c_rank) {
-    if (NULL == name) {
-      /* find all datasets in the context */
-      rc = asprintf (&path, "%s/%s.hio", module->data_root, hioi_object_identifier(context));
-      assert (0 <= rc);
+  if (NULL == name) {
+    /* find all datasets in the context */
+    rc = asprintf (&path, "%s/%s.hio", module->data_root, hioi_object_identifier(context));
+    assert (0 <= rc);
 
-      dir = opendir (path);
-      free (path);
-      if (NULL == dir) {
-        return HIO_ERR_NOT_FOUND;
-      }
+    dir = opendir (path);
+    free (path);
+    if (NULL == dir) {
+      return HIO_ERR_NOT_FOUND;
+    }
 
-      while (NULL != (dp = readdir (dir))) {
-        if ('.' == dp->d_name[0]) {
-          continue;
-        }
-
-        rc = builtin_posix_module_dataset_list_internal (module, dp->d_name, headers, &num_sets);
+    while (NULL != (dp = readdir (dir))) {
+      if ('.' == dp->d_name[0]) {
+        continue;
       }
 
-      closedir (dir);
-    } else {
-      rc = builtin_posix_module_dataset_list_internal (module, name, headers, &num_sets);
-    }
-
-    if (HIO_SUCCESS != rc) {
-      num_sets = rc;
+      rc = builtin_posix_module_dataset_list_internal (module, dp->d_name, headers, &num_sets);
     }
-  }
-
-#if HIO_MPI_HAVE(1)
-  if (hioi_context_using_mpi (context)) {
-    MPI_Bcast (&num_sets, 1, MPI_INT, 0, context->c_comm);
-  }
-#endif
-
-  new_sets = num_sets - *count;
-
-  if (0 == new_sets) {
-    return HIO_SUCCESS;
-  }
-
-  if (0 > num_sets) {
-    return num_sets;
-  }
 
-  if (0 != context->c_rank) {
-    *headers = (hio_dataset_header_t *) realloc (*headers, num_sets * sizeof (**headers));
-    assert (NULL != *headers);
+    closedir (dir);
+  } else {
+    rc = builtin_posix_module_dataset_list_internal (module, name, headers, &num_sets);
   }
 
-#if HIO_MPI_HAVE(1)
-  if (hioi_context_using_mpi (context)) {
-    MPI_Bcast (*headers + *count, sizeof (**headers) * new_sets, MPI_BYTE, 0, context->c_comm);
+  if (HIO_SUCCESS != rc) {
+    return rc;
   }
-#endif
 
-  /* set the correct module pointer for this rank */
+  /* set the correct module pointer */
   for (int i = *count ; i < num_sets ; ++i) {
     headers[0][i].module = module;
   }
@@ -367,19 +936,10 @@ static int builtin_posix_module_dataset_dump_specific (struct hio_module_t *modu
     return HIO_ERR_OUT_OF_RESOURCE;
   }
 
-  rc = asprintf (&manifest_path, "%s/manifest.json.bz2", path);
-  if (0 > rc) {
+  rc = builtin_posix_manifest_path (path, -1, &manifest_path);
+  if (HIO_ERR_OUT_OF_RESOURCE == rc) {
     free (path);
-    return HIO_ERR_OUT_OF_RESOURCE;
-  }
-
-  if (F_OK != access (manifest_path, R_OK)) {
-    free (manifest_path);
-    rc = asprintf (&manifest_path, "%s/manifest.json", path);
-    if (0 > rc) {
-      free (path);
-      return HIO_ERR_OUT_OF_RESOURCE;
-    }
+    return rc;
   }
 
   rc = hioi_manifest_read (context, manifest_path, &manifest);
@@ -398,15 +958,8 @@ static int builtin_posix_module_dataset_dump_specific (struct hio_module_t *modu
     rc = builtin_posix_module_dataset_manifest_list_all (path, &manifest_ids, &manifest_count, 1);
     if (HIO_SUCCESS == rc) {
       for (size_t i = 0 ; i < manifest_count ; ++i) {
-        /* check for compressed manifest first */
-        rc = asprintf (&manifest_path, "%s/manifest.%x.json.bz2", path, manifest_ids[i]);
-        assert (0 < rc);
-        if (F_OK != access(manifest_path, R_OK)) {
-          free (manifest_path);
-          /* compressed manifest not found. see if an uncompressed manifest exists */
-          rc = asprintf (&manifest_path, "%s/manifest.%x.json", path, manifest_ids[i]);
-          assert (0 < rc);
-        }
+        rc = builtin_posix_manifest_path (path, manifest_ids[i], &manifest_path);
+        assert (HIO_ERR_OUT_OF_RESOURCE != rc);
 
         rc = hioi_manifest_read (context, manifest_path, &manifest2);
         free (manifest_path);
@@ -759,13 +1312,158 @@ static int builtin_posix_module_setup_striping (hio_context_t context, struct hi
 }
 
 #if HIO_MPI_HAVE(3)
+/** state shared by the manifest reader threads */
+typedef struct builtin_posix_manifest_reader_t {
+  builtin_posix_module_dataset_t *posix_dataset;
+  /** ids of the manifests to read */
+  const int *manifest_ids;
+  /** number of manifests to read */
+  size_t count;
+  /** binary image of each manifest. after the reduction the first slot holds
+   * the merged image */
+  unsigned char **images;
+  size_t *image_sizes;
+  /** codec statistics of each manifest */
+  hio_manifest_codec_stats_t *stats;
+  /** next work item */
+  atomic_ulong next;
+  /** number of work items in the current phase */
+  size_t work_count;
+  /** distance between merged slots in the current reduction round */
+  size_t stride;
+  /** synchronizes the phases */
+  pthread_barrier_t barrier;
+  /** held while the threads are started */
+  pthread_mutex_t gate;
+  /** result of the last work item on each slot. each slot is written by one thread per phase */
+  int *rcs;
+  /** first error encountered. only updated by the thread that sets up the next phase */
+  int rc;
+} builtin_posix_manifest_reader_t;
+
+static void builtin_posix_manifest_reader_read (builtin_posix_manifest_reader_t *reader, size_t index) {
+  builtin_posix_module_dataset_t *posix_dataset = reader->posix_dataset;
+  hio_context_t context = hioi_object_context ((hio_object_t) posix_dataset);
+  hio_manifest_t manifest;
+  char *path;
+  int rc;
+
+  hioi_log (context, HIO_VERBOSE_DEBUG_LOW, "posix:dataset_open: reading manifest data from id %x\n",
+            reader->manifest_ids[index]);
+
+  /* when writing the dataset in file_per_node mode each rank writes its own manifest. try
+   * to open the manifest. if a manifest does not exist then it is likely this rank did not
+   * write a manifest. ranks that read a manifest will distribute the manifest data to the
+   * appropriate ranks in hioi_dataset_scatter(). */
+  rc = builtin_posix_manifest_path (posix_dataset->base_path, reader->manifest_ids[index], &path);
+  if (HIO_SUCCESS != rc) {
+    /* this might be a real error. we were told to read from a manifest but we couldn't
+     * find it! */
+    free (path);
+    return;
+  }
+
+  /* read the manifest and convert it to a binary image for the reduction */
+  rc = hioi_manifest_read (context, path, &manifest);
+  free (path);
+  if (HIO_SUCCESS == rc) {
+    rc = hioi_manifest_take_binary (manifest, reader->images + index, reader->image_sizes + index);
+    reader->stats[index] = manifest->codec_stats;
+    hioi_manifest_release (manifest);
+  }
+
+  reader->rcs[index] = rc;
+}
+
+static void builtin_posix_manifest_reader_merge (builtin_posix_manifest_reader_t *reader, size_t index) {
+  size_t first = index * 2 * reader->stride, second = first + reader->stride;
+  const unsigned char *images[2] = {reader->images[first], reader->images[second]};
+  size_t image_sizes[2] = {reader->image_sizes[first], reader->image_sizes[second]};
+  unsigned char *merged;
+  size_t merged_size;
+  int rc;
+
+  if (NULL == images[1]) {
+    return;
+  }
+
+  if (NULL == images[0]) {
+    /* nothing to merge. move the image */
+    reader->images[first] = reader->images[second];
+    reader->image_sizes[first] = reader->image_sizes[second];
+    reader->images[second] = NULL;
+    return;
+  }
+
+  /* the segment runs in each image are sorted so this is a linear merge */
+  rc = hioi_manifest_binary_merge (images, image_sizes, 2, &merged, &merged_size);
+  if (HIO_SUCCESS != rc) {
+    reader->rcs[first] = rc;
+    return;
+  }
+
+  free (reader->images[first]);
+  free (reader->images[second]);
+  reader->images[first] = merged;
+  reader->image_sizes[first] = merged_size;
+  reader->images[second] = NULL;
+}
+
+/**
+ * @brief Manifest reader thread
+ *
+ * Threads first read (and decompress) manifests then merge the resulting images
+ * with a tree reduction. Work items in each phase are claimed with an atomic
+ * counter. The first thread through the barrier sets up the next phase.
+ */
+static void *builtin_posix_manifest_reader_thread (void *arg) {
+  builtin_posix_manifest_reader_t *reader = (builtin_posix_manifest_reader_t *) arg;
+  bool read_phase = true;
+
+  /* wait until all threads have been started and the barrier is set up */
+  pthread_mutex_lock (&reader->gate);
+  pthread_mutex_unlock (&reader->gate);
+
+  do {
+    for (size_t index = atomic_fetch_add (&reader->next, 1) ; index < reader->work_count ;
+         index = atomic_fetch_add (&reader->next, 1)) {
+      if (read_phase) {
+        builtin_posix_manifest_reader_read (reader, index);
+      } else {
+        builtin_posix_manifest_reader_merge (reader, index);
+      }
+    }
+
+    if (PTHREAD_BARRIER_SERIAL_THREAD == pthread_barrier_wait (&reader->barrier)) {
+      /* all work items in this phase are complete. collect the first error */
+      for (size_t i = 0 ; i < reader->count && HIO_SUCCESS == reader->rc ; ++i) {
+        reader->rc = reader->rcs[i];
+      }
+
+      reader->stride = read_phase ? 1 : reader->stride * 2;
+      /* number of pairs (first, first + stride) in this round */
+      reader->work_count = (reader->stride < reader->count && HIO_SUCCESS == reader->rc) ?
+        (reader->count - reader->stride + 2 * reader->stride - 1) / (2 * reader->stride) : 0;
+      reader->next = 0;
+    }
+
+    read_phase = false;
+
+    pthread_barrier_wait (&reader->barrier);
+  } while (reader->work_count);
+
+  return NULL;
+}
+
 static int bultin_posix_scatter_data (builtin_posix_module_dataset_t *posix_dataset) {
   hio_context_t context = hioi_object_context ((hio_object_t) posix_dataset);
-  hio_manifest_t manifest = NULL, manifest2;
+  builtin_posix_manifest_reader_t reader = {.posix_dataset = posix_dataset, .rc = HIO_SUCCESS};
+  hio_manifest_t manifest = NULL;
   size_t manifest_id_count = 0;
-  int rc = HIO_SUCCESS;
+  int rc = HIO_SUCCESS, thread_count;
+  pthread_t *threads = NULL;
+  uint64_t start = hioi_gettime (), read_time;
   int *manifest_ids;
-  char *path;
 
   if (HIO_SET_ELEMENT_UNIQUE == posix_dataset->base.ds_mode) {
     /* only read the manifest this rank wrote */
@@ -779,55 +1477,92 @@ static int bultin_posix_scatter_data (builtin_posix_module_dataset_t *posix_data
     }
   }
 
+  /* the id list may be terminated early by -1 */
   for (size_t i = 0 ; i < manifest_id_count ; ++i) {
     if (-1 == manifest_ids[i]) {
-      /* nothing more to do */
+      manifest_id_count = i;
       break;
     }
+  }
 
-    hioi_log (context, HIO_VERBOSE_DEBUG_LOW, "posix:dataset_open: reading manifest data from id %x\n",
-              manifest_ids[i]);
+  if (manifest_id_count) {
+    reader.manifest_ids = manifest_ids;
+    reader.count = reader.work_count = manifest_id_count;
+    reader.images = calloc (manifest_id_count, sizeof (reader.images[0]));
+    reader.image_sizes = calloc (manifest_id_count, sizeof (reader.image_sizes[0]));
+    reader.stats = calloc (manifest_id_count, sizeof (reader.stats[0]));
+    reader.rcs = calloc (manifest_id_count, sizeof (reader.rcs[0]));
 
-    /* when writing the dataset in file_per_node mode each IO manager writes its own manifest. try
-     * to open the manifest. if a manifest does not exist then it is likely this rank did not
-     * write a manifest. IO managers will distribute the manifest data to the appropriate ranks
-     * in hioi_dataset_scatter(). */
-    rc = asprintf (&path, "%s/manifest.%x.json.bz2", posix_dataset->base_path, manifest_ids[i]);
-    assert (0 < rc);
+    thread_count = posix_dataset->ds_manifest_read_threads;
+    if (thread_count < 1) {
+      thread_count = 1;
+    } else if ((size_t) thread_count > manifest_id_count) {
+      thread_count = manifest_id_count;
+    }
 
-    if (access (path, F_OK)) {
-      free (path);
-      /* Check for a non-bzip'd manifest file. */
-      rc = asprintf (&path, "%s/manifest.%x.json", posix_dataset->base_path, manifest_ids[i]);
-      assert (0 < rc);
-      if (access (path, F_OK)) {
-        /* this might be a real error. we were told to read from a manifest but we couldn't
-         * find it! */
-        free (path);
-        path = NULL;
-      }
+    threads = calloc (thread_count, sizeof (threads[0]));
+    if (NULL == reader.images || NULL == reader.image_sizes || NULL == reader.stats || NULL == reader.rcs ||
+        NULL == threads) {
+      rc = HIO_ERR_OUT_OF_RESOURCE;
     }
+  }
 
-    if (path) {
-      /* read the manifest if it exists */
-      rc = hioi_manifest_read (context, path, &manifest2);
-      if (HIO_SUCCESS == rc) {
-        if (NULL != manifest) {
-          rc = hioi_manifest_merge_data (manifest, manifest2);
-          hioi_manifest_release (manifest2);
-        } else {
-          manifest = manifest2;
-        }
+  if (HIO_SUCCESS == rc && manifest_id_count) {
+    pthread_mutex_init (&reader.gate, NULL);
+    pthread_mutex_lock (&reader.gate);
+
+    /* this thread participates as well */
+    for (int i = 1 ; i < thread_count ; ++i) {
+      if (0 != pthread_create (threads + i, NULL, builtin_posix_manifest_reader_thread, &reader)) {
+        /* continue with the threads that were started */
+        hioi_log (context, HIO_VERBOSE_WARN, "posix:dataset_open: could only start %d manifest reader threads", i);
+        thread_count = i;
+        break;
       }
+    }
 
-      free (path);
+    pthread_barrier_init (&reader.barrier, NULL, thread_count);
+    pthread_mutex_unlock (&reader.gate);
 
-      if (HIO_SUCCESS != rc) {
-        break;
+    (void) builtin_posix_manifest_reader_thread (&reader);
+
+    for (int i = 1 ; i < thread_count ; ++i) {
+      pthread_join (threads[i], NULL);
+    }
+
+    pthread_barrier_destroy (&reader.barrier);
+    pthread_mutex_destroy (&reader.gate);
+
+    for (size_t i = 0 ; i < manifest_id_count ; ++i) {
+      builtin_posix_codec_stats (posix_dataset, reader.stats + i);
+    }
+
+    rc = reader.rc;
+    if (HIO_SUCCESS == rc && NULL != reader.images[0]) {
+      rc = hioi_manifest_create_binary (context, reader.images[0], reader.image_sizes[0], &manifest);
+      if (HIO_SUCCESS == rc) {
+        reader.images[0] = NULL;
       }
     }
   }
 
+  if (NULL != reader.images) {
+    for (size_t i = 0 ; i < manifest_id_count ; ++i) {
+      free (reader.images[i]);
+    }
+  }
+
+  free (reader.images);
+  free (reader.image_sizes);
+  free (reader.stats);
+  free (reader.rcs);
+  free (threads);
+
+  read_time = hioi_gettime () - start;
+
+  hioi_log (context, HIO_VERBOSE_DEBUG_LOW, "posix:dataset_open: read %lu data manifests in %" PRIu64 " usec",
+            (unsigned long) manifest_id_count, read_time);
+
   /* share dataset information with all processes on this node */
   if (HIO_SET_ELEMENT_UNIQUE == posix_dataset->base.ds_mode) {
     rc = hioi_dataset_scatter_unique (&posix_dataset->base, manifest, rc);
@@ -835,6 +1570,10 @@ static int bultin_posix_scatter_data (builtin_posix_module_dataset_t *posix_data
     rc = hioi_dataset_scatter_comm (&posix_dataset->base, context->c_shared_comm, manifest, rc);
   }
 
+  /* loading the manifest overwrote the codec statistics and the read time */
+  builtin_posix_codec_stats (posix_dataset, NULL);
+  posix_dataset->ds_manifest_read_time = read_time;
+
   free (manifest_ids);
 
   if (manifest) {
@@ -894,33 +1633,90 @@ static int builtin_posix_module_dataset_open (struct hio_module_t *module, hio_d
                    ", 1: stdio (fread/fwrite), or 2: pposix (pread/pwrite). The default is to use "
                    "posix", 0);
 
+  posix_dataset->ds_read_gap = 65536;
+  hioi_config_add (context, &dataset->ds_object, &posix_dataset->ds_read_gap,
+                   "posix_read_coalesce_gap", NULL, HIO_CONFIG_TYPE_UINT64, NULL, "Largest gap (bytes) "
+                   "between two non-blocking reads that will be merged into a single file read when the "
+                   "reads are completed", 0);
+
+  posix_dataset->ds_read_max = 16777216;
+  hioi_config_add (context, &dataset->ds_object, &posix_dataset->ds_read_max,
+                   "posix_read_coalesce_max", NULL, HIO_CONFIG_TYPE_UINT64, NULL, "Largest file read (bytes) "
+                   "that will be formed by merging non-blocking reads. Set to 0 to disable merging", 0);
+
+  posix_dataset->ds_manifest_format = HIO_MANIFEST_FORMAT_JSON;
+  hioi_config_add (context, &dataset->ds_object, &posix_dataset->ds_manifest_format,
+                   "dataset_manifest_format", NULL, HIO_CONFIG_TYPE_INT32, &builtin_posix_manifest_formats,
+                   "Format to use when writing dataset manifests. Valid values: json, binary (uncompressed "
+                   "image that is mapped and loaded without parsing). Manifests in either format can be read "
+                   "regardless of this setting", 0);
+
+  /* the file mode of a dataset opened for reading is not known until its manifest is
+   * loaded so these are registered in every mode */
+  posix_dataset->ds_manifest_read_threads = 8;
+  hioi_config_add (context, &dataset->ds_object, &posix_dataset->ds_manifest_read_threads,
+                   "dataset_manifest_read_threads", NULL, HIO_CONFIG_TYPE_INT32, NULL,
+                   "Number of threads to use to read and merge data manifests when opening a file_per_node "
+                   "dataset for reading", HIO_VAR_FLAG_LOCAL);
+
+  hioi_perf_add (context, &dataset->ds_object, &posix_dataset->ds_manifest_read_time, "manifest_read_time_usec",
+                 HIO_CONFIG_TYPE_UINT64, NULL, "Time spent reading and merging data manifests when opening "
+                 "a dataset", 0);
+
   if (HIO_FILE_MODE_OPTIMIZED == posix_dataset->ds_fmode) {
-    posix_dataset->ds_use_bzip = true;
-    hioi_config_add (context, &dataset->ds_object, &posix_dataset->ds_use_bzip,
-                     "dataset_use_bzip", NULL, HIO_CONFIG_TYPE_BOOL, NULL,
-                     "Use bzip2 compression for dataset manifests", 0);
+    posix_dataset->ds_manifest_codec = HIO_MANIFEST_CODEC_BZIP2;
+    hioi_config_add (context, &dataset->ds_object, &posix_dataset->ds_manifest_codec,
+                     "dataset_use_bzip", NULL, HIO_CONFIG_TYPE_INT32, &builtin_posix_manifest_codecs,
+                     "Codec to use to compress json data manifests. Valid values: none (false), bzip2 "
+                     "(true, best compression), lz (fast). Manifests written with any codec can be read "
+                     "regardless of this setting", 0);
+
+    hioi_perf_add (context, &dataset->ds_object, &posix_dataset->ds_codec_time, "manifest_codec_time_usec",
+                   HIO_CONFIG_TYPE_UINT64, NULL, "Time spent compressing or decompressing data manifests", 0);
+
+    hioi_perf_add (context, &dataset->ds_object, &posix_dataset->ds_codec_ratio, "manifest_compression_ratio",
+                   HIO_CONFIG_TYPE_DOUBLE, NULL, "Ratio of uncompressed to compressed data manifest size", 0);
+
+    posix_dataset->ds_stripe_roots = false;
+    hioi_config_add (context, &dataset->ds_object, &posix_dataset->ds_stripe_roots,
+                     "dataset_stripe_data_roots", NULL, HIO_CONFIG_TYPE_BOOL, NULL,
+                     "Distribute the data files of a new dataset across all available data roots in "
+                     "proportion to their measured write bandwidth (default: false)", 0);
+
+    posix_dataset->ds_data_checksum = false;
+    hioi_config_add (context, &dataset->ds_object, &posix_dataset->ds_data_checksum,
+                     "dataset_data_checksum", NULL, HIO_CONFIG_TYPE_BOOL, NULL,
+                     "Compute a crc32c checksum of each data segment when it is written and store it in "
+                     "the manifest. Reads that cover a whole segment are verified against the checksum "
+                     "(default: false)", 0);
+
+    /* set when the dataset is created. the value is restored from the manifest when the dataset
+     * is opened for reading */
+    posix_dataset->ds_data_roots = strdup ("");
+    hioi_config_add (context, &dataset->ds_object, &posix_dataset->ds_data_roots,
+                     "dataset_data_roots", NULL, HIO_CONFIG_TYPE_STRING, NULL,
+                     "Comma-separated list of data roots holding data files for this dataset", 0);
   }
 
   if (dataset->ds_flags & HIO_FLAG_TRUNC) {
     /* blow away the existing dataset */
     if (0 == context->c_rank) {
+      /* the old data is moved out of the way first so it can be removed in the background */
       (void) builtin_posix_module_dataset_unlink (module, hioi_object_identifier(dataset),
-                                                  dataset->ds_id);
+                                                  dataset->ds_id, HIO_UNLINK_MODE_ASYNC);
     }
   }
 
   if (!(dataset->ds_flags & HIO_FLAG_CREAT)) {
     if (0 == context->c_rank) {
       /* load manifest. the manifest data will be shared with other processes in hioi_dataset_scatter */
-      rc = asprintf (&path, "%s/manifest.json", posix_dataset->base_path);
-      assert (0 < rc);
-      if (access (path, F_OK)) {
+      rc = builtin_posix_manifest_path (posix_dataset->base_path, -1, &path);
+      if (HIO_SUCCESS != rc) {
         /* this should never happen on a valid dataset */
-        free (path);
         hioi_log (context, HIO_VERBOSE_DEBUG_LOW, "posix:dataset_open: could not find top-level manifest %s", path);
+        free (path);
+        path = NULL;
         rc = HIO_ERR_NOT_FOUND;
-      } else {
-        rc = HIO_SUCCESS;
       }
     }
 
@@ -961,19 +1757,26 @@ static int builtin_posix_module_dataset_open (struct hio_module_t *module, hio_d
   if (context->c_enable_tracing) {
     char *path;
 
-    rc = asprintf (&path, "%s/trace/posix/trace.%d", posix_dataset->base_path, context->c_rank);
+    rc = asprintf (&path, "%s/trace/posix/trace.%d.bin", posix_dataset->base_path, context->c_rank);
     if (rc > 0) {
-      posix_dataset->ds_trace_fh = fopen (path, "a");
+      rc = hioi_trace_open (&posix_dataset->ds_trace, path, hioi_object_identifier (dataset), dataset->ds_id,
+                            context->c_rank);
+      if (HIO_SUCCESS != rc) {
+        hioi_log (context, HIO_VERBOSE_WARN, "posix:dataset_open: could not open trace file %s. error: %d",
+                  path, rc);
+      }
       free (path);
     }
 
-    builtin_posix_trace (posix_dataset, "trace_begin", 0, 0, 0, 0);
+    uint64_t now = hioi_gettime_ns ();
+    builtin_posix_trace (posix_dataset, HIO_TRACE_EVENT_TRACE_BEGIN, 0, 0, now, now);
   }
 
 #if HIO_MPI_HAVE(3)
   if (!(dataset->ds_flags & HIO_FLAG_CREAT) && HIO_FILE_MODE_OPTIMIZED == posix_dataset->ds_fmode) {
     rc = bultin_posix_scatter_data (posix_dataset);
     if (HIO_SUCCESS != rc) {
+      hioi_trace_close (posix_dataset->ds_trace);
       free (posix_dataset->base_path);
       return rc;
     }
@@ -981,7 +1784,7 @@ static int builtin_posix_module_dataset_open (struct hio_module_t *module, hio_d
 
   /* if possible set up a shared memory window for this dataset */
   if (HIO_FILE_MODE_BASIC != posix_dataset->ds_fmode || HIO_SET_ELEMENT_SHARED == dataset->ds_mode) {
-    POSIX_TRACE_CALL(posix_dataset, hioi_dataset_shared_init (dataset, dataset->ds_fsattr.fs_scount * posix_dataset->ds_fcount), "shared_init", 0, 0);
+    POSIX_TRACE_CALL(posix_dataset, hioi_dataset_shared_init (dataset, dataset->ds_fsattr.fs_scount * posix_dataset->ds_fcount), HIO_TRACE_EVENT_SHARED_INIT, 0, 0);
   }
 
   if (HIO_FILE_MODE_OPTIMIZED == posix_dataset->ds_fmode) {
@@ -991,14 +1794,26 @@ static int builtin_posix_module_dataset_open (struct hio_module_t *module, hio_d
       hioi_log (context, HIO_VERBOSE_WARN, "posix:dataset_open: optimized file mode requested but not supported in this "
                 "dataset mode. falling back to basic file mode, path: %s", posix_dataset->base_path);
     } else if (HIO_SET_ELEMENT_SHARED == dataset->ds_mode) {
-      POSIX_TRACE_CALL(posix_dataset, rc = hioi_dataset_generate_map (dataset), "generate_map", 0, 0);
+      POSIX_TRACE_CALL(posix_dataset, rc = hioi_dataset_generate_map (dataset), HIO_TRACE_EVENT_GENERATE_MAP, 0, 0);
       if (HIO_SUCCESS != rc) {
+        hioi_trace_close (posix_dataset->ds_trace);
         free (posix_dataset->base_path);
         return rc;
       }
     }
   }
 
+  if (HIO_FILE_MODE_OPTIMIZED == posix_dataset->ds_fmode && (dataset->ds_flags & HIO_FLAG_CREAT) &&
+      posix_dataset->ds_stripe_roots) {
+    rc = builtin_posix_setup_data_roots (posix_module, posix_dataset);
+    if (HIO_SUCCESS != rc) {
+      builtin_posix_release_data_roots (posix_dataset);
+      hioi_trace_close (posix_dataset->ds_trace);
+      free (posix_dataset->base_path);
+      return rc;
+    }
+  }
+
   /* NTH: if requested more code is needed to load an optimized dataset with an older MPI */
 #endif /* HIO_MPI_HAVE(3) */
 
@@ -1006,6 +1821,8 @@ static int builtin_posix_module_dataset_open (struct hio_module_t *module, hio_d
   dataset->ds_close = builtin_posix_module_dataset_close;
   dataset->ds_element_open = builtin_posix_module_element_open;
   dataset->ds_process_reqs = builtin_posix_module_process_reqs;
+  dataset->ds_element_locate = builtin_posix_module_element_locate;
+  dataset->ds_element_list = builtin_posix_module_element_list;
 
   /* record the open time */
   gettimeofday (&dataset->ds_otime, NULL);
@@ -1017,7 +1834,7 @@ static int builtin_posix_module_dataset_open (struct hio_module_t *module, hio_d
             (dataset->ds_flags & HIO_FLAG_CREAT) ? "created" : "opened", hioi_object_identifier(dataset),
             dataset->ds_id, module->data_root, stop - start, posix_dataset->ds_fmode);
 
-  builtin_posix_trace (posix_dataset, "open", 0, 0, start, stop);
+  builtin_posix_trace (posix_dataset, HIO_TRACE_EVENT_OPEN, 0, 0, start * 1000, stop * 1000);
 
   return HIO_SUCCESS;
 }
@@ -1034,7 +1851,7 @@ static int builtin_posix_module_dataset_close (hio_dataset_t dataset) {
 
   for (int i = 0 ; i < HIO_POSIX_MAX_OPEN_FILES ; ++i) {
     if (posix_dataset->files[i].f_bid >= 0) {
-      POSIX_TRACE_CALL(posix_dataset, hioi_file_close (posix_dataset->files + i), "file_close",
+      POSIX_TRACE_CALL(posix_dataset, hioi_file_close (posix_dataset->files + i), HIO_TRACE_EVENT_FILE_CLOSE,
                        posix_dataset->files[i].f_bid, 0);
     }
   }
@@ -1052,49 +1869,59 @@ static int builtin_posix_module_dataset_close (hio_dataset_t dataset) {
 
     /* write manifest header */
     POSIX_TRACE_CALL(posix_dataset, rc = hioi_dataset_gather_manifest (dataset, &manifest, true),
-                     "gather_manifest", 0, 0);
+                     HIO_TRACE_EVENT_GATHER_MANIFEST, 0, 0);
     if (HIO_SUCCESS != rc) {
       dataset->ds_status = rc;
     }
 
     if (0 == context->c_rank) {
-      rc = asprintf (&path, "%s/manifest.json", posix_dataset->base_path);
+      rc = asprintf (&path, "%s/manifest%s", posix_dataset->base_path,
+                     (HIO_MANIFEST_FORMAT_BINARY == posix_dataset->ds_manifest_format) ?
+                     HIO_POSIX_MANIFEST_BINARY_SUFFIX : ".json");
       if (0 > rc) {
         /* out of memory. not much we can do now */
         return hioi_err_errno (errno);
       }
 
-      rc = hioi_manifest_save (manifest, false, path);
-      hioi_manifest_release (manifest);
+      rc = hioi_manifest_save (manifest, posix_dataset->ds_manifest_format, HIO_MANIFEST_CODEC_NONE, path);
       free (path);
       if (HIO_SUCCESS != rc) {
         hioi_err_push (rc, &dataset->ds_object, "posix: error writing dataset manifest");
+      } else {
+        hio_dataset_header_t header;
+
+        /* keep the catalog in sync with the manifest */
+        if (HIO_SUCCESS == hioi_manifest_read_header (manifest, &header)) {
+          builtin_posix_catalog_update (module, hioi_object_identifier (dataset), dataset->ds_id, &header);
+        }
       }
+      hioi_manifest_release (manifest);
     }
 
 #if HIO_MPI_HAVE(3)
     if (HIO_FILE_MODE_OPTIMIZED == posix_dataset->ds_fmode) {
-      /* optimized mode requires a data manifest to describe how the data landed on the filesystem */
-      POSIX_TRACE_CALL(posix_dataset, rc = hioi_dataset_gather_manifest_comm (dataset, context->c_shared_comm, &manifest,
-                                                                              false),
-                       "gather_manifest", 0, 0);
-      if (HIO_SUCCESS != rc) {
-        dataset->ds_status = rc;
-      }
-
-      if (NULL != manifest) {
+      hio_manifest_codec_stats_t codec_stats = {.cs_raw_bytes = 0};
+
+      /* optimized mode requires a data manifest to describe how the data landed on the filesystem. each
+       * rank streams its own data manifest straight from its elements. this avoids holding the manifest
+       * data of every rank on a node in memory. */
+      if (HIO_MANIFEST_FORMAT_BINARY == posix_dataset->ds_manifest_format) {
+        rc = asprintf (&path, "%s/manifest.%x" HIO_POSIX_MANIFEST_BINARY_SUFFIX, posix_dataset->base_path,
+                       context->c_rank);
+      } else {
         rc = asprintf (&path, "%s/manifest.%x.json%s", posix_dataset->base_path, context->c_rank,
-                       posix_dataset->ds_use_bzip ? ".bz2" : "");
-        if (0 > rc) {
-          return hioi_err_errno (errno);
-        }
+                       hioi_manifest_codec_suffix (posix_dataset->ds_manifest_codec));
+      }
+      if (0 > rc) {
+        return hioi_err_errno (errno);
+      }
 
-        rc = hioi_manifest_save (manifest, posix_dataset->ds_use_bzip, path);
-        hioi_manifest_release (manifest);
-        free (path);
-        if (HIO_SUCCESS != rc) {
-          hioi_err_push (rc, &dataset->ds_object, "posix: error writing dataset manifest");
-        }
+      rc = hioi_manifest_save_dataset (dataset, posix_dataset->ds_manifest_format, posix_dataset->ds_manifest_codec,
+                                       path, &codec_stats);
+      builtin_posix_codec_stats (posix_dataset, &codec_stats);
+      free (path);
+      if (HIO_SUCCESS != rc) {
+        hioi_err_push (rc, &dataset->ds_object, "posix: error writing dataset manifest");
       }
     }
 #endif
@@ -1107,123 +1934,92 @@ static int builtin_posix_module_dataset_close (hio_dataset_t dataset) {
   }
 #endif
 
+  builtin_posix_release_data_roots (posix_dataset);
   free (posix_dataset->base_path);
 
   stop = hioi_gettime ();
 
-  builtin_posix_trace (posix_dataset, "close", 0, 0, start, stop);
+  builtin_posix_trace (posix_dataset, HIO_TRACE_EVENT_CLOSE, 0, 0, start * 1000, stop * 1000);
 
   hioi_log (context, HIO_VERBOSE_DEBUG_LOW, "posix:dataset_close: successfully closed posix dataset "
             "%s:%" PRIu64 " on data root %s. close time %" PRIu64 " usec", hioi_object_identifier(dataset),
             dataset->ds_id, module->data_root, stop - start);
 
-  builtin_posix_trace (posix_dataset, "trace_end", 0, 0, 0, 0);
-  if (posix_dataset->ds_trace_fh) {
-    fclose (posix_dataset->ds_trace_fh);
+  if (posix_dataset->ds_trace) {
+    uint64_t now = hioi_gettime_ns ();
+    builtin_posix_trace (posix_dataset, HIO_TRACE_EVENT_TRACE_END, 0, 0, now, now);
+    hioi_trace_close (posix_dataset->ds_trace);
+    posix_dataset->ds_trace = NULL;
   }
 
   return rc;
 }
 
-#define UNLINK_MAX_THREADS 16
-
-static pthread_mutex_t unlink_mutex = PTHREAD_MUTEX_INITIALIZER;
-static pthread_t unlink_threads[UNLINK_MAX_THREADS];
-static uint32_t unlink_mask;
-static int unlink_error;
-
-static void *builtin_posix_unlink_thread (void *arg) {
-  int ret = remove ((const char *) arg);
-  if (ret != 0 && !unlink_error) {
-    unlink_error = errno;
-  }
-
-  free (arg);
-
-  return NULL;
-}
-
-
-static int builtin_posix_unlink_cb (const char *path, const struct stat *sb, int typeflag, struct FTW *ftwbuf) {
-  char *new_path = strdup (path);
-  static int last = 0;
-  void *ret;
-
-  if (FTW_DP == typeflag) {
-    /* wait for all previous threads to exit before trying to remove a directory */
-    for (int i = 0 ; i < UNLINK_MAX_THREADS ; ++i) {
-      if (unlink_mask & (1 << i)) {
-        pthread_join (unlink_threads[i], &ret);
-      }
-    }
-
-    /* all threads clear */
-    unlink_mask = 0;
-
-    /* remove directory */
-    builtin_posix_unlink_thread ((void *) new_path);
-    return 0;
-  }
-
-  for (int i = 0 ; i < UNLINK_MAX_THREADS ; ++ i) {
-    if (!(unlink_mask & (1 << i))) {
-      unlink_mask |= (1 << i);
-      pthread_create (unlink_threads + i, NULL, builtin_posix_unlink_thread, (void *) new_path);
-      return 0;
-    }
-  }
-
-  pthread_join (unlink_threads[last], &ret);
-  last = (last + 1) % UNLINK_MAX_THREADS;
-  pthread_create (unlink_threads + last, NULL, builtin_posix_unlink_thread, (void *) new_path);
-
-  return 0;
-}
-
-static int builtin_posix_module_dataset_unlink (struct hio_module_t *module, const char *name, int64_t set_id) {
+static int builtin_posix_module_dataset_unlink (struct hio_module_t *module, const char *name, int64_t set_id,
+                                                int flags) {
+  hio_context_t context = module->context;
+  bool collective = !!(flags & HIO_UNLINK_MODE_COLLECTIVE);
   struct stat statinfo;
   char *path = NULL;
   int rc;
 
-  if (module->context->c_rank) {
+  if (context->c_rank && !collective) {
     return HIO_ERR_NOT_AVAILABLE;
   }
 
   rc = builtin_posix_dataset_path (module, &path, name, set_id);
+  if (HIO_SUCCESS == rc && 0 == context->c_rank && stat (path, &statinfo)) {
+    rc = hioi_err_errno (errno);
+  }
+
+#if HIO_MPI_HAVE(1)
+  if (collective && hioi_context_using_mpi (context)) {
+    /* all ranks need to agree that the dataset exists before starting the collective removal */
+    MPI_Bcast (&rc, 1, MPI_INT, 0, context->c_comm);
+  }
+#endif
+
   if (HIO_SUCCESS != rc) {
+    free (path);
     return rc;
   }
 
-  if (stat (path, &statinfo)) {
-    free (path);
-    return hioi_err_errno (errno);
+  hioi_log (context, HIO_VERBOSE_DEBUG_LOW, "posix: unlinking existing dataset %s::%" PRId64 "%s",
+            name, set_id, collective ? " using all ranks" : ((flags & HIO_UNLINK_MODE_ASYNC) ?
+                                                             " in the background" : ""));
+
+  if (collective) {
+    rc = hioi_unlink_tree_collective (context, path);
+  } else {
+    rc = hioi_unlink_tree (context, path, !!(flags & HIO_UNLINK_MODE_ASYNC));
   }
+  free (path);
 
-  hioi_log (module->context, HIO_VERBOSE_DEBUG_LOW, "posix: unlinking existing dataset %s::%" PRId64,
-            name, set_id);
+  if (0 != context->c_rank) {
+    return rc;
+  }
 
-  /* use tree walk depth-first to remove all of the files for this dataset */
+  if (HIO_SUCCESS != rc) {
+    hioi_err_push (rc, &context->c_object, "posix: could not unlink dataset. rc: %d", rc);
+  } else {
+    builtin_posix_catalog_update (module, name, set_id, NULL);
+  }
 
-  pthread_mutex_lock (&unlink_mutex);
-  unlink_mask = 0;
-  unlink_error = 0;
-  (void) nftw (path, builtin_posix_unlink_cb, 32, FTW_DEPTH | FTW_PHYS);
-  free (path);
+  /* remove any data files the dataset placed on other data roots */
+  for (int i = 0 ; i < context->c_mcount ; ++i) {
+    if (module == context->c_modules[i] ||
+        HIO_SUCCESS != builtin_posix_stripe_path (context->c_modules[i]->data_root, context, &path, name, set_id)) {
+      continue;
+    }
 
-  for (int i = 0 ; i < UNLINK_MAX_THREADS ; ++i) {
-    void *ret;
-    if (unlink_mask & (1 << i)) {
-      pthread_join (unlink_threads[i], &ret);
+    if (0 == stat (path, &statinfo)) {
+      (void) hioi_unlink_tree (context, path, !!(flags & HIO_UNLINK_MODE_ASYNC));
     }
-  }
-  pthread_mutex_unlock (&unlink_mutex);
 
-  if (unlink_error) {
-    hioi_err_push (hioi_err_errno (unlink_error), &module->context->c_object, "posix: could not unlink dataset. errno: %d",
-                  unlink_error);
+    free (path);
   }
 
-  return hioi_err_errno (unlink_error);
+  return rc;
 }
 
 static int builtin_posix_open_file (builtin_posix_module_t *posix_module, builtin_posix_module_dataset_t *posix_dataset,
@@ -1282,7 +2078,7 @@ static int builtin_posix_module_element_open_basic (builtin_posix_module_t *posi
   }
 
   POSIX_TRACE_CALL(posix_dataset, rc = builtin_posix_open_file (posix_module, posix_dataset, path, &element->e_file),
-                   "file_open", 0, 0);
+                   HIO_TRACE_EVENT_FILE_OPEN, 0, 0);
   free (path);
   if (HIO_SUCCESS != rc) {
     return rc;
@@ -1293,6 +2089,43 @@ static int builtin_posix_module_element_open_basic (builtin_posix_module_t *posi
   return HIO_SUCCESS;
 }
 
+/**
+ * Determine the size of a strided mode element
+ *
+ * The size of an element is not stored in the manifest in strided mode. It is found from the
+ * last block written to any of the element's files.
+ */
+static void builtin_posix_module_element_size_strided (builtin_posix_module_dataset_t *posix_dataset,
+                                                       hio_element_t element) {
+  const uint64_t block_size = posix_dataset->ds_bs;
+  struct stat statinfo;
+  char *path;
+  int rc;
+
+  for (uint64_t file_id = 0 ; file_id < posix_dataset->ds_fcount ; ++file_id) {
+    uint64_t last, block_id, size;
+
+    rc = asprintf (&path, "%s/data/%s_block.%08lu", posix_dataset->base_path, hioi_object_identifier(element),
+                   (unsigned long) file_id);
+    if (0 > rc) {
+      return;
+    }
+
+    rc = stat (path, &statinfo);
+    free (path);
+    if (0 != rc || 0 == statinfo.st_size) {
+      continue;
+    }
+
+    last = statinfo.st_size - 1;
+    block_id = (last / block_size) * posix_dataset->ds_fcount + file_id;
+    size = block_id * block_size + last % block_size + 1;
+    if (size > (uint64_t) element->e_size) {
+      element->e_size = size;
+    }
+  }
+}
+
 static int builtin_posix_module_element_open (hio_dataset_t dataset, hio_element_t element) {
   builtin_posix_module_dataset_t *posix_dataset = (builtin_posix_module_dataset_t *) dataset;
   builtin_posix_module_t *posix_module = (builtin_posix_module_t *) dataset->ds_module;
@@ -1302,9 +2135,11 @@ static int builtin_posix_module_element_open (hio_dataset_t dataset, hio_element
   if (HIO_FILE_MODE_BASIC == posix_dataset->ds_fmode) {
     rc = builtin_posix_module_element_open_basic (posix_module, posix_dataset, element);
     if (HIO_SUCCESS != rc) {
-      hioi_object_release (&element->e_object);
+      /* the caller owns the element */
       return rc;
     }
+  } else if (HIO_FILE_MODE_STRIDED == posix_dataset->ds_fmode && !(HIO_FLAG_WRITE & dataset->ds_flags)) {
+    builtin_posix_module_element_size_strided (posix_dataset, element);
   }
 
   hioi_log (context, HIO_VERBOSE_DEBUG_LOW, "posix: %s element %p (identifier %s) for dataset %s",
@@ -1398,14 +2233,14 @@ static int builtin_posix_element_translate_strided (builtin_posix_module_t *posi
 
   if (file_id != file->f_bid || file->f_element != element) {
     if (file->f_bid >= 0) {
-      POSIX_TRACE_CALL(posix_dataset, hioi_file_close (file), "file_close", file->f_bid, 0);
+      POSIX_TRACE_CALL(posix_dataset, hioi_file_close (file), HIO_TRACE_EVENT_FILE_CLOSE, file->f_bid, 0);
     }
     file->f_bid = -1;
 
     file->f_element = element;
 
     POSIX_TRACE_CALL(posix_dataset, rc = builtin_posix_open_file (posix_module, posix_dataset, path, file),
-                     "file_open", file_id, 0);
+                     HIO_TRACE_EVENT_FILE_OPEN, file_id, 0);
     if (HIO_SUCCESS != rc) {
       return rc;
     }
@@ -1413,7 +2248,7 @@ static int builtin_posix_element_translate_strided (builtin_posix_module_t *posi
     file->f_bid = file_id;
   }
 
-  POSIX_TRACE_CALL(posix_dataset, hioi_file_seek (file, block_offset, SEEK_SET), "file_seek", file->f_bid, block_offset);
+  POSIX_TRACE_CALL(posix_dataset, hioi_file_seek (file, block_offset, SEEK_SET), HIO_TRACE_EVENT_FILE_SEEK, file->f_bid, block_offset);
 
   *file_out = file;
 
@@ -1434,11 +2269,11 @@ static int builtin_posix_element_translate_opt (builtin_posix_module_t *posix_mo
   hioi_log (context, HIO_VERBOSE_DEBUG_MED, "translating element %s offset %" PRIu64 " size %lu",
             hioi_object_identifier (&element->e_object), offset, *size);
   POSIX_TRACE_CALL(posix_dataset, rc = hioi_element_translate_offset (element, offset, &file_index, &file_offset, size),
-                   "translate_offset", offset, *size);
+                   HIO_TRACE_EVENT_TRANSLATE_OFFSET, offset, *size);
 #if HIO_MPI_HAVE(3)
   if (HIO_SUCCESS != rc && reading) {
     POSIX_TRACE_CALL(posix_dataset, rc = hioi_dataset_map_translate_offset (element, offset, &file_index, &file_offset, size),
-                     "map_translate_offset", offset, *size);
+                     HIO_TRACE_EVENT_MAP_TRANSLATE_OFFSET, offset, *size);
   }
 #endif
 
@@ -1457,26 +2292,50 @@ static int builtin_posix_element_translate_opt (builtin_posix_module_t *posix_mo
       file_index = 0;
     }
 
-    rc = asprintf (&path, "%s/data/data.%x", posix_dataset->base_path, file_index);
+    if (posix_dataset->ds_write_root) {
+      /* the data root is recorded in the upper bits of the file index stored in the manifest */
+      rc = asprintf (&path, "%s/data/data.%x", posix_dataset->ds_root_paths[posix_dataset->ds_write_root],
+                     file_index);
+      file_index |= posix_dataset->ds_write_root << HIO_POSIX_ROOT_SHIFT;
+    } else {
+      rc = asprintf (&path, "%s/data/data.%x", posix_dataset->base_path, file_index);
+    }
     if (0 > rc) {
       return HIO_ERR_OUT_OF_RESOURCE;
     }
 
     hioi_element_add_segment (element, file_index, file_offset, offset, *size);
   } else {
+    int root = file_index >> HIO_POSIX_ROOT_SHIFT;
+
     hioi_log (context, HIO_VERBOSE_DEBUG_MED, "offset found in file @ rank %d, offset %" PRIu64
-              ", size %lu", file_index, file_offset, *size);
-    rc = asprintf (&path, "%s/data/data.%x", posix_dataset->base_path, file_index);
-    if (0 > rc) {
-      return HIO_ERR_OUT_OF_RESOURCE;
-    }
+              ", size %lu", file_index & HIO_POSIX_FILE_MASK, file_offset, *size);
+    if (root) {
+      rc = builtin_posix_parse_data_roots (posix_dataset);
+      if (HIO_SUCCESS != rc || root >= posix_dataset->ds_root_count) {
+        hioi_err_push (HIO_ERR_NOT_FOUND, &element->e_object, "posix: data root %d for data file %x not "
+                       "found in dataset data roots: %s", root, file_index & HIO_POSIX_FILE_MASK,
+                       posix_dataset->ds_data_roots);
+        return HIO_ERR_NOT_FOUND;
+      }
 
-    if (access (path, R_OK)) {
-      free (path);
-      rc = asprintf (&path, "%s/data.%x", posix_dataset->base_path, file_index);
+      rc = asprintf (&path, "%s/data/data.%x", posix_dataset->ds_root_paths[root], file_index & HIO_POSIX_FILE_MASK);
       if (0 > rc) {
         return HIO_ERR_OUT_OF_RESOURCE;
       }
+    } else {
+      rc = asprintf (&path, "%s/data/data.%x", posix_dataset->base_path, file_index);
+      if (0 > rc) {
+        return HIO_ERR_OUT_OF_RESOURCE;
+      }
+
+      if (access (path, R_OK)) {
+        free (path);
+        rc = asprintf (&path, "%s/data.%x", posix_dataset->base_path, file_index);
+        if (0 > rc) {
+          return HIO_ERR_OUT_OF_RESOURCE;
+        }
+      }
     }
   }
 
@@ -1486,13 +2345,13 @@ static int builtin_posix_element_translate_opt (builtin_posix_module_t *posix_mo
 
   if (file_index != file->f_bid) {
     if (file->f_bid >= 0) {
-      POSIX_TRACE_CALL(posix_dataset, hioi_file_close (file), "file_close", file->f_bid, 0);
+      POSIX_TRACE_CALL(posix_dataset, hioi_file_close (file), HIO_TRACE_EVENT_FILE_CLOSE, file->f_bid, 0);
     }
 
     file->f_bid = -1;
 
     POSIX_TRACE_CALL(posix_dataset, rc = builtin_posix_open_file (posix_module, posix_dataset, path, file),
-                     "file_open", file_index, 0);
+                     HIO_TRACE_EVENT_FILE_OPEN, file_index, 0);
     if (HIO_SUCCESS != rc) {
       free (path);
       return rc;
@@ -1503,7 +2362,7 @@ static int builtin_posix_element_translate_opt (builtin_posix_module_t *posix_mo
 
   free (path);
 
-  POSIX_TRACE_CALL(posix_dataset, hioi_file_seek (file, file_offset, SEEK_SET), "file_seek", file->f_bid, file_offset);
+  POSIX_TRACE_CALL(posix_dataset, hioi_file_seek (file, file_offset, SEEK_SET), HIO_TRACE_EVENT_FILE_SEEK, file->f_bid, file_offset);
 
   *file_out = file;
 
@@ -1552,13 +2411,48 @@ static void builtin_posix_stripe_unlock (hio_element_t element, int stripe_id) {
 }
 
 
+/**
+ * Checksum data and account for the time spent in the dataset statistics
+ */
+static uint32_t builtin_posix_checksum (hio_dataset_t dataset, uint32_t checksum, const void *data, size_t length) {
+  uint64_t start = hioi_gettime_ns ();
+
+  checksum = hioi_crc32c (checksum, data, length);
+
+  hioi_dataset_stat_add (dataset, HIO_STAT_CKTIME, hioi_gettime_ns () - start);
+  hioi_dataset_stat_add (dataset, HIO_STAT_CKBYTES, length);
+
+  return checksum;
+}
+
+/**
+ * Compare the checksum of segment data that was read with the one recorded when it was written
+ */
+static int builtin_posix_checksum_verify (hio_element_t element, uint64_t offset, size_t length, uint32_t expected,
+                                          uint32_t checksum) {
+  hio_dataset_t dataset = hioi_element_dataset (element);
+
+  if (expected == checksum) {
+    return HIO_SUCCESS;
+  }
+
+  hioi_dataset_stat_add (dataset, HIO_STAT_CKERRORS, 1);
+  hioi_err_push (HIO_ERR_IO_PERMANENT, &element->e_object, "posix: checksum mismatch in element %s segment at "
+                 "offset %" PRIu64 " length %lu. expected 0x%08x, got 0x%08x", hioi_object_identifier (element),
+                 offset, (unsigned long) length, expected, checksum);
+
+  return HIO_ERR_IO_PERMANENT;
+}
+
 static ssize_t builtin_posix_module_element_io_internal (builtin_posix_module_t *posix_module, hio_element_t element,
                                                          uint64_t offset, hio_iovec_t *iovec, int count, bool reading) {
   builtin_posix_module_dataset_t *posix_dataset = (builtin_posix_module_dataset_t *) hioi_element_dataset (element);
   size_t bytes_transferred = 0, total = 0, iov_index, iov_count, remaining, current;
   hio_dataset_t dataset = &posix_dataset->base;
-  uint64_t stop, start, data;
+  uint32_t checksum = 0, expected_checksum = 0;
+  uint64_t stop, start, start_ns, data;
   int rc, locked_stripe_id = -1;
+  bool verify = false;
   hio_file_t *file;
   ssize_t ret;
 
@@ -1577,6 +2471,7 @@ static ssize_t builtin_posix_module_element_io_internal (builtin_posix_module_t
   }
 
   start = hioi_gettime ();
+  start_ns = hioi_gettime_ns ();
 
   errno = 0;
   iov_index = 0;
@@ -1590,13 +2485,19 @@ static ssize_t builtin_posix_module_element_io_internal (builtin_posix_module_t
     /* translate as much as possible to minimize the number of manifest entries for this element */
     POSIX_TRACE_CALL(posix_dataset, rc = builtin_posix_element_translate (posix_module, element, offset, &actual,
                                                                           &file, reading),
-                     "element_translate", offset, req);
+                     HIO_TRACE_EVENT_ELEMENT_TRANSLATE, offset, req);
     if (HIO_SUCCESS != rc) {
       break;
     }
 
     req = actual;
 
+    if (reading) {
+      /* data can only be verified if the read covers an entire segment */
+      verify = hioi_element_segment_checksum (element, offset, actual, &expected_checksum);
+      checksum = 0;
+    }
+
     do {
       current = actual < remaining ? actual : remaining;
       hioi_log (hioi_object_context (&element->e_object), HIO_VERBOSE_DEBUG_HIGH,
@@ -1634,15 +2535,26 @@ static ssize_t builtin_posix_module_element_io_internal (builtin_posix_module_t
 
       /* perform actual io */
       if (reading) {
-        POSIX_TRACE_CALL(posix_dataset, ret = hioi_file_read (file, (void *) data, current), "file_read", offset, actual);
+        POSIX_TRACE_CALL(posix_dataset, ret = hioi_file_read (file, (void *) data, current), HIO_TRACE_EVENT_FILE_READ, offset, actual);
       } else {
-        POSIX_TRACE_CALL(posix_dataset, ret = hioi_file_write (file, (void *) data, current), "file_write", offset, actual);
+        POSIX_TRACE_CALL(posix_dataset, ret = hioi_file_write (file, (void *) data, current), HIO_TRACE_EVENT_FILE_WRITE, offset, actual);
       }
 
       if (ret > 0) {
         bytes_transferred += ret;
         actual -= current;
         remaining -= current;
+
+        if (verify) {
+          checksum = builtin_posix_checksum (dataset, checksum, (void *) data, ret);
+        } else if (!reading && posix_dataset->ds_data_checksum) {
+          /* the data is still in cache. extend the checksum of the segment it was written to */
+          uint64_t ck_start = hioi_gettime_ns ();
+
+          hioi_element_checksum_update (element, offset, (void *) data, ret);
+          hioi_dataset_stat_add (dataset, HIO_STAT_CKTIME, hioi_gettime_ns () - ck_start);
+          hioi_dataset_stat_add (dataset, HIO_STAT_CKBYTES, ret);
+        }
       }
 
       if (ret < current) {
@@ -1676,6 +2588,10 @@ static ssize_t builtin_posix_module_element_io_internal (builtin_posix_module_t
       }
     } while (actual);
 
+    if (verify && 0 == actual) {
+      rc = builtin_posix_checksum_verify (element, offset - req, req, expected_checksum, checksum);
+    }
+
     if (HIO_SUCCESS != rc || actual) {
       break;
     }
@@ -1699,20 +2615,25 @@ static ssize_t builtin_posix_module_element_io_internal (builtin_posix_module_t
 
   stop = hioi_gettime ();
 
+  hioi_latency_record (dataset->ds_stat.s_latency + (reading ? HIO_LATENCY_OP_READ : HIO_LATENCY_OP_WRITE),
+                       hioi_gettime_ns () - start_ns);
+
   if (reading) {
     /* update read statistics */
-    dataset->ds_stat.s_rtime += stop - start;
+    hioi_dataset_stat_add (dataset, HIO_STAT_RTIME, stop - start);
 
     if (0 < bytes_transferred) {
-      dataset->ds_stat.s_bread += bytes_transferred;
+      hioi_dataset_stat_add (dataset, HIO_STAT_BREAD, bytes_transferred);
     }
   } else {
-    /* update size and write statistics */
-    element->e_size = offset + bytes_transferred;
-    dataset->ds_stat.s_wtime += stop - start;
+    /* update size and write statistics. offset has already been advanced past the data */
+    if ((int64_t) offset > element->e_size) {
+      element->e_size = offset;
+    }
+    hioi_dataset_stat_add (dataset, HIO_STAT_WTIME, stop - start);
 
     if (0 < bytes_transferred) {
-      dataset->ds_stat.s_bwritten += bytes_transferred;
+      hioi_dataset_stat_add (dataset, HIO_STAT_BWRITTEN, bytes_transferred);
     }
   }
 
@@ -1723,6 +2644,305 @@ static ssize_t builtin_posix_module_element_io_internal (builtin_posix_module_t
   return bytes_transferred;
 }
 
+static int builtin_posix_module_element_locate (hio_element_t element, uint64_t offset, size_t *size, int *fd,
+                                                uint64_t *file_offset) {
+  hio_dataset_t dataset = hioi_element_dataset (element);
+  builtin_posix_module_dataset_t *posix_dataset = (builtin_posix_module_dataset_t *) dataset;
+  builtin_posix_module_t *posix_module = (builtin_posix_module_t *) dataset->ds_module;
+  size_t length = *size;
+  hio_file_t *file;
+  int rc;
+
+  hioi_object_lock (&dataset->ds_object);
+
+  rc = builtin_posix_element_translate (posix_module, element, offset, &length, &file, true);
+  if (HIO_SUCCESS == rc) {
+    *fd = (HIO_FAPI_STDIO == file->f_api) ? fileno (file->f_hndl) : file->f_fd;
+    *file_offset = file->f_offset;
+    *size = length;
+  } else if (HIO_ERR_NOT_FOUND == rc) {
+    length = 0;
+
+    /* the size of the hole can only be determined if all of the element's segments are
+     * known to this process */
+    if (HIO_FILE_MODE_OPTIMIZED == posix_dataset->ds_fmode && HIO_SET_ELEMENT_UNIQUE == dataset->ds_mode) {
+      length = *size;
+      for (size_t i = 0 ; i < element->e_scount ; ++i) {
+        uint64_t seg_offset = element->e_sarray[i].seg_offset;
+        if (seg_offset > offset && seg_offset - offset < length) {
+          length = seg_offset - offset;
+        }
+      }
+    }
+
+    *size = length;
+  }
+
+  hioi_object_unlock (&dataset->ds_object);
+
+  return rc;
+}
+
+static int builtin_posix_element_list_add (char ***names, int **ranks, size_t *count, const char *name,
+                                           size_t name_len, int rank) {
+  if (0 == (*count & 63)) {
+    void *tmp;
+
+    tmp = realloc (*names, (*count + 64) * sizeof (**names));
+    if (NULL == tmp) {
+      return HIO_ERR_OUT_OF_RESOURCE;
+    }
+    *names = tmp;
+
+    tmp = realloc (*ranks, (*count + 64) * sizeof (**ranks));
+    if (NULL == tmp) {
+      return HIO_ERR_OUT_OF_RESOURCE;
+    }
+    *ranks = tmp;
+  }
+
+  (*names)[*count] = strndup (name, name_len);
+  if (NULL == (*names)[*count]) {
+    return HIO_ERR_OUT_OF_RESOURCE;
+  }
+
+  (*ranks)[(*count)++] = rank;
+
+  return HIO_SUCCESS;
+}
+
+/**
+ * Find the elements in a basic or strided mode dataset
+ *
+ * These modes do not describe their elements in the manifest so the element list is
+ * generated from the names of the files in the dataset directory. One "<rank> <element name>"
+ * record is written to {fh} for each element file.
+ */
+static void builtin_posix_element_scan (builtin_posix_module_dataset_t *posix_dataset, FILE *fh) {
+  const bool unique = HIO_SET_ELEMENT_UNIQUE == posix_dataset->base.ds_mode;
+
+  /* element data files live in the data subdirectory. old datasets kept them in the base directory */
+  for (int i = 0 ; i < 2 ; ++i) {
+    struct dirent *dp;
+    char *path;
+    DIR *dir;
+
+    if (0 > asprintf (&path, i ? "%s" : "%s/data", posix_dataset->base_path)) {
+      return;
+    }
+
+    dir = opendir (path);
+    free (path);
+    if (NULL == dir) {
+      continue;
+    }
+
+    while (NULL != (dp = readdir (dir))) {
+      const char *name = dp->d_name, *suffix;
+      long rank = -1;
+      char *tmp;
+
+      if (HIO_FILE_MODE_BASIC == posix_dataset->ds_fmode) {
+        /* element_data.<name> or element_data.<name>.<rank> */
+        if (strncmp (name, "element_data.", 13)) {
+          continue;
+        }
+
+        name += 13;
+        suffix = unique ? strrchr (name, '.') : name + strlen (name);
+      } else {
+        /* <name>_block.<file id> */
+        suffix = strstr (name, "_block.");
+      }
+
+      if (NULL == suffix || suffix == name) {
+        continue;
+      }
+
+      if (unique) {
+        errno = 0;
+        rank = strtol (suffix + 1, &tmp, 10);
+        if (errno || '\0' != tmp[0] || tmp == suffix + 1) {
+          continue;
+        }
+      }
+
+      fprintf (fh, "%ld %.*s\n", rank, (int) (suffix - name), name);
+    }
+
+    closedir (dir);
+  }
+}
+
+#if HIO_MPI_HAVE(3)
+/**
+ * Combine the element lists generated by each rank on rank 0
+ */
+static void builtin_posix_element_list_gather (hio_context_t context, char **list) {
+  int length = strlen (*list), *lengths = NULL, *displacements = NULL, total = 0;
+  char *combined = NULL;
+
+  if (0 == context->c_rank) {
+    lengths = malloc (2 * context->c_size * sizeof (int));
+    assert (NULL != lengths);
+    displacements = lengths + context->c_size;
+  }
+
+  MPI_Gather (&length, 1, MPI_INT, lengths, 1, MPI_INT, 0, context->c_comm);
+
+  if (0 == context->c_rank) {
+    for (int i = 0 ; i < context->c_size ; ++i) {
+      displacements[i] = total;
+      total += lengths[i];
+    }
+
+    combined = malloc (total + 1);
+    assert (NULL != combined);
+  }
+
+  MPI_Gatherv (*list, length, MPI_CHAR, combined, lengths, displacements, MPI_CHAR, 0, context->c_comm);
+
+  if (0 == context->c_rank) {
+    combined[total] = '\0';
+    free (*list);
+    *list = combined;
+  }
+
+  free (lengths);
+}
+#endif
+
+static int builtin_posix_module_element_list (hio_dataset_t dataset, char ***names_out, int **ranks_out,
+                                              size_t *count_out) {
+  builtin_posix_module_dataset_t *posix_dataset = (builtin_posix_module_dataset_t *) dataset;
+  hio_context_t context = hioi_object_context (&dataset->ds_object);
+  const bool unique = HIO_SET_ELEMENT_UNIQUE == dataset->ds_mode;
+  char **names = NULL, *list = NULL;
+  size_t count = 0, list_length;
+  hio_element_t element;
+  int *ranks = NULL;
+  int rc = HIO_SUCCESS;
+  FILE *fh;
+
+  fh = open_memstream (&list, &list_length);
+  if (NULL == fh) {
+    return HIO_ERR_OUT_OF_RESOURCE;
+  }
+
+  if (HIO_FILE_MODE_OPTIMIZED == posix_dataset->ds_fmode) {
+    bool contribute = true;
+
+    /* the data manifests describe every element */
+    rc = hioi_manifest_directory_load_all (dataset);
+
+#if HIO_MPI_HAVE(3)
+    if (!unique) {
+      /* each node read a different subset of the data manifests. every rank on a node has
+       * the same elements */
+      contribute = 0 == context->c_shared_rank;
+    }
+#endif
+
+    if (contribute) {
+      hioi_object_lock (&dataset->ds_object);
+      hioi_list_foreach (element, dataset->ds_elist, struct hio_element, e_list) {
+        fprintf (fh, "%d %s\n", unique ? element->e_rank : -1, hioi_object_identifier (element));
+      }
+      hioi_object_unlock (&dataset->ds_object);
+    }
+  } else if (0 == context->c_rank) {
+    builtin_posix_element_scan (posix_dataset, fh);
+  }
+
+  if (0 != fclose (fh)) {
+    rc = HIO_ERR_OUT_OF_RESOURCE;
+  }
+
+#if HIO_MPI_HAVE(1)
+  /* every rank receives the full list unless each rank lists its own elements */
+  if (hioi_context_using_mpi (context) && !(unique && HIO_FILE_MODE_OPTIMIZED == posix_dataset->ds_fmode)) {
+    MPI_Allreduce (MPI_IN_PLACE, &rc, 1, MPI_INT, MPI_MIN, context->c_comm);
+    if (HIO_SUCCESS == rc) {
+#if HIO_MPI_HAVE(3)
+      if (HIO_FILE_MODE_OPTIMIZED == posix_dataset->ds_fmode) {
+        builtin_posix_element_list_gather (context, &list);
+      }
+#endif
+      rc = hioi_string_scatter (context, &list);
+    }
+  }
+#endif
+
+  for (char *line = list, *next ; HIO_SUCCESS == rc && line && '\0' != line[0] ; line = next) {
+    int rank, name_offset;
+
+    next = strchr (line, '\n');
+    if (NULL != next) {
+      *next++ = '\0';
+    } else {
+      next = line + strlen (line);
+    }
+
+    if (1 != sscanf (line, "%d %n", &rank, &name_offset)) {
+      continue;
+    }
+
+    rc = builtin_posix_element_list_add (&names, &ranks, &count, line + name_offset,
+                                         strlen (line + name_offset), rank);
+  }
+
+  free (list);
+
+  if (HIO_SUCCESS != rc) {
+    for (size_t i = 0 ; i < count ; ++i) {
+      free (names[i]);
+    }
+    free (names);
+    free (ranks);
+    return rc;
+  }
+
+  *names_out = names;
+  *ranks_out = ranks;
+  *count_out = count;
+
+  return HIO_SUCCESS;
+}
+
+/**
+ * Queue a read request on its element
+ *
+ * The request is copied as the caller's copy may not outlive this call. If the caller
+ * asked for a request one is returned now and completed when the read is issued.
+ */
+static int builtin_posix_defer_read (hio_context_t context, hio_internal_request_t *req) {
+  hio_element_t element = req->ir_element;
+  hio_internal_request_t *deferred;
+  hio_request_t new_request = NULL;
+
+  deferred = hioi_internal_request_alloc (element, req->ir_offset, (void *) req->ir_vec.base, req->ir_vec.count,
+                                          req->ir_vec.size, req->ir_vec.stride, req->ir_type, NULL);
+  if (NULL == deferred) {
+    return HIO_ERR_OUT_OF_RESOURCE;
+  }
+
+  if (req->ir_urequest) {
+    new_request = hioi_request_alloc (context);
+    if (NULL == new_request) {
+      free (deferred);
+      return HIO_ERR_OUT_OF_RESOURCE;
+    }
+
+    new_request->req_element = element;
+    req->ir_urequest[0] = new_request;
+  }
+
+  deferred->ir_request = new_request;
+  hioi_list_append (deferred, element->e_pending_reads, ir_list);
+
+  return HIO_SUCCESS;
+}
+
 static int builtin_posix_module_process_reqs (hio_dataset_t dataset, hio_internal_request_t **reqs, int req_count) {
   builtin_posix_module_dataset_t *posix_dataset = (builtin_posix_module_dataset_t *) dataset;
   builtin_posix_module_t *posix_module = (builtin_posix_module_t *) dataset->ds_module;
@@ -1737,17 +2957,20 @@ static int builtin_posix_module_process_reqs (hio_dataset_t dataset, hio_interna
     hio_internal_request_t *req = reqs[i];
 
     if (HIO_REQUEST_TYPE_READ == req->ir_type) {
-      POSIX_TRACE_CALL(posix_dataset,
-                       req->ir_status = builtin_posix_module_element_io_internal (posix_module, req->ir_element, req->ir_offset,
-                                                                                  &req->ir_vec, 1, true),
-                       "element_read", req->ir_offset, req->ir_vec.count * req->ir_vec.size);
-    } else {
-      POSIX_TRACE_CALL(posix_dataset,
-                       req->ir_status = builtin_posix_module_element_io_internal (posix_module, req->ir_element, req->ir_offset,
-                                                                                  &req->ir_vec, 1, false),
-                       "element_write", req->ir_offset, req->ir_vec.count * req->ir_vec.size);
+      /* reads are queued on the element and issued together by builtin_posix_module_element_complete */
+      rc = builtin_posix_defer_read (context, req);
+      if (HIO_SUCCESS != rc) {
+        break;
+      }
+
+      continue;
     }
 
+    POSIX_TRACE_CALL(posix_dataset,
+                     req->ir_status = builtin_posix_module_element_io_internal (posix_module, req->ir_element, req->ir_offset,
+                                                                                &req->ir_vec, 1, false),
+                     HIO_TRACE_EVENT_ELEMENT_WRITE, req->ir_offset, req->ir_vec.count * req->ir_vec.size);
+
     if (req->ir_urequest && req->ir_status > 0) {
       hio_request_t new_request = hioi_request_alloc (context);
       if (NULL == new_request) {
@@ -1771,7 +2994,7 @@ static int builtin_posix_module_process_reqs (hio_dataset_t dataset, hio_interna
 
   stop = hioi_gettime ();
 
-  builtin_posix_trace (posix_dataset, "process_requests", req_count, 0, start, stop);
+  builtin_posix_trace (posix_dataset, HIO_TRACE_EVENT_PROCESS_REQUESTS, req_count, 0, start * 1000, stop * 1000);
 
   return rc;
 }
@@ -1803,16 +3026,251 @@ static int builtin_posix_module_element_flush (hio_element_t element, hio_flush_
   return hioi_file_flush (&element->e_file);
 }
 
+/** deferred read and the location of its data */
+typedef struct builtin_posix_read_t {
+  hio_internal_request_t *req;
+  /** file holding the data (NULL if the read can not be merged with others) */
+  hio_file_t *file;
+  /** block id of the file at the time of translation (identifies the file in the cache) */
+  int64_t     file_bid;
+  /** offset of the data in the file */
+  uint64_t    file_offset;
+  /** bytes requested */
+  size_t      size;
+} builtin_posix_read_t;
+
+static int builtin_posix_read_compare (const void *a, const void *b) {
+  const builtin_posix_read_t *ra = (const builtin_posix_read_t *) a, *rb = (const builtin_posix_read_t *) b;
+
+  /* reads that can not be merged go last */
+  if (ra->file != rb->file) {
+    if (NULL == ra->file || NULL == rb->file) {
+      return (NULL == ra->file) ? 1 : -1;
+    }
+
+    return ((intptr_t) ra->file < (intptr_t) rb->file) ? -1 : 1;
+  }
+
+  if (ra->file_bid != rb->file_bid) {
+    return (ra->file_bid < rb->file_bid) ? -1 : 1;
+  }
+
+  if (ra->file_offset != rb->file_offset) {
+    return (ra->file_offset < rb->file_offset) ? -1 : 1;
+  }
+
+  return 0;
+}
+
+/**
+ * Issue a run of deferred reads from the same file with a single file read
+ *
+ * @param[in] posix_module posix module
+ * @param[in] element      element the reads belong to
+ * @param[in] reads        sorted reads to issue
+ * @param[in] count        number of reads in the run
+ * @param[in] run_size     number of bytes covered by the run
+ */
+static void builtin_posix_read_run (builtin_posix_module_t *posix_module, hio_element_t element,
+                                    builtin_posix_read_t *reads, int count, size_t run_size) {
+  builtin_posix_module_dataset_t *posix_dataset = (builtin_posix_module_dataset_t *) hioi_element_dataset (element);
+  uint64_t run_offset = reads[0].file_offset, start, stop, start_ns;
+  uint32_t checksum, expected;
+  size_t actual = reads[0].size;
+  hio_file_t *file;
+  ssize_t ret;
+  char *buffer;
+  int rc;
+
+  buffer = malloc (run_size);
+  if (NULL == buffer) {
+    /* fall back on reading each request on its own */
+    for (int i = 0 ; i < count ; ++i) {
+      reads[i].file = NULL;
+    }
+    return;
+  }
+
+  start = hioi_gettime ();
+  start_ns = hioi_gettime_ns ();
+
+  /* translating the first read positions the (possibly reopened) file at the start of the run */
+  rc = builtin_posix_element_translate (posix_module, element, reads[0].req->ir_offset, &actual, &file, true);
+  if (HIO_SUCCESS == rc && file->f_offset == run_offset) {
+    POSIX_TRACE_CALL(posix_dataset, ret = hioi_file_read (file, buffer, run_size), HIO_TRACE_EVENT_FILE_READ,
+                     reads[0].req->ir_offset, run_size);
+    if (ret < 0) {
+      rc = hioi_err_errno (errno);
+    }
+  } else {
+    ret = -1;
+    if (HIO_SUCCESS == rc) {
+      rc = HIO_ERR_IO_PERMANENT;
+    }
+  }
+
+  stop = hioi_gettime ();
+
+  hioi_latency_record (posix_dataset->base.ds_stat.s_latency + HIO_LATENCY_OP_READ, hioi_gettime_ns () - start_ns);
+
+  for (int i = 0 ; i < count ; ++i) {
+    hio_internal_request_t *req = reads[i].req;
+    uint64_t skip = reads[i].file_offset - run_offset;
+
+    if (ret < 0) {
+      req->ir_status = rc;
+      continue;
+    }
+
+    req->ir_status = ((uint64_t) ret > skip) ? ret - skip : 0;
+    if ((size_t) req->ir_status > reads[i].size) {
+      req->ir_status = reads[i].size;
+    }
+
+    memcpy ((void *) req->ir_vec.base, buffer + skip, req->ir_status);
+
+    if (hioi_element_segment_checksum (element, req->ir_offset, req->ir_status, &expected)) {
+      checksum = builtin_posix_checksum (&posix_dataset->base, 0, buffer + skip, req->ir_status);
+      rc = builtin_posix_checksum_verify (element, req->ir_offset, req->ir_status, expected, checksum);
+      if (HIO_SUCCESS != rc) {
+        req->ir_status = rc;
+      }
+    }
+  }
+
+  free (buffer);
+
+  hioi_dataset_stat_add (&posix_dataset->base, HIO_STAT_RTIME, stop - start);
+  if (ret > 0) {
+    hioi_dataset_stat_add (&posix_dataset->base, HIO_STAT_BREAD, ret);
+  }
+
+  hioi_log (hioi_object_context (&element->e_object), HIO_VERBOSE_DEBUG_MED, "posix: merged %d reads into a "
+            "single %lu byte read at file offset %" PRIu64, count, (unsigned long) run_size, run_offset);
+}
+
 static int builtin_posix_module_element_complete (hio_element_t element) {
   hio_dataset_t dataset = hioi_element_dataset (element);
+  builtin_posix_module_dataset_t *posix_dataset = (builtin_posix_module_dataset_t *) dataset;
+  builtin_posix_module_t *posix_module = (builtin_posix_module_t *) dataset->ds_module;
+  hio_internal_request_t *req, *next;
+  builtin_posix_read_t *reads;
+  int count = 0, rc = HIO_SUCCESS;
+  uint64_t start, stop;
 
-  /* reads in this module are always blocking. need to update this code if
-   * that ever changes */
   if (!(dataset->ds_flags & HIO_FLAG_READ)) {
     return HIO_ERR_PERM;
   }
 
-  return HIO_SUCCESS;
+  hioi_object_lock (&dataset->ds_object);
+
+  hioi_list_foreach (req, element->e_pending_reads, hio_internal_request_t, ir_list) {
+    ++count;
+  }
+
+  if (0 == count) {
+    hioi_object_unlock (&dataset->ds_object);
+    return HIO_SUCCESS;
+  }
+
+  reads = calloc (count, sizeof (reads[0]));
+  if (NULL == reads) {
+    hioi_object_unlock (&dataset->ds_object);
+    return HIO_ERR_OUT_OF_RESOURCE;
+  }
+
+  start = hioi_gettime ();
+
+  /* locate the data for each read. only reads that are contiguous in memory and in a
+   * single file can be merged */
+  count = 0;
+  hioi_list_foreach_safe (req, next, element->e_pending_reads, hio_internal_request_t, ir_list) {
+    builtin_posix_read_t *read = reads + count++;
+    size_t actual;
+    hio_file_t *file;
+
+    hioi_list_remove (req, ir_list);
+    read->req = req;
+    read->size = actual = req->ir_vec.count * req->ir_vec.size;
+
+    if (posix_dataset->ds_read_max && read->size && read->size <= posix_dataset->ds_read_max &&
+        (1 == req->ir_vec.count || 0 == req->ir_vec.stride) &&
+        HIO_SUCCESS == builtin_posix_element_translate (posix_module, element, req->ir_offset, &actual, &file, true) &&
+        actual == read->size) {
+      read->file = file;
+      read->file_bid = file->f_bid;
+      read->file_offset = file->f_offset;
+    }
+  }
+
+  qsort (reads, count, sizeof (reads[0]), builtin_posix_read_compare);
+
+  for (int i = 0 ; i < count ; ) {
+    uint64_t run_end = reads[i].file_offset + reads[i].size;
+    int run_count = 1;
+
+    /* extend the run while the next read is in the same file and close enough */
+    while (reads[i].file && i + run_count < count) {
+      builtin_posix_read_t *read = reads + i + run_count;
+      uint64_t read_end = read->file_offset + read->size;
+
+      if (read->file != reads[i].file || read->file_bid != reads[i].file_bid ||
+          read->file_offset > run_end + posix_dataset->ds_read_gap ||
+          (read_end > run_end ? read_end : run_end) - reads[i].file_offset > posix_dataset->ds_read_max) {
+        break;
+      }
+
+      if (read_end > run_end) {
+        run_end = read_end;
+      }
+
+      ++run_count;
+    }
+
+    if (run_count > 1) {
+      builtin_posix_read_run (posix_module, element, reads + i, run_count, run_end - reads[i].file_offset);
+    }
+
+    for (int j = i ; j < i + run_count ; ++j) {
+      req = reads[j].req;
+
+      if (1 == run_count || NULL == reads[j].file) {
+        POSIX_TRACE_CALL(posix_dataset,
+                         req->ir_status = builtin_posix_module_element_io_internal (posix_module, element, req->ir_offset,
+                                                                                    &req->ir_vec, 1, true),
+                         HIO_TRACE_EVENT_ELEMENT_READ, req->ir_offset, reads[j].size);
+      }
+
+      if (req->ir_status < 0) {
+        if (HIO_SUCCESS == rc) {
+          rc = (int) req->ir_status;
+        }
+      } else if ((size_t) req->ir_status < reads[j].size && HIO_SUCCESS == rc) {
+        /* a short read is an error */
+        rc = HIO_ERR_TRUNCATE;
+      }
+
+      if (req->ir_request) {
+        req->ir_request->req_transferred = (req->ir_status > 0) ? req->ir_status : 0;
+        req->ir_request->req_status = (req->ir_status < 0) ? (int) req->ir_status : HIO_SUCCESS;
+        req->ir_request->req_complete = true;
+      }
+
+      free (req);
+    }
+
+    i += run_count;
+  }
+
+  free (reads);
+
+  hioi_object_unlock (&dataset->ds_object);
+
+  stop = hioi_gettime ();
+
+  builtin_posix_trace (posix_dataset, HIO_TRACE_EVENT_COMPLETE, count, 0, start * 1000, stop * 1000);
+
+  return rc;
 }
 
 static int builtin_posix_module_fini (struct hio_module_t *module) {
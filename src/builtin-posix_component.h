@@ -1,6 +1,6 @@
 /* -*- Mode: C; c-basic-offset:2 ; indent-tabs-mode:nil -*- */
 /*
- * Copyright (c) 2014-2016 Los Alamos National Security, LLC.  All rights
+ * Copyright (c) 2014-2017 Los Alamos National Security, LLC.  All rights
  *                         reserved.
  * $COPYRIGHT$
  *
@@ -17,6 +17,11 @@
 
 #define HIO_POSIX_MAX_OPEN_FILES  32
 
+/** optimized mode file indices store the data root index in the upper bits (see
+ * ds_data_roots) and the writing node's master rank in the lower bits */
+#define HIO_POSIX_ROOT_SHIFT      24
+#define HIO_POSIX_FILE_MASK       ((1 << HIO_POSIX_ROOT_SHIFT) - 1)
+
 typedef enum builtin_posix_dataset_fmode {
   /** use basic mode. unique address space results in a single file per element per rank.
    * shared address space results in a single file per element */
@@ -54,8 +59,28 @@ typedef struct builtin_posix_module_dataset_t {
   /** stripe this rank should write to */
   int my_stripe;
 
-  /** use bzip2 to compress data manifests */
-  bool                ds_use_bzip;
+  /** codec to use to compress data manifests (see hio_manifest_codec_t) */
+  int32_t             ds_manifest_codec;
+
+  /** time spent compressing/decompressing data manifests */
+  uint64_t            ds_codec_time;
+
+  /** compression ratio of data manifests */
+  double              ds_codec_ratio;
+
+  /** accumulated codec statistics (see builtin_posix_codec_stats) */
+  uint64_t            ds_codec_raw_bytes;
+  uint64_t            ds_codec_coded_bytes;
+  uint64_t            ds_codec_time_total;
+
+  /** number of threads to use to read data manifests on open */
+  int32_t             ds_manifest_read_threads;
+
+  /** time spent reading and merging data manifests on open */
+  uint64_t            ds_manifest_read_time;
+
+  /** format to use when writing manifests (see hio_manifest_format_t) */
+  int32_t             ds_manifest_format;
 
   /** dataset file mode */
   builtin_posix_dataset_fmode_t ds_fmode;
@@ -66,14 +91,39 @@ typedef struct builtin_posix_module_dataset_t {
   /** number of files to use with strided mode */
   int                 ds_fcount;
 
-  /** trace file */
-  FILE               *ds_trace_fh;
+  /** binary event trace (NULL if tracing is disabled) */
+  hio_trace_t        *ds_trace;
 
   /** exclusively write to a single stripe in optimized mode */
   bool                ds_stripe_exclusivity;
 
   /** API to use to read/write files */
   int                 ds_file_api;
+
+  /** largest gap (in bytes) between deferred reads that will be merged into one file read */
+  uint64_t            ds_read_gap;
+
+  /** largest file read (in bytes) that will be formed by merging deferred reads */
+  uint64_t            ds_read_max;
+
+  /** distribute data files across all data roots (optimized file mode only) */
+  bool                ds_stripe_roots;
+
+  /** compute a checksum of each data segment as it is written (optimized file mode only) */
+  bool                ds_data_checksum;
+
+  /** comma-separated list of data roots holding data files for this dataset. the
+   * first entry is the data root of the dataset. stored in the manifest */
+  char               *ds_data_roots;
+
+  /** dataset data path on each data root in ds_data_roots */
+  char              **ds_root_paths;
+
+  /** number of entries in ds_root_paths */
+  int                 ds_root_count;
+
+  /** index of the data root this rank's node writes to */
+  int                 ds_write_root;
 } builtin_posix_module_dataset_t;
 
 extern hio_component_t builtin_posix_component;
@@ -167,6 +167,8 @@ int hioi_component_fini (void) {
     (void) component->fini ();
   }
 
+  hioi_unlink_fini ();
+
 #if USE_DYNAMIC_COMPONENTS
   for (int i = 0 ; i < hio_external_component_count ; ++i) {
     hio_dynamic_component_t *component = hio_external_components + i;
@@ -30,6 +30,9 @@ static void hioi_context_release (hio_object_t object) {
   hio_dataset_data_t *ds_data, *next;
   hio_context_t context = (hio_context_t) object;
 
+  /* background removals reference the context */
+  (void) hioi_unlink_wait (context);
+
   for (int i = 0 ; i < context->c_mcount ; ++i) {
     context->c_modules[i]->fini (context->c_modules[i]);
   }
@@ -291,6 +294,23 @@ int hioi_context_create_modules (hio_context_t context) {
   context->c_mcount = num_modules;
   context->c_cur_module = 0;
 
+  /* seed the data root statistics with the available space on each data root */
+  for (int i = 0 ; i < num_modules ; ++i) {
+    hio_module_stats_t *stats = context->c_module_stats + i;
+    hio_fs_attr_t fs_attr;
+
+    memset (stats, 0, sizeof (*stats));
+    stats->ms_bavail = UINT64_MAX;
+
+    if (HIO_SUCCESS == hioi_fs_query (context, context->c_modules[i]->data_root, &fs_attr)) {
+      stats->ms_bavail = fs_attr.fs_bavail * fs_attr.fs_bsize;
+    }
+  }
+
+  /* apply data root statistics from previous jobs. this also loads the dataset history if
+   * none was found when the context was created (data roots can be changed after init) */
+  (void) hioi_history_load (context);
+
   free (data_roots);
 
   return rc;
@@ -358,6 +378,11 @@ static int hio_init_common (hio_context_t context, const char *config_file, cons
   hioi_config_add (context, &context->c_object, &context->c_dw_root,
                    "datawarp_root", NULL, HIO_CONFIG_TYPE_STRING, NULL, "Mount path "
                    "for datawarp (burst-buffer) (default: auto-detect)", HIO_VAR_FLAG_DEFAULT);
+  context->c_dw_prefetch = false;
+  hioi_config_add (context, &context->c_object, &context->c_dw_prefetch,
+                   "datawarp_prefetch", NULL, HIO_CONFIG_TYPE_BOOL, NULL, "Stage the newest "
+                   "complete id of each dataset from the PFS into datawarp on restart "
+                   "(default: 0)", 0);
   #ifdef HIO_DATAWARP_DEBUG_LOG
     context->c_dw_debug_mask = 0;
     context->c_dw_debug_installed = false;
@@ -404,10 +429,26 @@ static int hio_init_common (hio_context_t context, const char *config_file, cons
                  "bytes_written", HIO_CONFIG_TYPE_UINT64, NULL, "Total number of bytes "
                  "written in this context", 0);
 
+  hioi_perf_add (context, &context->c_object, &context->c_cur_module,
+                 "data_root_selected", HIO_CONFIG_TYPE_INT32, NULL, "Index of the data root "
+                 "selected for the last dataset created in this context", 0);
+
+  context->c_module_retry_interval = 300;
+  hioi_config_add (context, &context->c_object, &context->c_module_retry_interval,
+                   "data_root_retry_interval", NULL, HIO_CONFIG_TYPE_UINT64, NULL, "Seconds "
+                   "before a failing data root is tried again (default: 300)", 0);
+
+  hioi_perf_add (context, &context->c_object, &context->c_module_failovers,
+                 "data_root_failovers", HIO_CONFIG_TYPE_UINT64, NULL, "Number of times the "
+                 "preferred data root was skipped because it was full or failing", 0);
+
   if (context->c_verbose > HIO_VERBOSE_MAX) {
     context->c_verbose = HIO_VERBOSE_MAX;
   }
 
+  /* make the statistics of previous jobs available to hio_dataset_should_checkpoint() */
+  (void) hioi_history_load (context);
+
   return HIO_SUCCESS;
 }
 
@@ -558,19 +599,123 @@ int hio_fini (hio_context_t *context) {
   return hioi_component_fini ();
 }
 
-void hio_should_checkpoint (hio_context_t ctx, int *hint) {
-  /* TODO -- implement this */
-  *hint = HIO_SCP_MUST_CHECKPOINT;
+/** number of consecutive failures before a data root is considered degraded */
+#define HIOI_MODULE_MAX_FAILURES 2
+
+static uint64_t hioi_module_expected_time (hio_module_stats_t *stats, uint64_t bytes) {
+  uint64_t expected = stats->ms_latency;
+
+  /* data roots without a bandwidth measurement are assumed to be as fast as possible so
+   * that each data root is tried once */
+  if (stats->ms_bandwidth > 0.0) {
+    expected += (uint64_t) ((double) bytes / stats->ms_bandwidth);
+  }
+
+  return expected;
 }
 
-hio_module_t *hioi_context_select_module (hio_context_t context) {
-  /* TODO -- finish implementation */
-  if (-1 == context->c_cur_module) {
-    context->c_cur_module = 0;
+hio_module_t *hioi_context_select_module (hio_context_t context, hio_dataset_t dataset) {
+  int selected = -1, preferred = -1;
+
+  if (0 == context->c_rank) {
+    uint64_t bytes, best_time = UINT64_MAX, preferred_time = UINT64_MAX;
+    time_t now = time (NULL);
+
+    bytes = dataset->ds_data->dd_average_size ? dataset->ds_data->dd_average_size :
+      dataset->ds_data->dd_last_size;
+
+    for (int i = 0 ; i < context->c_mcount ; ++i) {
+      hio_module_stats_t *stats = context->c_module_stats + i;
+      uint64_t expected = hioi_module_expected_time (stats, bytes);
+
+      if (expected < preferred_time) {
+        preferred_time = expected;
+        preferred = i;
+      }
+
+      if (stats->ms_failures >= HIOI_MODULE_MAX_FAILURES &&
+          (uint64_t) (now - stats->ms_last_failure) >= context->c_module_retry_interval) {
+        /* give a failing data root another chance. the failure may have been transient.
+         * the next retry is only allowed after another full interval */
+        hioi_log (context, HIO_VERBOSE_DEBUG_MED, "Retrying data root %s after %d failures",
+                  context->c_modules[i]->data_root, stats->ms_failures);
+        stats->ms_failures = HIOI_MODULE_MAX_FAILURES - 1;
+        stats->ms_last_failure = now;
+      }
+
+      if (stats->ms_failures >= HIOI_MODULE_MAX_FAILURES || stats->ms_bavail < bytes) {
+        hioi_log (context, HIO_VERBOSE_DEBUG_MED, "Skipping data root %s. failures: %d, available: %"
+                  PRIu64 ", expected size: %" PRIu64, context->c_modules[i]->data_root, stats->ms_failures,
+                  stats->ms_bavail, bytes);
+        continue;
+      }
+
+      if (expected < best_time) {
+        best_time = expected;
+        selected = i;
+      }
+    }
+
+    if (-1 == selected) {
+      /* every data root is full or failing. use the fastest one */
+      selected = preferred;
+    } else if (selected != preferred) {
+      context->c_module_failovers++;
+    }
   }
 
+#if HIO_MPI_HAVE(1)
+  if (hioi_context_using_mpi (context)) {
+    MPI_Bcast (&selected, 1, MPI_INT, 0, context->c_comm);
+  }
+#endif
+
+  context->c_cur_module = (selected >= 0) ? selected : 0;
+
   hioi_log (context, HIO_VERBOSE_DEBUG_LOW, "Selected module %d with data root %s",
             context->c_cur_module, context->c_modules[context->c_cur_module]->data_root);
 
   return context->c_modules[context->c_cur_module];
 }
+
+void hioi_context_update_module_stats (hio_context_t context, hio_module_t *module, int rc, uint64_t bytes,
+                                       uint64_t data_time, uint64_t close_time) {
+  hio_module_stats_t *stats = NULL;
+
+  if (0 != context->c_rank) {
+    return;
+  }
+
+  for (int i = 0 ; i < context->c_mcount ; ++i) {
+    if (module == context->c_modules[i]) {
+      stats = context->c_module_stats + i;
+      break;
+    }
+  }
+
+  if (NULL == stats) {
+    return;
+  }
+
+  if (HIO_SUCCESS != rc) {
+    stats->ms_failures++;
+    stats->ms_last_failure = time (NULL);
+    return;
+  }
+
+  stats->ms_failures = 0;
+
+  if (close_time) {
+    stats->ms_latency = stats->ms_latency ? (uint64_t) (0.8 * stats->ms_latency + 0.2 * close_time) : close_time;
+  }
+
+  if (bytes && data_time) {
+    double bandwidth = (double) bytes / (double) data_time;
+
+    stats->ms_bandwidth = (stats->ms_bandwidth > 0.0) ? 0.8 * stats->ms_bandwidth + 0.2 * bandwidth : bandwidth;
+
+    if (UINT64_MAX != stats->ms_bavail) {
+      stats->ms_bavail = (stats->ms_bavail > bytes) ? stats->ms_bavail - bytes : 0;
+    }
+  }
+}
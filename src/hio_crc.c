@@ -4,44 +4,176 @@
  *                         reserved.
  *
  * $COPYRIGHT$
- * 
+ *
  * Additional copyrights may follow
- * 
+ *
  * $HEADER$
  */
 
 #include "hio_internal.h"
 
+#include <string.h>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define HIO_CRC32C_SSE42 1
+#include <nmmintrin.h>
+#else
+#define HIO_CRC32C_SSE42 0
+#endif
+
 #define CRC32POLY 0x04C11DB7l
+#define CRC32CPOLY 0x82F63B78l
 #define CRC64POLY 0xC96C5795D7870F42ul
 
-static uint32_t crc32_table[256];
-static uint64_t crc64_table[256];
+/** bytes in each of the three streams checksummed together by the sse4.2 crc32c implementation */
+#define HIO_CRC32C_LANE 4096
+
+/* slicing-by-8 tables. table[k][i] is the crc of byte i followed by k zero bytes. the
+ * tables are filled in by hioi_crc_init () when the library is loaded */
+static uint32_t crc32_table[8][256];
+static uint32_t crc32c_table[8][256];
+static uint64_t crc64_table[8][256];
 
-static bool crc_initialized = false;
+/** crc32c register shift over HIO_CRC32C_LANE zero bytes (one table per byte of the register) */
+static uint32_t crc32c_lane_shift[4][256];
 
-pthread_mutex_t crc_init_lock = PTHREAD_MUTEX_INITIALIZER;
+static uint32_t hioi_crc32c_sw (uint32_t crc, const uint8_t *buf, size_t length);
 
-static void crc_init_tables (void) {
-  pthread_mutex_lock (&crc_init_lock);
-  if (crc_initialized) {
-    pthread_mutex_unlock (&crc_init_lock);
-    return;
+/** crc32c implementation selected at load time */
+static uint32_t (*hioi_crc32c_impl) (uint32_t, const uint8_t *, size_t) = hioi_crc32c_sw;
+
+static inline uint64_t hioi_crc_load64 (const uint8_t *buf) {
+  uint64_t word;
+
+  /* the tables are indexed with the first byte in the low bits */
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  memcpy (&word, buf, sizeof (word));
+#else
+  word = 0;
+  for (int i = 7 ; i >= 0 ; --i) {
+    word = (word << 8) | buf[i];
   }
+#endif
+
+  return word;
+}
+
+static uint32_t hioi_crc32_slice8 (uint32_t table[8][256], uint32_t crc, const uint8_t *buf, size_t length) {
+  for ( ; length && ((uintptr_t) buf & 7) ; --length) {
+    crc = (crc >> 8) ^ table[0][(crc ^ *buf++) & 0xff];
+  }
+
+  for ( ; length >= 8 ; length -= 8, buf += 8) {
+    uint64_t word = hioi_crc_load64 (buf) ^ crc;
+
+    crc = table[7][word & 0xff] ^ table[6][(word >> 8) & 0xff] ^ table[5][(word >> 16) & 0xff] ^
+      table[4][(word >> 24) & 0xff] ^ table[3][(word >> 32) & 0xff] ^ table[2][(word >> 40) & 0xff] ^
+      table[1][(word >> 48) & 0xff] ^ table[0][word >> 56];
+  }
+
+  for ( ; length ; --length) {
+    crc = (crc >> 8) ^ table[0][(crc ^ *buf++) & 0xff];
+  }
+
+  return crc;
+}
+
+static uint64_t hioi_crc64_slice8 (uint64_t crc, const uint8_t *buf, size_t length) {
+  for ( ; length && ((uintptr_t) buf & 7) ; --length) {
+    crc = (crc >> 8) ^ crc64_table[0][(crc ^ *buf++) & 0xff];
+  }
+
+  for ( ; length >= 8 ; length -= 8, buf += 8) {
+    uint64_t word = hioi_crc_load64 (buf) ^ crc;
+
+    crc = crc64_table[7][word & 0xff] ^ crc64_table[6][(word >> 8) & 0xff] ^
+      crc64_table[5][(word >> 16) & 0xff] ^ crc64_table[4][(word >> 24) & 0xff] ^
+      crc64_table[3][(word >> 32) & 0xff] ^ crc64_table[2][(word >> 40) & 0xff] ^
+      crc64_table[1][(word >> 48) & 0xff] ^ crc64_table[0][word >> 56];
+  }
+
+  for ( ; length ; --length) {
+    crc = (crc >> 8) ^ crc64_table[0][(crc ^ *buf++) & 0xff];
+  }
+
+  return crc;
+}
+
+static uint32_t hioi_crc32c_sw (uint32_t crc, const uint8_t *buf, size_t length) {
+  return hioi_crc32_slice8 (crc32c_table, crc, buf, length);
+}
+
+#if HIO_CRC32C_SSE42
+static inline uint32_t hioi_crc32c_shift (uint32_t crc) {
+  return crc32c_lane_shift[0][crc & 0xff] ^ crc32c_lane_shift[1][(crc >> 8) & 0xff] ^
+    crc32c_lane_shift[2][(crc >> 16) & 0xff] ^ crc32c_lane_shift[3][crc >> 24];
+}
+
+__attribute__((target ("sse4.2")))
+static uint32_t hioi_crc32c_sse42 (uint32_t crc, const uint8_t *buf, size_t length) {
+  uint64_t crc0 = crc;
+
+  for ( ; length && ((uintptr_t) buf & 7) ; --length) {
+    crc0 = _mm_crc32_u8 ((uint32_t) crc0, *buf++);
+  }
+
+  /* the crc32 instruction has a latency of three cycles but a throughput of one per cycle.
+   * checksum three independent streams and combine them by shifting the first two over
+   * the length of the ones that follow */
+  for ( ; length >= 3 * HIO_CRC32C_LANE ; length -= 3 * HIO_CRC32C_LANE) {
+    uint64_t crc1 = 0, crc2 = 0;
 
+    for (size_t i = 0 ; i < HIO_CRC32C_LANE ; i += 8, buf += 8) {
+      crc0 = _mm_crc32_u64 (crc0, hioi_crc_load64 (buf));
+      crc1 = _mm_crc32_u64 (crc1, hioi_crc_load64 (buf + HIO_CRC32C_LANE));
+      crc2 = _mm_crc32_u64 (crc2, hioi_crc_load64 (buf + 2 * HIO_CRC32C_LANE));
+    }
+
+    crc0 = hioi_crc32c_shift ((uint32_t) crc0) ^ (uint32_t) crc1;
+    crc0 = hioi_crc32c_shift ((uint32_t) crc0) ^ (uint32_t) crc2;
+    buf += 2 * HIO_CRC32C_LANE;
+  }
+
+  for ( ; length >= 8 ; length -= 8, buf += 8) {
+    crc0 = _mm_crc32_u64 (crc0, hioi_crc_load64 (buf));
+  }
+
+  for ( ; length ; --length) {
+    crc0 = _mm_crc32_u8 ((uint32_t) crc0, *buf++);
+  }
+
+  return (uint32_t) crc0;
+}
+#endif
+
+static void hioi_crc32_init_table (uint32_t table[8][256], uint32_t poly) {
   for (int i = 0 ; i < 256 ; i++) {
     uint32_t r = i;
 
     for (int j = 0; j < 8; j++)  {
       if (r & 1)
-        r = (r >> 1) ^ CRC32POLY;
+        r = (r >> 1) ^ poly;
       else
         r >>= 1;
     }
 
-    crc32_table[i] = r;
+    table[0][i] = r;
   }
 
+  for (int k = 1 ; k < 8 ; ++k) {
+    for (int i = 0 ; i < 256 ; ++i) {
+      table[k][i] = (table[k-1][i] >> 8) ^ table[0][table[k-1][i] & 0xff];
+    }
+  }
+}
+
+static void __attribute__((constructor)) hioi_crc_init (void) {
+  static const uint8_t zeros[HIO_CRC32C_LANE];
+  uint32_t lane_basis[32];
+
+  hioi_crc32_init_table (crc32_table, CRC32POLY);
+  hioi_crc32_init_table (crc32c_table, CRC32CPOLY);
+
   for (int i = 0 ; i < 256 ; i++) {
     uint64_t r = i;
 
@@ -52,33 +184,59 @@ static void crc_init_tables (void) {
         r >>= 1;
     }
 
-    crc64_table[i] = r;
+    crc64_table[0][i] = r;
+  }
+
+  for (int k = 1 ; k < 8 ; ++k) {
+    for (int i = 0 ; i < 256 ; ++i) {
+      crc64_table[k][i] = (crc64_table[k-1][i] >> 8) ^ crc64_table[0][crc64_table[k-1][i] & 0xff];
+    }
+  }
+
+  /* the shift over a lane is linear in the crc register. compute it for each bit of the register
+   * then build the per-byte tables from those */
+  for (int bit = 0 ; bit < 32 ; ++bit) {
+    lane_basis[bit] = hioi_crc32c_sw (UINT32_C(1) << bit, zeros, sizeof (zeros));
   }
 
-  crc_initialized = true;
-  pthread_mutex_unlock (&crc_init_lock);
+  for (int k = 0 ; k < 4 ; ++k) {
+    for (int i = 0 ; i < 256 ; ++i) {
+      uint32_t r = 0;
+
+      for (int bit = 0 ; bit < 8 ; ++bit) {
+        if (i & (1 << bit)) {
+          r ^= lane_basis[k * 8 + bit];
+        }
+      }
+
+      crc32c_lane_shift[k][i] = r;
+    }
+  }
+
+#if HIO_CRC32C_SSE42
+  __builtin_cpu_init ();
+  if (__builtin_cpu_supports ("sse4.2")) {
+    hioi_crc32c_impl = hioi_crc32c_sse42;
+  }
+#endif
 }
 
 uint32_t hioi_crc32 (uint8_t *buf, size_t length) {
-  uint32_t crc = 0;
-  
-  if (!crc_initialized)
-    crc_init_tables ();
-  
-  for (int i = 0 ; i < length ; i++)
-    crc = (crc >> 8) ^ crc32_table[(crc ^ buf[i]) & 0xff];
-  
-  return crc;
+  return hioi_crc32_slice8 (crc32_table, 0, buf, length);
 }
 
-uint64_t hioi_crc64 (uint8_t *buf, size_t length) {
-  uint64_t crc = 0;
-  
-  if (!crc_initialized)
-    crc_init_tables ();
-  
-  for (int i = 0 ; i < length ; ++i)
-    crc = (crc >> 8) ^ crc64_table[(crc ^ buf[i]) & 0xff];
+uint32_t hioi_crc32c (uint32_t crc, const void *buf, size_t length) {
+  return ~hioi_crc32c_impl (~crc, (const uint8_t *) buf, length);
+}
 
-  return crc;
+uint32_t hioi_crc32c_software (uint32_t crc, const void *buf, size_t length) {
+  return ~hioi_crc32c_sw (~crc, (const uint8_t *) buf, length);
+}
+
+bool hioi_crc32c_accelerated (void) {
+  return hioi_crc32c_sw != hioi_crc32c_impl;
+}
+
+uint64_t hioi_crc64 (uint8_t *buf, size_t length) {
+  return hioi_crc64_slice8 (0, buf, length);
 }
@@ -28,6 +28,18 @@ static hio_var_enum_t hioi_dataset_fs_type_enum = {
   .values = hioi_dataset_fs_type_enum_values,
 };
 
+#if HIO_MPI_HAVE(3)
+static hio_var_enum_value_t hioi_dataset_map_engine_enum_values[] = {
+  {.string_value = "hash", .value = HIO_MAP_ENGINE_HASH},
+  {.string_value = "range", .value = HIO_MAP_ENGINE_RANGE},
+};
+
+static hio_var_enum_t hioi_dataset_map_engine_enum = {
+  .count  = 2,
+  .values = hioi_dataset_map_engine_enum_values,
+};
+#endif
+
 int hioi_dataset_data_lookup (hio_context_t context, const char *name, hio_dataset_data_t **data) {
   hio_dataset_data_t *ds_data;
 
@@ -67,6 +79,97 @@ int hioi_dataset_data_lookup (hio_context_t context, const char *name, hio_datas
   return HIO_SUCCESS;
 }
 
+/** names used for the latency performance variables of each operation */
+static const char *hioi_dataset_latency_names[HIO_LATENCY_OP_MAX] = {
+  [HIO_LATENCY_OP_APPEND] = "append",
+  [HIO_LATENCY_OP_WRITE] = "backend_write",
+  [HIO_LATENCY_OP_READ] = "backend_read",
+  [HIO_LATENCY_OP_FLUSH] = "flush",
+  [HIO_LATENCY_OP_OPEN] = "open",
+  [HIO_LATENCY_OP_CLOSE] = "close",
+  [HIO_LATENCY_OP_GATHER_MANIFEST] = "gather_manifest",
+};
+
+void hioi_dataset_perf_update (hio_object_t object) {
+  hio_dataset_t dataset = (hio_dataset_t) object;
+  uint64_t sums[HIO_STAT_MAX] = {0};
+
+  for (int i = 0 ; i < HIO_STAT_SHARDS ; ++i) {
+    for (int j = 0 ; j < HIO_STAT_MAX ; ++j) {
+      sums[j] += atomic_load (dataset->ds_stat.s_shards[i].ss_values + j);
+    }
+  }
+
+  dataset->ds_stat.s_bread = sums[HIO_STAT_BREAD];
+  dataset->ds_stat.s_rtime = sums[HIO_STAT_RTIME];
+  dataset->ds_stat.s_bwritten = sums[HIO_STAT_BWRITTEN];
+  dataset->ds_stat.s_wtime = sums[HIO_STAT_WTIME];
+  dataset->ds_stat.s_rcount = sums[HIO_STAT_RCOUNT];
+  dataset->ds_stat.s_wcount = sums[HIO_STAT_WCOUNT];
+  dataset->ds_stat.s_ckbytes = sums[HIO_STAT_CKBYTES];
+  dataset->ds_stat.s_cktime = sums[HIO_STAT_CKTIME];
+  dataset->ds_stat.s_ckerrors = sums[HIO_STAT_CKERRORS];
+
+  for (int i = 0 ; i < HIO_LATENCY_OP_MAX ; ++i) {
+    hioi_latency_summarize (dataset->ds_stat.s_latency + i, dataset->ds_stat.s_lsummary + i);
+  }
+}
+
+static void hioi_dataset_latency_add_perf (hio_context_t context, hio_dataset_t dataset, hio_latency_summary_t *summary,
+                                           const char *prefix, const char *op_name) {
+  struct {
+    uint64_t   *value;
+    const char *suffix;
+    const char *description;
+  } vars[] = {
+    {&summary->ls_count, "count", "Number of operations timed by this latency histogram"},
+    {&summary->ls_p50, "p50_nsec", "Median latency (nsec) of this operation"},
+    {&summary->ls_p90, "p90_nsec", "90th percentile latency (nsec) of this operation"},
+    {&summary->ls_p99, "p99_nsec", "99th percentile latency (nsec) of this operation"},
+    {&summary->ls_max, "max_nsec", "Maximum latency (nsec) of this operation"},
+  };
+  char name[128];
+
+  for (size_t i = 0 ; i < sizeof (vars) / sizeof (vars[0]) ; ++i) {
+    snprintf (name, sizeof (name), "%s%s_latency_%s", prefix, op_name, vars[i].suffix);
+    hioi_perf_add (context, &dataset->ds_object, vars[i].value, name, HIO_CONFIG_TYPE_UINT64, NULL,
+                   vars[i].description, 0);
+  }
+}
+
+void hioi_dataset_latency_aggregate (hio_dataset_t dataset) {
+  hio_context_t context = hioi_object_context (&dataset->ds_object);
+  uint64_t buckets[HIO_LATENCY_OP_MAX][HIO_LATENCY_BUCKETS], max[HIO_LATENCY_OP_MAX];
+
+  for (int i = 0 ; i < HIO_LATENCY_OP_MAX ; ++i) {
+    for (int j = 0 ; j < HIO_LATENCY_BUCKETS ; ++j) {
+      buckets[i][j] = atomic_load (dataset->ds_stat.s_latency[i].lh_buckets + j);
+    }
+
+    max[i] = atomic_load (&dataset->ds_stat.s_latency[i].lh_max);
+  }
+
+#if HIO_MPI_HAVE(1)
+  if (1 != context->c_size) {
+    /* the bucket counts are summed. the maximums are reduced separately */
+    MPI_Reduce (0 == context->c_rank ? MPI_IN_PLACE : buckets, buckets, HIO_LATENCY_OP_MAX * HIO_LATENCY_BUCKETS,
+                MPI_UINT64_T, MPI_SUM, 0, context->c_comm);
+    MPI_Reduce (0 == context->c_rank ? MPI_IN_PLACE : max, max, HIO_LATENCY_OP_MAX, MPI_UINT64_T, MPI_MAX, 0,
+                context->c_comm);
+  }
+#endif
+
+  /* only valid on rank 0 (like the other aggregate statistics) */
+  for (int i = 0 ; i < HIO_LATENCY_OP_MAX ; ++i) {
+    for (int j = 0 ; j < HIO_LATENCY_BUCKETS ; ++j) {
+      atomic_init (dataset->ds_stat.s_alatency[i].lh_buckets + j, buckets[i][j]);
+    }
+
+    atomic_init (&dataset->ds_stat.s_alatency[i].lh_max, max[i]);
+    hioi_latency_summarize (dataset->ds_stat.s_alatency + i, dataset->ds_stat.s_alsummary + i);
+  }
+}
+
 static hio_return_t hioi_dataset_element_open_stub (hio_dataset_t dataset, hio_element_t element) {
   return HIO_ERR_BAD_PARAM;
 }
@@ -83,6 +186,9 @@ static void hioi_dataset_release (hio_object_t object) {
     hioi_list_remove(element, e_list);
     hioi_object_release (&element->e_object);
   }
+
+  hioi_manifest_directory_release (dataset->ds_element_directory);
+  free (dataset->ds_stat.s_shards);
 }
 
 hio_dataset_t hioi_dataset_alloc (hio_context_t context, const char *name, int64_t id,
@@ -101,9 +207,15 @@ hio_dataset_t hioi_dataset_alloc (hio_context_t context, const char *name, int64
     return NULL;
   }
 
-  /* initialize counters */
-  atomic_init (&new_dataset->ds_stat.s_wcount, 0);
-  atomic_init (&new_dataset->ds_stat.s_rcount, 0);
+  /* allocate statistics shards. each shard starts on its own cache line */
+  rc = posix_memalign ((void **) &new_dataset->ds_stat.s_shards, HIO_CACHE_LINE_SIZE,
+                       HIO_STAT_SHARDS * sizeof (hio_stat_shard_t));
+  if (0 != rc) {
+    hioi_object_release (&new_dataset->ds_object);
+    return NULL;
+  }
+
+  memset (new_dataset->ds_stat.s_shards, 0, HIO_STAT_SHARDS * sizeof (hio_stat_shard_t));
 
   /* lookup/allocate persistent dataset data. this data will keep track of per-dataset
    * statistics (average write time, last successful checkpoint, etc) */
@@ -123,6 +235,7 @@ hio_dataset_t hioi_dataset_alloc (hio_context_t context, const char *name, int64
   new_dataset->ds_shared_win = MPI_WIN_NULL;
   new_dataset->ds_map.map_elements.md_win = MPI_WIN_NULL;
   new_dataset->ds_map.map_segments.md_win = MPI_WIN_NULL;
+  new_dataset->ds_map.map_ranges.md_win = MPI_WIN_NULL;
 #endif
   hioi_list_init(new_dataset->ds_buffer.b_reqlist);
 
@@ -135,12 +248,26 @@ hio_dataset_t hioi_dataset_alloc (hio_context_t context, const char *name, int64
                    "dataset_expected_size", NULL, HIO_CONFIG_TYPE_INT64, NULL,
                    "Expected global size of this dataset", 0);
 
+  /* read-only so the value is not overwritten when a manifest is loaded */
+  hioi_perf_add (context, &new_dataset->ds_object, &new_dataset->ds_data->dd_bandwidth,
+                 "dataset_write_bandwidth", HIO_CONFIG_TYPE_DOUBLE, NULL, "Weighted average "
+                 "bandwidth (bytes/usec) observed writing instances of this dataset",
+                 HIO_VAR_FLAG_READONLY);
+
   /* default to a megabyte for the buffer size */
   new_dataset->ds_buffer_size = 1 << 20;
   hioi_config_add (context, &new_dataset->ds_object, &new_dataset->ds_buffer_size,
                    "dataset_buffer_size", NULL, HIO_CONFIG_TYPE_INT64, NULL,
                    "Buffer size to use for aggregating read and write operations", 0);
 
+#if HIO_MPI_HAVE(3)
+  new_dataset->ds_map.map_engine = HIO_MAP_ENGINE_HASH;
+  hioi_config_add (context, &new_dataset->ds_object, &new_dataset->ds_map.map_engine,
+                   "dataset_map_engine", NULL, HIO_CONFIG_TYPE_INT32, &hioi_dataset_map_engine_enum,
+                   "Engine used to locate remote segments when reading shared datasets. Valid "
+                   "values: hash, range (sorted index partitioned across node leaders)", HIO_VAR_FLAG_LOCAL);
+#endif
+
   /* set up performance variables */
   hioi_perf_add (context, &new_dataset->ds_object, &new_dataset->ds_stat.s_bread, "bytes_read",
                  HIO_CONFIG_TYPE_UINT64, NULL, "Total number of bytes read in this dataset instance", 0);
@@ -160,6 +287,23 @@ hio_dataset_t hioi_dataset_alloc (hio_context_t context, const char *name, int64
   hioi_perf_add (context, &new_dataset->ds_object, &new_dataset->ds_stat.s_wcount, "write_count",
                  HIO_CONFIG_TYPE_UINT64, NULL, "Total number of calls to write APIs in this dataset instance", 0);
 
+  hioi_perf_add (context, &new_dataset->ds_object, &new_dataset->ds_stat.s_ckbytes, "checksum_bytes",
+                 HIO_CONFIG_TYPE_UINT64, NULL, "Total number of bytes checksummed when writing or verified when "
+                 "reading in this dataset instance", 0);
+
+  hioi_perf_add (context, &new_dataset->ds_object, &new_dataset->ds_stat.s_cktime, "checksum_time_nsec",
+                 HIO_CONFIG_TYPE_UINT64, NULL, "Total time spent computing data checksums in this dataset instance", 0);
+
+  hioi_perf_add (context, &new_dataset->ds_object, &new_dataset->ds_stat.s_ckerrors, "checksum_error_count",
+                 HIO_CONFIG_TYPE_UINT64, NULL, "Number of segments that failed checksum verification in this "
+                 "dataset instance", 0);
+
+  for (int i = 0 ; i < HIO_LATENCY_OP_MAX ; ++i) {
+    hioi_dataset_latency_add_perf (context, new_dataset, new_dataset->ds_stat.s_lsummary + i, "",
+                                   hioi_dataset_latency_names[i]);
+  }
+  new_dataset->ds_object.perf_update_fn = hioi_dataset_perf_update;
+
 
   hioi_perf_add (context, &new_dataset->ds_object, &new_dataset->ds_stat.s_abread, "aggregate_bytes_read",
                  HIO_CONFIG_TYPE_UINT64, NULL, "Total number of bytes read in this dataset", 0);
@@ -179,6 +323,11 @@ hio_dataset_t hioi_dataset_alloc (hio_context_t context, const char *name, int64
   hioi_perf_add (context, &new_dataset->ds_object, &new_dataset->ds_stat.s_awcount, "aggregate_write_count",
                  HIO_CONFIG_TYPE_UINT64, NULL, "Total number of calls to write APIs in this dataset", 0);
 
+  for (int i = 0 ; i < HIO_LATENCY_OP_MAX ; ++i) {
+    hioi_dataset_latency_add_perf (context, new_dataset, new_dataset->ds_stat.s_alsummary + i, "aggregate_",
+                                   hioi_dataset_latency_names[i]);
+  }
+
   hioi_list_init (new_dataset->ds_elist);
 
   return new_dataset;
@@ -230,7 +379,7 @@ hio_dataset_backend_data_t *hioi_dbd_lookup_backend_data (hio_dataset_data_t *da
 
 int hioi_dataset_open_internal (hio_module_t *module, hio_dataset_t dataset) {
   /* get timestamp before open call */
-  uint64_t rotime = hioi_gettime ();
+  uint64_t rotime = hioi_gettime (), start = hioi_gettime_ns ();
   int rc;
 
   hioi_log (module->context, HIO_VERBOSE_DEBUG_LOW, "Opening dataset %s::%" PRIu64 " with flags 0x%x "
@@ -260,12 +409,24 @@ int hioi_dataset_open_internal (hio_module_t *module, hio_dataset_t dataset) {
   dataset->ds_rotime = rotime;
 
   /* reset session statistics that were loaded from the manifest */
+  for (int i = 0 ; i < HIO_STAT_SHARDS ; ++i) {
+    for (int j = 0 ; j < HIO_STAT_MAX ; ++j) {
+      atomic_init (dataset->ds_stat.s_shards[i].ss_values + j, 0);
+    }
+  }
   dataset->ds_stat.s_bread = 0;
   dataset->ds_stat.s_bwritten = 0;
   dataset->ds_stat.s_rtime = 0;
   dataset->ds_stat.s_wtime = 0;
-  atomic_init (&dataset->ds_stat.s_rcount, 0);
-  atomic_init (&dataset->ds_stat.s_wcount, 0);
+  dataset->ds_stat.s_ckbytes = 0;
+  dataset->ds_stat.s_cktime = 0;
+  dataset->ds_stat.s_ckerrors = 0;
+  dataset->ds_stat.s_rcount = 0;
+  dataset->ds_stat.s_wcount = 0;
+  memset (dataset->ds_stat.s_latency, 0, sizeof (dataset->ds_stat.s_latency));
+  memset (dataset->ds_stat.s_lsummary, 0, sizeof (dataset->ds_stat.s_lsummary));
+
+  hioi_latency_record (dataset->ds_stat.s_latency + HIO_LATENCY_OP_OPEN, hioi_gettime_ns () - start);
 
   return HIO_SUCCESS;
 }
@@ -296,23 +457,37 @@ int hioi_dataset_close_internal (hio_dataset_t dataset) {
 
 int hioi_dataset_gather_manifest (hio_dataset_t dataset, hio_manifest_t *manifest_out, bool simple) {
   hio_context_t context = hioi_object_context (&dataset->ds_object);
+  uint64_t start = hioi_gettime_ns ();
   hio_manifest_t manifest;
   int rc = HIO_ERROR;
 
-  rc = hioi_manifest_generate (dataset, simple, &manifest);
+  /* make sure the manifest has up-to-date statistics */
+  hioi_dataset_perf_update (&dataset->ds_object);
+
   if (!hioi_context_using_mpi (context)) {
-    *manifest_out = manifest;
+    /* the binary image is built directly from the element list and can be saved in
+     * either format without building a json object tree */
+    rc = hioi_manifest_generate_binary (dataset, simple, manifest_out);
+    hioi_latency_record (dataset->ds_stat.s_latency + HIO_LATENCY_OP_GATHER_MANIFEST, hioi_gettime_ns () - start);
     return rc;
   }
 
 #if HIO_MPI_HAVE(1)
-  rc = hioi_manifest_gather_comm (&manifest, context->c_comm);
-  if (0 != context->c_rank) {
+  /* generate a binary manifest. it is cheaper to reduce than json. the reduction is
+   * collective so it takes place even if the local manifest could not be generated */
+  manifest = NULL;
+  rc = hioi_manifest_generate_binary (dataset, simple, &manifest);
+  rc = hioi_manifest_gather_comm (context, &manifest, context->c_comm, rc);
+  if (0 != context->c_rank || HIO_SUCCESS != rc) {
     /* no longer need the manifest */
-    hioi_manifest_release (manifest);
+    if (NULL != manifest) {
+      hioi_manifest_release (manifest);
+    }
   } else {
     *manifest_out = manifest;
   }
+
+  hioi_latency_record (dataset->ds_stat.s_latency + HIO_LATENCY_OP_GATHER_MANIFEST, hioi_gettime_ns () - start);
 #endif
 
   return rc;
@@ -321,24 +496,26 @@ int hioi_dataset_gather_manifest (hio_dataset_t dataset, hio_manifest_t *manifes
 #if HIO_MPI_HAVE(1)
 int hioi_dataset_gather_manifest_comm (hio_dataset_t dataset, MPI_Comm comm, hio_manifest_t *manifest_out, bool simple) {
   hio_context_t context = hioi_object_context (&dataset->ds_object);
+  uint64_t start = hioi_gettime_ns ();
   hio_manifest_t manifest;
   int rc, comm_rank;
 
   MPI_Comm_rank (comm, &comm_rank);
 
-  rc = hioi_manifest_generate (dataset, simple, &manifest);
-  if (HIO_SUCCESS != rc) {
-    return rc;
-  }
+  hioi_dataset_perf_update (&dataset->ds_object);
 
-  rc = hioi_manifest_gather_comm (&manifest, comm);
-  if (HIO_SUCCESS != rc || 0 != comm_rank) {
+  manifest = NULL;
+  rc = hioi_manifest_generate_binary (dataset, simple, &manifest);
+  rc = hioi_manifest_gather_comm (context, &manifest, comm, rc);
+  if ((HIO_SUCCESS != rc || 0 != comm_rank) && NULL != manifest) {
     hioi_manifest_release (manifest);
     manifest = NULL;
   }
 
   *manifest_out = manifest;
 
+  hioi_latency_record (dataset->ds_stat.s_latency + HIO_LATENCY_OP_GATHER_MANIFEST, hioi_gettime_ns () - start);
+
   return rc;
 }
 
@@ -354,7 +531,13 @@ int hioi_dataset_scatter_comm (hio_dataset_t dataset, MPI_Comm comm, hio_manifes
   }
 
   if (manifest) {
-    hioi_manifest_serialize (manifest, &manifest_data, &manifest_size, false);
+    if (!(dataset->ds_flags & HIO_FLAG_WRITE)) {
+      /* convert the manifest to a binary image once so every rank can defer loading elements
+       * until they are opened (see hioi_manifest_load_binary) */
+      (void) hioi_manifest_convert_binary (manifest);
+    }
+
+    hioi_manifest_serialize (manifest, &manifest_data, &manifest_size, HIO_MANIFEST_CODEC_NONE);
   }
 
   MPI_Comm_rank (comm, &rank);
@@ -489,10 +672,17 @@ int hioi_dataset_scatter_unique (hio_dataset_t dataset, hio_manifest_t manifest,
   return rc;
 }
 
+#endif
+
 static int hioi_dataset_header_compare_newest (const void *a, const void *b) {
   const hio_dataset_header_t *headera = (const hio_dataset_header_t *) a;
   const hio_dataset_header_t *headerb = (const hio_dataset_header_t *) b;
 
+  if (headera->ds_mtime == headerb->ds_mtime) {
+    /* mtime only has a resolution of one second. the higher id is assumed to be newer */
+    return ((headera->ds_id > headerb->ds_id) - (headera->ds_id < headerb->ds_id));
+  }
+
   return ((headera->ds_mtime > headerb->ds_mtime) - (headera->ds_mtime < headerb->ds_mtime));
 }
 
@@ -518,4 +708,92 @@ int hioi_dataset_headers_sort (hio_dataset_header_t *headers, int count, int64_t
   return HIO_SUCCESS;
 }
 
+int hioi_dataset_headers_scatter (hio_context_t context, hio_dataset_header_t **headers, int *count) {
+#if HIO_MPI_HAVE(1)
+  int *module_index = NULL, mpirc, data[2];
+
+  if (!hioi_context_using_mpi (context)) {
+    return HIO_SUCCESS;
+  }
+
+  if (0 == context->c_rank) {
+    data[0] = *count;
+    data[1] = HIO_SUCCESS;
+
+    if (*count) {
+      module_index = malloc (*count * sizeof (module_index[0]));
+      if (NULL == module_index) {
+        data[1] = HIO_ERR_OUT_OF_RESOURCE;
+      } else {
+        /* module pointers are not valid on other ranks. send the module's index instead */
+        for (int i = 0 ; i < *count ; ++i) {
+          module_index[i] = -1;
+          for (int j = 0 ; j < context->c_mcount ; ++j) {
+            if (headers[0][i].module == context->c_modules[j]) {
+              module_index[i] = j;
+              break;
+            }
+          }
+        }
+      }
+    }
+  }
+
+  mpirc = MPI_Bcast (data, 2, MPI_INT, 0, context->c_comm);
+  if (MPI_SUCCESS != mpirc) {
+    free (module_index);
+    return hioi_err_mpi (mpirc);
+  }
+
+  if (HIO_SUCCESS != data[1]) {
+    return data[1];
+  }
+
+  if (0 == data[0]) {
+    *count = 0;
+    return HIO_SUCCESS;
+  }
+
+  if (0 != context->c_rank) {
+    free (*headers);
+    *headers = malloc (data[0] * sizeof (**headers));
+    module_index = malloc (data[0] * sizeof (module_index[0]));
+    if (NULL == *headers || NULL == module_index) {
+      data[1] = HIO_ERR_OUT_OF_RESOURCE;
+    }
+  }
+
+  /* every rank must be able to receive the headers before they are sent */
+  mpirc = MPI_Allreduce (MPI_IN_PLACE, data + 1, 1, MPI_INT, MPI_MIN, context->c_comm);
+  if (MPI_SUCCESS != mpirc || HIO_SUCCESS != data[1]) {
+    free (module_index);
+    if (0 != context->c_rank) {
+      free (*headers);
+      *headers = NULL;
+      *count = 0;
+    }
+    return (MPI_SUCCESS != mpirc) ? hioi_err_mpi (mpirc) : data[1];
+  }
+
+  mpirc = MPI_Bcast (*headers, data[0] * sizeof (**headers), MPI_BYTE, 0, context->c_comm);
+  if (MPI_SUCCESS == mpirc) {
+    mpirc = MPI_Bcast (module_index, data[0], MPI_INT, 0, context->c_comm);
+  }
+
+  if (MPI_SUCCESS != mpirc) {
+    free (module_index);
+    return hioi_err_mpi (mpirc);
+  }
+
+  if (0 != context->c_rank) {
+    for (int i = 0 ; i < data[0] ; ++i) {
+      headers[0][i].module = (module_index[i] >= 0) ? context->c_modules[module_index[i]] : NULL;
+    }
+  }
+
+  free (module_index);
+  *count = data[0];
 #endif
+
+  return HIO_SUCCESS;
+}
@@ -35,6 +35,7 @@ static int request_compare (const void *a, const void *b) {
 int hioi_dataset_buffer_flush (hio_dataset_t dataset) {
   size_t req_count = hioi_list_length (&dataset->ds_buffer.b_reqlist);
   hio_internal_request_t **reqs, *req, *next;
+  uint64_t start = hioi_gettime_ns ();
   int rc;
 
   if (0 == req_count) {
@@ -68,6 +69,8 @@ int hioi_dataset_buffer_flush (hio_dataset_t dataset) {
 
   dataset->ds_buffer.b_remaining = dataset->ds_buffer.b_size;
 
+  hioi_latency_record (dataset->ds_stat.s_latency + HIO_LATENCY_OP_FLUSH, hioi_gettime_ns () - start);
+
   return rc;
 }
 
@@ -18,8 +18,18 @@
 
 static void hioi_element_release (hio_object_t object) {
   hio_element_t element = (hio_element_t) object;
+  hio_internal_request_t *req, *next;
+
+  /* reads that were never completed */
+  hioi_list_foreach_safe (req, next, element->e_pending_reads, hio_internal_request_t, ir_list) {
+    hioi_list_remove (req, ir_list);
+    free (req);
+  }
 
   free (element->e_sarray);
+#if HIO_MPI_HAVE(3)
+  free (element->e_map_cache);
+#endif
 }
 
 hio_element_t hioi_element_alloc (hio_dataset_t dataset, const char *name, const int rank) {
@@ -34,13 +44,14 @@ hio_element_t hioi_element_alloc (hio_dataset_t dataset, const char *name, const
   element->e_rank = rank;
   element->e_file.f_fd = -1;
   element->e_index = -1;
+  hioi_list_init (element->e_pending_reads);
 
   return element;
 }
 
 int hioi_element_open_internal (hio_dataset_t dataset, hio_element_t *element_out, const char *element_name,
                                 int flags, int rank) {
-  hio_element_t element;
+  hio_element_t element, item;
   int rc = HIO_SUCCESS;
 
   if (HIO_SET_ELEMENT_SHARED == dataset->ds_mode) {
@@ -49,21 +60,41 @@ int hioi_element_open_internal (hio_dataset_t dataset, hio_element_t *element_ou
   }
 
   hioi_object_lock (&dataset->ds_object);
-  hioi_list_foreach (element, dataset->ds_elist, struct hio_element, e_list) {
-    if (!strcmp (hioi_object_identifier(element), element_name) && rank == element->e_rank) {
-      *element_out = element;
-      if (0 == element->e_open_count++ && hioi_dataset_doing_io (dataset)) {
-        /* don't actually "open" the element unless this rank is performing IO directly */
-        rc = dataset->ds_element_open (dataset, element);
-        if (HIO_SUCCESS != rc) {
-          element->e_open_count = 0;
-        }
+
+  /* check the manifest for records of this element that have not been loaded yet. the records
+   * are merged into the element if it already exists */
+  element = NULL;
+  rc = hioi_manifest_directory_load_element (dataset, element_name, rank, &element);
+  if (HIO_SUCCESS != rc && HIO_ERR_NOT_FOUND != rc) {
+    hioi_object_unlock (&dataset->ds_object);
+    return rc;
+  }
+
+  if (NULL == element) {
+    hioi_list_foreach (item, dataset->ds_elist, struct hio_element, e_list) {
+      if (!strcmp (hioi_object_identifier(item), element_name) && rank == item->e_rank) {
+        element = item;
+        break;
+      }
+    }
+  }
+
+  if (NULL != element) {
+    rc = HIO_SUCCESS;
+    *element_out = element;
+    if (0 == element->e_open_count++ && hioi_dataset_doing_io (dataset)) {
+      /* don't actually "open" the element unless this rank is performing IO directly */
+      rc = dataset->ds_element_open (dataset, element);
+      if (HIO_SUCCESS != rc) {
+        element->e_open_count = 0;
       }
-      hioi_object_unlock (&dataset->ds_object);
-      return rc;
     }
+    hioi_object_unlock (&dataset->ds_object);
+    return rc;
   }
 
+  rc = HIO_SUCCESS;
+
   /* no existing element matches */
   do {
     element = hioi_element_alloc (dataset, element_name, rank);
@@ -97,6 +128,11 @@ int hioi_element_close_internal (hio_element_t element) {
   int rc = HIO_SUCCESS;
 
   hioi_object_lock (&dataset->ds_object);
+  if (1 == element->e_open_count && element->e_complete && !hioi_list_empty (&element->e_pending_reads)) {
+    /* finish any reads that are still queued */
+    rc = element->e_complete (element);
+  }
+
   if (0 == --element->e_open_count && hioi_dataset_doing_io (dataset)) {
     if (dataset->ds_flags & HIO_FLAG_WRITE) {
       hioi_object_unlock (&dataset->ds_object);
@@ -139,21 +175,8 @@ static int hioi_element_segment_compare (const void *key, const void *value) {
   return 0;
 }
 
-/**
- * Add a segment descriptor to an element
- *
- * @param[in] element hio element handle
- * @param[in] file_index index in element e_flist for the associated file
- * @param[in] file_offset offset where the application segment lives
- * @param[in] app_offset application offset
- * @param[in[ seg_length length of application segment
- *
- * This function adds a segment to an hio element handle. This segment
- * will be written to the manifest when the dataset containing the
- * element is closed.
- */
-int hioi_element_add_segment (hio_element_t element, int file_index, uint64_t file_offset, uint64_t app_offset,
-                              size_t seg_length) {
+static int hioi_element_add_segment_internal (hio_element_t element, int file_index, uint64_t file_offset,
+                                              uint64_t app_offset, size_t seg_length, const uint32_t *checksum) {
   hio_manifest_segment_t *segment = NULL;
   int seg_index = 0;
   void *tmp;
@@ -166,7 +189,8 @@ int hioi_element_add_segment (hio_element_t element, int file_index, uint64_t fi
     segment = (hio_manifest_segment_t *) bsearch ((void *) (intptr_t) app_offset, element->e_sarray,
                                                   element->e_scount, sizeof (element->e_sarray[0]),
                                                   hioi_element_segment_compare);
-    if (segment) {
+    /* segments with a known checksum are never merged. the checksum would no longer cover the segment */
+    if (segment && NULL == checksum) {
       last_offset = segment->seg_offset + segment->seg_length;
       last_file_offset = segment->seg_foffset + segment->seg_length;
 
@@ -210,6 +234,13 @@ int hioi_element_add_segment (hio_element_t element, int file_index, uint64_t fi
   segment->seg_offset = app_offset;
   segment->seg_length = seg_length;
   segment->seg_file_index = file_index;
+  if (checksum) {
+    segment->seg_checksum = *checksum;
+    segment->seg_cksum_length = seg_length;
+  } else {
+    segment->seg_checksum = 0;
+    segment->seg_cksum_length = 0;
+  }
 
   assert (seg_length > 0);
 
@@ -220,6 +251,29 @@ int hioi_element_add_segment (hio_element_t element, int file_index, uint64_t fi
   return HIO_SUCCESS;
 }
 
+/**
+ * Add a segment descriptor to an element
+ *
+ * @param[in] element hio element handle
+ * @param[in] file_index index in element e_flist for the associated file
+ * @param[in] file_offset offset where the application segment lives
+ * @param[in] app_offset application offset
+ * @param[in[ seg_length length of application segment
+ *
+ * This function adds a segment to an hio element handle. This segment
+ * will be written to the manifest when the dataset containing the
+ * element is closed.
+ */
+int hioi_element_add_segment (hio_element_t element, int file_index, uint64_t file_offset, uint64_t app_offset,
+                              size_t seg_length) {
+  return hioi_element_add_segment_internal (element, file_index, file_offset, app_offset, seg_length, NULL);
+}
+
+int hioi_element_add_segment_checksum (hio_element_t element, int file_index, uint64_t file_offset,
+                                       uint64_t app_offset, size_t seg_length, uint32_t checksum) {
+  return hioi_element_add_segment_internal (element, file_index, file_offset, app_offset, seg_length, &checksum);
+}
+
 /**
  * Translate an application offset into a logical file and offset
  *
@@ -282,3 +336,61 @@ int hioi_element_translate_offset (hio_element_t element, uint64_t app_offset, i
 
   return rc;
 }
+
+void hioi_element_checksum_update (hio_element_t element, uint64_t app_offset, const void *data, size_t length) {
+  hio_manifest_segment_t *segment;
+
+  hioi_object_lock (&element->e_object);
+
+  segment = (hio_manifest_segment_t *) bsearch ((void *) (intptr_t) app_offset, element->e_sarray,
+                                                element->e_scount, sizeof (element->e_sarray[0]),
+                                                hioi_element_segment_compare);
+  if (segment && segment->seg_offset + segment->seg_length == app_offset &&
+      segment - element->e_sarray < element->e_scount - 1) {
+    /* matched the segment ending at app_offset */
+    ++segment;
+  }
+
+  if (NULL == segment || app_offset < segment->seg_offset ||
+      app_offset >= segment->seg_offset + segment->seg_length) {
+    hioi_object_unlock (&element->e_object);
+    return;
+  }
+
+  if (HIO_SEGMENT_CKSUM_INVALID != segment->seg_cksum_length &&
+      segment->seg_offset + segment->seg_cksum_length == app_offset &&
+      app_offset + length <= segment->seg_offset + segment->seg_length) {
+    segment->seg_checksum = hioi_crc32c (segment->seg_checksum, data, length);
+    segment->seg_cksum_length += length;
+  } else {
+    /* data was rewritten in place. the checksum can not be recovered */
+    segment->seg_cksum_length = HIO_SEGMENT_CKSUM_INVALID;
+  }
+
+  hioi_object_unlock (&element->e_object);
+}
+
+bool hioi_element_segment_checksum (hio_element_t element, uint64_t app_offset, size_t length, uint32_t *checksum) {
+  hio_manifest_segment_t *segment;
+  bool found = false;
+
+  hioi_object_lock (&element->e_object);
+
+  segment = (hio_manifest_segment_t *) bsearch ((void *) (intptr_t) app_offset, element->e_sarray,
+                                                element->e_scount, sizeof (element->e_sarray[0]),
+                                                hioi_element_segment_compare);
+  if (segment && segment->seg_offset != app_offset && segment - element->e_sarray < element->e_scount - 1) {
+    /* matched the segment ending at app_offset */
+    ++segment;
+  }
+
+  if (segment && segment->seg_offset == app_offset && segment->seg_length == length &&
+      segment->seg_cksum_length == length) {
+    *checksum = segment->seg_checksum;
+    found = true;
+  }
+
+  hioi_object_unlock (&element->e_object);
+
+  return found;
+}
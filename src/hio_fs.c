@@ -59,6 +59,12 @@
  * is hard-coded here. remove this line if cray ever defines this. */
 #define DW_SUPER_MAGIC 0x3e3f
 
+#elif HIO_DATAWARP_EMULATE
+
+/* the emulated burst buffer is an ordinary directory so it is never detected by
+ * filesystem magic */
+#include "builtin-datawarp_emulate.h"
+
 #endif
 
 static int hioi_fs_open_posix (hio_context_t context, const char *path, hio_fs_attr_t *fs_attr,
@@ -338,6 +344,7 @@ static int hioi_fs_set_stripe_lustre (const char *path, hio_fs_attr_t *fs_attr)
 #endif
 
 #if HIO_USE_DATAWARP
+#if defined(DW_SUPER_MAGIC)
 static int hioi_fs_query_datawarp (const char *path, hio_fs_attr_t *fs_attr) {
   int stripe_size, stripe_width, rc, fd, start;
 
@@ -363,6 +370,7 @@ static int hioi_fs_query_datawarp (const char *path, hio_fs_attr_t *fs_attr) {
 
   return HIO_SUCCESS;
 }
+#endif
 
 static int hioi_fs_set_stripe_datawarp (const char *path, hio_fs_attr_t *fs_attr) {
   int fd, rc;
@@ -453,7 +461,7 @@ int hioi_fs_query (hio_context_t context, const char *path, hio_fs_attr_t *fs_at
       /* panfs */
       break;
 #endif
-#if HIO_USE_DATAWARP
+#if defined(DW_SUPER_MAGIC)
     case DW_SUPER_MAGIC:
       hioi_fs_query_datawarp (tmp, fs_attr);
       break;
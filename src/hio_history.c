@@ -0,0 +1,264 @@
+/* -*- Mode: C; c-basic-offset:2 ; indent-tabs-mode:nil -*- */
+/*
+ * Copyright (c) 2017      Los Alamos National Security, LLC.  All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/**
+ * @file hio_history.c
+ * @brief Persistent dataset and data root history
+ *
+ * The statistics used to select data roots (hioi_context_select_module) and to
+ * recommend checkpoints (hio_dataset_should_checkpoint) are saved to a small text
+ * file in the context directory of the first data root each time a dataset is
+ * closed. The file is loaded when the context is created so a restarted job does
+ * not need to relearn them. Only rank 0 keeps these statistics so only rank 0 reads
+ * and writes the file. Data root failure counts are not saved. A failure seen by
+ * one job should not demote a data root for later jobs.
+ *
+ * File format (one record per line, names last as they may contain spaces):
+ *
+ *   hio_history <version>
+ *   root <bandwidth> <latency> <data root>
+ *   dataset <last id> <last completion> <average write time> <last write time> <last size> <bandwidth> <name>
+ */
+
+#include "hio_internal.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+#define HIOI_HISTORY_FILE    ".history"
+#define HIOI_HISTORY_VERSION 2
+
+/**
+ * Locate the history file for a context
+ *
+ * The file is kept in the context directory on the first data root that is a
+ * filesystem path. If the modules have not been created yet the data root is
+ * taken from the data_roots configuration variable.
+ */
+static int hioi_history_path (hio_context_t context, char **path) {
+  char *data_roots, *data_root, *last;
+  int rc = HIO_ERR_NOT_FOUND;
+
+  for (int i = 0 ; i < context->c_mcount ; ++i) {
+    if ('/' == context->c_modules[i]->data_root[0]) {
+      rc = asprintf (path, "%s/%s.hio/" HIOI_HISTORY_FILE, context->c_modules[i]->data_root,
+                     hioi_object_identifier (context));
+      return (0 > rc) ? HIO_ERR_OUT_OF_RESOURCE : HIO_SUCCESS;
+    }
+  }
+
+  if (NULL == context->c_droots) {
+    return HIO_ERR_NOT_FOUND;
+  }
+
+  data_roots = strdup (context->c_droots);
+  if (NULL == data_roots) {
+    return HIO_ERR_OUT_OF_RESOURCE;
+  }
+
+  for (data_root = strtok_r (data_roots, ",", &last) ; data_root ; data_root = strtok_r (NULL, ",", &last)) {
+    /* strip the module name if one was specified */
+    char *tmp = strchr (data_root, ':');
+    if (NULL != tmp) {
+      data_root = tmp + 1;
+    }
+
+    if ('/' == data_root[0]) {
+      rc = asprintf (path, "%s/%s.hio/" HIOI_HISTORY_FILE, data_root, hioi_object_identifier (context));
+      rc = (0 > rc) ? HIO_ERR_OUT_OF_RESOURCE : HIO_SUCCESS;
+      break;
+    }
+  }
+
+  free (data_roots);
+
+  return rc;
+}
+
+static void hioi_history_load_dataset (hio_context_t context, const char *line) {
+  unsigned long long average_write_time, last_write_time, last_size;
+  long long last_id, last_completion;
+  hio_dataset_data_t *ds_data;
+  double bandwidth;
+  int name_offset;
+
+  if (6 != sscanf (line, "dataset %lld %lld %llu %llu %llu %lf %n", &last_id, &last_completion,
+                   &average_write_time, &last_write_time, &last_size, &bandwidth, &name_offset) ||
+      '\0' == line[name_offset]) {
+    return;
+  }
+
+  if (HIO_SUCCESS != hioi_dataset_data_lookup (context, line + name_offset, &ds_data)) {
+    return;
+  }
+
+  ds_data->dd_last_id = last_id;
+  ds_data->dd_last_completion = (time_t) last_completion;
+  ds_data->dd_average_write_time = average_write_time;
+  ds_data->dd_last_write_time = last_write_time;
+  ds_data->dd_last_size = last_size;
+  ds_data->dd_bandwidth = bandwidth;
+}
+
+static void hioi_history_load_root (hio_context_t context, const char *line, int version) {
+  unsigned long long latency;
+  double bandwidth;
+  int failures, name_offset;
+
+  if (1 == version) {
+    /* version 1 also recorded the failure count. it is ignored */
+    if (3 != sscanf (line, "root %lf %llu %d %n", &bandwidth, &latency, &failures, &name_offset)) {
+      return;
+    }
+  } else if (2 != sscanf (line, "root %lf %llu %n", &bandwidth, &latency, &name_offset)) {
+    return;
+  }
+
+  if ('\0' == line[name_offset]) {
+    return;
+  }
+
+  for (int i = 0 ; i < context->c_mcount ; ++i) {
+    if (0 == strcmp (context->c_modules[i]->data_root, line + name_offset)) {
+      hio_module_stats_t *stats = context->c_module_stats + i;
+
+      stats->ms_bandwidth = bandwidth;
+      stats->ms_latency = latency;
+      break;
+    }
+  }
+}
+
+int hioi_history_load (hio_context_t context) {
+  char *path, line[4096];
+  bool load_datasets;
+  int version = 0;
+  FILE *fh;
+  int rc;
+
+  if (0 != context->c_rank) {
+    return HIO_SUCCESS;
+  }
+
+  rc = hioi_history_path (context, &path);
+  if (HIO_SUCCESS != rc) {
+    return rc;
+  }
+
+  fh = fopen (path, "r");
+  if (NULL == fh) {
+    hioi_log (context, HIO_VERBOSE_DEBUG_MED, "No dataset history found at %s", path);
+    free (path);
+    return HIO_ERR_NOT_FOUND;
+  }
+
+  if (NULL == fgets (line, sizeof (line), fh) || 1 != sscanf (line, "hio_history %d", &version) ||
+      1 > version || HIOI_HISTORY_VERSION < version) {
+    hioi_log (context, HIO_VERBOSE_WARN, "Ignoring dataset history %s with unsupported version %d",
+              path, version);
+    fclose (fh);
+    free (path);
+    return HIO_ERR_BAD_PARAM;
+  }
+
+  /* dataset history is only loaded once. it is updated by this job after that */
+  load_datasets = !context->c_history_loaded;
+
+  while (NULL != fgets (line, sizeof (line), fh)) {
+    line[strcspn (line, "\n")] = '\0';
+
+    if (load_datasets && 0 == strncmp (line, "dataset ", 8)) {
+      hioi_history_load_dataset (context, line);
+    } else if (0 == strncmp (line, "root ", 5)) {
+      hioi_history_load_root (context, line, version);
+    }
+  }
+
+  fclose (fh);
+
+  hioi_log (context, HIO_VERBOSE_DEBUG_LOW, "Loaded dataset history from %s", path);
+  free (path);
+
+  context->c_history_loaded = true;
+
+  return HIO_SUCCESS;
+}
+
+int hioi_history_save (hio_context_t context) {
+  hio_dataset_data_t *ds_data;
+  char *path, *tmp_path;
+  FILE *fh;
+  int rc;
+
+  if (0 != context->c_rank) {
+    return HIO_SUCCESS;
+  }
+
+  rc = hioi_history_path (context, &path);
+  if (HIO_SUCCESS != rc) {
+    return rc;
+  }
+
+  /* write to a temporary file first so a reader never sees a partial history */
+  rc = hioi_tmp_path (path, &tmp_path);
+  if (HIO_SUCCESS != rc) {
+    free (path);
+    return rc;
+  }
+
+  fh = fopen (tmp_path, "w");
+  if (NULL == fh) {
+    rc = hioi_err_errno (errno);
+    hioi_log (context, HIO_VERBOSE_DEBUG_LOW, "Could not save dataset history to %s. errno: %d", path, errno);
+    free (tmp_path);
+    free (path);
+    return rc;
+  }
+
+  fprintf (fh, "hio_history %d\n", HIOI_HISTORY_VERSION);
+
+  for (int i = 0 ; i < context->c_mcount ; ++i) {
+    hio_module_stats_t *stats = context->c_module_stats + i;
+
+    fprintf (fh, "root %.17g %llu %s\n", stats->ms_bandwidth, (unsigned long long) stats->ms_latency,
+             context->c_modules[i]->data_root);
+  }
+
+  hioi_object_lock (&context->c_object);
+  hioi_list_foreach (ds_data, context->c_ds_data, hio_dataset_data_t, dd_list) {
+    if (0 > ds_data->dd_last_id) {
+      /* nothing has been written */
+      continue;
+    }
+
+    fprintf (fh, "dataset %lld %lld %llu %llu %llu %.17g %s\n", (long long) ds_data->dd_last_id,
+             (long long) ds_data->dd_last_completion, (unsigned long long) ds_data->dd_average_write_time,
+             (unsigned long long) ds_data->dd_last_write_time, (unsigned long long) ds_data->dd_last_size,
+             ds_data->dd_bandwidth, ds_data->dd_name);
+  }
+  hioi_object_unlock (&context->c_object);
+
+  if (0 != fclose (fh) || 0 != rename (tmp_path, path)) {
+    rc = hioi_err_errno (errno);
+    hioi_log (context, HIO_VERBOSE_DEBUG_LOW, "Could not save dataset history to %s. errno: %d", path, errno);
+    (void) unlink (tmp_path);
+  } else {
+    rc = HIO_SUCCESS;
+  }
+
+  free (tmp_path);
+  free (path);
+
+  return rc;
+}
@@ -422,6 +422,74 @@ uint64_t hioi_gettime (void) {
 #endif
 }
 
+uint64_t hioi_gettime_ns (void) {
+#if defined(HAVE_CLOCK_GETTIME) && defined(CLOCK_MONOTONIC) && !HIO_DISABLE_CLOCK_GETTIME
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return 1000000000ul * ts.tv_sec + ts.tv_nsec;
+#else
+  struct timeval tv;
+  gettimeofday (&tv, NULL);
+  return 1000000000ul * tv.tv_sec + 1000ul * tv.tv_usec;
+#endif
+}
+
+__thread int hioi_stat_thread_shard;
+
+int hioi_stat_shard_assign (void) {
+  static atomic_ulong next_shard;
+  int shard = (int) (atomic_fetch_add (&next_shard, 1) % HIO_STAT_SHARDS);
+
+  hioi_stat_thread_shard = shard + 1;
+
+  return shard;
+}
+
+/**
+ * Largest latency (nsec) counted in a histogram bucket
+ */
+static uint64_t hioi_latency_bucket_limit (int index) {
+  const int sub_count = 1 << HIO_LATENCY_SUB_BITS;
+  int shift;
+
+  if (index < sub_count) {
+    return index;
+  }
+
+  if (HIO_LATENCY_BUCKETS - 1 == index) {
+    return UINT64_MAX;
+  }
+
+  shift = (index >> HIO_LATENCY_SUB_BITS) - 1;
+
+  return ((uint64_t) (sub_count + (index & (sub_count - 1)) + 1) << shift) - 1;
+}
+
+void hioi_latency_summarize (const hio_latency_histogram_t *histogram, hio_latency_summary_t *summary) {
+  const double percentiles[] = {0.5, 0.9, 0.99};
+  uint64_t *values[] = {&summary->ls_p50, &summary->ls_p90, &summary->ls_p99};
+  uint64_t count = 0, total = 0, max = atomic_load (&histogram->lh_max);
+  int next = 0;
+
+  for (int i = 0 ; i < HIO_LATENCY_BUCKETS ; ++i) {
+    total += atomic_load (histogram->lh_buckets + i);
+  }
+
+  memset (summary, 0, sizeof (*summary));
+  summary->ls_count = total;
+  summary->ls_max = max;
+
+  for (int i = 0 ; i < HIO_LATENCY_BUCKETS && next < 3 && total ; ++i) {
+    count += atomic_load (histogram->lh_buckets + i);
+
+    while (next < 3 && (double) count >= percentiles[next] * (double) total) {
+      uint64_t limit = hioi_latency_bucket_limit (i);
+
+      *values[next++] = limit < max ? limit : max;
+    }
+  }
+}
+
 int hioi_mkpath (hio_context_t context, const char *path, mode_t access_mode) {
   char *tmp = strdup (path);
   int rc;
@@ -461,6 +529,23 @@ int hioi_mkpath (hio_context_t context, const char *path, mode_t access_mode) {
   return (rc && errno != EEXIST) ? HIO_ERROR : HIO_SUCCESS;
 }
 
+int hioi_tmp_path (const char *path, char **tmp_path) {
+  char hostname[256];
+
+  if (0 != gethostname (hostname, sizeof (hostname))) {
+    strcpy (hostname, "unknown");
+  }
+
+  /* gethostname does not guarantee termination if the name was truncated */
+  hostname[sizeof (hostname) - 1] = '\0';
+
+  if (0 > asprintf (tmp_path, "%s.%s.%d", path, hostname, (int) getpid ())) {
+    return HIO_ERR_OUT_OF_RESOURCE;
+  }
+
+  return HIO_SUCCESS;
+}
+
 hio_object_t hioi_object_alloc (const char *name, hio_object_type_t type, hio_object_t parent,
                                 size_t object_size, hio_object_release_fn_t release_fn) {
   pthread_mutexattr_t mutex_attr;
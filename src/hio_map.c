@@ -21,6 +21,12 @@
 /* number of entries to get at once */
 #define HIO_MAP_BUCKET_SIZE 8
 
+/* number of fence keys each node leader publishes in the range engine splitter table */
+#define HIO_MAP_RANGE_FENCES 64
+
+/* number of uint64_t's in the splitter table for each node leader (count, stride, fence keys) */
+#define HIO_MAP_RANGE_TABLE_STRIDE (2 + 2 * HIO_MAP_RANGE_FENCES)
+
 enum hio_map_state_t {
   HIO_MAP_STATE_FREE,
   HIO_MAP_STATE_PENDING,
@@ -72,6 +78,23 @@ typedef struct hio_map_segment_t {
   } value;
 } hio_map_segment_t;
 
+/**
+ * Segment record stored in the range-partitioned segment index. Records
+ * are globally sorted by (element index, application offset).
+ */
+typedef struct hio_map_range_record_t {
+  /** element index */
+  uint32_t mr_index;
+  /** index of file holding the segment */
+  uint32_t mr_findex;
+  /** segment application offset */
+  uint64_t mr_aoff;
+  /** segment size */
+  uint64_t mr_size;
+  /** offset of segment within the file */
+  uint64_t mr_foff;
+} hio_map_range_record_t;
+
 typedef bool (*hioi_map_key_compare_fn_t) (const void *a, const void *b);
 typedef void (*hioi_map_element_prepare_fn_t) (MPI_Win win, void *data, void *key, int64_t count);
 typedef uint64_t (*hioi_map_hash_fn_t) (void *value);
@@ -517,9 +540,515 @@ static int hioi_dataset_map_generate_segment_map (hio_dataset_t dataset, uint64_
   return HIO_SUCCESS;
 }
 
+static inline int hioi_map_range_key_compare (uint64_t index_a, uint64_t aoff_a, uint64_t index_b,
+                                              uint64_t aoff_b) {
+  if (index_a != index_b) {
+    return (index_a < index_b) ? -1 : 1;
+  }
+
+  if (aoff_a != aoff_b) {
+    return (aoff_a < aoff_b) ? -1 : 1;
+  }
+
+  return 0;
+}
+
+static int hioi_map_range_record_compare (const void *a, const void *b) {
+  const hio_map_range_record_t *reca = (const hio_map_range_record_t *) a;
+  const hio_map_range_record_t *recb = (const hio_map_range_record_t *) b;
+
+  return hioi_map_range_key_compare (reca->mr_index, reca->mr_aoff, recb->mr_index, recb->mr_aoff);
+}
+
+static int hioi_map_range_key_compare_qsort (const void *a, const void *b) {
+  const uint64_t *keya = (const uint64_t *) a;
+  const uint64_t *keyb = (const uint64_t *) b;
+
+  return hioi_map_range_key_compare (keya[0], keya[1], keyb[0], keyb[1]);
+}
+
+/**
+ * Sort all segments in the dataset across the node leaders
+ *
+ * @param[in]  dataset     hio dataset object
+ * @param[out] records_out sorted records owned by this node leader
+ * @param[out] count_out   number of records in records_out
+ *
+ * This function implements a parallel sample sort. Every leader sorts its local
+ * segments, contributes regularly spaced samples, and then sends each record to
+ * the leader that owns the key range it falls in. On return every leader holds
+ * a sorted slice of the global segment list. Must only be called by node leaders.
+ */
+static int hioi_dataset_map_range_sort (hio_dataset_t dataset, hio_map_range_record_t **records_out,
+                                        uint64_t *count_out) {
+  hio_context_t context = hioi_object_context (&dataset->ds_object);
+  int nleaders = context->c_node_count, nsamples = context->c_node_count - 1;
+  int *send_counts = NULL, *send_displs, *recv_counts, *recv_displs;
+  hio_map_range_record_t *records, *sorted = NULL;
+  uint64_t *samples = NULL, *splitters, count = 0, sorted_count = 0;
+  MPI_Datatype record_type = MPI_DATATYPE_NULL;
+  hio_element_t element;
+  int rc = HIO_SUCCESS, j;
+
+  hioi_list_foreach (element, dataset->ds_elist, struct hio_element, e_list) {
+    count += element->e_scount;
+  }
+
+  records = (hio_map_range_record_t *) malloc (count * sizeof (records[0]) + 1);
+  if (NULL == records) {
+    if (1 == nleaders) {
+      return HIO_ERR_OUT_OF_RESOURCE;
+    }
+
+    /* the other leaders still need to be told about the failure */
+    rc = HIO_ERR_OUT_OF_RESOURCE;
+  }
+
+  count = 0;
+  hioi_list_foreach (element, dataset->ds_elist, struct hio_element, e_list) {
+    if (NULL == records) {
+      break;
+    }
+
+    for (size_t i = 0 ; i < element->e_scount ; ++i, ++count) {
+      hio_manifest_segment_t *segment = element->e_sarray + i;
+
+      records[count].mr_index = element->e_index;
+      records[count].mr_findex = segment->seg_file_index;
+      records[count].mr_aoff = segment->seg_offset;
+      records[count].mr_size = segment->seg_length;
+      records[count].mr_foff = segment->seg_foffset;
+    }
+  }
+
+  if (records) {
+    qsort (records, count, sizeof (records[0]), hioi_map_range_record_compare);
+  }
+
+  if (1 == nleaders) {
+    /* nothing more to do */
+    *records_out = records;
+    *count_out = count;
+    return HIO_SUCCESS;
+  }
+
+  do {
+    /* the sample buffer holds (nleaders - 1) keys from every leader followed by
+     * the nleaders - 1 keys contributed by this leader */
+    samples = (uint64_t *) malloc ((nleaders + 1) * nsamples * 2 * sizeof (uint64_t));
+    send_counts = (int *) calloc (4 * nleaders, sizeof (int));
+    if (NULL == samples || NULL == send_counts) {
+      rc = HIO_ERR_OUT_OF_RESOURCE;
+    }
+
+    /* all leaders must agree before entering the exchange or a failed leader will
+     * leave the others waiting in a collective it never calls */
+    MPI_Allreduce (MPI_IN_PLACE, &rc, 1, MPI_INT, MPI_MIN, context->c_node_leader_comm);
+    if (HIO_SUCCESS != rc) {
+      break;
+    }
+
+    send_displs = send_counts + nleaders;
+    recv_counts = send_displs + nleaders;
+    recv_displs = recv_counts + nleaders;
+
+    /* pick regularly spaced samples. leaders without any records contribute the
+     * maximum key so their samples sort to the end */
+    splitters = samples + nleaders * nsamples * 2;
+    for (int i = 0 ; i < nsamples ; ++i) {
+      if (count) {
+        uint64_t sample_index = ((uint64_t) i + 1) * count / nleaders;
+
+        splitters[2 * i] = records[sample_index].mr_index;
+        splitters[2 * i + 1] = records[sample_index].mr_aoff;
+      } else {
+        splitters[2 * i] = splitters[2 * i + 1] = UINT64_MAX;
+      }
+    }
+
+    rc = MPI_Allgather (splitters, nsamples * 2, MPI_UINT64_T, samples, nsamples * 2, MPI_UINT64_T,
+                        context->c_node_leader_comm);
+    if (MPI_SUCCESS != rc) {
+      rc = hioi_err_mpi (rc);
+      break;
+    }
+
+    qsort (samples, nleaders * nsamples, 2 * sizeof (uint64_t), hioi_map_range_key_compare_qsort);
+
+    /* select the global splitters. leader i owns keys in [splitter[i-1], splitter[i]) */
+    for (int i = 0 ; i < nsamples ; ++i) {
+      splitters[2 * i] = samples[2 * (i + 1) * nsamples];
+      splitters[2 * i + 1] = samples[2 * (i + 1) * nsamples + 1];
+    }
+
+    /* local records are sorted so the partition boundaries can be found in a single pass.
+     * counts are in records (not bytes) so a leader can exchange more than 2 GiB */
+    j = 0;
+    for (uint64_t i = 0 ; i < count ; ++i) {
+      while (j < nsamples && hioi_map_range_key_compare (records[i].mr_index, records[i].mr_aoff,
+                                                         splitters[2 * j], splitters[2 * j + 1]) >= 0) {
+        ++j;
+      }
+
+      send_counts[j]++;
+    }
+
+    rc = MPI_Alltoall (send_counts, 1, MPI_INT, recv_counts, 1, MPI_INT, context->c_node_leader_comm);
+    if (MPI_SUCCESS != rc) {
+      rc = hioi_err_mpi (rc);
+      break;
+    }
+
+    for (int i = 0 ; i < nleaders ; ++i) {
+      send_displs[i] = i ? send_displs[i-1] + send_counts[i-1] : 0;
+      recv_displs[i] = i ? recv_displs[i-1] + recv_counts[i-1] : 0;
+      sorted_count += recv_counts[i];
+    }
+
+    sorted = (hio_map_range_record_t *) malloc (sorted_count * sizeof (sorted[0]) + 1);
+    rc = sorted ? HIO_SUCCESS : HIO_ERR_OUT_OF_RESOURCE;
+
+    MPI_Allreduce (MPI_IN_PLACE, &rc, 1, MPI_INT, MPI_MIN, context->c_node_leader_comm);
+    if (HIO_SUCCESS != rc) {
+      break;
+    }
+
+    MPI_Type_contiguous (sizeof (hio_map_range_record_t), MPI_BYTE, &record_type);
+    MPI_Type_commit (&record_type);
+
+    rc = MPI_Alltoallv (records, send_counts, send_displs, record_type, sorted, recv_counts, recv_displs,
+                        record_type, context->c_node_leader_comm);
+    if (MPI_SUCCESS != rc) {
+      rc = hioi_err_mpi (rc);
+      break;
+    }
+
+    count = sorted_count;
+    qsort (sorted, count, sizeof (sorted[0]), hioi_map_range_record_compare);
+  } while (0);
+
+  if (MPI_DATATYPE_NULL != record_type) {
+    MPI_Type_free (&record_type);
+  }
+
+  free (samples);
+  free (send_counts);
+  free (records);
+
+  if (HIO_SUCCESS != rc) {
+    free (sorted);
+    return rc;
+  }
+
+  *records_out = sorted;
+  *count_out = count;
+
+  return HIO_SUCCESS;
+}
+
+static int hioi_dataset_map_generate_range_map (hio_dataset_t dataset) {
+  hio_context_t context = hioi_object_context (&dataset->ds_object);
+  hio_dataset_map_t *map = &dataset->ds_map;
+  hio_map_range_record_t *records = NULL;
+  size_t table_size = context->c_node_count * HIO_MAP_RANGE_TABLE_STRIDE;
+  uint64_t count = 0, *entry;
+  void *base;
+  int rc = HIO_SUCCESS;
+
+  map->map_range_table = (uint64_t *) calloc (table_size, sizeof (uint64_t));
+  if (NULL == map->map_range_table) {
+    rc = HIO_ERR_OUT_OF_RESOURCE;
+  }
+
+  /* every failure below must be agreed on before returning. the node peers wait on
+   * their leader in the broadcast and all ranks take part in the window allocation */
+  MPI_Allreduce (MPI_IN_PLACE, &rc, 1, MPI_INT, MPI_MIN, context->c_comm);
+  if (HIO_SUCCESS != rc) {
+    free (map->map_range_table);
+    map->map_range_table = NULL;
+    return rc;
+  }
+
+  if (0 == context->c_shared_rank) {
+    uint64_t local_entry[HIO_MAP_RANGE_TABLE_STRIDE];
+    uint64_t stride;
+
+    /* the sort agrees on errors across the node leaders internally */
+    hioi_timed_call(rc = hioi_dataset_map_range_sort (dataset, &records, &count));
+    if (HIO_SUCCESS == rc) {
+      /* publish every stride-th key so lookups can narrow a query down to a single
+       * contiguous run of records on the owning leader */
+      stride = (count + HIO_MAP_RANGE_FENCES - 1) / HIO_MAP_RANGE_FENCES;
+      if (0 == stride) {
+        stride = 1;
+      }
+
+      local_entry[0] = count;
+      local_entry[1] = stride;
+      for (int i = 0 ; i < HIO_MAP_RANGE_FENCES ; ++i) {
+        if (i * stride < count) {
+          local_entry[2 + 2 * i] = records[i * stride].mr_index;
+          local_entry[3 + 2 * i] = records[i * stride].mr_aoff;
+        } else {
+          local_entry[2 + 2 * i] = local_entry[3 + 2 * i] = UINT64_MAX;
+        }
+      }
+
+      rc = MPI_Allgather (local_entry, HIO_MAP_RANGE_TABLE_STRIDE, MPI_UINT64_T, map->map_range_table,
+                          HIO_MAP_RANGE_TABLE_STRIDE, MPI_UINT64_T, context->c_node_leader_comm);
+      if (MPI_SUCCESS != rc) {
+        rc = hioi_err_mpi (rc);
+      }
+    }
+  }
+
+  /* share the leader's result with the node then make sure every node saw the same */
+  MPI_Bcast (&rc, 1, MPI_INT, 0, context->c_shared_comm);
+  MPI_Allreduce (MPI_IN_PLACE, &rc, 1, MPI_INT, MPI_MIN, context->c_comm);
+  if (HIO_SUCCESS == rc) {
+    rc = MPI_Bcast (map->map_range_table, table_size, MPI_UINT64_T, 0, context->c_shared_comm);
+    rc = (MPI_SUCCESS == rc) ? HIO_SUCCESS : hioi_err_mpi (rc);
+  }
+
+  if (HIO_SUCCESS != rc) {
+    free (records);
+    free (map->map_range_table);
+    map->map_range_table = NULL;
+    return rc;
+  }
+
+  /* leaders without records inherit the first key of the previous leader. this keeps
+   * the first fence column monotonic so the owner of a key can be found with a binary
+   * search. */
+  if (0 == map->map_range_table[0]) {
+    map->map_range_table[2] = map->map_range_table[3] = 0;
+  }
+
+  for (int i = 1 ; i < context->c_node_count ; ++i) {
+    entry = map->map_range_table + i * HIO_MAP_RANGE_TABLE_STRIDE;
+    if (0 == entry[0]) {
+      entry[2] = entry[2 - HIO_MAP_RANGE_TABLE_STRIDE];
+      entry[3] = entry[3 - HIO_MAP_RANGE_TABLE_STRIDE];
+    }
+  }
+
+  map->map_ranges.md_local_size = count;
+  map->map_ranges.md_element_size = sizeof (hio_map_range_record_t);
+
+  hioi_timed_call(rc = MPI_Win_allocate (count * sizeof (records[0]), 1, MPI_INFO_NULL, context->c_comm,
+                                         (void *) &base, &map->map_ranges.md_win));
+  if (MPI_SUCCESS != rc) {
+    map->map_ranges.md_win = MPI_WIN_NULL;
+    free (records);
+    return hioi_err_mpi (rc);
+  }
+
+  if (count) {
+    memcpy (base, records, count * sizeof (records[0]));
+  }
+
+  free (records);
+
+  MPI_Barrier (context->c_comm);
+
+  MPI_Win_lock_all (0, map->map_ranges.md_win);
+
+  return HIO_SUCCESS;
+}
+
+/**
+ * Find the index of the last fence in an array that is less than or equal to a key
+ *
+ * @param[in] fences      array of (element index, application offset) pairs
+ * @param[in] fence_count number of fences in the array
+ * @param[in] stride      distance between fences (in uint64_t's)
+ * @param[in] index       element index
+ * @param[in] aoff        application offset
+ *
+ * @returns -1 if all fences are greater than the key
+ */
+static int hioi_map_range_fence_search (const uint64_t *fences, int fence_count, int stride, uint64_t index,
+                                        uint64_t aoff) {
+  int low = 0, high = fence_count - 1, found = -1;
+
+  while (low <= high) {
+    int mid = (low + high) / 2;
+    const uint64_t *fence = fences + mid * stride;
+
+    if (hioi_map_range_key_compare (fence[0], fence[1], index, aoff) <= 0) {
+      found = mid;
+      low = mid + 1;
+    } else {
+      high = mid - 1;
+    }
+  }
+
+  return found;
+}
+
+/* find the leader holding the largest key less than or equal to (index, aoff) */
+static int hioi_map_range_owner (hio_dataset_map_t *map, int node_count, uint64_t index, uint64_t aoff) {
+  int owner = hioi_map_range_fence_search (map->map_range_table + 2, node_count, HIO_MAP_RANGE_TABLE_STRIDE,
+                                           index, aoff);
+
+  /* skip leaders that have no records */
+  while (owner >= 0 && 0 == map->map_range_table[owner * HIO_MAP_RANGE_TABLE_STRIDE]) {
+    --owner;
+  }
+
+  return owner;
+}
+
+/**
+ * Query the range index for all segments of an element covering [offset, offset + length)
+ *
+ * @param[in] element hio element object
+ * @param[in] offset  application offset
+ * @param[in] length  length of query
+ *
+ * This function uses the local splitter table to locate the leader and the run of
+ * records that hold the requested range then fetches the run with a single MPI_Get.
+ * The segments belonging to the element are stored in the element's map cache. If
+ * the range spans more than one leader only the segments held by the first leader
+ * are returned.
+ */
+static int hioi_dataset_map_range_query (hio_element_t element, uint64_t offset, uint64_t length) {
+  hio_context_t context = hioi_object_context (&element->e_object);
+  hio_dataset_t dataset = hioi_element_dataset (element);
+  hio_dataset_map_t *map = &dataset->ds_map;
+  uint64_t last = offset + (length ? length - 1 : 0), count, stride, start, end;
+  hio_map_range_record_t *records;
+  hio_manifest_segment_t *cache;
+  int owner, fence_count, first_fence, last_fence, rc;
+  size_t cache_count = 0;
+  uint64_t *entry;
+
+  if (MPI_WIN_NULL == map->map_ranges.md_win) {
+    return HIO_ERR_NOT_FOUND;
+  }
+
+  owner = hioi_map_range_owner (map, context->c_node_count, element->e_index, offset);
+  if (0 > owner) {
+    return HIO_ERR_NOT_FOUND;
+  }
+
+  entry = map->map_range_table + owner * HIO_MAP_RANGE_TABLE_STRIDE;
+  count = entry[0];
+  stride = entry[1];
+  fence_count = (count + stride - 1) / stride;
+
+  first_fence = hioi_map_range_fence_search (entry + 2, fence_count, 2, element->e_index, offset);
+  start = first_fence * stride;
+
+  if (owner == hioi_map_range_owner (map, context->c_node_count, element->e_index, last)) {
+    last_fence = hioi_map_range_fence_search (entry + 2, fence_count, 2, element->e_index, last);
+    end = (last_fence + 1) * stride;
+    if (end > count) {
+      end = count;
+    }
+  } else {
+    end = count;
+  }
+
+  records = (hio_map_range_record_t *) malloc ((end - start) * sizeof (*records));
+  if (NULL == records) {
+    return HIO_ERR_OUT_OF_RESOURCE;
+  }
+
+  rc = MPI_Get (records, (end - start) * sizeof (*records), MPI_BYTE, context->c_node_leaders[owner],
+                start * sizeof (*records), (end - start) * sizeof (*records), MPI_BYTE, map->map_ranges.md_win);
+  if (MPI_SUCCESS == rc) {
+    rc = MPI_Win_flush (context->c_node_leaders[owner], map->map_ranges.md_win);
+  }
+
+  if (MPI_SUCCESS != rc) {
+    free (records);
+    return hioi_err_mpi (rc);
+  }
+
+  cache = (hio_manifest_segment_t *) calloc (end - start, sizeof (*cache));
+  if (NULL == cache) {
+    free (records);
+    return HIO_ERR_OUT_OF_RESOURCE;
+  }
+
+  /* records are sorted so the element's segments are contiguous in the run */
+  for (uint64_t i = 0 ; i < end - start ; ++i) {
+    hio_map_range_record_t record = records[i];
+
+    if (record.mr_index != element->e_index) {
+      continue;
+    }
+
+    cache[cache_count].seg_offset = record.mr_aoff;
+    cache[cache_count].seg_length = record.mr_size;
+    cache[cache_count].seg_foffset = record.mr_foff;
+    cache[cache_count++].seg_file_index = record.mr_findex;
+  }
+
+  free (records);
+
+  free (element->e_map_cache);
+  element->e_map_cache = cache;
+  element->e_map_cache_count = cache_count;
+
+  return HIO_SUCCESS;
+}
+
+static hio_manifest_segment_t *hioi_map_range_cache_search (hio_element_t element, uint64_t app_offset) {
+  hio_manifest_segment_t *segments = element->e_map_cache;
+  int64_t low = 0, high = (int64_t) element->e_map_cache_count - 1;
+
+  while (low <= high) {
+    int64_t mid = (low + high) / 2;
+    hio_manifest_segment_t *segment = segments + mid;
+
+    if (app_offset < segment->seg_offset) {
+      high = mid - 1;
+    } else if (app_offset >= segment->seg_offset + segment->seg_length) {
+      low = mid + 1;
+    } else {
+      return segment;
+    }
+  }
+
+  return NULL;
+}
+
+static int hioi_dataset_map_range_translate (hio_element_t element, uint64_t app_offset, int *file_index,
+                                             uint64_t *offset, size_t *length) {
+  hio_manifest_segment_t *segment;
+  uint64_t bound;
+  int rc;
+
+  segment = hioi_map_range_cache_search (element, app_offset);
+  if (NULL == segment) {
+    rc = hioi_dataset_map_range_query (element, app_offset, *length);
+    if (HIO_SUCCESS != rc) {
+      return rc;
+    }
+
+    segment = hioi_map_range_cache_search (element, app_offset);
+    if (NULL == segment) {
+      return HIO_ERR_NOT_FOUND;
+    }
+  }
+
+  bound = segment->seg_offset + segment->seg_length;
+
+  *file_index = segment->seg_file_index;
+  *offset = segment->seg_foffset + app_offset - segment->seg_offset;
+  if (app_offset + *length > bound) {
+    *length = bound - app_offset;
+  }
+
+  return HIO_SUCCESS;
+}
+
 int hioi_dataset_generate_map (hio_dataset_t dataset) {
   hio_context_t context = hioi_object_context (&dataset->ds_object);
-  uint64_t counts[2] = {0, 0};
+  /* element count, segment count, and the result of loading the elements */
+  int64_t counts[3] = {0, 0, HIO_SUCCESS};
   hio_element_t element;
   int rc;
 
@@ -540,6 +1069,13 @@ int hioi_dataset_generate_map (hio_dataset_t dataset) {
 
   do {
     if (0 == context->c_shared_rank) {
+      /* the map covers every element in the manifest */
+      counts[2] = hioi_manifest_directory_load_all (dataset);
+      if (HIO_SUCCESS != counts[2]) {
+        /* keep going. other node leaders are waiting on this rank */
+        hioi_err_push ((int) counts[2], &dataset->ds_object, "could not load all manifest elements");
+      }
+
       /* determine the number of elements and segments in the dataset */
       hioi_list_foreach (element, dataset->ds_elist, struct hio_element, e_list) {
         ++counts[0];
@@ -548,24 +1084,38 @@ int hioi_dataset_generate_map (hio_dataset_t dataset) {
 
       rc = MPI_Allreduce (MPI_IN_PLACE, counts, 2, MPI_INT64_T, MPI_SUM,
                           context->c_node_leader_comm);
+      if (MPI_SUCCESS == rc) {
+        /* a map generated from a partial element list is wrong on every node */
+        rc = MPI_Allreduce (MPI_IN_PLACE, counts + 2, 1, MPI_INT64_T, MPI_MIN,
+                            context->c_node_leader_comm);
+      }
       if (MPI_SUCCESS != rc) {
         rc = hioi_err_mpi (rc);
         break;
       }
     }
 
-    rc = MPI_Bcast (counts, 2, MPI_INT64_T, 0, context->c_shared_comm);
+    rc = MPI_Bcast (counts, 3, MPI_INT64_T, 0, context->c_shared_comm);
     if (MPI_SUCCESS != rc) {
       rc = hioi_err_mpi (rc);
       break;
     }
 
+    rc = (int) counts[2];
+    if (HIO_SUCCESS != rc) {
+      break;
+    }
+
     hioi_timed_call(rc = hioi_dataset_map_generate_element_map (dataset, counts[0]));
     if (HIO_SUCCESS != rc) {
       break;
     }
 
-    hioi_timed_call(rc = hioi_dataset_map_generate_segment_map (dataset, counts[1]));
+    if (HIO_MAP_ENGINE_RANGE == dataset->ds_map.map_engine) {
+      hioi_timed_call(rc = hioi_dataset_map_generate_range_map (dataset));
+    } else {
+      hioi_timed_call(rc = hioi_dataset_map_generate_segment_map (dataset, counts[1]));
+    }
   } while (0);
 
   hioi_object_unlock (&context->c_object);
@@ -574,8 +1124,21 @@ int hioi_dataset_generate_map (hio_dataset_t dataset) {
 }
 
 int hioi_dataset_map_release (hio_dataset_t dataset) {
+  hio_element_t element;
+
   hioi_dataset_map_data_finalize (&dataset->ds_map.map_segments);
   hioi_dataset_map_data_finalize (&dataset->ds_map.map_elements);
+  hioi_dataset_map_data_finalize (&dataset->ds_map.map_ranges);
+
+  free (dataset->ds_map.map_range_table);
+  dataset->ds_map.map_range_table = NULL;
+
+  /* cached segments are no longer valid */
+  hioi_list_foreach (element, dataset->ds_elist, struct hio_element, e_list) {
+    free (element->e_map_cache);
+    element->e_map_cache = NULL;
+    element->e_map_cache_count = 0;
+  }
 
   return HIO_SUCCESS;
 }
@@ -641,6 +1204,7 @@ static int hioi_dataset_map_lookup_segment (hio_element_t element, int64_t app_o
 int hioi_dataset_map_translate_offset (hio_element_t element, uint64_t app_offset,
                                        int *file_index, uint64_t *offset, size_t *length) {
   hio_map_segment_t segment = {.key = {.ms_aoff = 0, .ms_size = 0}, .value = {.ms_findex = -1, .ms_foff = -1}};
+  hio_dataset_t dataset = hioi_element_dataset (element);
   uint64_t base, bound;
   int rc;
 
@@ -651,6 +1215,10 @@ int hioi_dataset_map_translate_offset (hio_element_t element, uint64_t app_offse
     }
   }
 
+  if (HIO_MAP_ENGINE_RANGE == dataset->ds_map.map_engine) {
+    return hioi_dataset_map_range_translate (element, app_offset, file_index, offset, length);
+  }
+
   rc = hioi_dataset_map_lookup_segment (element, app_offset, &segment);
   if (HIO_SUCCESS != rc) {
     return rc;
@@ -57,7 +57,9 @@ static int hioi_request_test_internal (hio_request_t *requests, int nrequests, s
       }
 
       if (bytes_transferred) {
-        bytes_transferred[i] = requests[i]->req_transferred;
+        /* a request that completed in error reports the error code */
+        bytes_transferred[i] = (HIO_SUCCESS > requests[i]->req_status) ? requests[i]->req_status :
+          requests[i]->req_transferred;
       }
 
       hioi_request_release (requests[i]);
@@ -78,7 +80,7 @@ int hio_request_test (hio_request_t *requests, int nrequests, ssize_t *bytes_tra
 }
 
 int hio_request_wait (hio_request_t *requests, int nrequests, ssize_t *bytes_transferred) {
-  bool first = true;
+  bool first = true, progress;
   int rc;
 
   do {
@@ -93,6 +95,25 @@ int hio_request_wait (hio_request_t *requests, int nrequests, ssize_t *bytes_tra
 
     first = false;
 
+    /* requests may be waiting on deferred operations. give their elements a chance to complete them */
+    progress = false;
+    for (int i = 0 ; i < nrequests ; ++i) {
+      if (HIO_OBJECT_NULL != requests[i] && !requests[i]->req_complete && requests[i]->req_element) {
+        rc = hio_complete (requests[i]->req_element);
+        if (requests[i]->req_complete) {
+          /* errors from individual reads are reported through bytes_transferred */
+          progress = true;
+        } else if (HIO_SUCCESS != rc) {
+          /* the deferred operations could not be started. waiting longer will not help */
+          return rc;
+        }
+      }
+    }
+
+    if (progress) {
+      continue;
+    }
+
     struct timespec interval = {.tv_sec = 0, .tv_nsec = 1000};
     nanosleep (&interval, NULL);
   } while (1);
@@ -0,0 +1,494 @@
+/* -*- Mode: C; c-basic-offset:2 ; indent-tabs-mode:nil -*- */
+/*
+ * Copyright (c) 2017      Los Alamos National Security, LLC.  All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/**
+ * @file hio_trace.c
+ * @brief Binary event tracing
+ *
+ * Each thread that records an event into a trace gets its own fixed-size ring of
+ * event records. The owning thread is the only writer of the ring head and a
+ * flush thread (one per trace) is the only writer of the ring tail so recording
+ * an event does not take a lock. The flush thread periodically appends the
+ * contents of every ring to the trace file. Events recorded while a ring is full
+ * are dropped and the number of dropped events is recorded in the trace.
+ *
+ * A trace file is a sequence of sessions. Each session starts with a header
+ * followed by the dataset name (padded to 8 bytes) and the event records of the
+ * session. hio_trace_dump() converts trace files to text or Chrome trace JSON.
+ */
+
+#include "hio_internal.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#define HIO_TRACE_MAGIC        "HIOTRACE"
+#define HIO_TRACE_BYTE_ORDER   0x01020304
+#define HIO_TRACE_VERSION      1
+
+/** number of records in each thread's ring (power of two) */
+#define HIO_TRACE_RING_SIZE    4096
+
+/** time between flushes of the trace rings (ms) */
+#define HIO_TRACE_FLUSH_INTERVAL 100
+
+typedef struct hio_trace_header_t {
+  /** magic string (not NULL-terminated) */
+  char     th_magic[8];
+  /** byte order marker (HIO_TRACE_BYTE_ORDER in the writer's byte order) */
+  uint32_t th_byte_order;
+  /** trace format version */
+  uint32_t th_version;
+  /** rank that wrote the trace */
+  int32_t  th_rank;
+  /** length of the dataset name that follows the header */
+  uint32_t th_identifier_length;
+  /** dataset identifier */
+  int64_t  th_dataset_id;
+  /** size of an event record */
+  uint32_t th_record_size;
+  uint32_t th_resv0;
+} hio_trace_header_t;
+
+typedef struct hio_trace_record_t {
+  /** event start time (nsec, monotonic) */
+  uint64_t tr_start;
+  /** event stop time (nsec, monotonic) */
+  uint64_t tr_stop;
+  /** event payload */
+  uint64_t tr_value;
+  uint64_t tr_value2;
+  /** event identifier (see hio_trace_event_t) */
+  uint16_t tr_event;
+  /** index of the thread that recorded the event */
+  uint16_t tr_thread;
+  uint32_t tr_resv0;
+} hio_trace_record_t;
+
+typedef struct hio_trace_ring_t {
+  /** entry in the trace ring list */
+  hio_list_t          r_list;
+  /** thread that owns this ring */
+  pthread_t           r_owner;
+  /** index of this thread in the trace */
+  uint16_t            r_thread;
+  /** next record to write. only modified by the owner */
+  atomic_ulong        r_head;
+  char                r_pad0[64];
+  /** next record to flush. only modified by the flush thread */
+  atomic_ulong        r_tail;
+  char                r_pad1[64];
+  /** number of events dropped because the ring was full */
+  atomic_ulong        r_dropped;
+  hio_trace_record_t  r_records[HIO_TRACE_RING_SIZE];
+} hio_trace_ring_t;
+
+struct hio_trace {
+  /** unique identifier for this trace. used to validate the per-thread ring cache */
+  unsigned long       t_generation;
+  /** trace file descriptor */
+  int                 t_fd;
+  /** rings of all threads that have recorded events */
+  hio_list_t          t_rings;
+  /** number of rings in t_rings */
+  int                 t_ring_count;
+  /** protects t_rings and the flush thread state */
+  pthread_mutex_t     t_lock;
+  pthread_cond_t      t_cond;
+  pthread_t           t_thread;
+  bool                t_stop;
+};
+
+static const char *hioi_trace_event_names[HIO_TRACE_EVENT_MAX] = {
+  [HIO_TRACE_EVENT_TRACE_BEGIN] = "trace_begin",
+  [HIO_TRACE_EVENT_TRACE_END] = "trace_end",
+  [HIO_TRACE_EVENT_DROPPED] = "dropped",
+  [HIO_TRACE_EVENT_OPEN] = "open",
+  [HIO_TRACE_EVENT_CLOSE] = "close",
+  [HIO_TRACE_EVENT_SHARED_INIT] = "shared_init",
+  [HIO_TRACE_EVENT_GENERATE_MAP] = "generate_map",
+  [HIO_TRACE_EVENT_GATHER_MANIFEST] = "gather_manifest",
+  [HIO_TRACE_EVENT_FILE_OPEN] = "file_open",
+  [HIO_TRACE_EVENT_FILE_CLOSE] = "file_close",
+  [HIO_TRACE_EVENT_FILE_SEEK] = "file_seek",
+  [HIO_TRACE_EVENT_FILE_READ] = "file_read",
+  [HIO_TRACE_EVENT_FILE_WRITE] = "file_write",
+  [HIO_TRACE_EVENT_TRANSLATE_OFFSET] = "translate_offset",
+  [HIO_TRACE_EVENT_MAP_TRANSLATE_OFFSET] = "map_translate_offset",
+  [HIO_TRACE_EVENT_ELEMENT_TRANSLATE] = "element_translate",
+  [HIO_TRACE_EVENT_ELEMENT_READ] = "element_read",
+  [HIO_TRACE_EVENT_ELEMENT_WRITE] = "element_write",
+  [HIO_TRACE_EVENT_PROCESS_REQUESTS] = "process_requests",
+  [HIO_TRACE_EVENT_COMPLETE] = "complete",
+};
+
+static atomic_ulong hioi_trace_next_generation = 1;
+
+/** ring used by this thread for the most recently used trace */
+static __thread struct {
+  unsigned long     generation;
+  hio_trace_ring_t *ring;
+} hioi_trace_cache;
+
+static int hioi_trace_write (int fd, const void *data, size_t size) {
+  const char *buffer = (const char *) data;
+
+  while (size) {
+    ssize_t ret = write (fd, buffer, size);
+    if (ret < 0) {
+      if (EINTR == errno) {
+        continue;
+      }
+
+      return hioi_err_errno (errno);
+    }
+
+    buffer += ret;
+    size -= ret;
+  }
+
+  return HIO_SUCCESS;
+}
+
+/**
+ * Append the unflushed records of a ring to the trace file
+ */
+static void hioi_trace_flush_ring (hio_trace_t *trace, hio_trace_ring_t *ring) {
+  unsigned long tail = atomic_load (&ring->r_tail), head = hioi_atomic_load_acq (&ring->r_head);
+  unsigned long dropped = atomic_load (&ring->r_dropped);
+
+  while (tail != head) {
+    size_t first = tail & (HIO_TRACE_RING_SIZE - 1);
+    size_t count = head - tail;
+
+    if (first + count > HIO_TRACE_RING_SIZE) {
+      count = HIO_TRACE_RING_SIZE - first;
+    }
+
+    /* errors are ignored. the records are dropped */
+    (void) hioi_trace_write (trace->t_fd, ring->r_records + first, count * sizeof (ring->r_records[0]));
+    tail += count;
+  }
+
+  hioi_atomic_store_rel (&ring->r_tail, tail);
+
+  if (dropped) {
+    uint64_t now = hioi_gettime_ns ();
+    hio_trace_record_t record = {.tr_start = now, .tr_stop = now, .tr_value = dropped,
+                                 .tr_event = HIO_TRACE_EVENT_DROPPED, .tr_thread = ring->r_thread};
+
+    (void) atomic_fetch_add (&ring->r_dropped, -dropped);
+    (void) hioi_trace_write (trace->t_fd, &record, sizeof (record));
+  }
+}
+
+static void hioi_trace_flush (hio_trace_t *trace) {
+  hio_trace_ring_t *ring;
+
+  hioi_list_foreach (ring, trace->t_rings, hio_trace_ring_t, r_list) {
+    hioi_trace_flush_ring (trace, ring);
+  }
+}
+
+static void *hioi_trace_thread (void *arg) {
+  hio_trace_t *trace = (hio_trace_t *) arg;
+
+  pthread_mutex_lock (&trace->t_lock);
+  while (!trace->t_stop) {
+    struct timespec deadline;
+
+    hioi_trace_flush (trace);
+
+    clock_gettime (CLOCK_REALTIME, &deadline);
+    deadline.tv_nsec += HIO_TRACE_FLUSH_INTERVAL * 1000000;
+    if (deadline.tv_nsec >= 1000000000) {
+      deadline.tv_sec++;
+      deadline.tv_nsec -= 1000000000;
+    }
+
+    (void) pthread_cond_timedwait (&trace->t_cond, &trace->t_lock, &deadline);
+  }
+  pthread_mutex_unlock (&trace->t_lock);
+
+  return NULL;
+}
+
+int hioi_trace_open (hio_trace_t **trace_out, const char *path, const char *identifier, int64_t dataset_id,
+                     int rank) {
+  size_t identifier_length = strlen (identifier), padded_length = (identifier_length + 8) & ~(size_t) 7;
+  hio_trace_header_t header = {.th_byte_order = HIO_TRACE_BYTE_ORDER, .th_version = HIO_TRACE_VERSION,
+                               .th_rank = rank, .th_identifier_length = (uint32_t) identifier_length,
+                               .th_dataset_id = dataset_id, .th_record_size = sizeof (hio_trace_record_t)};
+  hio_trace_t *trace;
+  char *buffer;
+  int rc;
+
+  trace = calloc (1, sizeof (*trace));
+  if (NULL == trace) {
+    return HIO_ERR_OUT_OF_RESOURCE;
+  }
+
+  trace->t_fd = open (path, O_WRONLY | O_CREAT | O_APPEND, 0644);
+  if (0 > trace->t_fd) {
+    rc = hioi_err_errno (errno);
+    free (trace);
+    return rc;
+  }
+
+  /* write the session header and the dataset name */
+  buffer = calloc (1, sizeof (header) + padded_length);
+  if (NULL == buffer) {
+    close (trace->t_fd);
+    free (trace);
+    return HIO_ERR_OUT_OF_RESOURCE;
+  }
+
+  memcpy (header.th_magic, HIO_TRACE_MAGIC, sizeof (header.th_magic));
+  memcpy (buffer, &header, sizeof (header));
+  memcpy (buffer + sizeof (header), identifier, identifier_length);
+  rc = hioi_trace_write (trace->t_fd, buffer, sizeof (header) + padded_length);
+  free (buffer);
+  if (HIO_SUCCESS != rc) {
+    close (trace->t_fd);
+    free (trace);
+    return rc;
+  }
+
+  trace->t_generation = atomic_fetch_add (&hioi_trace_next_generation, 1);
+  hioi_list_init (trace->t_rings);
+  pthread_mutex_init (&trace->t_lock, NULL);
+  pthread_cond_init (&trace->t_cond, NULL);
+
+  if (0 != pthread_create (&trace->t_thread, NULL, hioi_trace_thread, trace)) {
+    pthread_mutex_destroy (&trace->t_lock);
+    pthread_cond_destroy (&trace->t_cond);
+    close (trace->t_fd);
+    free (trace);
+    return HIO_ERR_OUT_OF_RESOURCE;
+  }
+
+  *trace_out = trace;
+
+  return HIO_SUCCESS;
+}
+
+void hioi_trace_close (hio_trace_t *trace) {
+  hio_trace_ring_t *ring, *next;
+
+  if (NULL == trace) {
+    return;
+  }
+
+  pthread_mutex_lock (&trace->t_lock);
+  trace->t_stop = true;
+  pthread_cond_signal (&trace->t_cond);
+  pthread_mutex_unlock (&trace->t_lock);
+
+  pthread_join (trace->t_thread, NULL);
+
+  hioi_trace_flush (trace);
+  close (trace->t_fd);
+
+  hioi_list_foreach_safe (ring, next, trace->t_rings, hio_trace_ring_t, r_list) {
+    hioi_list_remove (ring, r_list);
+    free (ring);
+  }
+
+  pthread_mutex_destroy (&trace->t_lock);
+  pthread_cond_destroy (&trace->t_cond);
+  free (trace);
+}
+
+/**
+ * Find (or allocate) the ring of the calling thread
+ */
+static hio_trace_ring_t *hioi_trace_ring (hio_trace_t *trace) {
+  pthread_t self = pthread_self ();
+  hio_trace_ring_t *ring;
+
+  if (trace->t_generation == hioi_trace_cache.generation) {
+    return hioi_trace_cache.ring;
+  }
+
+  pthread_mutex_lock (&trace->t_lock);
+  hioi_list_foreach (ring, trace->t_rings, hio_trace_ring_t, r_list) {
+    if (pthread_equal (ring->r_owner, self)) {
+      break;
+    }
+  }
+
+  if (&ring->r_list == &trace->t_rings) {
+    ring = calloc (1, sizeof (*ring));
+    if (NULL != ring) {
+      ring->r_owner = self;
+      ring->r_thread = trace->t_ring_count++;
+      hioi_list_append (ring, trace->t_rings, r_list);
+    }
+  }
+  pthread_mutex_unlock (&trace->t_lock);
+
+  if (NULL != ring) {
+    hioi_trace_cache.generation = trace->t_generation;
+    hioi_trace_cache.ring = ring;
+  }
+
+  return ring;
+}
+
+void hioi_trace_event (hio_trace_t *trace, int event, uint64_t value, uint64_t value2, uint64_t start,
+                       uint64_t stop) {
+  hio_trace_ring_t *ring = hioi_trace_ring (trace);
+  hio_trace_record_t *record;
+  unsigned long head;
+
+  if (NULL == ring) {
+    return;
+  }
+
+  head = atomic_load (&ring->r_head);
+  if (head - hioi_atomic_load_acq (&ring->r_tail) == HIO_TRACE_RING_SIZE) {
+    (void) atomic_fetch_add (&ring->r_dropped, 1);
+    return;
+  }
+
+  record = ring->r_records + (head & (HIO_TRACE_RING_SIZE - 1));
+  record->tr_start = start;
+  record->tr_stop = stop;
+  record->tr_value = value;
+  record->tr_value2 = value2;
+  record->tr_event = (uint16_t) event;
+  record->tr_thread = ring->r_thread;
+  record->tr_resv0 = 0;
+
+  hioi_atomic_store_rel (&ring->r_head, head + 1);
+
+  if (head - atomic_load (&ring->r_tail) == HIO_TRACE_RING_SIZE / 2) {
+    /* wake up the flush thread early */
+    pthread_cond_signal (&trace->t_cond);
+  }
+}
+
+static const char *hioi_trace_event_name (int event) {
+  if (event < 0 || event >= HIO_TRACE_EVENT_MAX || NULL == hioi_trace_event_names[event]) {
+    return "unknown";
+  }
+
+  return hioi_trace_event_names[event];
+}
+
+/**
+ * Convert one trace file
+ *
+ * @param[in]     path    trace file
+ * @param[in]     chrome  write Chrome trace events instead of text
+ * @param[inout]  first   no Chrome trace event has been written yet
+ * @param[in]     fh      output file
+ */
+static int hioi_trace_dump_file (const char *path, bool chrome, bool *first, FILE *fh) {
+  hio_trace_header_t header;
+  hio_trace_record_t record;
+  char *identifier = NULL;
+  bool in_session = false;
+  FILE *input;
+  int rc = HIO_SUCCESS;
+
+  input = fopen (path, "r");
+  if (NULL == input) {
+    return hioi_err_errno (errno);
+  }
+
+  while (1) {
+    if (1 != fread (&record, sizeof (record), 1, input)) {
+      break;
+    }
+
+    if (0 == memcmp (&record, HIO_TRACE_MAGIC, 8)) {
+      size_t padded_length;
+
+      /* start of a new session. the header is the same size as a record */
+      memcpy (&header, &record, sizeof (header));
+      if (HIO_TRACE_BYTE_ORDER != header.th_byte_order || HIO_TRACE_VERSION < header.th_version ||
+          sizeof (record) != header.th_record_size) {
+        rc = HIO_ERR_BAD_PARAM;
+        break;
+      }
+
+      padded_length = (header.th_identifier_length + 8) & ~(size_t) 7;
+      free (identifier);
+      identifier = calloc (1, padded_length);
+      if (NULL == identifier) {
+        rc = HIO_ERR_OUT_OF_RESOURCE;
+        break;
+      }
+
+      if (1 != fread (identifier, padded_length, 1, input)) {
+        rc = HIO_ERR_TRUNCATE;
+        break;
+      }
+
+      in_session = true;
+      continue;
+    }
+
+    if (!in_session) {
+      rc = HIO_ERR_BAD_PARAM;
+      break;
+    }
+
+    if (chrome) {
+      fprintf (fh, "%s\n{\"name\": \"%s\", \"cat\": \"%s\", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f, "
+               "\"pid\": %d, \"tid\": %u, \"args\": {\"dataset_id\": %" PRId64 ", \"value\": %" PRIu64
+               ", \"value2\": %" PRIu64 "}}", *first ? "" : ",", hioi_trace_event_name (record.tr_event),
+               identifier, (double) record.tr_start / 1000.0, (double) (record.tr_stop - record.tr_start) / 1000.0,
+               header.th_rank, record.tr_thread, header.th_dataset_id, record.tr_value, record.tr_value2);
+      *first = false;
+    } else {
+      fprintf (fh, "%d:%u:%s::%" PRId64 ":%s:%" PRIu64 ":%" PRIu64 ":%" PRIu64 ":%" PRIu64 ":%" PRIu64 "\n",
+               header.th_rank, record.tr_thread, identifier, header.th_dataset_id,
+               hioi_trace_event_name (record.tr_event), record.tr_value, record.tr_value2, record.tr_start,
+               record.tr_stop, record.tr_stop - record.tr_start);
+    }
+  }
+
+  free (identifier);
+  fclose (input);
+
+  return rc;
+}
+
+int hio_trace_dump (const char **paths, int count, bool chrome, FILE *fh) {
+  bool first = true;
+  int rc = HIO_SUCCESS;
+
+  if (chrome) {
+    fprintf (fh, "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [");
+  }
+
+  for (int i = 0 ; i < count ; ++i) {
+    int ret = hioi_trace_dump_file (paths[i], chrome, &first, fh);
+    if (HIO_SUCCESS != ret) {
+      fprintf (stderr, "hio_trace_dump: error reading trace file %s: %d\n", paths[i], ret);
+      rc = ret;
+    }
+  }
+
+  if (chrome) {
+    fprintf (fh, "\n]}\n");
+  }
+
+  return rc;
+}
@@ -0,0 +1,647 @@
+/* -*- Mode: C; c-basic-offset:2 ; indent-tabs-mode:nil -*- */
+/*
+ * Copyright (c) 2017      Los Alamos National Security, LLC.  All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/**
+ * @file hio_unlink.c
+ * @brief Background removal of directory trees
+ *
+ * Directory trees (usually dataset ids) are first renamed into a hidden trash
+ * entry next to the original path so the original path disappears immediately.
+ * The trash entry is then removed by a small pool of persistent worker threads.
+ * One worker walks the tree and queues the files it finds. All idle workers
+ * (including the walker while it waits to remove a directory) remove queued
+ * files.
+ *
+ * Collective removal (hioi_unlink_tree_collective) instead splits the files of
+ * the tree across all ranks in the context.
+ */
+
+#include "hio_internal.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <assert.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#if HIO_MPI_HAVE(1)
+#include <mpi.h>
+#endif
+
+#define HIOI_UNLINK_MAX_THREADS 16
+
+typedef struct hioi_unlink_tree_t {
+  /** tree queue entry */
+  hio_list_t     ut_list;
+  /** context that requested the removal */
+  hio_context_t  ut_context;
+  /** path to the (renamed) tree */
+  char          *ut_path;
+  /** number of queued or in-flight file removals */
+  int            ut_outstanding;
+  /** first error seen while removing the tree */
+  int            ut_error;
+  /** tree has been removed (or removal failed) */
+  bool           ut_complete;
+  /** caller is waiting on this tree. the waiter releases the tree */
+  bool           ut_waited;
+} hioi_unlink_tree_t;
+
+typedef struct hioi_unlink_file_t {
+  /** file queue entry */
+  hio_list_t          uf_list;
+  /** tree this file belongs to */
+  hioi_unlink_tree_t *uf_tree;
+  /** path of the file */
+  char                uf_path[];
+} hioi_unlink_file_t;
+
+static pthread_mutex_t hioi_unlink_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t hioi_unlink_cond = PTHREAD_COND_INITIALIZER;
+static pthread_t hioi_unlink_threads[HIOI_UNLINK_MAX_THREADS];
+static int hioi_unlink_thread_count;
+static bool hioi_unlink_shutdown;
+static unsigned hioi_unlink_trash_count;
+
+static hio_list_t hioi_unlink_tree_queue = {.next = &hioi_unlink_tree_queue, .prev = &hioi_unlink_tree_queue};
+static hio_list_t hioi_unlink_file_queue = {.next = &hioi_unlink_file_queue, .prev = &hioi_unlink_file_queue};
+
+static bool hioi_unlink_queue_empty (hio_list_t *queue) {
+  return queue->next == queue;
+}
+
+/* must be called with the lock held */
+static void hioi_unlink_record_error (hioi_unlink_tree_t *tree, int err) {
+  if (err && ENOENT != err && !tree->ut_error) {
+    tree->ut_error = err;
+  }
+}
+
+/* pops and removes one queued file. must be called with the lock held. the lock is dropped
+ * while the file is being removed */
+static void hioi_unlink_file_process (void) {
+  hioi_unlink_file_t *file = hioi_list_item (hioi_unlink_file_queue.next, hioi_unlink_file_t, uf_list);
+  hioi_unlink_tree_t *tree = file->uf_tree;
+  int err = 0;
+
+  hioi_list_remove (file, uf_list);
+  pthread_mutex_unlock (&hioi_unlink_lock);
+
+  if (0 != unlink (file->uf_path)) {
+    err = errno;
+  }
+
+  free (file);
+
+  pthread_mutex_lock (&hioi_unlink_lock);
+  hioi_unlink_record_error (tree, err);
+  if (0 == --tree->ut_outstanding) {
+    pthread_cond_broadcast (&hioi_unlink_cond);
+  }
+}
+
+static void hioi_unlink_queue_file (hioi_unlink_tree_t *tree, const char *path) {
+  size_t path_len = strlen (path);
+  hioi_unlink_file_t *file;
+
+  file = malloc (sizeof (*file) + path_len + 1);
+  if (NULL == file) {
+    /* remove it here */
+    if (0 != unlink (path)) {
+      pthread_mutex_lock (&hioi_unlink_lock);
+      hioi_unlink_record_error (tree, errno);
+      pthread_mutex_unlock (&hioi_unlink_lock);
+    }
+    return;
+  }
+
+  file->uf_tree = tree;
+  memcpy (file->uf_path, path, path_len + 1);
+
+  pthread_mutex_lock (&hioi_unlink_lock);
+  ++tree->ut_outstanding;
+  hioi_list_append (file, hioi_unlink_file_queue, uf_list);
+  pthread_cond_signal (&hioi_unlink_cond);
+  pthread_mutex_unlock (&hioi_unlink_lock);
+}
+
+/* wait for all files queued from this tree to be removed. helps with queued removals
+ * instead of sleeping when there is work available. */
+static void hioi_unlink_tree_drain (hioi_unlink_tree_t *tree) {
+  pthread_mutex_lock (&hioi_unlink_lock);
+  while (tree->ut_outstanding) {
+    if (!hioi_unlink_queue_empty (&hioi_unlink_file_queue)) {
+      hioi_unlink_file_process ();
+    } else {
+      pthread_cond_wait (&hioi_unlink_cond, &hioi_unlink_lock);
+    }
+  }
+  pthread_mutex_unlock (&hioi_unlink_lock);
+}
+
+static void hioi_unlink_walk (hioi_unlink_tree_t *tree, const char *path) {
+  struct dirent *dp;
+  DIR *dir;
+  int err = 0;
+
+  dir = opendir (path);
+  if (NULL == dir) {
+    if (ENOTDIR == errno) {
+      /* not a directory. just remove it */
+      hioi_unlink_queue_file (tree, path);
+      return;
+    }
+
+    err = errno;
+  } else {
+    while (NULL != (dp = readdir (dir))) {
+      bool is_dir = false;
+      char *entry_path;
+
+      if (0 == strcmp (dp->d_name, ".") || 0 == strcmp (dp->d_name, "..")) {
+        continue;
+      }
+
+      if (0 > asprintf (&entry_path, "%s/%s", path, dp->d_name)) {
+        err = ENOMEM;
+        break;
+      }
+
+#if defined(_DIRENT_HAVE_D_TYPE)
+      if (DT_UNKNOWN != dp->d_type) {
+        is_dir = (DT_DIR == dp->d_type);
+      } else
+#endif
+      {
+        struct stat statinfo;
+        is_dir = (0 == lstat (entry_path, &statinfo) && S_ISDIR(statinfo.st_mode));
+      }
+
+      if (is_dir) {
+        hioi_unlink_walk (tree, entry_path);
+      } else {
+        hioi_unlink_queue_file (tree, entry_path);
+      }
+
+      free (entry_path);
+    }
+
+    closedir (dir);
+  }
+
+  /* the directory can only be removed once all of its files are gone */
+  hioi_unlink_tree_drain (tree);
+
+  if (0 != rmdir (path) && !err) {
+    err = errno;
+  }
+
+  pthread_mutex_lock (&hioi_unlink_lock);
+  hioi_unlink_record_error (tree, err);
+  pthread_mutex_unlock (&hioi_unlink_lock);
+}
+
+/* must be called with the lock held */
+static void hioi_unlink_tree_finish (hioi_unlink_tree_t *tree) {
+  hio_context_t context = tree->ut_context;
+
+  tree->ut_complete = true;
+
+  if (tree->ut_error && !context->c_unlink_error) {
+    context->c_unlink_error = tree->ut_error;
+  }
+
+  --context->c_unlink_pending;
+
+  if (!tree->ut_waited) {
+    free (tree->ut_path);
+    free (tree);
+  }
+
+  pthread_cond_broadcast (&hioi_unlink_cond);
+}
+
+static void *hioi_unlink_thread (void *arg) {
+  pthread_mutex_lock (&hioi_unlink_lock);
+  for (;;) {
+    if (!hioi_unlink_queue_empty (&hioi_unlink_file_queue)) {
+      hioi_unlink_file_process ();
+    } else if (!hioi_unlink_queue_empty (&hioi_unlink_tree_queue)) {
+      hioi_unlink_tree_t *tree = hioi_list_item (hioi_unlink_tree_queue.next, hioi_unlink_tree_t, ut_list);
+
+      hioi_list_remove (tree, ut_list);
+      pthread_mutex_unlock (&hioi_unlink_lock);
+
+      hioi_unlink_walk (tree, tree->ut_path);
+
+      pthread_mutex_lock (&hioi_unlink_lock);
+      hioi_unlink_tree_finish (tree);
+    } else if (hioi_unlink_shutdown) {
+      break;
+    } else {
+      pthread_cond_wait (&hioi_unlink_cond, &hioi_unlink_lock);
+    }
+  }
+  pthread_mutex_unlock (&hioi_unlink_lock);
+
+  return NULL;
+}
+
+/* must be called with the lock held */
+static int hioi_unlink_start_threads (void) {
+  if (hioi_unlink_thread_count) {
+    return HIO_SUCCESS;
+  }
+
+  hioi_unlink_shutdown = false;
+
+  for (int i = 0 ; i < HIOI_UNLINK_MAX_THREADS ; ++i) {
+    if (0 != pthread_create (hioi_unlink_threads + i, NULL, hioi_unlink_thread, NULL)) {
+      break;
+    }
+    ++hioi_unlink_thread_count;
+  }
+
+  return hioi_unlink_thread_count ? HIO_SUCCESS : HIO_ERR_OUT_OF_RESOURCE;
+}
+
+/**
+ * Move a tree out of the way so its path can be reused immediately
+ *
+ * @param[in]  context    context (for logging)
+ * @param[in]  path       path of the tree
+ * @param[out] trash_path new path of the tree (allocated)
+ *
+ * @returns true if the tree was moved, false if the tree must be removed in place
+ *
+ * The trash entry is hidden (starts with .) and lives in the same directory so the
+ * rename stays on the same filesystem.
+ */
+static bool hioi_unlink_move_to_trash (hio_context_t context, const char *path, char **trash_path) {
+  char *tmp = strrchr (path, '/');
+  int rc;
+
+  pthread_mutex_lock (&hioi_unlink_lock);
+  rc = asprintf (trash_path, "%.*s.trash.%s.%d.%u", tmp ? (int) (tmp - path + 1) : 0, path,
+                 tmp ? tmp + 1 : path, (int) getpid (), hioi_unlink_trash_count++);
+  pthread_mutex_unlock (&hioi_unlink_lock);
+
+  if (0 <= rc) {
+    if (0 == rename (path, *trash_path)) {
+      return true;
+    }
+
+    hioi_log (context, HIO_VERBOSE_DEBUG_LOW, "unlink: could not move %s to trash. errno: %d. removing in place",
+              path, errno);
+    free (*trash_path);
+  }
+
+  *trash_path = strdup (path);
+  assert (NULL != *trash_path);
+
+  return false;
+}
+
+int hioi_unlink_tree (hio_context_t context, const char *path, bool async) {
+  hioi_unlink_tree_t *tree;
+  char *trash_path;
+  int rc;
+
+  tree = calloc (1, sizeof (*tree));
+  if (NULL == tree) {
+    return HIO_ERR_OUT_OF_RESOURCE;
+  }
+
+  if (!hioi_unlink_move_to_trash (context, path, &trash_path)) {
+    /* the original path can not be released until the tree is gone */
+    async = false;
+  }
+
+  tree->ut_context = context;
+  tree->ut_path = trash_path;
+  tree->ut_waited = !async;
+
+  pthread_mutex_lock (&hioi_unlink_lock);
+  rc = hioi_unlink_start_threads ();
+  if (HIO_SUCCESS != rc) {
+    pthread_mutex_unlock (&hioi_unlink_lock);
+    /* no workers available. remove the tree from this thread */
+    tree->ut_waited = true;
+    hioi_unlink_walk (tree, trash_path);
+    pthread_mutex_lock (&hioi_unlink_lock);
+    rc = hioi_err_errno (tree->ut_error);
+    pthread_mutex_unlock (&hioi_unlink_lock);
+    free (trash_path);
+    free (tree);
+    return rc;
+  }
+
+  ++context->c_unlink_pending;
+  hioi_list_append (tree, hioi_unlink_tree_queue, ut_list);
+  pthread_cond_signal (&hioi_unlink_cond);
+
+  if (async) {
+    pthread_mutex_unlock (&hioi_unlink_lock);
+    return HIO_SUCCESS;
+  }
+
+  while (!tree->ut_complete) {
+    pthread_cond_wait (&hioi_unlink_cond, &hioi_unlink_lock);
+  }
+  pthread_mutex_unlock (&hioi_unlink_lock);
+
+  rc = hioi_err_errno (tree->ut_error);
+  free (tree->ut_path);
+  free (tree);
+
+  return rc;
+}
+
+int hioi_unlink_wait (hio_context_t context) {
+  int rc;
+
+  pthread_mutex_lock (&hioi_unlink_lock);
+  while (context->c_unlink_pending) {
+    pthread_cond_wait (&hioi_unlink_cond, &hioi_unlink_lock);
+  }
+
+  rc = hioi_err_errno (context->c_unlink_error);
+  context->c_unlink_error = 0;
+  pthread_mutex_unlock (&hioi_unlink_lock);
+
+  return rc;
+}
+
+int hioi_unlink_pending (hio_context_t context) {
+  int pending;
+
+  pthread_mutex_lock (&hioi_unlink_lock);
+  pending = context->c_unlink_pending;
+  pthread_mutex_unlock (&hioi_unlink_lock);
+
+  return pending;
+}
+
+#if HIO_MPI_HAVE(1)
+typedef struct hioi_unlink_names_t {
+  /** NUL-separated names */
+  char   *un_data;
+  /** bytes used in un_data */
+  size_t  un_used;
+  /** allocated size of un_data */
+  size_t  un_size;
+  /** number of names */
+  int     un_count;
+} hioi_unlink_names_t;
+
+static int hioi_unlink_names_append (hioi_unlink_names_t *names, const char *name) {
+  size_t name_len = strlen (name) + 1;
+
+  if (names->un_used + name_len > names->un_size) {
+    size_t new_size = names->un_size ? names->un_size * 2 : 65536;
+    void *tmp;
+
+    while (new_size < names->un_used + name_len) {
+      new_size *= 2;
+    }
+
+    tmp = realloc (names->un_data, new_size);
+    if (NULL == tmp) {
+      return HIO_ERR_OUT_OF_RESOURCE;
+    }
+
+    names->un_data = tmp;
+    names->un_size = new_size;
+  }
+
+  memcpy (names->un_data + names->un_used, name, name_len);
+  names->un_used += name_len;
+  names->un_count++;
+
+  return HIO_SUCCESS;
+}
+
+/* list all files (relative to the root) in a tree. directories are listed deepest first */
+static int hioi_unlink_enumerate (const char *path, size_t root_len, hioi_unlink_names_t *files,
+                                  hioi_unlink_names_t *dirs) {
+  int rc = HIO_SUCCESS;
+  struct dirent *dp;
+  DIR *dir;
+
+  dir = opendir (path);
+  if (NULL == dir) {
+    return hioi_err_errno (errno);
+  }
+
+  while (HIO_SUCCESS == rc && NULL != (dp = readdir (dir))) {
+    bool is_dir = false;
+    char *entry_path;
+
+    if (0 == strcmp (dp->d_name, ".") || 0 == strcmp (dp->d_name, "..")) {
+      continue;
+    }
+
+    if (0 > asprintf (&entry_path, "%s/%s", path, dp->d_name)) {
+      rc = HIO_ERR_OUT_OF_RESOURCE;
+      break;
+    }
+
+#if defined(_DIRENT_HAVE_D_TYPE)
+    if (DT_UNKNOWN != dp->d_type) {
+      is_dir = (DT_DIR == dp->d_type);
+    } else
+#endif
+    {
+      struct stat statinfo;
+      is_dir = (0 == lstat (entry_path, &statinfo) && S_ISDIR(statinfo.st_mode));
+    }
+
+    if (is_dir) {
+      rc = hioi_unlink_enumerate (entry_path, root_len, files, dirs);
+      if (HIO_SUCCESS == rc) {
+        rc = hioi_unlink_names_append (dirs, entry_path + root_len + 1);
+      }
+    } else {
+      rc = hioi_unlink_names_append (files, entry_path + root_len + 1);
+    }
+
+    free (entry_path);
+  }
+
+  closedir (dir);
+
+  return rc;
+}
+#endif
+
+int hioi_unlink_tree_collective (hio_context_t context, const char *path) {
+#if HIO_MPI_HAVE(1)
+  hioi_unlink_names_t files = {.un_count = 0}, dirs = {.un_count = 0};
+  int *send_counts = NULL, *displs = NULL, recv_count = 0, err = 0, rc = HIO_SUCCESS, mpirc;
+  char *trash_path = NULL, *recv_buffer = NULL;
+  long data[2] = {HIO_SUCCESS, 0};
+  bool moved = false;
+
+  if (!hioi_context_using_mpi (context)) {
+    return hioi_unlink_tree (context, path, false);
+  }
+
+  if (0 == context->c_rank) {
+    moved = hioi_unlink_move_to_trash (context, path, &trash_path);
+
+    rc = hioi_unlink_enumerate (trash_path, strlen (trash_path), &files, &dirs);
+    if (HIO_SUCCESS == rc) {
+      send_counts = calloc (context->c_size, sizeof (int));
+      displs = calloc (context->c_size, sizeof (int));
+      if (NULL == send_counts || NULL == displs) {
+        rc = HIO_ERR_OUT_OF_RESOURCE;
+      }
+    }
+
+    if (HIO_SUCCESS == rc) {
+      /* give each rank a contiguous block of roughly the same number of files */
+      size_t offset = 0;
+      int file_index = 0;
+
+      for (int i = 0 ; i < context->c_size ; ++i) {
+        int file_end = (int) (((int64_t) files.un_count * (i + 1)) / context->c_size);
+
+        displs[i] = (int) offset;
+        for ( ; file_index < file_end ; ++file_index) {
+          offset += strlen (files.un_data + offset) + 1;
+        }
+        send_counts[i] = (int) offset - displs[i];
+      }
+    }
+
+    data[0] = rc;
+    data[1] = (long) strlen (trash_path) + 1;
+  }
+
+  mpirc = MPI_Bcast (data, 2, MPI_LONG, 0, context->c_comm);
+  if (MPI_SUCCESS == mpirc && HIO_SUCCESS == data[0]) {
+    if (0 != context->c_rank) {
+      trash_path = malloc (data[1]);
+      assert (NULL != trash_path);
+    }
+
+    mpirc = MPI_Bcast (trash_path, (int) data[1], MPI_CHAR, 0, context->c_comm);
+    if (MPI_SUCCESS == mpirc) {
+      mpirc = MPI_Scatter (send_counts, 1, MPI_INT, &recv_count, 1, MPI_INT, 0, context->c_comm);
+    }
+
+    if (MPI_SUCCESS == mpirc) {
+      recv_buffer = malloc (recv_count + 1);
+      assert (NULL != recv_buffer);
+      mpirc = MPI_Scatterv (files.un_data, send_counts, displs, MPI_CHAR, recv_buffer, recv_count,
+                            MPI_CHAR, 0, context->c_comm);
+    }
+  }
+
+  free (send_counts);
+  free (displs);
+  free (files.un_data);
+
+  if (MPI_SUCCESS != mpirc) {
+    rc = hioi_err_mpi (mpirc);
+  } else {
+    rc = (int) data[0];
+  }
+
+  if (HIO_SUCCESS != rc && moved) {
+    /* nothing has been removed yet. put the tree back where the caller can see it
+     * and retry the unlink */
+    if (0 != rename (trash_path, path)) {
+      hioi_err_push (hioi_err_errno (errno), &context->c_object, "unlink: could not restore %s from %s",
+                     path, trash_path);
+    }
+  }
+
+  if (HIO_SUCCESS == rc) {
+    /* remove this rank's share of the files */
+    for (int offset = 0 ; offset < recv_count ; offset += strlen (recv_buffer + offset) + 1) {
+      char *file_path;
+
+      if (0 > asprintf (&file_path, "%s/%s", trash_path, recv_buffer + offset)) {
+        err = ENOMEM;
+        break;
+      }
+
+      if (0 != unlink (file_path) && ENOENT != errno && !err) {
+        err = errno;
+      }
+
+      free (file_path);
+    }
+
+    rc = hioi_err_errno (err);
+
+    /* wait for all files to be removed before removing directories */
+    mpirc = MPI_Allreduce (MPI_IN_PLACE, &rc, 1, MPI_INT, MPI_MIN, context->c_comm);
+    if (MPI_SUCCESS != mpirc) {
+      rc = hioi_err_mpi (mpirc);
+    }
+
+    if (0 == context->c_rank) {
+      size_t offset = 0;
+
+      for (int i = 0 ; i < dirs.un_count ; ++i) {
+        char *dir_path;
+
+        if (0 > asprintf (&dir_path, "%s/%s", trash_path, dirs.un_data + offset)) {
+          break;
+        }
+
+        if (0 != rmdir (dir_path) && HIO_SUCCESS == rc) {
+          rc = hioi_err_errno (errno);
+        }
+
+        free (dir_path);
+        offset += strlen (dirs.un_data + offset) + 1;
+      }
+
+      if (0 != rmdir (trash_path) && HIO_SUCCESS == rc) {
+        rc = hioi_err_errno (errno);
+      }
+    }
+
+    mpirc = MPI_Bcast (&rc, 1, MPI_INT, 0, context->c_comm);
+    if (MPI_SUCCESS != mpirc) {
+      rc = hioi_err_mpi (mpirc);
+    }
+  }
+
+  free (dirs.un_data);
+  free (recv_buffer);
+  free (trash_path);
+
+  return rc;
+#else
+  return hioi_unlink_tree (context, path, false);
+#endif
+}
+
+void hioi_unlink_fini (void) {
+  pthread_mutex_lock (&hioi_unlink_lock);
+  hioi_unlink_shutdown = true;
+  pthread_cond_broadcast (&hioi_unlink_cond);
+  pthread_mutex_unlock (&hioi_unlink_lock);
+
+  for (int i = 0 ; i < hioi_unlink_thread_count ; ++i) {
+    pthread_join (hioi_unlink_threads[i], NULL);
+  }
+
+  hioi_unlink_thread_count = 0;
+}
@@ -585,6 +585,29 @@ int hioi_config_set_value (hio_object_t object, const char *variable, const char
   return rc;
 }
 
+int hioi_config_load_value (hio_object_t object, const char *variable, const char *value) {
+  bool local = false;
+  int config_index;
+
+  if (NULL == object || NULL == variable || NULL == value) {
+    return HIO_ERR_BAD_PARAM;
+  }
+
+  hioi_object_lock (object);
+  config_index = hioi_var_lookup (&object->configuration, variable);
+  if (0 <= config_index) {
+    local = !!(object->configuration.vars[config_index].var_flags & HIO_VAR_FLAG_LOCAL);
+  }
+  hioi_object_unlock (object);
+
+  if (local) {
+    /* the value in use was chosen by this process */
+    return HIO_SUCCESS;
+  }
+
+  return hioi_config_set_value (object, variable, value);
+}
+
 int hio_config_set_value (hio_object_t object, const char *variable, const char *value) {
   int rc = hioi_config_set_value (object, variable, value);
   if (HIO_ERR_PERM == rc) {
@@ -777,6 +800,12 @@ int hio_perf_get_value (hio_object_t object, char *variable, void *value, size_t
 
   var = object->performance.vars + perf_index;
 
+  if (NULL != object->perf_update_fn) {
+    hioi_object_lock (object);
+    object->perf_update_fn (object);
+    hioi_object_unlock (object);
+  }
+
   switch (var->var_type) {
   case HIO_CONFIG_TYPE_BOOL:
     ((bool *) value)[0] = var->var_storage->boolval;
@@ -250,6 +250,11 @@
  * - @b datawarp_root - Overide the root directory for DataWarp.  If not set, the value of system provided
  *   environment variable DW_JOB_STRIPED is used.
  *
+ * - @b datawarp_prefetch - If true, when the DataWarp module is created (at the first dataset allocation)
+ *   the newest complete id of each dataset on the PFS data root is staged into DataWarp. Reads of that id
+ *   are served from DataWarp once the stage-in has completed and from the PFS before then. The default
+ *   value is 0.
+ *
  * - @b datawarp_debug_mask - this 64 bit unsigned value is used to enable classes of DataWarp debug log
  *   messages. The default value is 0. Specific classes and their related mask bits wil be provided
  *   as needed by DataWarp development. The DataWarp debug logger is activated at hio_dataset_open with
@@ -276,10 +281,14 @@
  *   is only valid for datasets opened for writing.
  *
  * - @b datawarp_keep_last - Number of unique dataset ids to keep on datawarp. If the limit is reached then
- *   existing dataset ids are destaged (if marked as end_of_job) or libhio will block until immediate staging
- *   is complete. The datasets are then removed from datawarp. The  calculated count includes dataset ids
- *   resident on datawarp before hio_init()/hio_init_mpi(). The default is 1. This value can be set on any
- *   dataset instance and will affect all datasets with the same name.
+ *   existing dataset ids are destaged (if marked as end_of_job) or, if an immediate stage is still in
+ *   progress, removed by a background stage tracker once the stage completes. The  calculated count includes
+ *   dataset ids resident on datawarp before hio_init()/hio_init_mpi(). The default is 1. This value can be
+ *   set on any dataset instance and will affect all datasets with the same name. Stage progress is reported
+ *   by the stage_* performance variables of datasets opened for writing.
+ *
+ * - @b datawarp_stage_poll_interval - Time in milliseconds between queries of immediate stages in progress
+ *   made by the stage tracker. The default is 100.
  *
  * - @b dataset_file_mode - File mode to use when writing files on POSIX-like file systems. When set to
  *   basic either a single file (@ref HIO_SET_ELEMENT_SHARED) or a file per rank (@ref HIO_SET_ELEMENT_UNIQUE)
@@ -299,8 +308,17 @@
  *   values are "default" (posix-like), "lustre", and "gpfs". Additional types will be added in the
  *   future.
  *
- * - @b dataset_use_bzip - Use bzip2 compression when writing dataset manifests. This will reduce the size
- *   of large manifest files.
+ * - @b dataset_use_bzip - Codec to use when compressing json dataset manifests. Valid values are "none",
+ *   "bzip2" (smallest manifests), and "lz" (much faster compression and decompression at a lower ratio).
+ *   For compatibility "true" selects bzip2 and "false" disables compression. The time spent in the codec
+ *   and the achieved compression ratio are reported in the manifest_codec_time_usec and
+ *   manifest_compression_ratio performance variables.
+ *
+ * - @b dataset_data_checksum - Relevant only when the dataset_file_mode is file_per_node. When true a crc32c
+ *   checksum of each data segment is computed as it is written and stored in the dataset manifest. Reads
+ *   that cover an entire segment are verified against the stored checksum and fail with
+ *   @ref HIO_ERR_IO_PERMANENT on a mismatch. The cost is reported in the checksum_bytes, checksum_time_nsec,
+ *   and checksum_error_count performance variables. The default is false.
  *
  * - @b stripe_size - Filesystem stripe size in bytes. This value will be passed along to the underlying
  *   filesystem if it is supported. Not valid for optimized file mode.
@@ -567,7 +585,15 @@ typedef enum hio_unlink_mode_t {
   /** Unlink first matching dataset id instance */
   HIO_UNLINK_MODE_FIRST,
   /** Unlink all matching dataset id instances */
-  HIO_UNLINK_MODE_ALL
+  HIO_UNLINK_MODE_ALL,
+  /** Modifier that can be or'd with any of the above modes. The dataset is removed
+   * from view before hio_dataset_unlink() returns but its data is removed in the
+   * background. See hio_dataset_unlink_wait(). */
+  HIO_UNLINK_MODE_ASYNC = 0x100,
+  /** Modifier that can be or'd with any of the above modes. hio_dataset_unlink() is
+   * collective over the context and the data files are removed by all ranks. Can not
+   * be combined with HIO_UNLINK_MODE_ASYNC. */
+  HIO_UNLINK_MODE_COLLECTIVE = 0x200
 } hio_unlink_mode_t;
 
 
@@ -829,6 +855,33 @@ hio_return_t hio_dataset_get_id (hio_dataset_t dataset, int64_t *set_id);
  */
 hio_return_t hio_dataset_unlink (hio_context_t context, const char *name, int64_t set_id, hio_unlink_mode_t mode);
 
+/**
+ * @ingroup API
+ * @brief Wait for background dataset removals to finish
+ *
+ * @param[in] context hio context
+ *
+ * @returns HIO_SUCCESS if all background removals completed successfully
+ * @returns hio error code of the first failed removal otherwise
+ *
+ * This function blocks until all datasets unlinked with HIO_UNLINK_MODE_ASYNC
+ * on this context have been removed. This function is not collective. Pending
+ * removals are also waited on by hio_fini().
+ */
+hio_return_t hio_dataset_unlink_wait (hio_context_t context);
+
+/**
+ * @ingroup API
+ * @brief Query the number of background dataset removals
+ *
+ * @param[in]  context hio context
+ * @param[out] count   number of removals that have not finished
+ *
+ * @returns HIO_SUCCESS on success
+ * @returns HIO_ERR_BAD_PARAM if an invalid parameter is specified
+ */
+hio_return_t hio_dataset_unlink_pending (hio_context_t context, int *count);
+
 /**
  * @ingroup API
  * @brief Open an element
@@ -873,12 +926,21 @@ hio_return_t hio_element_size (hio_element_t element, int64_t *e_size);
  * @param[in] flags        construct flags
  *
  * This function takes an hio dataset and reconstructs the file(s) that
- * make up the hio element. This could be a single file or many depending
- * on how the hio element was constructed. If the dataset has unique offsets
- * for each rank the resulting files will have the form \<element_name\>.\<rank\>.
- * This function will fail if the output is a directory and a file already
- * exists at {destination}. This functionality is still in development and
- * will likely change before the final version of this API is released.
+ * make up the hio elements in the directory {destination}. If the dataset has
+ * shared offsets each element is written to \<destination\>/\<element_name\>.
+ * If the dataset has unique offsets the resulting files will have the form
+ * \<destination\>/\<element_name\>.\<rank\>. This function will fail with
+ * HIO_ERR_EXISTS if an output file already exists. The dataset must be open
+ * for reading.
+ *
+ * This function is collective over the dataset's context. The conversion is
+ * performed in parallel: shared elements are distributed among the ranks and
+ * unique elements are written by the rank that wrote them. Where the source
+ * and destination filesystems allow it the data is copied in the kernel
+ * (copy_file_range) without passing through user space. Regions of an
+ * element that were never written are left as holes in the output.
+ *
+ * The flags argument is currently unused and should be 0.
  *
  * The functionality of this API will also be supplied by the command-line
  * executable hio_construct.
@@ -1176,6 +1238,10 @@ hio_return_t hio_element_read_strided_nb (hio_element_t element, hio_request_t *
  * This function completes all outstanding reads on the element specified in
  * {element}. This function will return an error code if any read on the
  * dataset did not complete. Note: A short read is considered an error.
+ *
+ * Non-blocking reads may be deferred until this function or hio_request_wait()
+ * is called. This allows the implementation to sort the reads by location and
+ * merge nearby reads into fewer, larger file reads.
  */
 hio_return_t hio_complete (hio_element_t element);
 
@@ -1222,7 +1288,9 @@ int hio_request_test (hio_request_t *requests, int nrequests, ssize_t *bytes_tra
  * index in the {requests} array is HIO_OBJECT_NULL the corresponding location
  * in the {bytes_transferred} array is set to 0. If a request completes in error,
  * the cooresponding bytes_transferred entry is set to the hio_return_t error value
- * (all of which are negative).
+ * (all of which are negative). If deferred reads could not be issued (see
+ * hio_complete()) the error is returned and the affected requests are left
+ * incomplete so they can be waited on again.
  */
 hio_return_t hio_request_wait (hio_request_t *requests, int nrequests, ssize_t *bytes_transferred);
 
@@ -1243,9 +1311,35 @@ hio_return_t hio_request_wait (hio_request_t *requests, int nrequests, ssize_t *
  * order to return a consistent result this call is collective and must be
  * called by all ranks in the communicator associated with the context if
  * using MPI.
+ *
+ * All times used by the recommendation are in seconds. The expected time to
+ * write the dataset is its expected size divided by the average write bandwidth
+ * measured when earlier instances were closed. The optimal interval between
+ * checkpoints is calculated from the expected write time and the mean time to
+ * interrupt (see the job_sys_int_rate, job_node_int_rate, and job_node_sw_rate
+ * context variables). If the end_time context variable (UNIX time) is set no
+ * checkpoint is recommended when there is not enough time left to write one. A
+ * dataset that has not been written by this context is always recommended.
  */
 hio_recommendation_t hio_dataset_should_checkpoint (hio_context_t context, const char *name);
 
+/**
+ * @ingroup API
+ * @brief Get recommendation on if a checkpoint should be written
+ *
+ * @param[in]  context hio context
+ * @param[out] hint    recommendation (see @ref hio_recommendation_t)
+ *
+ * @returns HIO_SUCCESS on success
+ * @returns HIO_ERR_BAD_PARAM if {context} or {hint} is NULL
+ *
+ * This function is the same as hio_dataset_should_checkpoint() but the
+ * recommendation is made for the dataset most recently written in this
+ * context. This call is collective and must be called by all ranks in the
+ * communicator associated with the context if using MPI.
+ */
+hio_return_t hio_should_checkpoint (hio_context_t context, int *hint);
+
 /**
  * @ingroup configuration
  * @brief Set the value of an hio configuration variable
@@ -1383,6 +1477,14 @@ hio_return_t hio_perf_get_info (hio_object_t object, int index, char **name, hio
  * in {object}. {object} must be a context, dataset, or element. On success the value
  * of the performance variable is stored in the buffer specified in {value} according
  * to its type.
+ *
+ * Datasets keep latency histograms for the append (buffered write), backend_write,
+ * backend_read, flush, open, close, and gather_manifest operations. Each histogram is
+ * summarized by the {op}_latency_count, {op}_latency_p50_nsec, {op}_latency_p90_nsec,
+ * {op}_latency_p99_nsec, and {op}_latency_max_nsec variables. The histograms of all
+ * ranks are summed when the dataset is closed and summarized by the matching
+ * aggregate_{op}_latency_* variables on rank 0. Percentiles are accurate to
+ * within 12.5%.
  */
 hio_return_t hio_perf_get_value (hio_object_t object, char *variable, void *value, size_t value_len);
 
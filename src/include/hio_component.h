@@ -48,6 +48,7 @@ typedef int (*hio_module_dataset_open_fn_t) (struct hio_module_t *module,
  * @param[in] module   hio module
  * @param[in] name     dataset name
  * @param[in] set_id   dataset identifier
+ * @param[in] flags    unlink flags (HIO_UNLINK_MODE_ASYNC, HIO_UNLINK_MODE_COLLECTIVE)
  *
  * @returns HIO_SUCCESS on success
  * @returns HIO_ERR_NOT_FOUND if the specified dataset does not exist on the
@@ -55,11 +56,15 @@ typedef int (*hio_module_dataset_open_fn_t) (struct hio_module_t *module,
  * @returns hio error on other failure
  *
  * This function removes the specified dataset from the data root associated
- * with the hio module.
+ * with the hio module. If HIO_UNLINK_MODE_ASYNC is set the dataset must no
+ * longer be visible when this function returns but its data may be removed in
+ * the background (see hioi_unlink_tree()). If HIO_UNLINK_MODE_COLLECTIVE is set
+ * this function is called on all ranks and the result must be the same on all
+ * ranks.
  */
 typedef int
 (*hio_module_dataset_unlink_fn_t) (struct hio_module_t *module,
-				   const char *name, int64_t set_id);
+				   const char *name, int64_t set_id, int flags);
 
 /**
  * List all dataset identifiers on the data root for a given dataset name
@@ -71,7 +76,8 @@ typedef int
  *
  * This functions queries the data root for all existing set identifiers associated
  * with the given dataset name. This function is allowed to return incomplete or
- * failed dataset identifiers.
+ * failed dataset identifiers. This function is not collective. It is called on
+ * rank 0 of the context and the results are distributed by the caller.
  */
 typedef int
 (*hio_module_dataset_list_fn_t) (struct hio_module_t *module, const char *name,
@@ -137,6 +137,104 @@ void hioi_dump_writer(hio_context_t context, const char * header, const void * d
  */
 int hioi_err_errno (int err);
 
+/**
+ * Remove a directory tree
+ *
+ * @param[in] context  context requesting the removal
+ * @param[in] path     path of the tree to remove
+ * @param[in] async    return before the tree has been removed
+ *
+ * @returns hio error code
+ *
+ * The tree is renamed to a hidden trash entry in its parent directory before
+ * it is removed so {path} can be reused as soon as this function returns. The
+ * removal is done by a pool of persistent worker threads. If {async} is true
+ * errors are reported by hioi_unlink_wait().
+ */
+int hioi_unlink_tree (hio_context_t context, const char *path, bool async);
+
+/**
+ * Remove a directory tree using all ranks in a context
+ *
+ * @param[in] context  context
+ * @param[in] path     path of the tree to remove (only used on rank 0)
+ *
+ * @returns hio error code (the same on all ranks)
+ *
+ * This function is collective over the context communicator. Rank 0 moves the
+ * tree to the trash, lists its files, and scatters the list. Each rank removes
+ * its share of the files. Rank 0 removes the directories once all ranks are done.
+ */
+int hioi_unlink_tree_collective (hio_context_t context, const char *path);
+
+/**
+ * Wait for all background removals started by a context
+ *
+ * @param[in] context  context
+ *
+ * @returns the first error seen by a background removal since the last call
+ */
+int hioi_unlink_wait (hio_context_t context);
+
+/**
+ * Get the number of background removals started by a context that have not finished
+ *
+ * @param[in] context  context
+ */
+int hioi_unlink_pending (hio_context_t context);
+
+/**
+ * Stop the removal worker threads
+ *
+ * This function is called once all contexts have been released.
+ */
+void hioi_unlink_fini (void);
+
+/**
+ * Load dataset and data root history saved by a previous job
+ *
+ * @param[in] context  context
+ *
+ * Dataset history is loaded the first time a history file is found. Data root
+ * statistics are applied to any data root modules that exist. Only rank 0 loads
+ * the history. See hio_history.c.
+ */
+int hioi_history_load (hio_context_t context);
+
+/**
+ * Save dataset and data root history for use by future jobs
+ *
+ * @param[in] context  context
+ */
+int hioi_history_save (hio_context_t context);
+
+/**
+ * Select the data root for a new dataset
+ *
+ * @param[in] context  context
+ * @param[in] dataset  dataset being created
+ *
+ * @returns the selected module (also stored in context->c_cur_module)
+ *
+ * The data root with the lowest expected write time for the dataset is selected.
+ * Data roots without enough space for the dataset or that have failed repeatedly
+ * are skipped unless no other data root is available. This function is collective.
+ */
+hio_module_t *hioi_context_select_module (hio_context_t context, hio_dataset_t dataset);
+
+/**
+ * Update data root statistics after a dataset is opened or closed
+ *
+ * @param[in] context    context
+ * @param[in] module     module the dataset was opened on
+ * @param[in] rc         result of the open or close
+ * @param[in] bytes      aggregate number of bytes written (0 on open)
+ * @param[in] data_time  time spent between open and close (usec)
+ * @param[in] close_time time spent closing the dataset (usec)
+ */
+void hioi_context_update_module_stats (hio_context_t context, hio_module_t *module, int rc, uint64_t bytes,
+                                       uint64_t data_time, uint64_t close_time);
+
 /**
  * Create HIO dataset modules based on the current data roots
  *
@@ -153,6 +251,53 @@ int hioi_context_create_modules (hio_context_t context);
  */
 uint64_t hioi_gettime (void);
 
+/**
+ * Get the current time (relative to system boot) in nsec
+ *
+ * @returns monotonically increasing time in nsec
+ */
+uint64_t hioi_gettime_ns (void);
+
+/**
+ * Record a latency in a histogram
+ *
+ * @param[in] histogram  latency histogram
+ * @param[in] nsec       latency in nsec
+ */
+static inline void hioi_latency_record (hio_latency_histogram_t *histogram, uint64_t nsec) {
+  unsigned long max;
+  int index;
+
+  if (nsec < (1 << HIO_LATENCY_SUB_BITS)) {
+    index = (int) nsec;
+  } else {
+    int exponent = 63 - __builtin_clzll (nsec);
+
+    index = ((exponent - HIO_LATENCY_SUB_BITS + 1) << HIO_LATENCY_SUB_BITS) +
+      (int) ((nsec >> (exponent - HIO_LATENCY_SUB_BITS)) - (1 << HIO_LATENCY_SUB_BITS));
+    if (index >= HIO_LATENCY_BUCKETS) {
+      index = HIO_LATENCY_BUCKETS - 1;
+    }
+  }
+
+  /* backend threads may record into the same histogram concurrently */
+  atomic_fetch_add (histogram->lh_buckets + index, 1);
+
+  max = atomic_load (&histogram->lh_max);
+  while (nsec > max && !atomic_compare_exchange_weak (&histogram->lh_max, &max, nsec));
+}
+
+/**
+ * Summarize a latency histogram
+ *
+ * @param[in]  histogram  latency histogram
+ * @param[out] summary    operation count, percentiles, and maximum
+ *
+ * Percentiles are reported as the upper bound of the bucket they fall in
+ * (limited to the maximum recorded latency).
+ */
+void hioi_latency_summarize (const hio_latency_histogram_t *histogram, hio_latency_summary_t *summary);
+
 /**
  * Make the component directories of the specified path
  *
@@ -169,6 +314,21 @@ uint64_t hioi_gettime (void);
  */
 int hioi_mkpath (hio_context_t context, const char *path, mode_t access_mode);
 
+/**
+ * Generate the name of a temporary file used to atomically replace a file
+ *
+ * @param[in]  path     path of the file that will be replaced
+ * @param[out] tmp_path path of the temporary file (allocated)
+ *
+ * @returns HIO_SUCCESS on success
+ * @returns HIO_ERR_OUT_OF_RESOURCE if memory could not be allocated
+ *
+ * The temporary file is in the same directory as path (so it can be renamed over
+ * path) and its name includes the hostname and pid so processes on different nodes
+ * sharing a filesystem do not write the same temporary file.
+ */
+int hioi_tmp_path (const char *path, char **tmp_path);
+
 /**
  * Share a string with all processes in a context
  *
@@ -194,6 +354,31 @@ int hioi_string_scatter (hio_context_t context, char **string);
  */
 uint32_t hioi_crc32 (uint8_t *buf, size_t length);
 
+/**
+ * Calculate the CRC32C (Castagnoli) of a buffer
+ *
+ * @param[in] crc     crc of the preceding data (0 to start a new checksum)
+ * @param[in] buf     buffer to CRC
+ * @param[in] length  length of buffer
+ *
+ * @return CRC32C checksum
+ *
+ * Uses the SSE4.2 crc32 instruction if the processor supports it.
+ */
+uint32_t hioi_crc32c (uint32_t crc, const void *buf, size_t length);
+
+/**
+ * Calculate the CRC32C of a buffer without hardware acceleration
+ *
+ * Same as hioi_crc32c(). Exposed for testing.
+ */
+uint32_t hioi_crc32c_software (uint32_t crc, const void *buf, size_t length);
+
+/**
+ * Check if hioi_crc32c() is using hardware acceleration
+ */
+bool hioi_crc32c_accelerated (void);
+
 /**
  * Calculate CRC64 of buffer
  *
@@ -204,6 +389,90 @@ uint32_t hioi_crc32 (uint8_t *buf, size_t length);
  */
 uint64_t hioi_crc64 (uint8_t *buf, size_t length);
 
+/**
+ * Trace events. New events must be added at the end (before HIO_TRACE_EVENT_MAX)
+ * to keep existing trace files readable.
+ */
+typedef enum hio_trace_event_t {
+  HIO_TRACE_EVENT_TRACE_BEGIN,
+  HIO_TRACE_EVENT_TRACE_END,
+  /** events dropped because a trace ring was full (value: count) */
+  HIO_TRACE_EVENT_DROPPED,
+  HIO_TRACE_EVENT_OPEN,
+  HIO_TRACE_EVENT_CLOSE,
+  HIO_TRACE_EVENT_SHARED_INIT,
+  HIO_TRACE_EVENT_GENERATE_MAP,
+  HIO_TRACE_EVENT_GATHER_MANIFEST,
+  HIO_TRACE_EVENT_FILE_OPEN,
+  HIO_TRACE_EVENT_FILE_CLOSE,
+  HIO_TRACE_EVENT_FILE_SEEK,
+  HIO_TRACE_EVENT_FILE_READ,
+  HIO_TRACE_EVENT_FILE_WRITE,
+  HIO_TRACE_EVENT_TRANSLATE_OFFSET,
+  HIO_TRACE_EVENT_MAP_TRANSLATE_OFFSET,
+  HIO_TRACE_EVENT_ELEMENT_TRANSLATE,
+  HIO_TRACE_EVENT_ELEMENT_READ,
+  HIO_TRACE_EVENT_ELEMENT_WRITE,
+  HIO_TRACE_EVENT_PROCESS_REQUESTS,
+  HIO_TRACE_EVENT_COMPLETE,
+  HIO_TRACE_EVENT_MAX,
+} hio_trace_event_t;
+
+typedef struct hio_trace hio_trace_t;
+
+/**
+ * Open a binary trace file
+ *
+ * @param[out] trace       new trace
+ * @param[in]  path        trace file path (appended to if it exists)
+ * @param[in]  identifier  dataset name
+ * @param[in]  dataset_id  dataset identifier
+ * @param[in]  rank        rank of this process
+ *
+ * @returns HIO_SUCCESS on success
+ * @returns hio error code on failure
+ *
+ * Starts a thread that periodically flushes recorded events to the file.
+ */
+int hioi_trace_open (hio_trace_t **trace, const char *path, const char *identifier, int64_t dataset_id,
+                     int rank);
+
+/**
+ * Record a trace event
+ *
+ * @param[in] trace   trace
+ * @param[in] event   event identifier (see hio_trace_event_t)
+ * @param[in] value   event payload
+ * @param[in] value2  event payload
+ * @param[in] start   event start time (nsec, see hioi_gettime_ns())
+ * @param[in] stop    event stop time (nsec)
+ *
+ * This function does not block. The event is dropped (and counted) if the
+ * calling thread's trace ring is full.
+ */
+void hioi_trace_event (hio_trace_t *trace, int event, uint64_t value, uint64_t value2, uint64_t start,
+                       uint64_t stop);
+
+/**
+ * Flush all recorded events and close a trace
+ *
+ * @param[in] trace   trace to close (may be NULL)
+ */
+void hioi_trace_close (hio_trace_t *trace);
+
+/**
+ * Convert binary trace files to text or Chrome trace event JSON
+ *
+ * @param[in] paths   trace files
+ * @param[in] count   number of trace files
+ * @param[in] chrome  write Chrome trace event JSON instead of text
+ * @param[in] fh      output file
+ *
+ * @returns HIO_SUCCESS on success
+ * @returns hio error code if any trace file could not be read
+ */
+int hio_trace_dump (const char **paths, int count, bool chrome, FILE *fh);
+
 /**
  * Compress an hio iovec if possible
  *
@@ -354,6 +623,64 @@ hio_dataset_backend_data_t *hioi_dbd_lookup_backend_data (hio_dataset_data_t *da
  */
 int hioi_dataset_headers_sort (hio_dataset_header_t *headers, int count, int64_t id);
 
+/**
+ * Distribute a header array from rank 0 to all ranks in the context.
+ *
+ * @param[in]     context     hio context
+ * @param[in,out] headers     header array (input on rank 0, output elsewhere)
+ * @param[in,out] count       number of elements in the headers array
+ *
+ * This function is collective over the context communicator. The module
+ * pointer in each header is translated to the matching module on each rank.
+ */
+int hioi_dataset_headers_scatter (hio_context_t context, hio_dataset_header_t **headers, int *count);
+
+/** statistics shard of the calling thread plus one (0 if not yet assigned) */
+extern __thread int hioi_stat_thread_shard;
+
+/**
+ * Assign a statistics shard to the calling thread
+ *
+ * @returns shard index in [0, HIO_STAT_SHARDS)
+ */
+int hioi_stat_shard_assign (void);
+
+/**
+ * Add to a dataset statistic
+ *
+ * @param[in] dataset  dataset
+ * @param[in] stat     statistic to update
+ * @param[in] value    value to add
+ *
+ * The value is added to the calling thread's shard. Shards are summed by
+ * hioi_dataset_perf_update().
+ */
+static inline void hioi_dataset_stat_add (hio_dataset_t dataset, hio_stat_t stat, uint64_t value) {
+  int shard = hioi_stat_thread_shard ? hioi_stat_thread_shard - 1 : hioi_stat_shard_assign ();
+
+  (void) atomic_fetch_add (dataset->ds_stat.s_shards[shard].ss_values + stat, value);
+}
+
+/**
+ * Update the derived dataset performance variables
+ *
+ * @param[in] object   dataset object
+ *
+ * Sums the statistics shards and summarizes the latency histograms. This is the
+ * perf_update_fn of dataset objects.
+ */
+void hioi_dataset_perf_update (hio_object_t object);
+
+/**
+ * Sum the latency histograms of all ranks in the context
+ *
+ * @param[in] dataset   dataset being closed
+ *
+ * This function is collective over the context communicator. The aggregate
+ * latency summaries are only valid on rank 0.
+ */
+void hioi_dataset_latency_aggregate (hio_dataset_t dataset);
+
 /* element functions */
 
 /**
@@ -364,6 +691,38 @@ int hioi_dataset_headers_sort (hio_dataset_header_t *headers, int count, int64_t
  */
 hio_element_t hioi_element_alloc (hio_dataset_t dataset, const char *name, const int rank);
 
+/* manifest element directory functions */
+
+/**
+ * Load an element from the dataset's manifest element directory
+ *
+ * @param[in]  dataset   dataset to load the element into
+ * @param[in]  name      element identifier
+ * @param[in]  rank      element rank (unique mode only)
+ * @param[out] element   loaded element
+ *
+ * @returns HIO_ERR_NOT_FOUND if the directory does not contain the element
+ *
+ * The element and its segments are added to the dataset's element list. The
+ * caller must hold the dataset lock.
+ */
+int hioi_manifest_directory_load_element (hio_dataset_t dataset, const char *name, int rank,
+                                          hio_element_t *element);
+
+/**
+ * Load all elements that remain in the dataset's manifest element directory
+ *
+ * @param[in]  dataset   dataset to load the elements into
+ */
+int hioi_manifest_directory_load_all (hio_dataset_t dataset);
+
+/**
+ * Release a manifest element directory
+ *
+ * @param[in]  directory element directory (may be NULL)
+ */
+void hioi_manifest_directory_release (hio_manifest_directory_t *directory);
+
 hio_request_t hioi_request_alloc (hio_context_t context);
 
 void hioi_request_release (hio_request_t request);
@@ -371,6 +730,15 @@ void hioi_request_release (hio_request_t request);
 int hioi_element_add_segment (hio_element_t element, int file_index, uint64_t file_offset,
                               uint64_t app_offset, size_t seg_length);
 
+/**
+ * Add a segment with a known data checksum to an element
+ *
+ * Same as hioi_element_add_segment() but the segment is never merged with
+ * an adjacent segment. Used when loading checksummed segments from a manifest.
+ */
+int hioi_element_add_segment_checksum (hio_element_t element, int file_index, uint64_t file_offset,
+                                       uint64_t app_offset, size_t seg_length, uint32_t checksum);
+
 int hioi_element_find_offset (hio_element_t element, uint64_t app_offset, int rank,
                               off_t *offset, size_t *length);
 
@@ -473,6 +841,32 @@ int hioi_element_close_internal (hio_element_t element);
 int hioi_element_translate_offset (hio_element_t element, uint64_t app_offset, int *file_index,
                                    uint64_t *offset, size_t *length);
 
+/**
+ * Extend the checksum of the segment containing newly written data
+ *
+ * @param[in] element hio element handle
+ * @param[in] app_offset application offset of the data
+ * @param[in] data data that was written
+ * @param[in] length length of the data
+ *
+ * The data must immediately follow the bytes already covered by the checksum of the
+ * segment containing app_offset. If it does not the segment is left without a valid
+ * checksum.
+ */
+void hioi_element_checksum_update (hio_element_t element, uint64_t app_offset, const void *data, size_t length);
+
+/**
+ * Look up the checksum of a segment
+ *
+ * @param[in] element hio element handle
+ * @param[in] app_offset application offset
+ * @param[in] length length of the application block
+ * @param[out] checksum crc32c of the segment
+ *
+ * @returns true if the block is exactly one segment of the element with a valid checksum
+ */
+bool hioi_element_segment_checksum (hio_element_t element, uint64_t app_offset, size_t length, uint32_t *checksum);
+
 static inline bool hioi_dataset_doing_io (hio_dataset_t dataset) {
   return true;
 }
@@ -583,6 +977,14 @@ int hio_dataset_dump (const char *data_roots, const char *context, const char *d
                       uint32_t flags, int rank, FILE *fh);
 
 int hioi_config_set_value (hio_object_t object, const char *variable, const char *value);
+
+/**
+ * @brief Apply a configuration value read from a manifest
+ *
+ * Same as hioi_config_set_value() except that variables registered with
+ * HIO_VAR_FLAG_LOCAL keep their current value.
+ */
+int hioi_config_load_value (hio_object_t object, const char *variable, const char *value);
 int hioi_perf_set_value (hio_object_t object, const char *variable, const char *value);
 
 #endif /* !defined(HIO_INTERNAL_H) */
@@ -34,6 +34,9 @@
 
 #include <stdatomic.h>
 
+#define hioi_atomic_load_acq(v) atomic_load_explicit(v, memory_order_acquire)
+#define hioi_atomic_store_rel(p, v) atomic_store_explicit(p, v, memory_order_release)
+
 #elif HIO_ATOMICS_BUILTIN
 
 
@@ -42,7 +45,10 @@ typedef volatile unsigned long atomic_ulong;
 #define atomic_init(p, v) (*(p) = v)
 #define atomic_fetch_add(p, v) __atomic_fetch_add(p, v, __ATOMIC_SEQ_CST)
 #define atomic_fetch_or(p, v) __atomic_fetch_or(p, v, __ATOMIC_SEQ_CST)
+#define atomic_compare_exchange_weak(p, e, d) __atomic_compare_exchange_n(p, e, d, 1, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST)
 #define atomic_load(v) (*(v))
+#define hioi_atomic_load_acq(v) __atomic_load_n(v, __ATOMIC_ACQUIRE)
+#define hioi_atomic_store_rel(p, v) __atomic_store_n(p, v, __ATOMIC_RELEASE)
 
 #elif HIO_ATOMICS_SYNC
 
@@ -51,7 +57,11 @@ typedef volatile unsigned long atomic_ulong;
 #define atomic_init(p, v) (*(p) = v)
 #define atomic_fetch_add(p, v) __sync_fetch_and_add(p, v)
 #define atomic_fetch_or(p, v) __sync_fetch_and_or(p, v)
+#define atomic_compare_exchange_weak(p, e, d) ({ unsigned long _e = *(e), _o = __sync_val_compare_and_swap(p, _e, d); \
+      *(e) = _o; _o == _e; })
 #define atomic_load(v) (*(v))
+#define hioi_atomic_load_acq(v) ({ unsigned long _v = *(v); __sync_synchronize (); _v; })
+#define hioi_atomic_store_rel(p, v) do { __sync_synchronize (); *(p) = (v); } while (0)
 
 #endif
 
@@ -128,6 +138,9 @@ struct hio_internal_request_t;
 struct hio_manifest;
 typedef struct hio_manifest *hio_manifest_t;
 
+struct hio_manifest_directory;
+typedef struct hio_manifest_directory hio_manifest_directory_t;
+
 /**
  * Close a dataset and release any internal state
  *
@@ -237,8 +250,50 @@ typedef int (*hio_element_complete_fn_t) (hio_element_t element);
  */
 typedef int (*hio_element_close_fn_t) (hio_element_t element);
 
+/**
+ * Locate the data backing an element offset
+ *
+ * @param[in]     element      hio dataset element object (open for reading)
+ * @param[in]     offset       element offset
+ * @param[in,out] size         in: maximum number of bytes to locate. out: number of contiguous
+ *                             bytes available at {file_offset} in {fd} or, if no data exists at
+ *                             {offset}, the size of the hole (0 if not known)
+ * @param[out]    fd           file descriptor holding the data
+ * @param[out]    file_offset  offset of the data in {fd}
+ *
+ * @returns HIO_SUCCESS on success
+ * @returns HIO_ERR_NOT_FOUND if no data was written at {offset}
+ *
+ * This function allows data to be copied directly out of the files backing an element
+ * (see hio_dataset_construct()). The file descriptor belongs to the module and is only
+ * valid until the next operation on the dataset.
+ */
+typedef int (*hio_element_locate_fn_t) (hio_element_t element, uint64_t offset, size_t *size, int *fd,
+                                        uint64_t *file_offset);
+
+/**
+ * List the elements stored in a dataset
+ *
+ * @param[in]  dataset  hio dataset object (open for reading)
+ * @param[out] names    newly allocated array of element names
+ * @param[out] ranks    newly allocated array holding the rank that wrote each element
+ *                      (unique datasets only. -1 for shared datasets)
+ * @param[out] count    number of entries in {names} and {ranks}
+ *
+ * This function is collective. It lists elements whether or not they are described
+ * by the dataset manifest. For shared datasets every rank receives the same list (names
+ * may repeat). For unique datasets the list may be limited to the calling rank's
+ * elements. The caller is responsible for freeing each name and both arrays.
+ */
+typedef int (*hio_dataset_element_list_fn_t) (hio_dataset_t dataset, char ***names, int **ranks, size_t *count);
+
 typedef void (*hio_object_release_fn_t) (hio_object_t object);
 
+/**
+ * Update derived performance variables before they are read
+ */
+typedef void (*hio_object_perf_update_fn_t) (hio_object_t object);
+
 struct hio_config_t;
 
 enum {
@@ -264,6 +319,9 @@ enum {
   HIO_VAR_FLAG_READONLY = 1,
   /** variable value will never change (informational) */
   HIO_VAR_FLAG_CONSTANT = 2,
+  /** variable only affects how this process accesses the object. values saved in a
+   * manifest are not applied to it */
+  HIO_VAR_FLAG_LOCAL    = 4,
 };
 
 typedef union hio_var_value_t {
@@ -372,8 +430,28 @@ struct hio_object {
 
   /** object release function */
   hio_object_release_fn_t release_fn;
+
+  /** function to update derived performance variables (may be NULL) */
+  hio_object_perf_update_fn_t perf_update_fn;
 };
 
+/**
+ * Per data root statistics used to select a data root for new datasets. These
+ * statistics are only maintained on rank 0 of the context.
+ */
+typedef struct hio_module_stats_t {
+  /** weighted average aggregate write bandwidth (bytes/usec). 0 if unknown */
+  double             ms_bandwidth;
+  /** weighted average fixed cost of closing a dataset (usec) */
+  uint64_t           ms_latency;
+  /** available space on the data root (bytes). UINT64_MAX if unknown */
+  uint64_t           ms_bavail;
+  /** number of consecutive failed opens or closes */
+  int                ms_failures;
+  /** time of the last failure (seconds since the epoch) */
+  time_t             ms_last_failure;
+} hio_module_stats_t;
+
 struct hio_context {
   struct hio_object c_object;
 
@@ -410,10 +488,24 @@ struct hio_context {
   int                c_mcount;
   /** current active data root */
   int                c_cur_module;
+  /** statistics for each data root (see hioi_context_select_module) */
+  hio_module_stats_t c_module_stats[HIO_MAX_DATA_ROOTS];
+  /** number of times a data root was skipped because it was full or failing */
+  uint64_t           c_module_failovers;
+  /** seconds before a failing data root is tried again */
+  uint64_t           c_module_retry_interval;
+
+  /** number of background dataset removals in progress (see hio_unlink.c) */
+  int                c_unlink_pending;
+  /** first error from a background dataset removal (errno) */
+  int                c_unlink_error;
 
 #if HIO_USE_DATAWARP
   /** path to datawarp root */
   char              *c_dw_root;
+  /** stage the newest complete dataset ids from the PFS into datawarp when the
+   * datawarp module is created */
+  bool               c_dw_prefetch;
   #ifdef HIO_DATAWARP_DEBUG_LOG
     uint64_t          c_dw_debug_mask;
     bool              c_dw_debug_installed;
@@ -433,6 +525,8 @@ struct hio_context {
   int                c_shared_rank;
 
   hio_list_t         c_ds_data;
+  /** dataset history has been loaded from a previous job (see hio_history.c) */
+  bool               c_history_loaded;
 
   /** size of a dataset object */
   size_t             c_ds_size;
@@ -472,12 +566,23 @@ struct hio_dataset_data_t {
    * dataset */
   time_t      dd_last_completion;
 
-  /** weighted average write time for a member of this dataset */
+  /** weighted average time (usec) spent writing a member of this dataset. this only
+   * includes time spent in hio write and close calls */
   uint64_t    dd_average_write_time;
 
+  /** time (usec) spent writing the last member of this dataset that was written. this
+   * is the largest time any rank spent in hio write and close calls */
+  uint64_t    dd_last_write_time;
+
+  /** weighted average bandwidth (bytes/usec) observed writing members of this dataset */
+  double      dd_bandwidth;
+
   /** average dataset size */
   uint64_t    dd_average_size;
 
+  /** aggregate size of the last member of this dataset that was written */
+  uint64_t    dd_last_size;
+
   hio_list_t  dd_backend_data;
 };
 typedef struct hio_dataset_data_t hio_dataset_data_t;
@@ -582,11 +687,30 @@ typedef struct hio_dataset_map_data_t {
   MPI_Win md_win;
 } hio_dataset_map_data_t;
 
+/**
+ * Engines available for looking up remote segments in shared datasets
+ */
+typedef enum hio_dataset_map_engine_t {
+  /** open-addressing hash of segments at multiple granularities */
+  HIO_MAP_ENGINE_HASH,
+  /** range-partitioned sorted segment index */
+  HIO_MAP_ENGINE_RANGE,
+} hio_dataset_map_engine_t;
+
 typedef struct hio_dataset_map_t {
+  /** map engine in use (see hio_dataset_map_engine_t) */
+  int32_t map_engine;
   /** element window */
   hio_dataset_map_data_t map_elements;
   /** segment window */
   hio_dataset_map_data_t map_segments;
+
+  /** range engine: sorted segment records held by the node leaders */
+  hio_dataset_map_data_t map_ranges;
+  /** range engine: splitter table. for each node leader this holds the
+   * number of records it owns, the record stride between fences, and
+   * HIO_MAP_RANGE_FENCES (element index, application offset) fence keys */
+  uint64_t *map_range_table;
 } hio_dataset_map_t;
 #endif /* HIO_MPI_HAVE(3) */
 
@@ -606,6 +730,91 @@ typedef struct hio_shared_control_t {
   } s_stripes[];
 } hio_shared_control_t;
 
+/**
+ * Dataset statistics counted in per-thread shards
+ */
+typedef enum hio_stat_t {
+  HIO_STAT_BREAD,
+  HIO_STAT_RTIME,
+  HIO_STAT_BWRITTEN,
+  HIO_STAT_WTIME,
+  HIO_STAT_RCOUNT,
+  HIO_STAT_WCOUNT,
+  HIO_STAT_CKBYTES,
+  HIO_STAT_CKTIME,
+  HIO_STAT_CKERRORS,
+  HIO_STAT_MAX,
+} hio_stat_t;
+
+/** number of statistics shards in each dataset. threads beyond this share shards */
+#define HIO_STAT_SHARDS        16
+
+#define HIO_CACHE_LINE_SIZE    64
+
+/**
+ * Statistics counters updated by one (or a few) threads. Each shard is padded
+ * to a multiple of the cache line size so updates from different threads do not
+ * contend for the same cache line.
+ */
+typedef struct hio_stat_shard_t {
+  atomic_ulong ss_values[HIO_STAT_MAX];
+  char         ss_pad[HIO_CACHE_LINE_SIZE - (HIO_STAT_MAX * sizeof (atomic_ulong)) % HIO_CACHE_LINE_SIZE];
+} hio_stat_shard_t;
+
+/**
+ * Operations with a latency histogram
+ */
+typedef enum hio_latency_op_t {
+  /** copying write data into the dataset buffer */
+  HIO_LATENCY_OP_APPEND,
+  /** backend write call */
+  HIO_LATENCY_OP_WRITE,
+  /** backend read call */
+  HIO_LATENCY_OP_READ,
+  /** flushing the dataset buffer to the backend */
+  HIO_LATENCY_OP_FLUSH,
+  /** backend dataset open */
+  HIO_LATENCY_OP_OPEN,
+  /** dataset close */
+  HIO_LATENCY_OP_CLOSE,
+  /** gathering the dataset manifest */
+  HIO_LATENCY_OP_GATHER_MANIFEST,
+  HIO_LATENCY_OP_MAX,
+} hio_latency_op_t;
+
+/** number of sub-buckets (log2) in each power of two of a latency histogram */
+#define HIO_LATENCY_SUB_BITS   3
+/** largest power of two (nsec) with its own histogram buckets. larger values are
+ * counted in the last bucket */
+#define HIO_LATENCY_MAX_EXP    40
+#define HIO_LATENCY_BUCKETS    ((HIO_LATENCY_MAX_EXP - HIO_LATENCY_SUB_BITS + 2) << HIO_LATENCY_SUB_BITS)
+
+/**
+ * Log-linear latency histogram. Each power of two of nsec is split into
+ * 2^HIO_LATENCY_SUB_BITS buckets so values are recorded with a relative
+ * error of at most 12.5%.
+ */
+typedef struct hio_latency_histogram_t {
+  /** number of operations in each bucket */
+  atomic_ulong lh_buckets[HIO_LATENCY_BUCKETS];
+  /** largest recorded latency (nsec) */
+  atomic_ulong lh_max;
+} hio_latency_histogram_t;
+
+/**
+ * Latency histogram summary exposed as performance variables
+ */
+typedef struct hio_latency_summary_t {
+  /** number of operations */
+  uint64_t ls_count;
+  /** percentiles (nsec) */
+  uint64_t ls_p50;
+  uint64_t ls_p90;
+  uint64_t ls_p99;
+  /** maximum (nsec) */
+  uint64_t ls_max;
+} hio_latency_summary_t;
+
 struct hio_dataset {
   /** allows for type detection */
   struct hio_object   ds_object;
@@ -625,6 +834,10 @@ struct hio_dataset {
   /** list of elements */
   hio_list_t          ds_elist;
 
+  /** manifest element directory. elements in the directory are added to
+   * ds_elist when they are first opened (may be NULL) */
+  hio_manifest_directory_t *ds_element_directory;
+
   /** open time */
   struct timeval      ds_otime;
 
@@ -632,6 +845,10 @@ struct hio_dataset {
   uint64_t            ds_rotime;
 
   struct {
+    /** per-thread counter shards (see hioi_dataset_stat_add()). the
+     * counters below are sums of the shards */
+    hio_stat_shard_t   *s_shards;
+
     /** aggregate number of bytes read */
     uint64_t            s_bread;
     /** aggregate read time */
@@ -643,9 +860,21 @@ struct hio_dataset {
     uint64_t            s_wtime;
 
     /** total number of write operations */
-    atomic_ulong        s_wcount;
+    uint64_t            s_wcount;
     /** total number of read operations */
-    atomic_ulong        s_rcount;
+    uint64_t            s_rcount;
+
+    /** number of bytes checksummed (written or verified) */
+    uint64_t            s_ckbytes;
+    /** time spent computing data checksums (nsec) */
+    uint64_t            s_cktime;
+    /** number of segments that failed checksum verification */
+    uint64_t            s_ckerrors;
+
+    /** latency histograms */
+    hio_latency_histogram_t s_latency[HIO_LATENCY_OP_MAX];
+    /** summaries of s_latency. updated by hioi_dataset_perf_update() */
+    hio_latency_summary_t s_lsummary[HIO_LATENCY_OP_MAX];
 
     /** aggregate number of bytes read */
     uint64_t            s_abread;
@@ -661,6 +890,11 @@ struct hio_dataset {
     uint64_t            s_awcount;
     /** total number of read operations */
     uint64_t            s_arcount;
+
+    /** sum of the latency histograms of all ranks. updated at close */
+    hio_latency_histogram_t s_alatency[HIO_LATENCY_OP_MAX];
+    /** summaries of s_alatency */
+    hio_latency_summary_t s_alsummary[HIO_LATENCY_OP_MAX];
   } ds_stat;
 
   /** data associated with this dataset */
@@ -692,6 +926,12 @@ struct hio_dataset {
 
   /** process multiple requests */
   hio_dataset_process_requests_fn_t ds_process_reqs;
+
+  /** locate the file data backing an element offset (optional. may be NULL) */
+  hio_element_locate_fn_t ds_element_locate;
+
+  /** list the elements stored in the dataset (optional. may be NULL) */
+  hio_dataset_element_list_fn_t ds_element_list;
 };
 
 typedef enum {
@@ -727,6 +967,8 @@ struct hio_request {
   size_t            req_transferred;
   /** status of the request */
   int               req_status;
+  /** element with deferred operations that will complete this request (NULL if none) */
+  hio_element_t     req_element;
 };
 
 typedef struct hio_iovec_t {
@@ -754,6 +996,8 @@ typedef struct hio_internal_request_t {
   ssize_t       ir_status;
   hio_request_type_t ir_type;
   hio_request_t *ir_urequest;
+  /** user request to complete when a deferred request finishes (may be NULL) */
+  hio_request_t  ir_request;
 } hio_internal_request_t;
 
 typedef struct hio_manifest_segment_t {
@@ -765,8 +1009,16 @@ typedef struct hio_manifest_segment_t {
   uint64_t   seg_foffset;
   /** file index */
   int        seg_file_index;
+  /** crc32c of the segment data (see seg_cksum_length) */
+  uint32_t   seg_checksum;
+  /** number of bytes from the start of the segment covered by seg_checksum. the
+   * checksum is only valid if this is equal to seg_length */
+  uint64_t   seg_cksum_length;
 } hio_manifest_segment_t;
 
+/** value of seg_cksum_length for a segment whose checksum can no longer be computed */
+#define HIO_SEGMENT_CKSUM_INVALID UINT64_MAX
+
 struct hio_element {
   struct hio_object e_object;
 
@@ -788,6 +1040,13 @@ struct hio_element {
   /** element is currently open */
   int32_t           e_open_count;
 
+#if HIO_MPI_HAVE(3)
+  /** segments returned by the last range map query (range map engine only) */
+  hio_manifest_segment_t *e_map_cache;
+  /** number of segments in the range map cache */
+  size_t            e_map_cache_count;
+#endif
+
   /** first invalid offset after the last valid block */
   int64_t           e_size;
 
@@ -796,6 +1055,9 @@ struct hio_element {
   /** function to flush pending element writes */
   hio_element_flush_fn_t e_flush;
 
+  /** reads that have been queued but not yet issued (see hio_complete()) */
+  hio_list_t        e_pending_reads;
+
   /** function to complete pending element reads */
   hio_element_complete_fn_t e_complete;
 
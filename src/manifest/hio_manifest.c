@@ -18,7 +18,9 @@
 #include <string.h>
 #include <assert.h>
 #include <unistd.h>
-#include <bzlib.h>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #if !defined(__STRICT_ANSI__)
 /* silence pedantic error about extension usage in json-c */
@@ -175,10 +177,10 @@ static int hioi_manifest_save_vars (json_object *top, const char *name, hio_var_
       hioi_manifest_set_string (object, name, var->var_storage->strval);
       break;
     case HIO_CONFIG_TYPE_FLOAT:
-      hioi_manifest_set_double (object, name, var->var_storage->doubleval);
+      hioi_manifest_set_double (object, name, var->var_storage->floatval);
       break;
     case HIO_CONFIG_TYPE_DOUBLE:
-      hioi_manifest_set_double (object, name, var->var_storage->floatval);
+      hioi_manifest_set_double (object, name, var->var_storage->doubleval);
       break;
     }
   }
@@ -286,6 +288,10 @@ static json_object *hio_manifest_generate_3_0 (hio_dataset_t dataset) {
                                   (unsigned long) segment->seg_length);
         hioi_manifest_set_number (segment_object, HIO_SEGMENT_KEY_FILE_INDEX,
                                   (unsigned long) segment->seg_file_index);
+        if (segment->seg_cksum_length == segment->seg_length) {
+          hioi_manifest_set_number (segment_object, HIO_SEGMENT_KEY_CHECKSUM,
+                                    (unsigned long) segment->seg_checksum);
+        }
         json_object_array_add (segments_object, segment_object);
       }
     }
@@ -300,72 +306,252 @@ static json_object *hio_manifest_generate_3_0 (hio_dataset_t dataset) {
  * @param[in] json_object json object pointer
  * @param[out] data serialized data out
  * @param[out] data_size length of serialized data
- * @param[in] compress_data whether to compress the serialized data
+ * @param[in] codec codec to use to compress the serialized data
+ * @param[in,out] stats codec statistics to update
  *
  * @returns HIO_SUCCESS on success
  * @returns HIO_ERR_OUT_OF_RESOURCE if run out of memory
  */
 static int hioi_manifest_serialize_json (json_object *json_object, unsigned char **data, size_t *data_size,
-                                         bool compress_data) {
+                                         int codec, hio_manifest_codec_stats_t *stats) {
   const char *serialized;
-  unsigned int serialized_len;
-  int rc;
+  size_t serialized_len;
 
   serialized = json_object_to_json_string (json_object);
   serialized_len = strlen (serialized) + 1;
-  if (compress_data) {
-    unsigned int compressed_size = serialized_len;
-    char *tmp;
+  if (HIO_MANIFEST_CODEC_NONE != codec) {
+    return hioi_manifest_compress (codec, (const unsigned char *) serialized, serialized_len, data, data_size,
+                                   stats);
+  }
 
-    tmp = malloc (serialized_len);
-    if (NULL == tmp) {
-      return HIO_ERR_OUT_OF_RESOURCE;
-    }
+  *data_size = serialized_len;
 
-    rc = BZ2_bzBuffToBuffCompress (tmp, &compressed_size, (char *) serialized, serialized_len, 3, 0, 0);
-    if (BZ_OK != rc) {
-      free (tmp);
-      return HIO_ERROR;
+  *data = calloc (*data_size, 1);
+  if (NULL == *data) {
+    return HIO_ERR_OUT_OF_RESOURCE;
+  }
+
+  memcpy (*data, serialized, *data_size - 1);
+
+  return HIO_SUCCESS;
+}
+
+static void hioi_manifest_release_binary (hio_manifest_t manifest) {
+  if (manifest->binary_mapped) {
+    (void) munmap (manifest->binary_data, manifest->binary_size);
+  } else {
+    free (manifest->binary_data);
+  }
+
+  manifest->binary_data = NULL;
+  manifest->binary_size = 0;
+  manifest->binary_mapped = false;
+}
+
+void hioi_manifest_release (hio_manifest_t manifest) {
+  if (NULL != manifest) {
+    json_object_put (manifest->json_object);
+    hioi_manifest_release_binary (manifest);
+    free (manifest);
+  }
+}
+
+void hioi_manifest_set_binary (hio_manifest_t manifest, unsigned char *data, size_t data_size) {
+  json_object_put (manifest->json_object);
+  manifest->json_object = NULL;
+  hioi_manifest_release_binary (manifest);
+
+  manifest->binary_data = data;
+  manifest->binary_size = data_size;
+}
+
+int hioi_manifest_convert_binary (hio_manifest_t manifest) {
+  unsigned char *data;
+  const char *compat;
+  size_t data_size;
+  int rc;
+
+  if (NULL == manifest->json_object) {
+    return HIO_SUCCESS;
+  }
+
+  /* the binary format only records the 3.0 layout */
+  rc = hioi_manifest_get_string (manifest->json_object, HIO_MANIFEST_KEY_COMPAT, &compat);
+  if (HIO_SUCCESS != rc || strcmp (compat, HIO_MANIFEST_COMPAT)) {
+    return HIO_SUCCESS;
+  }
+
+  rc = hioi_manifest_serialize_binary (manifest->json_object, &data, &data_size);
+  if (HIO_SUCCESS != rc) {
+    return rc;
+  }
+
+  hioi_manifest_set_binary (manifest, data, data_size);
+
+  return HIO_SUCCESS;
+}
+
+int hioi_manifest_create_binary (hio_context_t context, unsigned char *data, size_t data_size,
+                                 hio_manifest_t *manifest_out) {
+  hio_manifest_t manifest;
+
+  manifest = calloc (1, sizeof (*manifest));
+  if (NULL == manifest) {
+    return HIO_ERR_OUT_OF_RESOURCE;
+  }
+
+  manifest->context = context;
+  manifest->binary_data = data;
+  manifest->binary_size = data_size;
+
+  *manifest_out = manifest;
+
+  return HIO_SUCCESS;
+}
+
+int hioi_manifest_take_binary (hio_manifest_t manifest, unsigned char **data, size_t *data_size) {
+  if (NULL == manifest->json_object && NULL != manifest->binary_data) {
+    /* take ownership of the existing image */
+    if (!manifest->binary_mapped) {
+      *data = manifest->binary_data;
+      *data_size = manifest->binary_size;
+      manifest->binary_data = NULL;
+      manifest->binary_size = 0;
+      return HIO_SUCCESS;
     }
 
-    *data = realloc (tmp, compressed_size);
-    if (NULL == *data) {
-      free (tmp);
-      return HIO_ERR_OUT_OF_RESOURCE;
+    return hioi_manifest_serialize (manifest, data, data_size, HIO_MANIFEST_CODEC_NONE);
+  }
+
+  return hioi_manifest_serialize_binary (manifest->json_object, data, data_size);
+}
+
+json_object *hioi_manifest_get_json (hio_manifest_t manifest) {
+  int rc;
+
+  if (NULL == manifest->json_object && NULL != manifest->binary_data) {
+    rc = hioi_manifest_binary_to_json (manifest->binary_data, manifest->binary_size, &manifest->json_object);
+    if (HIO_SUCCESS != rc) {
+      return NULL;
     }
 
-    *data_size = compressed_size;
-  } else {
-    *data_size = serialized_len;
+    /* the json object may be modified so the binary image is no longer valid */
+    hioi_manifest_release_binary (manifest);
+  }
 
-    *data = calloc (*data_size, 1);
+  return manifest->json_object;
+}
+
+int hioi_manifest_serialize (hio_manifest_t manifest, unsigned char **data, size_t *data_size, int codec) {
+  if (NULL == manifest->json_object && NULL != manifest->binary_data) {
+    /* binary images are sent as-is */
+    *data = malloc (manifest->binary_size);
     if (NULL == *data) {
       return HIO_ERR_OUT_OF_RESOURCE;
     }
 
-    memcpy (*data, serialized, *data_size - 1);
+    memcpy (*data, manifest->binary_data, manifest->binary_size);
+    *data_size = manifest->binary_size;
+
+    return HIO_SUCCESS;
   }
 
-  return HIO_SUCCESS;
+  return hioi_manifest_serialize_json (manifest->json_object, data, data_size, codec, &manifest->codec_stats);
 }
 
-void hioi_manifest_release (hio_manifest_t manifest) {
-  if (NULL != manifest) {
-    json_object_put (manifest->json_object);
-    free (manifest);
+/**
+ * @brief Write a manifest held in a binary image to a file
+ *
+ * The image is written as-is (binary format) or converted to json on the fly
+ * (json format). Neither needs a json object tree or a serialized copy of the
+ * manifest so the memory needed does not depend on the number of segments.
+ */
+static int hioi_manifest_save_binary_image (hio_manifest_t manifest, int format, int codec, int fd) {
+  hio_manifest_encoder_t *encoder;
+  int rc, rc2;
+
+  if (HIO_MANIFEST_FORMAT_BINARY == format) {
+    codec = HIO_MANIFEST_CODEC_NONE;
+  }
+
+  rc = hioi_manifest_encoder_open (codec, fd, &manifest->codec_stats, &encoder);
+  if (HIO_SUCCESS != rc) {
+    return rc;
   }
+
+  if (HIO_MANIFEST_FORMAT_BINARY == format) {
+    rc = hioi_manifest_encoder_write (encoder, manifest->binary_data, manifest->binary_size);
+  } else {
+    rc = hioi_manifest_binary_write_json (manifest->binary_data, manifest->binary_size, encoder);
+  }
+
+  rc2 = hioi_manifest_encoder_close (encoder);
+
+  return (HIO_SUCCESS == rc) ? rc2 : rc;
 }
 
-int hioi_manifest_serialize (hio_manifest_t manifest, unsigned char **data, size_t *data_size, bool compress_data) {
-  return hioi_manifest_serialize_json (manifest->json_object, data, data_size, compress_data);
+int hioi_manifest_save_dataset (hio_dataset_t dataset, int format, int codec, const char *path,
+                                hio_manifest_codec_stats_t *stats) {
+  hio_manifest_encoder_t *encoder;
+  int rc, rc2, fd;
+
+  if (HIO_MANIFEST_FORMAT_BINARY == format) {
+    codec = HIO_MANIFEST_CODEC_NONE;
+  }
+
+  /* make sure the manifest has up-to-date statistics */
+  hioi_dataset_perf_update (&dataset->ds_object);
+
+  errno = 0;
+  fd = open (path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (0 > fd) {
+    return hioi_err_errno (errno);
+  }
+
+  rc = hioi_manifest_encoder_open (codec, fd, stats, &encoder);
+  if (HIO_SUCCESS == rc) {
+    rc = hioi_manifest_binary_write_dataset (dataset, format, encoder);
+    rc2 = hioi_manifest_encoder_close (encoder);
+    if (HIO_SUCCESS == rc) {
+      rc = rc2;
+    }
+  }
+
+  close (fd);
+
+  return rc;
 }
 
-int hioi_manifest_save (hio_manifest_t manifest, bool compress_data, const char *path) {
+int hioi_manifest_save (hio_manifest_t manifest, int format, int codec, const char *path) {
   unsigned char *data;
   size_t data_size;
   int rc;
 
-  rc = hioi_manifest_serialize_json (manifest->json_object, &data, &data_size, compress_data);
+  if (NULL == manifest->json_object && NULL != manifest->binary_data) {
+    errno = 0;
+    int fd = open (path, O_WRONLY | O_CREAT, 0644);
+    if (0 > fd) {
+      return hioi_err_errno (errno);
+    }
+
+    rc = hioi_manifest_save_binary_image (manifest, format, codec, fd);
+    close (fd);
+
+    return rc;
+  }
+
+  if (HIO_MANIFEST_FORMAT_BINARY == format) {
+    rc = hioi_manifest_serialize_binary (manifest->json_object, &data, &data_size);
+  } else {
+    json_object *object = hioi_manifest_get_json (manifest);
+
+    if (NULL == object) {
+      return HIO_ERROR;
+    }
+
+    rc = hioi_manifest_serialize_json (object, &data, &data_size, codec, &manifest->codec_stats);
+  }
+
   if (HIO_SUCCESS != rc) {
     return rc;
   }
@@ -390,7 +576,7 @@ int hioi_manifest_save (hio_manifest_t manifest, bool compress_data, const char
 }
 
 static int hioi_manifest_parse_segment_2_1 (hio_element_t element, json_object *segment_object) {
-  unsigned long file_offset, app_offset0, length, file_index;
+  unsigned long file_offset, app_offset0, length, file_index, checksum;
   int rc;
 
   rc = hioi_manifest_get_number (segment_object, HIO_SEGMENT_KEY_FILE_OFFSET, &file_offset);
@@ -414,6 +600,11 @@ static int hioi_manifest_parse_segment_2_1 (hio_element_t element, json_object *
     return rc;
   }
 
+  if (HIO_SUCCESS == hioi_manifest_get_number (segment_object, HIO_SEGMENT_KEY_CHECKSUM, &checksum)) {
+    return hioi_element_add_segment_checksum (element, file_index, file_offset, app_offset0, length,
+                                              (uint32_t) checksum);
+  }
+
   return hioi_element_add_segment (element, file_index, file_offset, app_offset0, length);
 }
 
@@ -690,7 +881,7 @@ static int hioi_manifest_parse_3_0 (hio_dataset_t dataset, json_object *object)
   if (NULL != config) {
     json_object_object_foreach (config, key, value) {
       hioi_log (context, HIO_VERBOSE_DEBUG_LOW, "found manifest configuration key %s", key);
-      (void) hioi_config_set_value (&dataset->ds_object, key, json_object_get_string (value));
+      (void) hioi_config_load_value (&dataset->ds_object, key, json_object_get_string (value));
     }
   }
 
@@ -800,69 +991,40 @@ static int hioi_manifest_parse_header_2_0 (hio_context_t context, hio_dataset_he
   return HIO_SUCCESS;
 }
 
-static int hioi_manifest_decompress (unsigned char **data, size_t data_size) {
-  const size_t increment = 8192;
-  char *uncompressed, *tmp;
-  bz_stream strm;
-  size_t size;
-  int rc;
+int hioi_manifest_generate (hio_dataset_t dataset, bool simple, hio_manifest_t *manifest_out) {
+  hio_manifest_t manifest;
 
-  uncompressed = malloc (increment);
-  if (NULL == uncompressed) {
+  manifest = calloc (1, sizeof (*manifest));
+  if (NULL == manifest) {
     return HIO_ERR_OUT_OF_RESOURCE;
   }
 
-  strm.bzalloc = NULL;
-  strm.bzfree = NULL;
-  strm.opaque = NULL;
-  strm.next_in = (char *) *data;
-  strm.avail_in = data_size;
-  strm.next_out = uncompressed;
-  strm.avail_out = size = increment;
-
-  BZ2_bzDecompressInit (&strm, 0, 0);
-
-  do {
-    rc = BZ2_bzDecompress (&strm);
-    if (BZ_OK != rc) {
-      BZ2_bzDecompressEnd (&strm);
-      if (BZ_STREAM_END == rc) {
-        break;
-      }
-      free (uncompressed);
-      return HIO_ERROR;
-    }
-
-    tmp = realloc (uncompressed, size + increment);
-    if (NULL == tmp) {
-      BZ2_bzDecompressEnd (&strm);
-      free (uncompressed);
-      return HIO_ERR_OUT_OF_RESOURCE;
-    }
+  if (simple) {
+    manifest->json_object = hio_manifest_generate_simple_3_0 (dataset);
+  } else {
+    manifest->json_object = hio_manifest_generate_3_0 (dataset);
+  }
 
-    uncompressed = tmp;
+  manifest->context = hioi_object_context (&dataset->ds_object);
 
-    strm.next_out = uncompressed + size;
-    strm.avail_out = increment;
-    size += increment;
-  } while (1);
+  *manifest_out = manifest;
 
-  *data = (unsigned char *) uncompressed;
   return HIO_SUCCESS;
 }
 
-int hioi_manifest_generate (hio_dataset_t dataset, bool simple, hio_manifest_t *manifest_out) {
+int hioi_manifest_generate_binary (hio_dataset_t dataset, bool simple, hio_manifest_t *manifest_out) {
   hio_manifest_t manifest;
+  int rc;
 
   manifest = calloc (1, sizeof (*manifest));
   if (NULL == manifest) {
     return HIO_ERR_OUT_OF_RESOURCE;
   }
 
-  if (simple) {
-    manifest->json_object = hio_manifest_generate_simple_3_0 (dataset);
-  } else {
-    manifest->json_object = hio_manifest_generate_3_0 (dataset);
+  rc = hioi_manifest_generate_binary_image (dataset, simple, &manifest->binary_data, &manifest->binary_size);
+  if (HIO_SUCCESS != rc) {
+    free (manifest);
+    return rc;
   }
 
   manifest->context = hioi_object_context (&dataset->ds_object);
@@ -901,10 +1063,27 @@ int hioi_manifest_deserialize (hio_context_t context, const unsigned char *data,
     return HIO_ERR_OUT_OF_RESOURCE;
   }
 
-  if ('B' == data[0] && 'Z' == data[1]) {
-    tmp = (unsigned char *) data;
-    /* gz compressed */
-    rc = hioi_manifest_decompress ((unsigned char **) &tmp, data_size);
+  manifest->context = context;
+
+  if (hioi_manifest_data_is_binary (data, data_size)) {
+    /* binary images are used as-is. keep a copy since the caller owns the data */
+    manifest->binary_data = malloc (data_size);
+    if (NULL == manifest->binary_data) {
+      free (manifest);
+      return HIO_ERR_OUT_OF_RESOURCE;
+    }
+
+    memcpy (manifest->binary_data, data, data_size);
+    manifest->binary_size = data_size;
+    *manifest_out = manifest;
+
+    return HIO_SUCCESS;
+  }
+
+  if (HIO_MANIFEST_CODEC_NONE != hioi_manifest_codec_detect (data, data_size)) {
+    size_t tmp_size;
+
+    rc = hioi_manifest_decompress (data, data_size, &tmp, &tmp_size, &manifest->codec_stats);
     if (HIO_SUCCESS != rc) {
       free (manifest);
       return rc;
@@ -920,7 +1099,6 @@ int hioi_manifest_deserialize (hio_context_t context, const unsigned char *data,
     return HIO_ERROR;
   }
 
-  manifest->context = context;
   manifest->json_object = object;
 
   *manifest_out = manifest;
@@ -928,8 +1106,51 @@ int hioi_manifest_deserialize (hio_context_t context, const unsigned char *data,
   return HIO_SUCCESS;
 }
 
+/**
+ * @brief Map a binary manifest into memory
+ *
+ * @param[in]  context      associated hio context
+ * @param[in]  path         location of the binary manifest
+ * @param[in]  file_size    size of the manifest file
+ * @param[out] manifest_out new manifest object
+ *
+ * Binary manifests do not need to be parsed so they are mapped directly instead
+ * of being copied into a buffer.
+ */
+static int hioi_manifest_map (hio_context_t context, const char *path, size_t file_size, hio_manifest_t *manifest_out) {
+  hio_manifest_t manifest;
+  void *base;
+  int fd;
+
+  fd = open (path, O_RDONLY);
+  if (0 > fd) {
+    return hioi_err_errno (errno);
+  }
+
+  base = mmap (NULL, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close (fd);
+  if (MAP_FAILED == base) {
+    return hioi_err_errno (errno);
+  }
+
+  manifest = calloc (1, sizeof (*manifest));
+  if (NULL == manifest) {
+    munmap (base, file_size);
+    return HIO_ERR_OUT_OF_RESOURCE;
+  }
+
+  manifest->context = context;
+  manifest->binary_data = (unsigned char *) base;
+  manifest->binary_size = file_size;
+  manifest->binary_mapped = true;
+
+  *manifest_out = manifest;
+
+  return HIO_SUCCESS;
+}
+
 int hioi_manifest_read (hio_context_t context, const char *path, hio_manifest_t *manifest_out) {
-  unsigned char *buffer = NULL;
+  unsigned char *buffer = NULL, magic[8];
   size_t file_size;
   FILE *fh;
   int rc;
@@ -956,6 +1177,15 @@ int hioi_manifest_read (hio_context_t context, const char *path, hio_manifest_t
     return HIO_ERR_BAD_PARAM;
   }
 
+  if (file_size > sizeof (magic) && sizeof (magic) == fread (magic, 1, sizeof (magic), fh)) {
+    if (hioi_manifest_data_is_binary (magic, sizeof (magic))) {
+      fclose (fh);
+      return hioi_manifest_map (context, path, file_size, manifest_out);
+    }
+
+    (void) fseek (fh, 0, SEEK_SET);
+  }
+
   buffer = malloc (file_size);
   if (NULL == buffer) {
     fclose (fh);
@@ -981,6 +1211,16 @@ int hioi_manifest_load (hio_dataset_t dataset, hio_manifest_t manifest) {
   hioi_log (context, HIO_VERBOSE_DEBUG_LOW, "Loading dataset manifest on %s:%" PRIu64,
             dataset->ds_object.identifier, dataset->ds_id);
 
+  if (!(dataset->ds_flags & HIO_FLAG_WRITE) && NULL == dataset->ds_element_directory) {
+    /* load elements from json manifests lazily as well. if the conversion fails the
+     * json manifest is parsed as usual */
+    (void) hioi_manifest_convert_binary (manifest);
+  }
+
+  if (NULL == manifest->json_object && NULL != manifest->binary_data) {
+    return hioi_manifest_load_binary (dataset, manifest);
+  }
+
   return hioi_manifest_parse_3_0 (dataset, manifest->json_object);
 }
 
@@ -1162,11 +1402,19 @@ static int hioi_manifest_merge_internal (json_object *object1, json_object *obje
 }
 
 int hioi_manifest_merge_data (hio_manifest_t manifest, hio_manifest_t manifest2) {
+  json_object *object, *object2;
+
   if (NULL == manifest || NULL == manifest2) {
     return HIO_ERR_BAD_PARAM;
   }
 
-  return hioi_manifest_merge_internal (manifest->json_object, manifest2->json_object);
+  object = hioi_manifest_get_json (manifest);
+  object2 = hioi_manifest_get_json (manifest2);
+  if (NULL == object || NULL == object2) {
+    return HIO_ERR_BAD_PARAM;
+  }
+
+  return hioi_manifest_merge_internal (object, object2);
 }
 
 static int rank_compare (const void *a, const void *b) {
@@ -1184,7 +1432,11 @@ int hioi_manifest_ranks (hio_manifest_t manifest, int **ranks, int *rank_count)
   *ranks = NULL;
   *rank_count = 0;
 
-  object = manifest->json_object;
+  object = hioi_manifest_get_json (manifest);
+  if (NULL == object) {
+    return HIO_ERR_BAD_PARAM;
+  }
+
   elements = hioi_manifest_find_object (object, HIO_MANIFEST_KEY_ELEMENTS);
   element_count = elements ? json_object_array_length (elements) : 0;
   if (0 == element_count) {
@@ -1257,5 +1509,10 @@ int hioi_manifest_read_header (hio_manifest_t manifest, hio_dataset_header_t *he
     return HIO_ERR_BAD_PARAM;
   }
 
+  if (NULL == manifest->json_object && NULL != manifest->binary_data) {
+    return hioi_manifest_read_header_binary (manifest->context, header, manifest->binary_data,
+                                             manifest->binary_size);
+  }
+
   return hioi_manifest_parse_header_2_0 (manifest->context, header, manifest->json_object);
 }
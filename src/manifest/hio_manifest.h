@@ -39,10 +39,57 @@
 #define HIO_SEGMENT_KEY_APP_OFFSET0   "off"
 #define HIO_SEGMENT_KEY_LENGTH        "len"
 #define HIO_SEGMENT_KEY_FILE_INDEX    "findex"
+#define HIO_SEGMENT_KEY_CHECKSUM      "crc"
+
+/**
+ * Manifest formats
+ */
+typedef enum hio_manifest_format_t {
+  /** json text (optionally bzip2 compressed) */
+  HIO_MANIFEST_FORMAT_JSON,
+  /** flat binary image that can be used without parsing */
+  HIO_MANIFEST_FORMAT_BINARY,
+} hio_manifest_format_t;
+
+/**
+ * Codecs for compressing serialized manifest data
+ */
+typedef enum hio_manifest_codec_t {
+  /** no compression */
+  HIO_MANIFEST_CODEC_NONE,
+  /** bzip2 (best ratio, slowest) */
+  HIO_MANIFEST_CODEC_BZIP2,
+  /** fast lz77 codec (LZ4 block format) */
+  HIO_MANIFEST_CODEC_LZ,
+} hio_manifest_codec_t;
+
+/**
+ * Codec statistics
+ */
+typedef struct hio_manifest_codec_stats_t {
+  /** uncompressed bytes processed */
+  uint64_t cs_raw_bytes;
+  /** compressed bytes processed */
+  uint64_t cs_coded_bytes;
+  /** time spent in the codec */
+  uint64_t cs_time_usec;
+} hio_manifest_codec_stats_t;
+
+/** streaming manifest encoder (see hioi_manifest_encoder_open) */
+typedef struct hio_manifest_encoder hio_manifest_encoder_t;
 
 struct hio_manifest {
   hio_context_t context;
   json_object *json_object;
+  /** binary manifest image. if json_object is NULL this image holds the
+   * manifest data. */
+  unsigned char *binary_data;
+  /** size of the binary manifest image */
+  size_t binary_size;
+  /** binary image was mapped from a file */
+  bool binary_mapped;
+  /** statistics of codec operations done on behalf of this manifest */
+  hio_manifest_codec_stats_t codec_stats;
 };
 
 /**
@@ -57,6 +104,18 @@ struct hio_manifest {
  */
 int hioi_manifest_generate (hio_dataset_t dataset, bool simple, hio_manifest_t *manifest);
 
+/**
+ * @brief Generate a new binary manifest object from an hio dataset object
+ *
+ * @param[in] dataset   libhio dataset
+ * @param[in] simple    boolean indicating whether to generate a simple manifest
+ *
+ * Same as hioi_manifest_generate() but the manifest is backed by a binary image. No
+ * json objects are created. This is the preferred form for manifests that will be
+ * reduced with hioi_manifest_gather_comm().
+ */
+int hioi_manifest_generate_binary (hio_dataset_t dataset, bool simple, hio_manifest_t *manifest);
+
 /**
  * @brief Create an empty manifest object
  *
@@ -105,24 +164,40 @@ void hioi_manifest_release (hio_manifest_t manifest);
  * @param[in]  dataset       dataset to serialize
  * @param[out] data          serialized data
  * @param[out] data_size     size of serialized data
- * @param[in]  compress_data if true will use bzip2 compression
- * @param[in]  simple        return only the manifest header data
+ * @param[in]  codec         codec to use to compress the data (see hio_manifest_codec_t)
  *
  * This function serializes the local data associated with the dataset and returns a buffer
- * containing the serialized data.
+ * containing the serialized data. Binary manifests are never compressed.
  */
-int hioi_manifest_serialize (hio_manifest_t manifest, unsigned char **data, size_t *data_size, bool compress_data);
+int hioi_manifest_serialize (hio_manifest_t manifest, unsigned char **data, size_t *data_size, int codec);
 
 /**
  * @brief Serialize the manifest in the dataset and save it to the specified file
  *
  * @param[in]  manifest      manifest to save
- * @param[in]  compress_data boolean indicating whether to bzip compress the manifest
+ * @param[in]  format        manifest format to write (see hio_manifest_format_t)
+ * @param[in]  codec         codec to use to compress the manifest (json format only)
  * @param[in]  path          file to save the manifest into
  *
  * This function serializes a manifest and saves it to a specific path.
  */
-int hioi_manifest_save (hio_manifest_t manifest, bool compress_data, const char *path);
+int hioi_manifest_save (hio_manifest_t manifest, int format, int codec, const char *path);
+
+/**
+ * @brief Write the manifest of a dataset directly to the specified file
+ *
+ * @param[in]  dataset       dataset to describe
+ * @param[in]  format        manifest format to write (see hio_manifest_format_t)
+ * @param[in]  codec         codec to use to compress the manifest (json format only)
+ * @param[in]  path          file to save the manifest into
+ * @param[in,out] stats      codec statistics to update (may be NULL)
+ *
+ * Writes the same manifest as hioi_manifest_generate_binary() followed by hioi_manifest_save()
+ * but records are emitted while walking the dataset's elements and written in fixed size
+ * chunks. Memory use does not depend on the number of elements or segments.
+ */
+int hioi_manifest_save_dataset (hio_dataset_t dataset, int format, int codec, const char *path,
+                                hio_manifest_codec_stats_t *stats);
 
 /**
  * @brief Merge hio manifests
@@ -160,12 +235,194 @@ int hioi_manifest_dump_file (hio_context_t context, const char *path, uint32_t f
 int hioi_manifest_dump (hio_manifest_t manifest, uint32_t flags, int rank, FILE *fh);
 
 #if HIO_MPI_HAVE(1)
-int hioi_manifest_gather_comm (hio_manifest_t *manifest, MPI_Comm comm);
+/**
+ * @brief Reduce the manifests of all ranks in a communicator to rank 0
+ *
+ * @param[in]    context   hio context
+ * @param[inout] manifest  local manifest. holds the reduced manifest on rank 0
+ * @param[in]    comm      communicator to reduce over
+ * @param[in]    rc        result of generating the local manifest
+ *
+ * @returns the same hio error code on every rank. HIO_SUCCESS if every rank succeeded
+ *
+ * Collective over comm. Every rank must call this function even if it failed to
+ * generate its local manifest (in which case *manifest may be NULL).
+ */
+int hioi_manifest_gather_comm (hio_context_t context, hio_manifest_t *manifest, MPI_Comm comm, int rc);
 int hioi_manifest_scatter_comm (hio_manifest_t manifest, MPI_Comm comm, int rc);
 #endif /* HIO_MPI_HAVE(1) */
 
 /* manifest internal functions */
 
+/**
+ * @brief Get the json representation of a manifest
+ *
+ * @param[in] manifest  hio manifest object
+ *
+ * If the manifest is backed by a binary image the image is converted to json and
+ * released. Returns NULL if the conversion fails.
+ */
+json_object *hioi_manifest_get_json (hio_manifest_t manifest);
+
+/**
+ * @brief Replace the contents of a manifest with a binary image
+ *
+ * @param[in] manifest   hio manifest object
+ * @param[in] data       binary manifest image (ownership is transferred to the manifest)
+ * @param[in] data_size  size of the image
+ */
+void hioi_manifest_set_binary (hio_manifest_t manifest, unsigned char *data, size_t data_size);
+
+/**
+ * @brief Convert a json manifest to a binary image in place
+ *
+ * @param[in] manifest   hio manifest object
+ *
+ * Binary manifests can have their elements loaded lazily (see hioi_manifest_load_binary).
+ * Manifests that are already binary or that use a json layout older than 3.0 are left
+ * as-is.
+ */
+int hioi_manifest_convert_binary (hio_manifest_t manifest);
+
+/**
+ * @brief Create a manifest from a binary image
+ *
+ * @param[in]  context      associated hio context
+ * @param[in]  data         binary manifest image (ownership is transferred to the manifest)
+ * @param[in]  data_size    size of the image
+ * @param[out] manifest_out new manifest object
+ */
+int hioi_manifest_create_binary (hio_context_t context, unsigned char *data, size_t data_size,
+                                 hio_manifest_t *manifest_out);
+
+/**
+ * @brief Get a binary image of a manifest
+ *
+ * @param[in]  manifest   hio manifest object
+ * @param[out] data       binary manifest image (allocated)
+ * @param[out] data_size  size of the image
+ *
+ * If the manifest is backed by an allocated binary image ownership of the image is
+ * transferred to the caller. Otherwise a new image is generated.
+ */
+int hioi_manifest_take_binary (hio_manifest_t manifest, unsigned char **data, size_t *data_size);
+
+/* binary manifest functions (hio_manifest_binary.c) */
+bool hioi_manifest_data_is_binary (const unsigned char *data, size_t data_size);
+
+/**
+ * @brief Convert a json manifest to a binary image
+ *
+ * @param[in]  object     json manifest (as read from a json manifest file)
+ * @param[out] data       binary manifest image (allocated)
+ * @param[out] data_size  size of the image
+ *
+ * Only used for manifests that were read in json format. Manifests for datasets
+ * being written are built with hioi_manifest_generate_binary_image() or written
+ * with hioi_manifest_binary_write_dataset() which never build a json object tree.
+ */
+int hioi_manifest_serialize_binary (json_object *object, unsigned char **data, size_t *data_size);
+
+int hioi_manifest_binary_to_json (const unsigned char *data, size_t data_size, json_object **object_out);
+int hioi_manifest_binary_write_json (const unsigned char *data, size_t data_size, hio_manifest_encoder_t *encoder);
+int hioi_manifest_binary_write_dataset (hio_dataset_t dataset, int format, hio_manifest_encoder_t *encoder);
+int hioi_manifest_read_header_binary (hio_context_t context, hio_dataset_header_t *header,
+                                      const unsigned char *data, size_t data_size);
+int hioi_manifest_load_binary (hio_dataset_t dataset, hio_manifest_t manifest);
+int hioi_manifest_generate_binary_image (hio_dataset_t dataset, bool simple, unsigned char **data, size_t *data_size);
+
+/**
+ * @brief Merge binary manifest images
+ *
+ * @param[in]  images      binary manifest images to merge
+ * @param[in]  image_sizes size of each image
+ * @param[in]  count       number of images
+ * @param[out] data        new merged image (allocated)
+ * @param[out] data_size   size of the merged image
+ *
+ * Elements with matching identifiers in shared datasets are combined by k-way merging
+ * their (sorted) segment runs. The header and variables of the first image are kept.
+ */
+int hioi_manifest_binary_merge (const unsigned char **images, const size_t *image_sizes, int count,
+                                unsigned char **data, size_t *data_size);
+
+/* codec functions (hio_manifest_codec.c) */
+
+/**
+ * @brief File name suffix for data compressed with a codec
+ */
+const char *hioi_manifest_codec_suffix (int codec);
+
+/**
+ * @brief Determine which codec was used to compress a payload
+ *
+ * @returns HIO_MANIFEST_CODEC_NONE if the payload is not compressed
+ */
+int hioi_manifest_codec_detect (const unsigned char *data, size_t data_size);
+
+/**
+ * @brief Compress data with the specified codec
+ *
+ * @param[in]  codec     codec to use (must not be HIO_MANIFEST_CODEC_NONE)
+ * @param[in]  data      data to compress
+ * @param[in]  data_size size of data
+ * @param[out] out       compressed data (allocated)
+ * @param[out] out_size  size of the compressed data
+ * @param[in,out] stats  codec statistics to update (may be NULL)
+ */
+int hioi_manifest_compress (int codec, const unsigned char *data, size_t data_size, unsigned char **out,
+                            size_t *out_size, hio_manifest_codec_stats_t *stats);
+
+/**
+ * @brief Decompress data. The codec is detected from the payload.
+ *
+ * @param[in]  data      compressed data
+ * @param[in]  data_size size of the compressed data
+ * @param[out] out       uncompressed data (allocated)
+ * @param[out] out_size  size of the uncompressed data
+ * @param[in,out] stats  codec statistics to update (may be NULL)
+ */
+int hioi_manifest_decompress (const unsigned char *data, size_t data_size, unsigned char **out, size_t *out_size,
+                              hio_manifest_codec_stats_t *stats);
+
+/**
+ * @brief Start writing an encoded manifest to a file
+ *
+ * @param[in]  codec     codec to use (see hio_manifest_codec_t)
+ * @param[in]  fd        file descriptor to write to (must be seekable)
+ * @param[in,out] stats  codec statistics to update (may be NULL)
+ * @param[out] encoder   new encoder
+ *
+ * Data passed to hioi_manifest_encoder_write() is staged in a fixed size buffer and
+ * encoded one chunk at a time so memory use does not depend on the size of the
+ * manifest. Compressed output can be read back with hioi_manifest_decompress().
+ */
+int hioi_manifest_encoder_open (int codec, int fd, hio_manifest_codec_stats_t *stats,
+                                hio_manifest_encoder_t **encoder);
+
+/**
+ * @brief Append data to an encoded manifest
+ *
+ * @param[in]  encoder   manifest encoder
+ * @param[in]  data      data to write
+ * @param[in]  data_size size of data
+ */
+int hioi_manifest_encoder_write (hio_manifest_encoder_t *encoder, const void *data, size_t data_size);
+
+/**
+ * @brief Flush remaining data and release an encoder
+ *
+ * @param[in]  encoder   manifest encoder
+ *
+ * @returns the first error encountered by the encoder or HIO_SUCCESS
+ */
+int hioi_manifest_encoder_close (hio_manifest_encoder_t *encoder);
+
+/* lz codec (hio_manifest_lz.c) */
+size_t hioi_lz_compress_bound (size_t size);
+int hioi_lz_compress (const unsigned char *src, size_t src_size, unsigned char *dst, size_t *dst_size);
+int hioi_lz_decompress (const unsigned char *src, size_t src_size, unsigned char *dst, size_t dst_size);
+
 int hioi_manifest_get_string (const json_object *parent, const char *name, const char **string);
 int hioi_manifest_get_number (const json_object *parent, const char *name, unsigned long *value);
 int hioi_manifest_get_signed_number (const json_object *parent, const char *name, long *value);
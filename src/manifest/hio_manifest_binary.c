@@ -0,0 +1,1950 @@
+/* -*- Mode: C; c-basic-offset:2 ; indent-tabs-mode:nil -*- */
+/*
+ * Copyright (c) 2017      Los Alamos National Security, LLC.  All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/**
+ * @file hio_manifest_binary.c
+ * @brief Binary manifest format
+ *
+ * The binary manifest is a flat image that can be used in place (for example
+ * directly from a mmap'd file) without a parse step. The image consists of a
+ * fixed header followed by four 8-byte aligned tables:
+ *
+ *  - variable table: configuration and performance variables (name/value string
+ *    table references)
+ *  - element table: one fixed-width record per element. each record references
+ *    a contiguous run of the segment table
+ *  - segment table: fixed-width segment records sorted by application offset
+ *    within each element
+ *  - string table: NULL-terminated strings referenced by offset
+ *
+ * All values are stored in the byte order of the writer. Readers reject images
+ * with a foreign byte order.
+ */
+
+#include "hio_manifest.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <assert.h>
+
+#define HIO_MANIFEST_BINARY_MAGIC      "HIOMANIF"
+#define HIO_MANIFEST_BINARY_BYTE_ORDER 0x01020304
+#define HIO_MANIFEST_BINARY_VERSION    1
+#define HIO_MANIFEST_BINARY_COMPAT     1
+
+/** string table offset used for strings that are not present */
+#define HIO_MANIFEST_BINARY_NO_STRING  UINT64_MAX
+
+enum {
+  /** the manifest describes a dataset (the dataset fields in the header are valid) */
+  HIO_MANIFEST_BINARY_FLAG_DATASET = 1,
+};
+
+enum {
+  /** every segment of the element carries a data checksum (mbs_checksum is valid) */
+  HIO_MANIFEST_BINARY_ELEMENT_CHECKSUM = 1,
+};
+
+enum {
+  HIO_MANIFEST_BINARY_VAR_CONFIG = 0,
+  HIO_MANIFEST_BINARY_VAR_PERF   = 1,
+};
+
+typedef struct hio_manifest_binary_header_t {
+  /** magic string (not NULL-terminated) */
+  char     mbh_magic[8];
+  /** byte order marker (HIO_MANIFEST_BINARY_BYTE_ORDER in the writer's byte order) */
+  uint32_t mbh_byte_order;
+  /** binary format version */
+  uint16_t mbh_version;
+  /** oldest binary format version that can read this image */
+  uint16_t mbh_compat;
+  /** size of this header */
+  uint32_t mbh_header_size;
+  /** header flags */
+  uint32_t mbh_flags;
+  /** dataset identifier */
+  int64_t  mbh_dataset_id;
+  /** dataset modification time */
+  uint64_t mbh_mtime;
+  /** dataset mode (unique or shared) */
+  int32_t  mbh_dataset_mode;
+  /** dataset status */
+  int32_t  mbh_status;
+  /** number of ranks that wrote the dataset */
+  uint64_t mbh_comm_size;
+  /** string table offset of the dataset name */
+  uint64_t mbh_identifier;
+  /** string table offset of the libhio version that wrote the manifest */
+  uint64_t mbh_hio_version;
+  /** offset and number of records of the variable table */
+  uint64_t mbh_var_offset;
+  uint64_t mbh_var_count;
+  /** offset and number of records of the element table */
+  uint64_t mbh_element_offset;
+  uint64_t mbh_element_count;
+  /** offset and number of records of the segment table */
+  uint64_t mbh_segment_offset;
+  uint64_t mbh_segment_count;
+  /** offset and size of the string table */
+  uint64_t mbh_string_offset;
+  uint64_t mbh_string_size;
+  /** total size of the image */
+  uint64_t mbh_size;
+} hio_manifest_binary_header_t;
+
+typedef struct hio_manifest_binary_var_t {
+  /** string table offset of the variable name */
+  uint64_t mbv_name;
+  /** string table offset of the variable value */
+  uint64_t mbv_value;
+  /** variable kind (config or perf) */
+  uint32_t mbv_kind;
+  uint32_t mbv_resv0;
+} hio_manifest_binary_var_t;
+
+typedef struct hio_manifest_binary_element_t {
+  /** string table offset of the element name */
+  uint64_t mbe_identifier;
+  /** element size */
+  uint64_t mbe_size;
+  /** rank that wrote the element (-1 for shared elements) */
+  int32_t  mbe_rank;
+  /** element flags */
+  uint32_t mbe_flags;
+  /** index of the first segment belonging to this element */
+  uint64_t mbe_segment_start;
+  /** number of segments belonging to this element */
+  uint64_t mbe_segment_count;
+} hio_manifest_binary_element_t;
+
+typedef struct hio_manifest_binary_segment_t {
+  /** application offset */
+  uint64_t mbs_app_offset;
+  /** offset of the segment in the file */
+  uint64_t mbs_file_offset;
+  /** length of the segment */
+  uint64_t mbs_length;
+  /** index of the file holding the segment */
+  int32_t  mbs_file_index;
+  /** crc32c of the segment data (only valid if the element has HIO_MANIFEST_BINARY_ELEMENT_CHECKSUM) */
+  uint32_t mbs_checksum;
+} hio_manifest_binary_segment_t;
+
+#define HIO_MANIFEST_BINARY_ALIGN(x) (((x) + 7) & ~((uint64_t) 7))
+
+bool hioi_manifest_data_is_binary (const unsigned char *data, size_t data_size) {
+  return data_size >= sizeof (hio_manifest_binary_header_t) &&
+    0 == memcmp (data, HIO_MANIFEST_BINARY_MAGIC, 8);
+}
+
+/**
+ * @brief Verify a binary manifest image
+ *
+ * Checks the header and makes sure all the tables are contained in the image. This
+ * is the only validation done on the image. Element and segment records are used
+ * as-is after this check succeeds.
+ */
+static const hio_manifest_binary_header_t *hioi_manifest_binary_header (const unsigned char *data, size_t data_size) {
+  const hio_manifest_binary_header_t *header = (const hio_manifest_binary_header_t *) data;
+
+  if (!hioi_manifest_data_is_binary (data, data_size) || HIO_MANIFEST_BINARY_BYTE_ORDER != header->mbh_byte_order ||
+      header->mbh_compat > HIO_MANIFEST_BINARY_VERSION || header->mbh_header_size < sizeof (*header) ||
+      header->mbh_size > data_size) {
+    return NULL;
+  }
+
+  if (header->mbh_var_offset + header->mbh_var_count * sizeof (hio_manifest_binary_var_t) > header->mbh_size ||
+      header->mbh_element_offset + header->mbh_element_count * sizeof (hio_manifest_binary_element_t) > header->mbh_size ||
+      header->mbh_segment_offset + header->mbh_segment_count * sizeof (hio_manifest_binary_segment_t) > header->mbh_size ||
+      header->mbh_string_offset + header->mbh_string_size > header->mbh_size ||
+      (header->mbh_string_size && '\0' != data[header->mbh_string_offset + header->mbh_string_size - 1])) {
+    return NULL;
+  }
+
+  return header;
+}
+
+static const char *hioi_manifest_binary_string (const unsigned char *data, const hio_manifest_binary_header_t *header,
+                                                uint64_t offset) {
+  if (HIO_MANIFEST_BINARY_NO_STRING == offset || offset >= header->mbh_string_size) {
+    return NULL;
+  }
+
+  return (const char *) (data + header->mbh_string_offset + offset);
+}
+
+#define HIO_MANIFEST_BINARY_TABLE(data, header, type, name) \
+  ((const type *) ((data) + (header)->mbh_ ## name ## _offset))
+
+/* string table under construction */
+typedef struct hio_manifest_binary_strings_t {
+  char    *base;
+  uint64_t size;
+} hio_manifest_binary_strings_t;
+
+static uint64_t hioi_manifest_binary_add_string (hio_manifest_binary_strings_t *strings, const char *value) {
+  uint64_t offset = strings->size;
+  size_t length;
+
+  if (NULL == value) {
+    return HIO_MANIFEST_BINARY_NO_STRING;
+  }
+
+  length = strlen (value) + 1;
+  memcpy (strings->base + offset, value, length);
+  strings->size += length;
+
+  return offset;
+}
+
+/**
+ * @brief Allocate a binary manifest image
+ *
+ * @param[in]  var_count     number of variable records
+ * @param[in]  element_count number of element records
+ * @param[in]  segment_count number of segment records
+ * @param[in]  string_size   total size of all strings (including terminators)
+ * @param[out] strings       empty string table for the new image
+ *
+ * Allocates a zeroed image and fills in the header fields that only depend on
+ * the table sizes. The caller is responsible for filling in the tables and the
+ * remaining header fields.
+ */
+static hio_manifest_binary_header_t *hioi_manifest_binary_image_alloc (uint64_t var_count, uint64_t element_count,
+                                                                       uint64_t segment_count, uint64_t string_size,
+                                                                       hio_manifest_binary_strings_t *strings) {
+  hio_manifest_binary_header_t *header;
+  uint64_t offset;
+
+  offset = HIO_MANIFEST_BINARY_ALIGN(sizeof (*header));
+  offset += var_count * sizeof (hio_manifest_binary_var_t) + element_count * sizeof (hio_manifest_binary_element_t) +
+    segment_count * sizeof (hio_manifest_binary_segment_t);
+  offset += HIO_MANIFEST_BINARY_ALIGN(string_size);
+
+  header = calloc (1, offset);
+  if (NULL == header) {
+    return NULL;
+  }
+
+  memcpy (header->mbh_magic, HIO_MANIFEST_BINARY_MAGIC, 8);
+  header->mbh_byte_order = HIO_MANIFEST_BINARY_BYTE_ORDER;
+  header->mbh_version = HIO_MANIFEST_BINARY_VERSION;
+  header->mbh_compat = HIO_MANIFEST_BINARY_COMPAT;
+  header->mbh_header_size = sizeof (*header);
+  header->mbh_size = offset;
+
+  header->mbh_var_offset = HIO_MANIFEST_BINARY_ALIGN(sizeof (*header));
+  header->mbh_var_count = var_count;
+  header->mbh_element_offset = header->mbh_var_offset + var_count * sizeof (hio_manifest_binary_var_t);
+  header->mbh_element_count = element_count;
+  header->mbh_segment_offset = header->mbh_element_offset + element_count * sizeof (hio_manifest_binary_element_t);
+  header->mbh_segment_count = segment_count;
+  header->mbh_string_offset = header->mbh_segment_offset + segment_count * sizeof (hio_manifest_binary_segment_t);
+
+  strings->base = (char *) header + header->mbh_string_offset;
+  strings->size = 0;
+
+  return header;
+}
+
+static uint64_t hioi_manifest_binary_json_number (json_object *object, const char *key, uint64_t default_value) {
+  unsigned long value;
+
+  if (HIO_SUCCESS != hioi_manifest_get_number (object, key, &value)) {
+    return default_value;
+  }
+
+  return (uint64_t) value;
+}
+
+static size_t hioi_manifest_binary_json_strlen (json_object *object, const char *key) {
+  const char *value;
+
+  if (HIO_SUCCESS != hioi_manifest_get_string (object, key, &value)) {
+    return 0;
+  }
+
+  return strlen (value) + 1;
+}
+
+int hioi_manifest_serialize_binary (json_object *object, unsigned char **data, size_t *data_size) {
+  uint64_t var_count = 0, element_count = 0, segment_count = 0, string_size = 0;
+  hio_manifest_binary_strings_t strings = {.base = NULL, .size = 0};
+  hio_manifest_binary_header_t *header;
+  hio_manifest_binary_element_t *elements;
+  hio_manifest_binary_segment_t *segments;
+  hio_manifest_binary_var_t *vars;
+  json_object *elements_object, *vars_object;
+  const char *var_keys[2] = {HIO_MANIFEST_KEY_CONFIG, HIO_MANIFEST_KEY_PERF};
+  const char *tmp_string;
+  unsigned char *image;
+  long status = 0;
+
+  /* first pass: determine the size of each table */
+  string_size += hioi_manifest_binary_json_strlen (object, HIO_MANIFEST_KEY_IDENTIFIER);
+  string_size += hioi_manifest_binary_json_strlen (object, HIO_MANIFEST_KEY_HIO_VERSION);
+
+  for (int i = 0 ; i < 2 ; ++i) {
+    if (json_object_object_get_ex (object, var_keys[i], &vars_object)) {
+      json_object_object_foreach (vars_object, key, value) {
+        string_size += strlen (key) + strlen (json_object_get_string (value)) + 2;
+        ++var_count;
+      }
+    }
+  }
+
+  if (!json_object_object_get_ex (object, HIO_MANIFEST_KEY_ELEMENTS, &elements_object)) {
+    elements_object = NULL;
+  }
+
+  if (elements_object) {
+    element_count = json_object_array_length (elements_object);
+    for (uint64_t i = 0 ; i < element_count ; ++i) {
+      json_object *element_object = json_object_array_get_idx (elements_object, i), *segments_object;
+
+      string_size += hioi_manifest_binary_json_strlen (element_object, HIO_MANIFEST_KEY_IDENTIFIER);
+      if (json_object_object_get_ex (element_object, HIO_MANIFEST_KEY_SEGMENTS, &segments_object)) {
+        segment_count += json_object_array_length (segments_object);
+      }
+    }
+  }
+
+  header = hioi_manifest_binary_image_alloc (var_count, element_count, segment_count, string_size, &strings);
+  if (NULL == header) {
+    return HIO_ERR_OUT_OF_RESOURCE;
+  }
+
+  image = (unsigned char *) header;
+  vars = (hio_manifest_binary_var_t *) (image + header->mbh_var_offset);
+  elements = (hio_manifest_binary_element_t *) (image + header->mbh_element_offset);
+  segments = (hio_manifest_binary_segment_t *) (image + header->mbh_segment_offset);
+
+  /* second pass: fill in the tables */
+  if (HIO_SUCCESS == hioi_manifest_get_string (object, HIO_MANIFEST_KEY_IDENTIFIER, &tmp_string)) {
+    header->mbh_flags |= HIO_MANIFEST_BINARY_FLAG_DATASET;
+    header->mbh_identifier = hioi_manifest_binary_add_string (&strings, tmp_string);
+  } else {
+    header->mbh_identifier = HIO_MANIFEST_BINARY_NO_STRING;
+  }
+
+  if (HIO_SUCCESS == hioi_manifest_get_string (object, HIO_MANIFEST_KEY_HIO_VERSION, &tmp_string)) {
+    header->mbh_hio_version = hioi_manifest_binary_add_string (&strings, tmp_string);
+  } else {
+    header->mbh_hio_version = HIO_MANIFEST_BINARY_NO_STRING;
+  }
+
+  header->mbh_dataset_mode = HIO_SET_ELEMENT_SHARED;
+  if (HIO_SUCCESS == hioi_manifest_get_string (object, HIO_MANIFEST_KEY_DATASET_MODE, &tmp_string) &&
+      0 == strcmp (tmp_string, "unique")) {
+    header->mbh_dataset_mode = HIO_SET_ELEMENT_UNIQUE;
+  }
+
+  (void) hioi_manifest_get_signed_number (object, HIO_MANIFEST_KEY_STATUS, &status);
+  header->mbh_status = (int32_t) status;
+  header->mbh_dataset_id = (int64_t) hioi_manifest_binary_json_number (object, HIO_MANIFEST_KEY_DATASET_ID, 0);
+  header->mbh_mtime = hioi_manifest_binary_json_number (object, HIO_MANIFEST_KEY_MTIME, 0);
+  header->mbh_comm_size = hioi_manifest_binary_json_number (object, HIO_MANIFEST_KEY_COMM_SIZE, 0);
+
+  for (int i = 0 ; i < 2 ; ++i) {
+    if (json_object_object_get_ex (object, var_keys[i], &vars_object)) {
+      json_object_object_foreach (vars_object, key, value) {
+        vars->mbv_name = hioi_manifest_binary_add_string (&strings, key);
+        vars->mbv_value = hioi_manifest_binary_add_string (&strings, json_object_get_string (value));
+        vars->mbv_kind = i ? HIO_MANIFEST_BINARY_VAR_PERF : HIO_MANIFEST_BINARY_VAR_CONFIG;
+        ++vars;
+      }
+    }
+  }
+
+  segment_count = 0;
+  for (uint64_t i = 0 ; i < element_count ; ++i) {
+    json_object *element_object = json_object_array_get_idx (elements_object, i), *segments_object;
+    long rank = -1;
+
+    if (HIO_SUCCESS == hioi_manifest_get_string (element_object, HIO_MANIFEST_KEY_IDENTIFIER, &tmp_string)) {
+      elements[i].mbe_identifier = hioi_manifest_binary_add_string (&strings, tmp_string);
+    } else {
+      elements[i].mbe_identifier = HIO_MANIFEST_BINARY_NO_STRING;
+    }
+
+    (void) hioi_manifest_get_signed_number (element_object, HIO_MANIFEST_KEY_RANK, &rank);
+    elements[i].mbe_rank = (int32_t) rank;
+    elements[i].mbe_size = hioi_manifest_binary_json_number (element_object, HIO_MANIFEST_KEY_SIZE, 0);
+    elements[i].mbe_segment_start = segment_count;
+
+    if (json_object_object_get_ex (element_object, HIO_MANIFEST_KEY_SEGMENTS, &segments_object)) {
+      int element_segments = json_object_array_length (segments_object);
+      unsigned long checksum;
+
+      elements[i].mbe_flags = element_segments ? HIO_MANIFEST_BINARY_ELEMENT_CHECKSUM : 0;
+
+      for (int j = 0 ; j < element_segments ; ++j, ++segment_count) {
+        json_object *segment_object = json_object_array_get_idx (segments_object, j);
+        hio_manifest_binary_segment_t *segment = segments + segment_count;
+
+        if (HIO_SUCCESS == hioi_manifest_get_number (segment_object, HIO_SEGMENT_KEY_CHECKSUM, &checksum)) {
+          segment->mbs_checksum = (uint32_t) checksum;
+        } else {
+          elements[i].mbe_flags &= ~HIO_MANIFEST_BINARY_ELEMENT_CHECKSUM;
+        }
+
+        segment->mbs_app_offset = hioi_manifest_binary_json_number (segment_object, HIO_SEGMENT_KEY_APP_OFFSET0, 0);
+        segment->mbs_file_offset = hioi_manifest_binary_json_number (segment_object, HIO_SEGMENT_KEY_FILE_OFFSET, 0);
+        segment->mbs_length = hioi_manifest_binary_json_number (segment_object, HIO_SEGMENT_KEY_LENGTH, 0);
+        segment->mbs_file_index = (int32_t) hioi_manifest_binary_json_number (segment_object, HIO_SEGMENT_KEY_FILE_INDEX, 0);
+      }
+
+      elements[i].mbe_segment_count = element_segments;
+    }
+  }
+
+  assert (strings.size == string_size);
+  header->mbh_string_size = strings.size;
+
+  *data = image;
+  *data_size = header->mbh_size;
+
+  return HIO_SUCCESS;
+}
+
+/**
+ * @brief Format the value of an hio variable for the string table
+ *
+ * @param[in] var     variable to format
+ * @param[in] buffer  scratch buffer for numeric values
+ * @param[in] size    size of buffer
+ *
+ * @returns the formatted value (either buffer or the string value of the variable)
+ */
+static const char *hioi_manifest_binary_var_value (const hio_var_t *var, char *buffer, size_t size) {
+  switch (var->var_type) {
+  case HIO_CONFIG_TYPE_BOOL:
+    return var->var_storage->boolval ? "true" : "false";
+  case HIO_CONFIG_TYPE_STRING:
+    return var->var_storage->strval ? var->var_storage->strval : "";
+  case HIO_CONFIG_TYPE_INT32:
+    snprintf (buffer, size, "%i", var->var_storage->int32val);
+    break;
+  case HIO_CONFIG_TYPE_UINT32:
+    snprintf (buffer, size, "%u", var->var_storage->uint32val);
+    break;
+  case HIO_CONFIG_TYPE_INT64:
+    snprintf (buffer, size, "%" PRId64, var->var_storage->int64val);
+    break;
+  case HIO_CONFIG_TYPE_UINT64:
+    snprintf (buffer, size, "%" PRIu64, var->var_storage->uint64val);
+    break;
+  case HIO_CONFIG_TYPE_FLOAT:
+    snprintf (buffer, size, "%f", var->var_storage->floatval);
+    break;
+  case HIO_CONFIG_TYPE_DOUBLE:
+    snprintf (buffer, size, "%lf", var->var_storage->doubleval);
+    break;
+  default:
+    buffer[0] = '\0';
+  }
+
+  return buffer;
+}
+
+int hioi_manifest_generate_binary_image (hio_dataset_t dataset, bool simple, unsigned char **data, size_t *data_size) {
+  hio_context_t context = hioi_object_context (&dataset->ds_object);
+  hio_var_array_t *var_arrays[2] = {&dataset->ds_object.configuration, &dataset->ds_object.performance};
+  uint64_t var_count = 0, element_count = 0, segment_count = 0, string_size = 0;
+  hio_manifest_binary_strings_t strings;
+  hio_manifest_binary_header_t *header;
+  hio_manifest_binary_element_t *elements;
+  hio_manifest_binary_segment_t *segments;
+  hio_manifest_binary_var_t *vars;
+  hio_element_t element;
+  char buffer[64];
+
+  /* first pass: determine the size of each table */
+  string_size += strlen (hioi_object_identifier (dataset)) + strlen (PACKAGE_VERSION) + 2;
+
+  for (int i = 0 ; i < 2 ; ++i) {
+    for (int j = 0 ; j < var_arrays[i]->var_count ; ++j) {
+      hio_var_t *var = var_arrays[i]->vars + j;
+      string_size += strlen (var->var_name) + strlen (hioi_manifest_binary_var_value (var, buffer, sizeof (buffer))) + 2;
+    }
+
+    var_count += var_arrays[i]->var_count;
+  }
+
+  if (!simple) {
+    hioi_list_foreach(element, dataset->ds_elist, struct hio_element, e_list) {
+      string_size += strlen (hioi_object_identifier (element)) + 1;
+      segment_count += element->e_scount;
+      ++element_count;
+    }
+  }
+
+  header = hioi_manifest_binary_image_alloc (var_count, element_count, segment_count, string_size, &strings);
+  if (NULL == header) {
+    return HIO_ERR_OUT_OF_RESOURCE;
+  }
+
+  vars = (hio_manifest_binary_var_t *) ((unsigned char *) header + header->mbh_var_offset);
+  elements = (hio_manifest_binary_element_t *) ((unsigned char *) header + header->mbh_element_offset);
+  segments = (hio_manifest_binary_segment_t *) ((unsigned char *) header + header->mbh_segment_offset);
+
+  /* second pass: fill in the tables */
+  header->mbh_flags = HIO_MANIFEST_BINARY_FLAG_DATASET;
+  header->mbh_identifier = hioi_manifest_binary_add_string (&strings, hioi_object_identifier (dataset));
+  header->mbh_hio_version = hioi_manifest_binary_add_string (&strings, PACKAGE_VERSION);
+  header->mbh_dataset_id = dataset->ds_id;
+  header->mbh_dataset_mode = dataset->ds_mode;
+  header->mbh_status = dataset->ds_status;
+  header->mbh_comm_size = context->c_size;
+  header->mbh_mtime = (uint64_t) time (NULL);
+
+  for (int i = 0 ; i < 2 ; ++i) {
+    for (int j = 0 ; j < var_arrays[i]->var_count ; ++j, ++vars) {
+      hio_var_t *var = var_arrays[i]->vars + j;
+
+      vars->mbv_name = hioi_manifest_binary_add_string (&strings, var->var_name);
+      vars->mbv_value = hioi_manifest_binary_add_string (&strings, hioi_manifest_binary_var_value (var, buffer,
+                                                                                                 sizeof (buffer)));
+      vars->mbv_kind = i ? HIO_MANIFEST_BINARY_VAR_PERF : HIO_MANIFEST_BINARY_VAR_CONFIG;
+    }
+  }
+
+  if (!simple) {
+    segment_count = 0;
+    hioi_list_foreach(element, dataset->ds_elist, struct hio_element, e_list) {
+      elements->mbe_identifier = hioi_manifest_binary_add_string (&strings, hioi_object_identifier (element));
+      elements->mbe_size = element->e_size;
+      elements->mbe_rank = (HIO_SET_ELEMENT_UNIQUE == dataset->ds_mode) ? element->e_rank : -1;
+      elements->mbe_segment_start = segment_count;
+      elements->mbe_segment_count = element->e_scount;
+      elements->mbe_flags = element->e_scount ? HIO_MANIFEST_BINARY_ELEMENT_CHECKSUM : 0;
+
+      for (size_t i = 0 ; i < element->e_scount ; ++i, ++segment_count) {
+        hio_manifest_segment_t *segment = element->e_sarray + i;
+
+        segments[segment_count].mbs_app_offset = segment->seg_offset;
+        segments[segment_count].mbs_file_offset = segment->seg_foffset;
+        segments[segment_count].mbs_length = segment->seg_length;
+        segments[segment_count].mbs_file_index = segment->seg_file_index;
+        segments[segment_count].mbs_checksum = segment->seg_checksum;
+        if (segment->seg_cksum_length != segment->seg_length) {
+          elements->mbe_flags &= ~HIO_MANIFEST_BINARY_ELEMENT_CHECKSUM;
+        }
+      }
+
+      ++elements;
+    }
+  }
+
+  assert (strings.size == string_size);
+  header->mbh_string_size = strings.size;
+
+  *data = (unsigned char *) header;
+  *data_size = header->mbh_size;
+
+  return HIO_SUCCESS;
+}
+
+static int hioi_manifest_binary_segment_compare (const void *arg1, const void *arg2) {
+  const hio_manifest_binary_segment_t *segment1 = (const hio_manifest_binary_segment_t *) arg1;
+  const hio_manifest_binary_segment_t *segment2 = (const hio_manifest_binary_segment_t *) arg2;
+
+  if (segment1->mbs_app_offset > segment2->mbs_app_offset) {
+    return 1;
+  }
+
+  return (segment1->mbs_app_offset < segment2->mbs_app_offset) ? -1 : 0;
+}
+
+/* element of a merged binary manifest */
+typedef struct hio_manifest_binary_merge_element_t {
+  /** identifier (points into one of the input images) */
+  const char *identifier;
+  /** matching element record in each input image (NULL if not present) */
+  const hio_manifest_binary_element_t **inputs;
+} hio_manifest_binary_merge_element_t;
+
+/* reference to an element record of one of the input images */
+typedef struct hio_manifest_binary_merge_ref_t {
+  /** identifier (points into the input image) */
+  const char *identifier;
+  /** input image index */
+  int image;
+  /** element record */
+  const hio_manifest_binary_element_t *element;
+} hio_manifest_binary_merge_ref_t;
+
+static int hioi_manifest_binary_merge_ref_compare (const void *arg1, const void *arg2) {
+  const hio_manifest_binary_merge_ref_t *ref1 = (const hio_manifest_binary_merge_ref_t *) arg1;
+  const hio_manifest_binary_merge_ref_t *ref2 = (const hio_manifest_binary_merge_ref_t *) arg2;
+  int ret = strcmp (ref1->identifier, ref2->identifier);
+
+  if (0 != ret) {
+    return ret;
+  }
+
+  if (ref1->image != ref2->image) {
+    return (ref1->image < ref2->image) ? -1 : 1;
+  }
+
+  return (ref1->element < ref2->element) ? -1 : (ref1->element > ref2->element);
+}
+
+/**
+ * @brief Merge the segment runs of an element
+ *
+ * Each input run is sorted by application offset so the output run is produced with
+ * a k-way merge. If any input run was not sorted the output is sorted after the merge.
+ */
+static void hioi_manifest_binary_merge_segments (const unsigned char **images, const hio_manifest_binary_header_t **headers,
+                                                 int count, const hio_manifest_binary_element_t **inputs,
+                                                 uint64_t *cursors, hio_manifest_binary_segment_t *out,
+                                                 uint64_t out_count) {
+  for (int i = 0 ; i < count ; ++i) {
+    cursors[i] = 0;
+  }
+
+  for (uint64_t j = 0 ; j < out_count ; ++j) {
+    const hio_manifest_binary_segment_t *next = NULL;
+    int next_input = -1;
+
+    for (int i = 0 ; i < count ; ++i) {
+      const hio_manifest_binary_segment_t *segment;
+
+      if (NULL == inputs[i] || cursors[i] == inputs[i]->mbe_segment_count) {
+        continue;
+      }
+
+      segment = HIO_MANIFEST_BINARY_TABLE(images[i], headers[i], hio_manifest_binary_segment_t, segment) +
+        inputs[i]->mbe_segment_start + cursors[i];
+      if (NULL == next || segment->mbs_app_offset < next->mbs_app_offset) {
+        next = segment;
+        next_input = i;
+      }
+    }
+
+    out[j] = *next;
+    ++cursors[next_input];
+
+    if (j && out[j].mbs_app_offset < out[j-1].mbs_app_offset) {
+      /* an input run was not sorted. finish the copy and sort the output */
+      for (++j ; j < out_count ; ++j) {
+        for (int i = 0 ; i < count ; ++i) {
+          if (NULL != inputs[i] && cursors[i] < inputs[i]->mbe_segment_count) {
+            out[j] = HIO_MANIFEST_BINARY_TABLE(images[i], headers[i], hio_manifest_binary_segment_t, segment)
+              [inputs[i]->mbe_segment_start + cursors[i]++];
+            break;
+          }
+        }
+      }
+
+      qsort (out, out_count, sizeof (*out), hioi_manifest_binary_segment_compare);
+      return;
+    }
+  }
+}
+
+int hioi_manifest_binary_merge (const unsigned char **images, const size_t *image_sizes, int count,
+                                unsigned char **data, size_t *data_size) {
+  const hio_manifest_binary_header_t **headers, *header0;
+  uint64_t element_count = 0, segment_count = 0, string_size = 0, max_elements = 0, ref_count = 0, *cursors;
+  hio_manifest_binary_merge_element_t *merged = NULL;
+  const hio_manifest_binary_element_t **inputs = NULL;
+  hio_manifest_binary_merge_ref_t *refs = NULL;
+  hio_manifest_binary_element_t *out_elements;
+  hio_manifest_binary_segment_t *out_segments;
+  hio_manifest_binary_var_t *out_vars;
+  hio_manifest_binary_strings_t strings;
+  hio_manifest_binary_header_t *header;
+  const hio_manifest_binary_var_t *vars;
+  const char *identifier0, *version0;
+  int rc = HIO_SUCCESS;
+
+  if (count < 1) {
+    return HIO_ERR_BAD_PARAM;
+  }
+
+  headers = calloc (count, sizeof (headers[0]) + sizeof (cursors[0]));
+  if (NULL == headers) {
+    return HIO_ERR_OUT_OF_RESOURCE;
+  }
+
+  cursors = (uint64_t *) (headers + count);
+
+  /* sanity check. make sure the manifest meta-data matches */
+  for (int i = 0 ; i < count ; ++i) {
+    headers[i] = hioi_manifest_binary_header (images[i], image_sizes[i]);
+    if (NULL == headers[i] || (headers[i]->mbh_flags & HIO_MANIFEST_BINARY_FLAG_DATASET) !=
+        (headers[0]->mbh_flags & HIO_MANIFEST_BINARY_FLAG_DATASET) ||
+        headers[i]->mbh_dataset_mode != headers[0]->mbh_dataset_mode ||
+        headers[i]->mbh_dataset_id != headers[0]->mbh_dataset_id) {
+      free (headers);
+      return HIO_ERR_BAD_PARAM;
+    }
+
+    max_elements += headers[i]->mbh_element_count;
+  }
+
+  header0 = headers[0];
+  identifier0 = hioi_manifest_binary_string (images[0], header0, header0->mbh_identifier);
+  version0 = hioi_manifest_binary_string (images[0], header0, header0->mbh_hio_version);
+
+  for (int i = 1 ; i < count ; ++i) {
+    const char *version = hioi_manifest_binary_string (images[i], headers[i], headers[i]->mbh_hio_version);
+    if ((NULL == version) != (NULL == version0) || (version && strcmp (version, version0))) {
+      free (headers);
+      return HIO_ERR_BAD_PARAM;
+    }
+  }
+
+  /* build the merged element list. unique elements are never merged. shared elements with
+   * the same identifier are combined. */
+  if (max_elements) {
+    merged = calloc (max_elements, sizeof (*merged));
+    inputs = calloc (max_elements * count, sizeof (*inputs));
+    refs = malloc (max_elements * sizeof (*refs));
+    if (NULL == merged || NULL == inputs || NULL == refs) {
+      rc = HIO_ERR_OUT_OF_RESOURCE;
+      goto merge_cleanup;
+    }
+  }
+
+  for (int i = 0 ; i < count ; ++i) {
+    const hio_manifest_binary_element_t *elements =
+      HIO_MANIFEST_BINARY_TABLE(images[i], headers[i], hio_manifest_binary_element_t, element);
+
+    for (uint64_t j = 0 ; j < headers[i]->mbh_element_count ; ++j, ++ref_count) {
+      refs[ref_count].identifier = hioi_manifest_binary_string (images[i], headers[i], elements[j].mbe_identifier);
+      refs[ref_count].image = i;
+      refs[ref_count].element = elements + j;
+
+      if (NULL == refs[ref_count].identifier ||
+          elements[j].mbe_segment_start + elements[j].mbe_segment_count > headers[i]->mbh_segment_count) {
+        rc = HIO_ERR_BAD_PARAM;
+        goto merge_cleanup;
+      }
+    }
+  }
+
+  if (HIO_SET_ELEMENT_UNIQUE != header0->mbh_dataset_mode) {
+    /* sort the references by identifier so that matching elements are adjacent. this keeps the
+     * merge at O(n log n) in the total number of elements no matter how many are shared */
+    qsort (refs, ref_count, sizeof (*refs), hioi_manifest_binary_merge_ref_compare);
+  }
+
+  for (uint64_t j = 0, group = 0, occurrence = 0 ; j < ref_count ; ++j) {
+    uint64_t k = element_count;
+
+    if (HIO_SET_ELEMENT_UNIQUE != header0->mbh_dataset_mode && j &&
+        0 == strcmp (refs[j].identifier, refs[j-1].identifier)) {
+      /* the n-th element with this identifier in an image is combined with the n-th element with
+       * the same identifier in each of the other images */
+      occurrence = (refs[j].image == refs[j-1].image) ? occurrence + 1 : 0;
+      k = group + occurrence;
+    } else {
+      group = element_count;
+      occurrence = 0;
+    }
+
+    if (k == element_count) {
+      merged[k].identifier = refs[j].identifier;
+      merged[k].inputs = inputs + k * count;
+      string_size += strlen (refs[j].identifier) + 1;
+      ++element_count;
+    }
+
+    merged[k].inputs[refs[j].image] = refs[j].element;
+    segment_count += refs[j].element->mbe_segment_count;
+  }
+
+  /* the variables, status, and times of the first image are kept (this matches the json merge) */
+  vars = HIO_MANIFEST_BINARY_TABLE(images[0], header0, hio_manifest_binary_var_t, var);
+  for (uint64_t i = 0 ; i < header0->mbh_var_count ; ++i) {
+    const char *name = hioi_manifest_binary_string (images[0], header0, vars[i].mbv_name);
+    const char *value = hioi_manifest_binary_string (images[0], header0, vars[i].mbv_value);
+
+    string_size += (name ? strlen (name) + 1 : 0) + (value ? strlen (value) + 1 : 0);
+  }
+
+  string_size += (identifier0 ? strlen (identifier0) + 1 : 0) + (version0 ? strlen (version0) + 1 : 0);
+
+  header = hioi_manifest_binary_image_alloc (header0->mbh_var_count, element_count, segment_count, string_size,
+                                             &strings);
+  if (NULL == header) {
+    rc = HIO_ERR_OUT_OF_RESOURCE;
+    goto merge_cleanup;
+  }
+
+  header->mbh_flags = header0->mbh_flags;
+  header->mbh_dataset_id = header0->mbh_dataset_id;
+  header->mbh_mtime = header0->mbh_mtime;
+  header->mbh_dataset_mode = header0->mbh_dataset_mode;
+  header->mbh_status = header0->mbh_status;
+  header->mbh_comm_size = header0->mbh_comm_size;
+  header->mbh_identifier = hioi_manifest_binary_add_string (&strings, identifier0);
+  header->mbh_hio_version = hioi_manifest_binary_add_string (&strings, version0);
+
+  out_vars = (hio_manifest_binary_var_t *) ((unsigned char *) header + header->mbh_var_offset);
+  out_elements = (hio_manifest_binary_element_t *) ((unsigned char *) header + header->mbh_element_offset);
+  out_segments = (hio_manifest_binary_segment_t *) ((unsigned char *) header + header->mbh_segment_offset);
+
+  for (uint64_t i = 0 ; i < header0->mbh_var_count ; ++i) {
+    out_vars[i].mbv_name = hioi_manifest_binary_add_string (&strings, hioi_manifest_binary_string (images[0], header0,
+                                                                                                   vars[i].mbv_name));
+    out_vars[i].mbv_value = hioi_manifest_binary_add_string (&strings, hioi_manifest_binary_string (images[0], header0,
+                                                                                                    vars[i].mbv_value));
+    out_vars[i].mbv_kind = vars[i].mbv_kind;
+  }
+
+  segment_count = 0;
+  for (uint64_t k = 0 ; k < element_count ; ++k) {
+    hio_manifest_binary_element_t *out_element = out_elements + k;
+
+    out_element->mbe_identifier = hioi_manifest_binary_add_string (&strings, merged[k].identifier);
+    out_element->mbe_rank = -1;
+    out_element->mbe_flags = HIO_MANIFEST_BINARY_ELEMENT_CHECKSUM;
+    out_element->mbe_segment_start = segment_count;
+
+    for (int i = 0 ; i < count ; ++i) {
+      const hio_manifest_binary_element_t *input = merged[k].inputs[i];
+
+      if (NULL == input) {
+        continue;
+      }
+
+      if (out_element->mbe_rank < 0) {
+        out_element->mbe_rank = input->mbe_rank;
+      }
+
+      /* use the larger of the sizes */
+      if (input->mbe_size > out_element->mbe_size) {
+        out_element->mbe_size = input->mbe_size;
+      }
+
+      out_element->mbe_segment_count += input->mbe_segment_count;
+      if (input->mbe_segment_count) {
+        out_element->mbe_flags &= input->mbe_flags;
+      }
+    }
+
+    if (0 == out_element->mbe_segment_count) {
+      out_element->mbe_flags = 0;
+    }
+
+    hioi_manifest_binary_merge_segments (images, headers, count, merged[k].inputs, cursors,
+                                         out_segments + segment_count, out_element->mbe_segment_count);
+    segment_count += out_element->mbe_segment_count;
+  }
+
+  assert (strings.size == string_size);
+  header->mbh_string_size = strings.size;
+
+  *data = (unsigned char *) header;
+  *data_size = header->mbh_size;
+
+ merge_cleanup:
+  free (refs);
+  free (merged);
+  free (inputs);
+  free (headers);
+
+  return rc;
+}
+
+int hioi_manifest_binary_to_json (const unsigned char *data, size_t data_size, json_object **object_out) {
+  const hio_manifest_binary_header_t *header = hioi_manifest_binary_header (data, data_size);
+  const hio_manifest_binary_element_t *elements;
+  const hio_manifest_binary_segment_t *segments;
+  const hio_manifest_binary_var_t *vars;
+  json_object *top, *config, *perf, *elements_object;
+  const char *tmp_string;
+
+  if (NULL == header) {
+    return HIO_ERR_BAD_PARAM;
+  }
+
+  vars = HIO_MANIFEST_BINARY_TABLE(data, header, hio_manifest_binary_var_t, var);
+  elements = HIO_MANIFEST_BINARY_TABLE(data, header, hio_manifest_binary_element_t, element);
+  segments = HIO_MANIFEST_BINARY_TABLE(data, header, hio_manifest_binary_segment_t, segment);
+
+  top = json_object_new_object ();
+  if (NULL == top) {
+    return HIO_ERR_OUT_OF_RESOURCE;
+  }
+
+  /* the json representation of a binary manifest is always a 3.0 manifest */
+  json_object_object_add (top, HIO_MANIFEST_KEY_VERSION, json_object_new_string ("3.0"));
+  json_object_object_add (top, HIO_MANIFEST_KEY_COMPAT, json_object_new_string ("3.0"));
+
+  tmp_string = hioi_manifest_binary_string (data, header, header->mbh_hio_version);
+  if (tmp_string) {
+    json_object_object_add (top, HIO_MANIFEST_KEY_HIO_VERSION, json_object_new_string (tmp_string));
+  }
+
+  if (header->mbh_flags & HIO_MANIFEST_BINARY_FLAG_DATASET) {
+    tmp_string = hioi_manifest_binary_string (data, header, header->mbh_identifier);
+    json_object_object_add (top, HIO_MANIFEST_KEY_IDENTIFIER, json_object_new_string (tmp_string ? tmp_string : ""));
+    json_object_object_add (top, HIO_MANIFEST_KEY_DATASET_ID, json_object_new_int64 (header->mbh_dataset_id));
+    json_object_object_add (top, HIO_MANIFEST_KEY_DATASET_MODE, json_object_new_string (
+                              (HIO_SET_ELEMENT_UNIQUE == header->mbh_dataset_mode) ? "unique" : "shared"));
+    json_object_object_add (top, HIO_MANIFEST_KEY_COMM_SIZE, json_object_new_int64 ((int64_t) header->mbh_comm_size));
+    json_object_object_add (top, HIO_MANIFEST_KEY_STATUS, json_object_new_int64 (header->mbh_status));
+    json_object_object_add (top, HIO_MANIFEST_KEY_MTIME, json_object_new_int64 ((int64_t) header->mbh_mtime));
+  }
+
+  if (header->mbh_var_count) {
+    config = json_object_new_object ();
+    perf = json_object_new_object ();
+    json_object_object_add (top, HIO_MANIFEST_KEY_CONFIG, config);
+    json_object_object_add (top, HIO_MANIFEST_KEY_PERF, perf);
+
+    for (uint64_t i = 0 ; i < header->mbh_var_count ; ++i) {
+      const char *name = hioi_manifest_binary_string (data, header, vars[i].mbv_name);
+      const char *value = hioi_manifest_binary_string (data, header, vars[i].mbv_value);
+
+      if (NULL == name || NULL == value) {
+        continue;
+      }
+
+      json_object_object_add ((HIO_MANIFEST_BINARY_VAR_PERF == vars[i].mbv_kind) ? perf : config, name,
+                              json_object_new_string (value));
+    }
+  }
+
+  if (header->mbh_element_count) {
+    elements_object = json_object_new_array ();
+    json_object_object_add (top, HIO_MANIFEST_KEY_ELEMENTS, elements_object);
+
+    for (uint64_t i = 0 ; i < header->mbh_element_count ; ++i) {
+      const hio_manifest_binary_element_t *element = elements + i;
+      json_object *element_object = json_object_new_object (), *segments_object;
+
+      tmp_string = hioi_manifest_binary_string (data, header, element->mbe_identifier);
+      json_object_object_add (element_object, HIO_MANIFEST_KEY_IDENTIFIER, json_object_new_string (tmp_string ? tmp_string : ""));
+      json_object_object_add (element_object, HIO_MANIFEST_KEY_SIZE, json_object_new_int64 ((int64_t) element->mbe_size));
+      if (element->mbe_rank >= 0) {
+        json_object_object_add (element_object, HIO_MANIFEST_KEY_RANK, json_object_new_int64 (element->mbe_rank));
+      }
+
+      json_object_array_add (elements_object, element_object);
+
+      if (0 == element->mbe_segment_count ||
+          element->mbe_segment_start + element->mbe_segment_count > header->mbh_segment_count) {
+        continue;
+      }
+
+      segments_object = json_object_new_array ();
+      json_object_object_add (element_object, HIO_MANIFEST_KEY_SEGMENTS, segments_object);
+
+      for (uint64_t j = 0 ; j < element->mbe_segment_count ; ++j) {
+        const hio_manifest_binary_segment_t *segment = segments + element->mbe_segment_start + j;
+        json_object *segment_object = json_object_new_object ();
+
+        json_object_object_add (segment_object, HIO_SEGMENT_KEY_APP_OFFSET0, json_object_new_int64 ((int64_t) segment->mbs_app_offset));
+        json_object_object_add (segment_object, HIO_SEGMENT_KEY_FILE_OFFSET, json_object_new_int64 ((int64_t) segment->mbs_file_offset));
+        json_object_object_add (segment_object, HIO_SEGMENT_KEY_LENGTH, json_object_new_int64 ((int64_t) segment->mbs_length));
+        json_object_object_add (segment_object, HIO_SEGMENT_KEY_FILE_INDEX, json_object_new_int64 (segment->mbs_file_index));
+        if (element->mbe_flags & HIO_MANIFEST_BINARY_ELEMENT_CHECKSUM) {
+          json_object_object_add (segment_object, HIO_SEGMENT_KEY_CHECKSUM, json_object_new_int64 (segment->mbs_checksum));
+        }
+        json_object_array_add (segments_object, segment_object);
+      }
+    }
+  }
+
+  *object_out = top;
+
+  return HIO_SUCCESS;
+}
+
+/**
+ * @brief Write a json string (with quotes) to a manifest encoder
+ */
+static int hioi_manifest_binary_write_json_string (hio_manifest_encoder_t *encoder, const char *string) {
+  const char *run = string;
+  char escape[8];
+  int rc;
+
+  rc = hioi_manifest_encoder_write (encoder, "\"", 1);
+
+  for ( ; HIO_SUCCESS == rc && *string ; ++string) {
+    unsigned char c = (unsigned char) *string;
+
+    if ('"' != c && '\\' != c && c >= 0x20) {
+      continue;
+    }
+
+    if ('"' == c || '\\' == c) {
+      escape[0] = '\\';
+      escape[1] = c;
+      escape[2] = '\0';
+    } else {
+      snprintf (escape, sizeof (escape), "\\u%04x", c);
+    }
+
+    rc = hioi_manifest_encoder_write (encoder, run, string - run);
+    if (HIO_SUCCESS == rc) {
+      rc = hioi_manifest_encoder_write (encoder, escape, strlen (escape));
+    }
+
+    run = string + 1;
+  }
+
+  if (HIO_SUCCESS == rc) {
+    rc = hioi_manifest_encoder_write (encoder, run, string - run);
+  }
+
+  if (HIO_SUCCESS == rc) {
+    rc = hioi_manifest_encoder_write (encoder, "\"", 1);
+  }
+
+  return rc;
+}
+
+/**
+ * @brief Write a json key/value pair with a string value to a manifest encoder
+ */
+static int hioi_manifest_binary_write_json_pair (hio_manifest_encoder_t *encoder, const char *prefix, const char *key,
+                                                 const char *value) {
+  int rc;
+
+  rc = hioi_manifest_encoder_write (encoder, prefix, strlen (prefix));
+  if (HIO_SUCCESS == rc) {
+    rc = hioi_manifest_binary_write_json_string (encoder, key);
+  }
+
+  if (HIO_SUCCESS == rc) {
+    rc = hioi_manifest_encoder_write (encoder, ": ", 2);
+  }
+
+  if (HIO_SUCCESS == rc) {
+    rc = hioi_manifest_binary_write_json_string (encoder, value);
+  }
+
+  return rc;
+}
+
+/**
+ * @brief Write the opening of a json manifest (version and dataset keys) to a manifest encoder
+ *
+ * If identifier is NULL the dataset keys are not written.
+ */
+static int hioi_manifest_binary_write_json_header (hio_manifest_encoder_t *encoder, const char *hio_version,
+                                                   const char *identifier, int64_t dataset_id, int dataset_mode,
+                                                   int64_t comm_size, int status, int64_t mtime) {
+  char buffer[256];
+  int rc, length;
+
+  length = snprintf (buffer, sizeof (buffer), "{ \"" HIO_MANIFEST_KEY_VERSION "\": \"3.0\", \""
+                     HIO_MANIFEST_KEY_COMPAT "\": \"3.0\"");
+  rc = hioi_manifest_encoder_write (encoder, buffer, length);
+
+  if (HIO_SUCCESS == rc && hio_version) {
+    rc = hioi_manifest_binary_write_json_pair (encoder, ", ", HIO_MANIFEST_KEY_HIO_VERSION, hio_version);
+  }
+
+  if (HIO_SUCCESS == rc && identifier) {
+    rc = hioi_manifest_binary_write_json_pair (encoder, ", ", HIO_MANIFEST_KEY_IDENTIFIER, identifier);
+    if (HIO_SUCCESS == rc) {
+      length = snprintf (buffer, sizeof (buffer), ", \"" HIO_MANIFEST_KEY_DATASET_ID "\": %" PRIu64 ", \""
+                         HIO_MANIFEST_KEY_DATASET_MODE "\": \"%s\", \"" HIO_MANIFEST_KEY_COMM_SIZE "\": %" PRId64
+                         ", \"" HIO_MANIFEST_KEY_STATUS "\": %d, \"" HIO_MANIFEST_KEY_MTIME "\": %" PRId64,
+                         dataset_id, (HIO_SET_ELEMENT_UNIQUE == dataset_mode) ? "unique" : "shared", comm_size,
+                         status, mtime);
+      rc = hioi_manifest_encoder_write (encoder, buffer, length);
+    }
+  }
+
+  return rc;
+}
+
+/**
+ * @brief Write the start of a json element (up to the opening of the segment array) to a manifest encoder
+ *
+ * The segment array is only opened if segment_count is non-zero.
+ */
+static int hioi_manifest_binary_write_json_element (hio_manifest_encoder_t *encoder, bool first,
+                                                    const char *identifier, uint64_t size, int32_t rank,
+                                                    uint64_t segment_count) {
+  char buffer[256];
+  int rc, length;
+
+  rc = hioi_manifest_binary_write_json_pair (encoder, first ? "{ " : ", { ", HIO_MANIFEST_KEY_IDENTIFIER, identifier);
+  if (HIO_SUCCESS != rc) {
+    return rc;
+  }
+
+  length = snprintf (buffer, sizeof (buffer), ", \"" HIO_MANIFEST_KEY_SIZE "\": %" PRId64, (int64_t) size);
+  if (rank >= 0) {
+    length += snprintf (buffer + length, sizeof (buffer) - length, ", \"" HIO_MANIFEST_KEY_RANK "\": %" PRId64,
+                        (int64_t) rank);
+  }
+
+  rc = hioi_manifest_encoder_write (encoder, buffer, length);
+  if (HIO_SUCCESS == rc && segment_count) {
+    rc = hioi_manifest_encoder_write (encoder, ", \"" HIO_MANIFEST_KEY_SEGMENTS "\": [ ",
+                                      strlen (", \"" HIO_MANIFEST_KEY_SEGMENTS "\": [ "));
+  }
+
+  return rc;
+}
+
+/**
+ * @brief Write a json segment to a manifest encoder
+ */
+static int hioi_manifest_binary_write_json_segment (hio_manifest_encoder_t *encoder, bool first,
+                                                    const hio_manifest_binary_segment_t *segment, bool checksum) {
+  char buffer[256];
+  int length;
+
+  length = snprintf (buffer, sizeof (buffer), "%s{ \"" HIO_SEGMENT_KEY_APP_OFFSET0 "\": %" PRId64 ", \""
+                     HIO_SEGMENT_KEY_FILE_OFFSET "\": %" PRId64 ", \"" HIO_SEGMENT_KEY_LENGTH "\": %"
+                     PRId64 ", \"" HIO_SEGMENT_KEY_FILE_INDEX "\": %" PRId64, first ? "" : ", ",
+                     (int64_t) segment->mbs_app_offset, (int64_t) segment->mbs_file_offset,
+                     (int64_t) segment->mbs_length, (int64_t) segment->mbs_file_index);
+  if (checksum) {
+    length += snprintf (buffer + length, sizeof (buffer) - length, ", \"" HIO_SEGMENT_KEY_CHECKSUM
+                        "\": %" PRIu32, segment->mbs_checksum);
+  }
+  length += snprintf (buffer + length, sizeof (buffer) - length, " }");
+
+  return hioi_manifest_encoder_write (encoder, buffer, length);
+}
+
+/**
+ * @brief Write the end of a json element to a manifest encoder
+ */
+static int hioi_manifest_binary_write_json_element_end (hio_manifest_encoder_t *encoder, uint64_t segment_count) {
+  int rc = HIO_SUCCESS;
+
+  if (segment_count) {
+    rc = hioi_manifest_encoder_write (encoder, " ]", 2);
+  }
+
+  if (HIO_SUCCESS == rc) {
+    rc = hioi_manifest_encoder_write (encoder, " }", 2);
+  }
+
+  return rc;
+}
+
+int hioi_manifest_binary_write_json (const unsigned char *data, size_t data_size, hio_manifest_encoder_t *encoder) {
+  const hio_manifest_binary_header_t *header = hioi_manifest_binary_header (data, data_size);
+  const hio_manifest_binary_element_t *elements;
+  const hio_manifest_binary_segment_t *segments;
+  const hio_manifest_binary_var_t *vars;
+  const char *identifier = NULL;
+  int rc;
+
+  if (NULL == header) {
+    return HIO_ERR_BAD_PARAM;
+  }
+
+  vars = HIO_MANIFEST_BINARY_TABLE(data, header, hio_manifest_binary_var_t, var);
+  elements = HIO_MANIFEST_BINARY_TABLE(data, header, hio_manifest_binary_element_t, element);
+  segments = HIO_MANIFEST_BINARY_TABLE(data, header, hio_manifest_binary_segment_t, segment);
+
+  /* this produces the same document as hioi_manifest_binary_to_json () without building the
+   * json object tree. output goes through the encoder in fixed size chunks. */
+  if (header->mbh_flags & HIO_MANIFEST_BINARY_FLAG_DATASET) {
+    identifier = hioi_manifest_binary_string (data, header, header->mbh_identifier);
+    if (NULL == identifier) {
+      identifier = "";
+    }
+  }
+
+  rc = hioi_manifest_binary_write_json_header (encoder, hioi_manifest_binary_string (data, header,
+                                                                                     header->mbh_hio_version),
+                                               identifier, header->mbh_dataset_id, header->mbh_dataset_mode,
+                                               (int64_t) header->mbh_comm_size, (int) header->mbh_status,
+                                               (int64_t) header->mbh_mtime);
+
+  if (HIO_SUCCESS == rc && header->mbh_var_count) {
+    for (int kind = 0 ; kind < 2 && HIO_SUCCESS == rc ; ++kind) {
+      const char *prefix = "{ ";
+      const char *key = kind ? ", \"" HIO_MANIFEST_KEY_PERF "\": " : ", \"" HIO_MANIFEST_KEY_CONFIG "\": ";
+
+      rc = hioi_manifest_encoder_write (encoder, key, strlen (key));
+
+      for (uint64_t i = 0 ; i < header->mbh_var_count && HIO_SUCCESS == rc ; ++i) {
+        const char *name = hioi_manifest_binary_string (data, header, vars[i].mbv_name);
+        const char *value = hioi_manifest_binary_string (data, header, vars[i].mbv_value);
+
+        if (NULL == name || NULL == value || kind != (HIO_MANIFEST_BINARY_VAR_PERF == vars[i].mbv_kind)) {
+          continue;
+        }
+
+        rc = hioi_manifest_binary_write_json_pair (encoder, prefix, name, value);
+        prefix = ", ";
+      }
+
+      if (HIO_SUCCESS == rc) {
+        /* an empty object is written as "{ }" */
+        rc = hioi_manifest_encoder_write (encoder, ('{' == prefix[0]) ? "{ }" : " }", ('{' == prefix[0]) ? 3 : 2);
+      }
+    }
+  }
+
+  if (HIO_SUCCESS == rc && header->mbh_element_count) {
+    rc = hioi_manifest_encoder_write (encoder, ", \"" HIO_MANIFEST_KEY_ELEMENTS "\": [ ",
+                                      strlen (", \"" HIO_MANIFEST_KEY_ELEMENTS "\": [ "));
+
+    for (uint64_t i = 0 ; i < header->mbh_element_count && HIO_SUCCESS == rc ; ++i) {
+      const hio_manifest_binary_element_t *element = elements + i;
+      uint64_t segment_count = element->mbe_segment_count;
+      const char *tmp_string;
+
+      if (element->mbe_segment_start + segment_count > header->mbh_segment_count) {
+        segment_count = 0;
+      }
+
+      tmp_string = hioi_manifest_binary_string (data, header, element->mbe_identifier);
+      rc = hioi_manifest_binary_write_json_element (encoder, 0 == i, tmp_string ? tmp_string : "", element->mbe_size,
+                                                    element->mbe_rank, segment_count);
+
+      for (uint64_t j = 0 ; j < segment_count && HIO_SUCCESS == rc ; ++j) {
+        rc = hioi_manifest_binary_write_json_segment (encoder, 0 == j, segments + element->mbe_segment_start + j,
+                                                      !!(element->mbe_flags & HIO_MANIFEST_BINARY_ELEMENT_CHECKSUM));
+      }
+
+      if (HIO_SUCCESS == rc) {
+        rc = hioi_manifest_binary_write_json_element_end (encoder, segment_count);
+      }
+    }
+
+    if (HIO_SUCCESS == rc) {
+      rc = hioi_manifest_encoder_write (encoder, " ]", 2);
+    }
+  }
+
+  if (HIO_SUCCESS == rc) {
+    /* manifests are stored with a terminating nul to match hioi_manifest_serialize () */
+    rc = hioi_manifest_encoder_write (encoder, " }", sizeof (" }"));
+  }
+
+  return rc;
+}
+
+/**
+ * @brief Get the binary flags of a dataset element
+ */
+static uint32_t hioi_manifest_binary_element_flags (hio_element_t element) {
+  if (0 == element->e_scount) {
+    return 0;
+  }
+
+  for (size_t i = 0 ; i < element->e_scount ; ++i) {
+    if (element->e_sarray[i].seg_cksum_length != element->e_sarray[i].seg_length) {
+      return 0;
+    }
+  }
+
+  return HIO_MANIFEST_BINARY_ELEMENT_CHECKSUM;
+}
+
+static void hioi_manifest_binary_segment_from_dataset (hio_manifest_binary_segment_t *out,
+                                                       const hio_manifest_segment_t *segment) {
+  out->mbs_app_offset = segment->seg_offset;
+  out->mbs_file_offset = segment->seg_foffset;
+  out->mbs_length = segment->seg_length;
+  out->mbs_file_index = segment->seg_file_index;
+  out->mbs_checksum = segment->seg_checksum;
+}
+
+/**
+ * @brief Write the image hioi_manifest_generate_binary_image () would produce to a manifest encoder
+ *
+ * The tables are emitted one record at a time while walking the dataset so no image is
+ * built in memory.
+ */
+static int hioi_manifest_binary_write_dataset_binary (hio_dataset_t dataset, hio_manifest_encoder_t *encoder) {
+  hio_context_t context = hioi_object_context (&dataset->ds_object);
+  hio_var_array_t *var_arrays[2] = {&dataset->ds_object.configuration, &dataset->ds_object.performance};
+  uint64_t var_count = 0, element_count = 0, segment_count = 0, string_size = 0, string_offset;
+  hio_manifest_binary_strings_t strings = {.base = NULL, .size = 0};
+  hio_manifest_binary_header_t *header;
+  const unsigned char zeros[8] = {0};
+  hio_element_t element;
+  char buffer[64];
+  int rc;
+
+  /* first pass: determine the size of each table */
+  string_size += strlen (hioi_object_identifier (dataset)) + strlen (PACKAGE_VERSION) + 2;
+
+  for (int i = 0 ; i < 2 ; ++i) {
+    for (int j = 0 ; j < var_arrays[i]->var_count ; ++j) {
+      hio_var_t *var = var_arrays[i]->vars + j;
+      string_size += strlen (var->var_name) + strlen (hioi_manifest_binary_var_value (var, buffer, sizeof (buffer))) + 2;
+    }
+
+    var_count += var_arrays[i]->var_count;
+  }
+
+  hioi_list_foreach(element, dataset->ds_elist, struct hio_element, e_list) {
+    string_size += strlen (hioi_object_identifier (element)) + 1;
+    segment_count += element->e_scount;
+    ++element_count;
+  }
+
+  /* allocate only the header. the tables are written directly */
+  header = hioi_manifest_binary_image_alloc (0, 0, 0, 0, &strings);
+  if (NULL == header) {
+    return HIO_ERR_OUT_OF_RESOURCE;
+  }
+
+  header->mbh_var_count = var_count;
+  header->mbh_element_offset = header->mbh_var_offset + var_count * sizeof (hio_manifest_binary_var_t);
+  header->mbh_element_count = element_count;
+  header->mbh_segment_offset = header->mbh_element_offset + element_count * sizeof (hio_manifest_binary_element_t);
+  header->mbh_segment_count = segment_count;
+  header->mbh_string_offset = header->mbh_segment_offset + segment_count * sizeof (hio_manifest_binary_segment_t);
+  header->mbh_string_size = string_size;
+  header->mbh_size = header->mbh_string_offset + HIO_MANIFEST_BINARY_ALIGN(string_size);
+
+  header->mbh_flags = HIO_MANIFEST_BINARY_FLAG_DATASET;
+  header->mbh_identifier = 0;
+  header->mbh_hio_version = strlen (hioi_object_identifier (dataset)) + 1;
+  header->mbh_dataset_id = dataset->ds_id;
+  header->mbh_dataset_mode = dataset->ds_mode;
+  header->mbh_status = dataset->ds_status;
+  header->mbh_comm_size = context->c_size;
+  header->mbh_mtime = (uint64_t) time (NULL);
+
+  rc = hioi_manifest_encoder_write (encoder, header, header->mbh_var_offset);
+  string_offset = header->mbh_hio_version + strlen (PACKAGE_VERSION) + 1;
+  free (header);
+
+  /* variable table */
+  for (int i = 0 ; i < 2 && HIO_SUCCESS == rc ; ++i) {
+    for (int j = 0 ; j < var_arrays[i]->var_count && HIO_SUCCESS == rc ; ++j) {
+      hio_var_t *var = var_arrays[i]->vars + j;
+      hio_manifest_binary_var_t record = {.mbv_kind = i ? HIO_MANIFEST_BINARY_VAR_PERF : HIO_MANIFEST_BINARY_VAR_CONFIG};
+
+      record.mbv_name = string_offset;
+      string_offset += strlen (var->var_name) + 1;
+      record.mbv_value = string_offset;
+      string_offset += strlen (hioi_manifest_binary_var_value (var, buffer, sizeof (buffer))) + 1;
+
+      rc = hioi_manifest_encoder_write (encoder, &record, sizeof (record));
+    }
+  }
+
+  /* element table */
+  segment_count = 0;
+  hioi_list_foreach(element, dataset->ds_elist, struct hio_element, e_list) {
+    hio_manifest_binary_element_t record = {.mbe_identifier = string_offset, .mbe_size = element->e_size,
+                                            .mbe_segment_start = segment_count,
+                                            .mbe_segment_count = element->e_scount};
+
+    if (HIO_SUCCESS != rc) {
+      break;
+    }
+
+    record.mbe_rank = (HIO_SET_ELEMENT_UNIQUE == dataset->ds_mode) ? element->e_rank : -1;
+    record.mbe_flags = hioi_manifest_binary_element_flags (element);
+    string_offset += strlen (hioi_object_identifier (element)) + 1;
+    segment_count += element->e_scount;
+
+    rc = hioi_manifest_encoder_write (encoder, &record, sizeof (record));
+  }
+
+  /* segment table */
+  hioi_list_foreach(element, dataset->ds_elist, struct hio_element, e_list) {
+    for (size_t i = 0 ; i < element->e_scount && HIO_SUCCESS == rc ; ++i) {
+      hio_manifest_binary_segment_t record;
+
+      hioi_manifest_binary_segment_from_dataset (&record, element->e_sarray + i);
+      rc = hioi_manifest_encoder_write (encoder, &record, sizeof (record));
+    }
+  }
+
+  /* string table (in the same order the offsets were assigned above) */
+  if (HIO_SUCCESS == rc) {
+    rc = hioi_manifest_encoder_write (encoder, hioi_object_identifier (dataset),
+                                      strlen (hioi_object_identifier (dataset)) + 1);
+  }
+
+  if (HIO_SUCCESS == rc) {
+    rc = hioi_manifest_encoder_write (encoder, PACKAGE_VERSION, strlen (PACKAGE_VERSION) + 1);
+  }
+
+  for (int i = 0 ; i < 2 && HIO_SUCCESS == rc ; ++i) {
+    for (int j = 0 ; j < var_arrays[i]->var_count && HIO_SUCCESS == rc ; ++j) {
+      hio_var_t *var = var_arrays[i]->vars + j;
+      const char *value = hioi_manifest_binary_var_value (var, buffer, sizeof (buffer));
+
+      rc = hioi_manifest_encoder_write (encoder, var->var_name, strlen (var->var_name) + 1);
+      if (HIO_SUCCESS == rc) {
+        rc = hioi_manifest_encoder_write (encoder, value, strlen (value) + 1);
+      }
+    }
+  }
+
+  hioi_list_foreach(element, dataset->ds_elist, struct hio_element, e_list) {
+    if (HIO_SUCCESS != rc) {
+      break;
+    }
+
+    rc = hioi_manifest_encoder_write (encoder, hioi_object_identifier (element),
+                                      strlen (hioi_object_identifier (element)) + 1);
+  }
+
+  if (HIO_SUCCESS == rc) {
+    assert (string_offset == string_size);
+    rc = hioi_manifest_encoder_write (encoder, zeros, HIO_MANIFEST_BINARY_ALIGN(string_size) - string_size);
+  }
+
+  return rc;
+}
+
+/**
+ * @brief Write the document hioi_manifest_binary_write_json () would produce for the dataset's
+ * binary image to a manifest encoder
+ */
+static int hioi_manifest_binary_write_dataset_json (hio_dataset_t dataset, hio_manifest_encoder_t *encoder) {
+  hio_context_t context = hioi_object_context (&dataset->ds_object);
+  hio_var_array_t *var_arrays[2] = {&dataset->ds_object.configuration, &dataset->ds_object.performance};
+  hio_element_t element;
+  bool first = true;
+  char buffer[64];
+  int rc;
+
+  rc = hioi_manifest_binary_write_json_header (encoder, PACKAGE_VERSION, hioi_object_identifier (dataset),
+                                               dataset->ds_id, dataset->ds_mode, context->c_size, dataset->ds_status,
+                                               (int64_t) time (NULL));
+
+  if (HIO_SUCCESS == rc && var_arrays[0]->var_count + var_arrays[1]->var_count) {
+    for (int kind = 0 ; kind < 2 && HIO_SUCCESS == rc ; ++kind) {
+      const char *key = kind ? ", \"" HIO_MANIFEST_KEY_PERF "\": " : ", \"" HIO_MANIFEST_KEY_CONFIG "\": ";
+
+      rc = hioi_manifest_encoder_write (encoder, key, strlen (key));
+
+      for (int i = 0 ; i < var_arrays[kind]->var_count && HIO_SUCCESS == rc ; ++i) {
+        hio_var_t *var = var_arrays[kind]->vars + i;
+
+        rc = hioi_manifest_binary_write_json_pair (encoder, i ? ", " : "{ ", var->var_name,
+                                                   hioi_manifest_binary_var_value (var, buffer, sizeof (buffer)));
+      }
+
+      if (HIO_SUCCESS == rc) {
+        /* an empty object is written as "{ }" */
+        rc = hioi_manifest_encoder_write (encoder, var_arrays[kind]->var_count ? " }" : "{ }",
+                                          var_arrays[kind]->var_count ? 2 : 3);
+      }
+    }
+  }
+
+  hioi_list_foreach(element, dataset->ds_elist, struct hio_element, e_list) {
+    int32_t rank = (HIO_SET_ELEMENT_UNIQUE == dataset->ds_mode) ? element->e_rank : -1;
+    bool checksum = !!hioi_manifest_binary_element_flags (element);
+
+    if (HIO_SUCCESS != rc) {
+      break;
+    }
+
+    if (first) {
+      rc = hioi_manifest_encoder_write (encoder, ", \"" HIO_MANIFEST_KEY_ELEMENTS "\": [ ",
+                                        strlen (", \"" HIO_MANIFEST_KEY_ELEMENTS "\": [ "));
+      if (HIO_SUCCESS != rc) {
+        break;
+      }
+    }
+
+    rc = hioi_manifest_binary_write_json_element (encoder, first, hioi_object_identifier (element), element->e_size,
+                                                  rank, element->e_scount);
+
+    for (size_t i = 0 ; i < element->e_scount && HIO_SUCCESS == rc ; ++i) {
+      hio_manifest_binary_segment_t record;
+
+      hioi_manifest_binary_segment_from_dataset (&record, element->e_sarray + i);
+      rc = hioi_manifest_binary_write_json_segment (encoder, 0 == i, &record, checksum);
+    }
+
+    if (HIO_SUCCESS == rc) {
+      rc = hioi_manifest_binary_write_json_element_end (encoder, element->e_scount);
+    }
+
+    first = false;
+  }
+
+  if (HIO_SUCCESS == rc && !first) {
+    rc = hioi_manifest_encoder_write (encoder, " ]", 2);
+  }
+
+  if (HIO_SUCCESS == rc) {
+    /* manifests are stored with a terminating nul to match hioi_manifest_serialize () */
+    rc = hioi_manifest_encoder_write (encoder, " }", sizeof (" }"));
+  }
+
+  return rc;
+}
+
+int hioi_manifest_binary_write_dataset (hio_dataset_t dataset, int format, hio_manifest_encoder_t *encoder) {
+  if (HIO_MANIFEST_FORMAT_BINARY == format) {
+    return hioi_manifest_binary_write_dataset_binary (dataset, encoder);
+  }
+
+  return hioi_manifest_binary_write_dataset_json (dataset, encoder);
+}
+
+int hioi_manifest_read_header_binary (hio_context_t context, hio_dataset_header_t *header,
+                                      const unsigned char *data, size_t data_size) {
+  const hio_manifest_binary_header_t *binary_header = hioi_manifest_binary_header (data, data_size);
+  const char *identifier;
+
+  if (NULL == binary_header || !(binary_header->mbh_flags & HIO_MANIFEST_BINARY_FLAG_DATASET)) {
+    return HIO_ERR_BAD_PARAM;
+  }
+
+  identifier = hioi_manifest_binary_string (data, binary_header, binary_header->mbh_identifier);
+  if (NULL == identifier || strlen (identifier) >= HIO_DATASET_NAME_MAX) {
+    return HIO_ERR_BAD_PARAM;
+  }
+
+  strncpy (header->ds_name, identifier, sizeof (header->ds_name));
+  header->ds_mode = binary_header->mbh_dataset_mode;
+  header->ds_status = binary_header->mbh_status;
+  header->ds_mtime = (time_t) binary_header->mbh_mtime;
+  header->ds_id = binary_header->mbh_dataset_id;
+
+  return HIO_SUCCESS;
+}
+
+/**
+ * @brief Add a run of segments from a binary manifest to an element
+ *
+ * Segments in a binary manifest are sorted by application offset. If the element
+ * does not have any segments yet the run is copied directly into the element's
+ * segment array. Otherwise the segments are inserted one at a time. Segment checksums
+ * are loaded if has_checksums is set.
+ */
+static int hioi_manifest_binary_load_segments (hio_element_t element, const hio_manifest_binary_segment_t *segments,
+                                               uint64_t count, bool has_checksums) {
+  int rc;
+
+  if (0 == element->e_scount && count) {
+    hio_manifest_segment_t *sarray = malloc (count * sizeof (*sarray));
+
+    if (NULL == sarray) {
+      return HIO_ERR_OUT_OF_RESOURCE;
+    }
+
+    for (uint64_t i = 0 ; i < count ; ++i) {
+      if (i && segments[i].mbs_app_offset < segments[i-1].mbs_app_offset + segments[i-1].mbs_length) {
+        /* not sorted. fall back on the slow path */
+        free (sarray);
+        sarray = NULL;
+        break;
+      }
+
+      sarray[i].seg_offset = segments[i].mbs_app_offset;
+      sarray[i].seg_foffset = segments[i].mbs_file_offset;
+      sarray[i].seg_length = segments[i].mbs_length;
+      sarray[i].seg_file_index = segments[i].mbs_file_index;
+      sarray[i].seg_checksum = has_checksums ? segments[i].mbs_checksum : 0;
+      sarray[i].seg_cksum_length = has_checksums ? segments[i].mbs_length : 0;
+    }
+
+    if (sarray) {
+      hioi_object_lock (&element->e_object);
+      free (element->e_sarray);
+      element->e_sarray = sarray;
+      element->e_scount = element->e_ssize = count;
+      hioi_object_unlock (&element->e_object);
+      return HIO_SUCCESS;
+    }
+  }
+
+  for (uint64_t i = 0 ; i < count ; ++i) {
+    if (has_checksums) {
+      rc = hioi_element_add_segment_checksum (element, segments[i].mbs_file_index, segments[i].mbs_file_offset,
+                                              segments[i].mbs_app_offset, segments[i].mbs_length,
+                                              segments[i].mbs_checksum);
+    } else {
+      rc = hioi_element_add_segment (element, segments[i].mbs_file_index, segments[i].mbs_file_offset,
+                                     segments[i].mbs_app_offset, segments[i].mbs_length);
+    }
+    if (HIO_SUCCESS != rc) {
+      return rc;
+    }
+  }
+
+  return HIO_SUCCESS;
+}
+
+/**
+ * @brief Load an element record from a binary manifest into a dataset
+ *
+ * @param[in]  dataset      dataset to load the element into
+ * @param[in]  data         binary manifest image
+ * @param[in]  header       header of the binary manifest image
+ * @param[in]  index        index of the element record
+ * @param[out] element_out  loaded element (may be NULL)
+ *
+ * Creates the element if it does not already exist in the dataset and adds the
+ * record's segments to it. Records for other ranks in unique datasets are ignored.
+ */
+static int hioi_manifest_binary_load_element (hio_dataset_t dataset, const unsigned char *data,
+                                              const hio_manifest_binary_header_t *header, uint64_t index,
+                                              hio_element_t *element_out) {
+  const hio_manifest_binary_element_t *binary_element =
+    HIO_MANIFEST_BINARY_TABLE(data, header, hio_manifest_binary_element_t, element) + index;
+  const hio_manifest_binary_segment_t *segments =
+    HIO_MANIFEST_BINARY_TABLE(data, header, hio_manifest_binary_segment_t, segment);
+  const char *identifier = hioi_manifest_binary_string (data, header, binary_element->mbe_identifier);
+  hio_context_t context = hioi_object_context (&dataset->ds_object);
+  hio_element_t element;
+  bool new_element = true;
+  int rank = -1, rc;
+
+  if (NULL == identifier ||
+      binary_element->mbe_segment_start + binary_element->mbe_segment_count > header->mbh_segment_count) {
+    hioi_err_push (HIO_ERR_BAD_PARAM, &dataset->ds_object, "corrupt element record in binary manifest");
+    return HIO_ERR_BAD_PARAM;
+  }
+
+  if (HIO_SET_ELEMENT_UNIQUE == dataset->ds_mode) {
+    if (binary_element->mbe_rank != context->c_rank) {
+      /* nothing to do */
+      return HIO_SUCCESS;
+    }
+
+    rank = binary_element->mbe_rank;
+  }
+
+  hioi_list_foreach (element, dataset->ds_elist, struct hio_element, e_list) {
+    if (!strcmp (hioi_object_identifier(element), identifier) && rank == element->e_rank) {
+      new_element = false;
+      break;
+    }
+  }
+
+  if (new_element) {
+    element = hioi_element_alloc (dataset, identifier, rank);
+    if (NULL == element) {
+      return HIO_ERR_OUT_OF_RESOURCE;
+    }
+  }
+
+  if (HIO_SET_ELEMENT_UNIQUE == dataset->ds_mode || (int64_t) binary_element->mbe_size > element->e_size) {
+    element->e_size = binary_element->mbe_size;
+  }
+
+  rc = hioi_manifest_binary_load_segments (element, segments + binary_element->mbe_segment_start,
+                                           binary_element->mbe_segment_count,
+                                           !!(binary_element->mbe_flags & HIO_MANIFEST_BINARY_ELEMENT_CHECKSUM));
+  if (HIO_SUCCESS != rc) {
+    if (new_element) {
+      hioi_object_release (&element->e_object);
+    }
+    return rc;
+  }
+
+  if (new_element) {
+    hioi_dataset_add_element (dataset, element);
+  }
+
+  if (element_out) {
+    *element_out = element;
+  }
+
+  return HIO_SUCCESS;
+}
+
+/**
+ * Element directory
+ *
+ * Datasets opened read-only do not load the elements in a binary manifest up front.
+ * Instead the manifest image is kept with the dataset and elements (with their
+ * segments) are loaded the first time they are opened. json manifests are converted
+ * to a binary image first (see hioi_manifest_convert_binary) unless they use a layout
+ * older than 3.0, in which case all elements are loaded when the dataset is opened. The directory index (element
+ * records sorted by identifier) is built on the first lookup.
+ */
+typedef struct hio_manifest_directory_entry_t {
+  /** element identifier (points into the binary image) */
+  const char *mde_identifier;
+  /** index of the element record */
+  uint64_t mde_record;
+} hio_manifest_directory_entry_t;
+
+struct hio_manifest_directory {
+  /** manifest holding the binary image */
+  hio_manifest_t md_manifest;
+  /** header of the binary image */
+  const hio_manifest_binary_header_t *md_header;
+  /** element records visible to this rank sorted by identifier */
+  hio_manifest_directory_entry_t *md_index;
+  /** number of entries in md_index */
+  uint64_t md_index_count;
+  /** bitmap of element records that have been loaded */
+  unsigned char *md_loaded;
+  /** number of element records that have not been loaded */
+  uint64_t md_remaining;
+};
+
+static int hioi_manifest_directory_compare (const void *arg1, const void *arg2) {
+  const hio_manifest_directory_entry_t *entry1 = (const hio_manifest_directory_entry_t *) arg1;
+  const hio_manifest_directory_entry_t *entry2 = (const hio_manifest_directory_entry_t *) arg2;
+
+  return strcmp (entry1->mde_identifier, entry2->mde_identifier);
+}
+
+static int hioi_manifest_directory_key_compare (const void *key, const void *arg) {
+  return strcmp ((const char *) key, ((const hio_manifest_directory_entry_t *) arg)->mde_identifier);
+}
+
+static int hioi_manifest_directory_build_index (hio_dataset_t dataset, hio_manifest_directory_t *directory) {
+  const hio_manifest_binary_header_t *header = directory->md_header;
+  const unsigned char *data = directory->md_manifest->binary_data;
+  const hio_manifest_binary_element_t *elements =
+    HIO_MANIFEST_BINARY_TABLE(data, header, hio_manifest_binary_element_t, element);
+  hio_context_t context = hioi_object_context (&dataset->ds_object);
+  hio_manifest_directory_entry_t *index;
+
+  index = malloc (header->mbh_element_count * sizeof (index[0]));
+  if (NULL == index) {
+    return HIO_ERR_OUT_OF_RESOURCE;
+  }
+
+  directory->md_index_count = 0;
+
+  for (uint64_t i = 0 ; i < header->mbh_element_count ; ++i) {
+    const char *identifier = hioi_manifest_binary_string (data, header, elements[i].mbe_identifier);
+
+    if (NULL == identifier) {
+      hioi_err_push (HIO_ERR_BAD_PARAM, &dataset->ds_object, "corrupt element record in binary manifest");
+      free (index);
+      return HIO_ERR_BAD_PARAM;
+    }
+
+    if (HIO_SET_ELEMENT_UNIQUE != dataset->ds_mode || elements[i].mbe_rank == context->c_rank) {
+      index[directory->md_index_count].mde_identifier = identifier;
+      index[directory->md_index_count++].mde_record = i;
+    }
+  }
+
+  qsort (index, directory->md_index_count, sizeof (index[0]), hioi_manifest_directory_compare);
+  directory->md_index = index;
+
+  return HIO_SUCCESS;
+}
+
+void hioi_manifest_directory_release (hio_manifest_directory_t *directory) {
+  if (NULL != directory) {
+    hioi_manifest_release (directory->md_manifest);
+    free (directory->md_index);
+    free (directory->md_loaded);
+    free (directory);
+  }
+}
+
+int hioi_manifest_directory_load_element (hio_dataset_t dataset, const char *name, int rank,
+                                          hio_element_t *element_out) {
+  hio_manifest_directory_t *directory = dataset->ds_element_directory;
+  hio_context_t context = hioi_object_context (&dataset->ds_object);
+  const hio_manifest_directory_entry_t *match;
+  hio_element_t element = NULL;
+  int rc;
+
+  if (NULL == directory) {
+    return HIO_ERR_NOT_FOUND;
+  }
+
+  if (HIO_SET_ELEMENT_UNIQUE == dataset->ds_mode && rank != context->c_rank) {
+    /* the directory only contains this rank's elements */
+    return HIO_ERR_NOT_FOUND;
+  }
+
+  if (NULL == directory->md_index) {
+    rc = hioi_manifest_directory_build_index (dataset, directory);
+    if (HIO_SUCCESS != rc) {
+      return rc;
+    }
+  }
+
+  match = bsearch (name, directory->md_index, directory->md_index_count, sizeof (directory->md_index[0]),
+                   hioi_manifest_directory_key_compare);
+  if (NULL == match) {
+    return HIO_ERR_NOT_FOUND;
+  }
+
+  /* there may be multiple records with the same identifier. find the first one */
+  while (match > directory->md_index && 0 == strcmp (name, match[-1].mde_identifier)) {
+    --match;
+  }
+
+  for ( ; match < directory->md_index + directory->md_index_count && 0 == strcmp (name, match->mde_identifier) ;
+        ++match) {
+    uint64_t record = match->mde_record;
+
+    if (directory->md_loaded[record >> 3] & (1 << (record & 7))) {
+      continue;
+    }
+
+    rc = hioi_manifest_binary_load_element (dataset, directory->md_manifest->binary_data, directory->md_header,
+                                            record, &element);
+    if (HIO_SUCCESS != rc) {
+      return rc;
+    }
+
+    directory->md_loaded[record >> 3] |= 1 << (record & 7);
+    --directory->md_remaining;
+  }
+
+  if (NULL == element) {
+    return HIO_ERR_NOT_FOUND;
+  }
+
+  hioi_log (context, HIO_VERBOSE_DEBUG_MED, "loaded element %s (%lu segments) from the element directory. %" PRIu64
+            " elements not loaded", name, (unsigned long) element->e_scount, directory->md_remaining);
+
+  *element_out = element;
+
+  return HIO_SUCCESS;
+}
+
+int hioi_manifest_directory_load_all (hio_dataset_t dataset) {
+  hio_manifest_directory_t *directory = dataset->ds_element_directory;
+  int rc;
+
+  if (NULL == directory || 0 == directory->md_remaining) {
+    return HIO_SUCCESS;
+  }
+
+  for (uint64_t i = 0 ; i < directory->md_header->mbh_element_count ; ++i) {
+    if (directory->md_loaded[i >> 3] & (1 << (i & 7))) {
+      continue;
+    }
+
+    rc = hioi_manifest_binary_load_element (dataset, directory->md_manifest->binary_data, directory->md_header,
+                                            i, NULL);
+    if (HIO_SUCCESS != rc) {
+      return rc;
+    }
+
+    directory->md_loaded[i >> 3] |= 1 << (i & 7);
+  }
+
+  directory->md_remaining = 0;
+
+  return HIO_SUCCESS;
+}
+
+/**
+ * @brief Keep a binary manifest as the dataset's element directory
+ *
+ * Takes ownership of the manifest's binary image.
+ */
+static int hioi_manifest_directory_create (hio_dataset_t dataset, hio_manifest_t manifest,
+                                           const hio_manifest_binary_header_t *header) {
+  hio_manifest_directory_t *directory;
+
+  directory = calloc (1, sizeof (*directory));
+  if (NULL == directory) {
+    return HIO_ERR_OUT_OF_RESOURCE;
+  }
+
+  directory->md_manifest = calloc (1, sizeof (*directory->md_manifest));
+  directory->md_loaded = calloc (1, (header->mbh_element_count >> 3) + 1);
+  if (NULL == directory->md_manifest || NULL == directory->md_loaded) {
+    free (directory->md_manifest);
+    free (directory->md_loaded);
+    free (directory);
+    return HIO_ERR_OUT_OF_RESOURCE;
+  }
+
+  /* move the image into the directory */
+  *directory->md_manifest = *manifest;
+  manifest->binary_data = NULL;
+  manifest->binary_size = 0;
+  manifest->binary_mapped = false;
+
+  directory->md_header = header;
+  directory->md_remaining = header->mbh_element_count;
+
+  dataset->ds_element_directory = directory;
+
+  return HIO_SUCCESS;
+}
+
+int hioi_manifest_load_binary (hio_dataset_t dataset, hio_manifest_t manifest) {
+  const unsigned char *data = manifest->binary_data;
+  const hio_manifest_binary_header_t *header = hioi_manifest_binary_header (data, manifest->binary_size);
+  hio_context_t context = hioi_object_context (&dataset->ds_object);
+  const hio_manifest_binary_var_t *vars;
+  int rc;
+
+  if (NULL == header) {
+    hioi_err_push (HIO_ERR_BAD_PARAM, &dataset->ds_object, "invalid or incompatible binary manifest");
+    return HIO_ERR_BAD_PARAM;
+  }
+
+  hioi_log (context, HIO_VERBOSE_DEBUG_LOW, "loading binary manifest version %d with %" PRIu64 " elements and %"
+            PRIu64 " segments", header->mbh_version, header->mbh_element_count, header->mbh_segment_count);
+
+  if (!(header->mbh_flags & HIO_MANIFEST_BINARY_FLAG_DATASET)) {
+    /* nothing to load */
+    return HIO_SUCCESS;
+  }
+
+  if (header->mbh_dataset_mode != dataset->ds_mode) {
+    hioi_err_push (HIO_ERR_BAD_PARAM, &dataset->ds_object,
+                   "mismatch in dataset mode. requested: %d, actual: %d", header->mbh_dataset_mode,
+                   dataset->ds_mode);
+    return HIO_ERR_BAD_PARAM;
+  }
+
+  if (HIO_SET_ELEMENT_UNIQUE == dataset->ds_mode && header->mbh_comm_size != (uint64_t) context->c_size) {
+    hioi_err_push (HIO_ERR_BAD_PARAM, &dataset->ds_object, "communicator size does not match dataset");
+    return HIO_ERR_BAD_PARAM;
+  }
+
+  vars = HIO_MANIFEST_BINARY_TABLE(data, header, hio_manifest_binary_var_t, var);
+
+  for (uint64_t i = 0 ; i < header->mbh_var_count ; ++i) {
+    const char *name = hioi_manifest_binary_string (data, header, vars[i].mbv_name);
+    const char *value = hioi_manifest_binary_string (data, header, vars[i].mbv_value);
+
+    if (NULL == name || NULL == value) {
+      continue;
+    }
+
+    if (HIO_MANIFEST_BINARY_VAR_PERF == vars[i].mbv_kind) {
+      (void) hioi_perf_set_value (&dataset->ds_object, name, value);
+    } else {
+      (void) hioi_config_load_value (&dataset->ds_object, name, value);
+    }
+  }
+
+  dataset->ds_status = header->mbh_status;
+
+  if (0 == header->mbh_element_count) {
+    return HIO_SUCCESS;
+  }
+
+  if (!(dataset->ds_flags & HIO_FLAG_WRITE) && NULL == dataset->ds_element_directory) {
+    /* defer loading elements until they are opened */
+    return hioi_manifest_directory_create (dataset, manifest, header);
+  }
+
+  for (uint64_t i = 0 ; i < header->mbh_element_count ; ++i) {
+    rc = hioi_manifest_binary_load_element (dataset, data, header, i, NULL);
+    if (HIO_SUCCESS != rc) {
+      return rc;
+    }
+  }
+
+  return HIO_SUCCESS;
+}
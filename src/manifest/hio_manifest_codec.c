@@ -0,0 +1,566 @@
+/* -*- Mode: C; c-basic-offset:2 ; indent-tabs-mode:nil -*- */
+/*
+ * Copyright (c) 2017      Los Alamos National Security, LLC.  All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/**
+ * @file hio_manifest_codec.c
+ * @brief Compression codecs for serialized manifest data
+ *
+ * Each codec is described by a hio_manifest_codec_ops_t entry. Compressed payloads
+ * are self-describing: bzip2 payloads start with the bzip2 stream magic ("BZh") and
+ * lz payloads start with a small header carrying the "HLZ1" magic and the
+ * uncompressed size. hioi_manifest_decompress() detects the codec from the
+ * payload so readers do not need to know how a manifest was written.
+ *
+ * Manifests written with the streaming encoder (hioi_manifest_encoder_open) use
+ * the same formats. bzip2 is naturally streaming. lz payloads written by the
+ * encoder set the framed flag in the header and hold a sequence of independently
+ * compressed chunks, each prefixed by its compressed and uncompressed sizes.
+ */
+
+#include "hio_manifest.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <bzlib.h>
+
+#define HIO_MANIFEST_LZ_MAGIC       "HLZ1"
+#define HIO_MANIFEST_LZ_HEADER_SIZE 16
+/** header flag: payload is a sequence of chunks */
+#define HIO_MANIFEST_LZ_FLAG_FRAMED 0x01
+#define HIO_MANIFEST_LZ_FRAME_HEADER_SIZE 8
+
+/** size of the staging buffer used by the streaming encoder */
+#define HIO_MANIFEST_ENCODER_CHUNK_SIZE (256 * 1024)
+
+typedef struct hio_manifest_codec_ops_t {
+  /** codec name (used in log messages) */
+  const char *name;
+  /** file name suffix for data compressed with this codec */
+  const char *suffix;
+  /** check if a payload was compressed with this codec */
+  bool (*detect) (const unsigned char *data, size_t data_size);
+  /** compress data. the output buffer is allocated by the codec */
+  int (*compress) (const unsigned char *data, size_t data_size, unsigned char **out, size_t *out_size);
+  /** decompress data. the output buffer is allocated by the codec */
+  int (*decompress) (const unsigned char *data, size_t data_size, unsigned char **out, size_t *out_size);
+} hio_manifest_codec_ops_t;
+
+/* bzip2 codec */
+
+static bool hioi_manifest_bzip2_detect (const unsigned char *data, size_t data_size) {
+  return data_size > 2 && 'B' == data[0] && 'Z' == data[1] && 'h' == data[2];
+}
+
+static int hioi_manifest_bzip2_compress (const unsigned char *data, size_t data_size, unsigned char **out,
+                                         size_t *out_size) {
+  /* bzip2 documents the worst case expansion as 1% + 600 bytes */
+  unsigned int compressed_size = data_size + data_size / 100 + 600;
+  unsigned char *tmp;
+  int rc;
+
+  tmp = malloc (compressed_size);
+  if (NULL == tmp) {
+    return HIO_ERR_OUT_OF_RESOURCE;
+  }
+
+  rc = BZ2_bzBuffToBuffCompress ((char *) tmp, &compressed_size, (char *) data, data_size, 3, 0, 0);
+  if (BZ_OK != rc) {
+    free (tmp);
+    return HIO_ERROR;
+  }
+
+  *out = realloc (tmp, compressed_size);
+  if (NULL == *out) {
+    *out = tmp;
+  }
+
+  *out_size = compressed_size;
+
+  return HIO_SUCCESS;
+}
+
+static int hioi_manifest_bzip2_decompress (const unsigned char *data, size_t data_size, unsigned char **out,
+                                           size_t *out_size) {
+  char *uncompressed, *tmp;
+  bz_stream strm;
+  size_t size;
+  int rc;
+
+  /* start with a guess of the compression ratio and double the buffer as needed */
+  size = 8 * data_size + 8192;
+  uncompressed = malloc (size);
+  if (NULL == uncompressed) {
+    return HIO_ERR_OUT_OF_RESOURCE;
+  }
+
+  strm.bzalloc = NULL;
+  strm.bzfree = NULL;
+  strm.opaque = NULL;
+  strm.next_in = (char *) data;
+  strm.avail_in = data_size;
+  strm.next_out = uncompressed;
+  strm.avail_out = size;
+
+  BZ2_bzDecompressInit (&strm, 0, 0);
+
+  do {
+    rc = BZ2_bzDecompress (&strm);
+    if (BZ_STREAM_END == rc) {
+      break;
+    }
+
+    if (BZ_OK != rc || (0 == strm.avail_in && 0 != strm.avail_out)) {
+      /* corrupt or truncated stream */
+      BZ2_bzDecompressEnd (&strm);
+      free (uncompressed);
+      return HIO_ERROR;
+    }
+
+    tmp = realloc (uncompressed, size * 2);
+    if (NULL == tmp) {
+      BZ2_bzDecompressEnd (&strm);
+      free (uncompressed);
+      return HIO_ERR_OUT_OF_RESOURCE;
+    }
+
+    uncompressed = tmp;
+    strm.next_out = uncompressed + size;
+    strm.avail_out = size;
+    size *= 2;
+  } while (1);
+
+  *out_size = size - strm.avail_out;
+  BZ2_bzDecompressEnd (&strm);
+
+  *out = (unsigned char *) uncompressed;
+
+  return HIO_SUCCESS;
+}
+
+/* lz codec */
+
+static inline void hioi_manifest_put_le (unsigned char *p, uint64_t value, int bytes) {
+  for (int i = 0 ; i < bytes ; ++i) {
+    p[i] = (unsigned char) (value >> (8 * i));
+  }
+}
+
+static inline uint64_t hioi_manifest_get_le (const unsigned char *p, int bytes) {
+  uint64_t value = 0;
+
+  for (int i = 0 ; i < bytes ; ++i) {
+    value |= (uint64_t) p[i] << (8 * i);
+  }
+
+  return value;
+}
+
+static bool hioi_manifest_lz_detect (const unsigned char *data, size_t data_size) {
+  return data_size >= HIO_MANIFEST_LZ_HEADER_SIZE && 0 == memcmp (data, HIO_MANIFEST_LZ_MAGIC, 4);
+}
+
+static int hioi_manifest_lz_compress (const unsigned char *data, size_t data_size, unsigned char **out,
+                                      size_t *out_size) {
+  size_t compressed_size = hioi_lz_compress_bound (data_size);
+  unsigned char *tmp;
+  int rc;
+
+  tmp = malloc (HIO_MANIFEST_LZ_HEADER_SIZE + compressed_size);
+  if (NULL == tmp) {
+    return HIO_ERR_OUT_OF_RESOURCE;
+  }
+
+  /* header: magic, 4 reserved bytes, uncompressed size (little endian) */
+  memcpy (tmp, HIO_MANIFEST_LZ_MAGIC, 4);
+  memset (tmp + 4, 0, 4);
+  hioi_manifest_put_le (tmp + 8, data_size, 8);
+
+  rc = hioi_lz_compress (data, data_size, tmp + HIO_MANIFEST_LZ_HEADER_SIZE, &compressed_size);
+  if (HIO_SUCCESS != rc) {
+    free (tmp);
+    return rc;
+  }
+
+  *out_size = HIO_MANIFEST_LZ_HEADER_SIZE + compressed_size;
+  *out = realloc (tmp, *out_size);
+  if (NULL == *out) {
+    *out = tmp;
+  }
+
+  return HIO_SUCCESS;
+}
+
+static int hioi_manifest_lz_decompress_framed (const unsigned char *data, size_t data_size, unsigned char *out,
+                                               size_t out_size) {
+  size_t offset = 0;
+  int rc;
+
+  while (data_size) {
+    uint64_t coded_size, raw_size;
+
+    if (data_size < HIO_MANIFEST_LZ_FRAME_HEADER_SIZE) {
+      return HIO_ERR_BAD_PARAM;
+    }
+
+    coded_size = hioi_manifest_get_le (data, 4);
+    raw_size = hioi_manifest_get_le (data + 4, 4);
+    data += HIO_MANIFEST_LZ_FRAME_HEADER_SIZE;
+    data_size -= HIO_MANIFEST_LZ_FRAME_HEADER_SIZE;
+
+    if (coded_size > data_size || raw_size > out_size - offset) {
+      return HIO_ERR_BAD_PARAM;
+    }
+
+    rc = hioi_lz_decompress (data, coded_size, out + offset, raw_size);
+    if (HIO_SUCCESS != rc) {
+      return rc;
+    }
+
+    data += coded_size;
+    data_size -= coded_size;
+    offset += raw_size;
+  }
+
+  return (offset == out_size) ? HIO_SUCCESS : HIO_ERR_BAD_PARAM;
+}
+
+static int hioi_manifest_lz_decompress (const unsigned char *data, size_t data_size, unsigned char **out,
+                                        size_t *out_size) {
+  uint64_t uncompressed_size;
+  unsigned char *tmp;
+  int rc;
+
+  uncompressed_size = hioi_manifest_get_le (data + 8, 8);
+
+  /* the lz format can not expand data by more than a factor of 255 */
+  if (uncompressed_size > (uint64_t) (data_size - HIO_MANIFEST_LZ_HEADER_SIZE) * 255) {
+    return HIO_ERR_BAD_PARAM;
+  }
+
+  tmp = malloc (uncompressed_size ? uncompressed_size : 1);
+  if (NULL == tmp) {
+    return HIO_ERR_OUT_OF_RESOURCE;
+  }
+
+  if (data[4] & HIO_MANIFEST_LZ_FLAG_FRAMED) {
+    rc = hioi_manifest_lz_decompress_framed (data + HIO_MANIFEST_LZ_HEADER_SIZE,
+                                             data_size - HIO_MANIFEST_LZ_HEADER_SIZE, tmp, uncompressed_size);
+  } else {
+    rc = hioi_lz_decompress (data + HIO_MANIFEST_LZ_HEADER_SIZE, data_size - HIO_MANIFEST_LZ_HEADER_SIZE, tmp,
+                             uncompressed_size);
+  }
+  if (HIO_SUCCESS != rc) {
+    free (tmp);
+    return rc;
+  }
+
+  *out = tmp;
+  *out_size = uncompressed_size;
+
+  return HIO_SUCCESS;
+}
+
+static const hio_manifest_codec_ops_t hioi_manifest_codecs[] = {
+  [HIO_MANIFEST_CODEC_NONE] = {.name = "none", .suffix = ""},
+  [HIO_MANIFEST_CODEC_BZIP2] = {.name = "bzip2", .suffix = ".bz2", .detect = hioi_manifest_bzip2_detect,
+                                .compress = hioi_manifest_bzip2_compress,
+                                .decompress = hioi_manifest_bzip2_decompress},
+  [HIO_MANIFEST_CODEC_LZ] = {.name = "lz", .suffix = ".hlz", .detect = hioi_manifest_lz_detect,
+                             .compress = hioi_manifest_lz_compress,
+                             .decompress = hioi_manifest_lz_decompress},
+};
+
+#define HIO_MANIFEST_CODEC_COUNT (int) (sizeof (hioi_manifest_codecs) / sizeof (hioi_manifest_codecs[0]))
+
+const char *hioi_manifest_codec_suffix (int codec) {
+  if (codec < 0 || codec >= HIO_MANIFEST_CODEC_COUNT) {
+    return "";
+  }
+
+  return hioi_manifest_codecs[codec].suffix;
+}
+
+int hioi_manifest_codec_detect (const unsigned char *data, size_t data_size) {
+  for (int i = 0 ; i < HIO_MANIFEST_CODEC_COUNT ; ++i) {
+    if (hioi_manifest_codecs[i].detect && hioi_manifest_codecs[i].detect (data, data_size)) {
+      return i;
+    }
+  }
+
+  return HIO_MANIFEST_CODEC_NONE;
+}
+
+static void hioi_manifest_codec_account (hio_manifest_codec_stats_t *stats, size_t raw_size, size_t coded_size,
+                                         uint64_t start) {
+  if (NULL != stats) {
+    stats->cs_raw_bytes += raw_size;
+    stats->cs_coded_bytes += coded_size;
+    stats->cs_time_usec += hioi_gettime () - start;
+  }
+}
+
+int hioi_manifest_compress (int codec, const unsigned char *data, size_t data_size, unsigned char **out,
+                            size_t *out_size, hio_manifest_codec_stats_t *stats) {
+  uint64_t start = hioi_gettime ();
+  int rc;
+
+  if (codec <= HIO_MANIFEST_CODEC_NONE || codec >= HIO_MANIFEST_CODEC_COUNT) {
+    return HIO_ERR_BAD_PARAM;
+  }
+
+  rc = hioi_manifest_codecs[codec].compress (data, data_size, out, out_size);
+  if (HIO_SUCCESS == rc) {
+    hioi_manifest_codec_account (stats, data_size, *out_size, start);
+  }
+
+  return rc;
+}
+
+int hioi_manifest_decompress (const unsigned char *data, size_t data_size, unsigned char **out, size_t *out_size,
+                              hio_manifest_codec_stats_t *stats) {
+  int codec = hioi_manifest_codec_detect (data, data_size);
+  uint64_t start = hioi_gettime ();
+  int rc;
+
+  if (HIO_MANIFEST_CODEC_NONE == codec) {
+    return HIO_ERR_BAD_PARAM;
+  }
+
+  rc = hioi_manifest_codecs[codec].decompress (data, data_size, out, out_size);
+  if (HIO_SUCCESS == rc) {
+    hioi_manifest_codec_account (stats, *out_size, data_size, start);
+  }
+
+  return rc;
+}
+
+/* streaming encoder */
+
+struct hio_manifest_encoder {
+  /** codec in use */
+  int codec;
+  /** output file */
+  int fd;
+  /** first error encountered */
+  int rc;
+  /** staging buffer for uncompressed data */
+  unsigned char *buffer;
+  /** bytes used in the staging buffer */
+  size_t buffer_used;
+  /** output buffer for compressed data */
+  unsigned char *out;
+  /** size of the output buffer */
+  size_t out_size;
+  /** bzip2 stream state */
+  bz_stream bz;
+  /** statistics */
+  hio_manifest_codec_stats_t stats, *stats_out;
+};
+
+static int hioi_manifest_encoder_emit (hio_manifest_encoder_t *encoder, const unsigned char *data, size_t data_size) {
+  encoder->stats.cs_coded_bytes += data_size;
+
+  while (data_size) {
+    ssize_t ret = write (encoder->fd, data, data_size);
+    if (0 > ret) {
+      if (EINTR == errno) {
+        continue;
+      }
+
+      return hioi_err_errno (errno);
+    }
+
+    data += ret;
+    data_size -= ret;
+  }
+
+  return HIO_SUCCESS;
+}
+
+static int hioi_manifest_encoder_flush (hio_manifest_encoder_t *encoder, const unsigned char *data, size_t data_size,
+                                        bool finish) {
+  uint64_t start = hioi_gettime ();
+  size_t coded_size;
+  int rc = HIO_SUCCESS, bzrc;
+
+  switch (encoder->codec) {
+  case HIO_MANIFEST_CODEC_BZIP2:
+    encoder->bz.next_in = (char *) data;
+    encoder->bz.avail_in = data_size;
+
+    /* keep going until bzip2 has consumed all of the input (and ended the stream on finish) */
+    do {
+      encoder->bz.next_out = (char *) encoder->out;
+      encoder->bz.avail_out = encoder->out_size;
+
+      bzrc = BZ2_bzCompress (&encoder->bz, finish ? BZ_FINISH : BZ_RUN);
+      if (bzrc < 0) {
+        return HIO_ERROR;
+      }
+
+      coded_size = encoder->out_size - encoder->bz.avail_out;
+      rc = hioi_manifest_encoder_emit (encoder, encoder->out, coded_size);
+      if (HIO_SUCCESS != rc) {
+        return rc;
+      }
+    } while (finish ? BZ_STREAM_END != bzrc : 0 != encoder->bz.avail_in);
+    break;
+  case HIO_MANIFEST_CODEC_LZ:
+    if (0 == data_size) {
+      break;
+    }
+
+    coded_size = encoder->out_size - HIO_MANIFEST_LZ_FRAME_HEADER_SIZE;
+    rc = hioi_lz_compress (data, data_size, encoder->out + HIO_MANIFEST_LZ_FRAME_HEADER_SIZE, &coded_size);
+    if (HIO_SUCCESS != rc) {
+      return rc;
+    }
+
+    hioi_manifest_put_le (encoder->out, coded_size, 4);
+    hioi_manifest_put_le (encoder->out + 4, data_size, 4);
+    rc = hioi_manifest_encoder_emit (encoder, encoder->out, HIO_MANIFEST_LZ_FRAME_HEADER_SIZE + coded_size);
+    break;
+  default:
+    return hioi_manifest_encoder_emit (encoder, data, data_size);
+  }
+
+  encoder->stats.cs_raw_bytes += data_size;
+  encoder->stats.cs_time_usec += hioi_gettime () - start;
+
+  return rc;
+}
+
+int hioi_manifest_encoder_open (int codec, int fd, hio_manifest_codec_stats_t *stats,
+                                hio_manifest_encoder_t **encoder_out) {
+  hio_manifest_encoder_t *encoder;
+  int rc = HIO_SUCCESS;
+
+  if (codec < 0 || codec >= HIO_MANIFEST_CODEC_COUNT) {
+    return HIO_ERR_BAD_PARAM;
+  }
+
+  encoder = calloc (1, sizeof (*encoder));
+  if (NULL == encoder) {
+    return HIO_ERR_OUT_OF_RESOURCE;
+  }
+
+  encoder->codec = codec;
+  encoder->fd = fd;
+  encoder->stats_out = stats;
+
+  if (HIO_MANIFEST_CODEC_NONE != codec) {
+    encoder->out_size = HIO_MANIFEST_LZ_FRAME_HEADER_SIZE + hioi_lz_compress_bound (HIO_MANIFEST_ENCODER_CHUNK_SIZE);
+    encoder->out = malloc (encoder->out_size);
+  }
+
+  encoder->buffer = malloc (HIO_MANIFEST_ENCODER_CHUNK_SIZE);
+  if (NULL == encoder->buffer || (HIO_MANIFEST_CODEC_NONE != codec && NULL == encoder->out)) {
+    free (encoder->buffer);
+    free (encoder->out);
+    free (encoder);
+    return HIO_ERR_OUT_OF_RESOURCE;
+  }
+
+  if (HIO_MANIFEST_CODEC_BZIP2 == codec) {
+    /* use the same block size as hioi_manifest_compress () */
+    if (BZ_OK != BZ2_bzCompressInit (&encoder->bz, 3, 0, 0)) {
+      rc = HIO_ERROR;
+    }
+  } else if (HIO_MANIFEST_CODEC_LZ == codec) {
+    unsigned char header[HIO_MANIFEST_LZ_HEADER_SIZE];
+
+    /* the uncompressed size is filled in by hioi_manifest_encoder_close () */
+    memcpy (header, HIO_MANIFEST_LZ_MAGIC, 4);
+    memset (header + 4, 0, sizeof (header) - 4);
+    header[4] = HIO_MANIFEST_LZ_FLAG_FRAMED;
+    rc = hioi_manifest_encoder_emit (encoder, header, sizeof (header));
+  }
+
+  if (HIO_SUCCESS != rc) {
+    free (encoder->buffer);
+    free (encoder->out);
+    free (encoder);
+    return rc;
+  }
+
+  *encoder_out = encoder;
+
+  return HIO_SUCCESS;
+}
+
+int hioi_manifest_encoder_write (hio_manifest_encoder_t *encoder, const void *data, size_t data_size) {
+  const unsigned char *bytes = (const unsigned char *) data;
+
+  while (HIO_SUCCESS == encoder->rc && data_size) {
+    size_t space = HIO_MANIFEST_ENCODER_CHUNK_SIZE - encoder->buffer_used;
+
+    if (0 == encoder->buffer_used && data_size >= HIO_MANIFEST_ENCODER_CHUNK_SIZE) {
+      /* encode directly from the caller's buffer */
+      size_t chunk = (HIO_MANIFEST_CODEC_NONE == encoder->codec) ? data_size : HIO_MANIFEST_ENCODER_CHUNK_SIZE;
+
+      encoder->rc = hioi_manifest_encoder_flush (encoder, bytes, chunk, false);
+      bytes += chunk;
+      data_size -= chunk;
+      continue;
+    }
+
+    if (space > data_size) {
+      space = data_size;
+    }
+
+    memcpy (encoder->buffer + encoder->buffer_used, bytes, space);
+    encoder->buffer_used += space;
+    bytes += space;
+    data_size -= space;
+
+    if (HIO_MANIFEST_ENCODER_CHUNK_SIZE == encoder->buffer_used) {
+      encoder->rc = hioi_manifest_encoder_flush (encoder, encoder->buffer, encoder->buffer_used, false);
+      encoder->buffer_used = 0;
+    }
+  }
+
+  return encoder->rc;
+}
+
+int hioi_manifest_encoder_close (hio_manifest_encoder_t *encoder) {
+  int rc = encoder->rc;
+
+  if (HIO_SUCCESS == rc) {
+    rc = hioi_manifest_encoder_flush (encoder, encoder->buffer, encoder->buffer_used, true);
+  }
+
+  if (HIO_SUCCESS == rc && HIO_MANIFEST_CODEC_LZ == encoder->codec) {
+    unsigned char raw_size[8];
+
+    hioi_manifest_put_le (raw_size, encoder->stats.cs_raw_bytes, 8);
+    if (sizeof (raw_size) != pwrite (encoder->fd, raw_size, sizeof (raw_size), 8)) {
+      rc = hioi_err_errno (errno);
+    }
+  }
+
+  if (HIO_MANIFEST_CODEC_BZIP2 == encoder->codec) {
+    BZ2_bzCompressEnd (&encoder->bz);
+  }
+
+  if (HIO_SUCCESS == rc && NULL != encoder->stats_out && HIO_MANIFEST_CODEC_NONE != encoder->codec) {
+    encoder->stats_out->cs_raw_bytes += encoder->stats.cs_raw_bytes;
+    encoder->stats_out->cs_coded_bytes += encoder->stats.cs_coded_bytes;
+    encoder->stats_out->cs_time_usec += encoder->stats.cs_time_usec;
+  }
+
+  free (encoder->buffer);
+  free (encoder->out);
+  free (encoder);
+
+  return rc;
+}
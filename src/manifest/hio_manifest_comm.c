@@ -1,6 +1,6 @@
 /* -*- Mode: C; c-basic-offset:2 ; indent-tabs-mode:nil -*- */
 /*
- * Copyright (c) 2014-2016 Los Alamos National Security, LLC.  All rights
+ * Copyright (c) 2014-2017 Los Alamos National Security, LLC.  All rights
  *                         reserved.
  * $COPYRIGHT$
  *
@@ -11,42 +11,47 @@
 
 #include "hio_manifest.h"
 
+#include <stdlib.h>
+
 #if HIO_MPI_HAVE(1)
-int hioi_manifest_gather_comm (hio_manifest_t *manifest_out, MPI_Comm comm) {
-  hio_context_t context = (*manifest_out)->context;
-  long int recv_size_left = 0, recv_size_right = 0, send_size, alloc_size;
-  int left, right, parent, c_rank, c_size = 1, rc, nreqs = 0;
-  unsigned char *remote_data;
-  hio_manifest_t manifest, manifest2;
-  MPI_Request reqs[2];
 
-  manifest = *manifest_out;
+int hioi_manifest_gather_comm (hio_context_t context, hio_manifest_t *manifest_out, MPI_Comm comm, int rc) {
+  long int recv_sizes[2] = {0, 0}, send_size = -1;
+  int children[2], parent = -1, c_rank = 0, c_size = 1, nreqs = 0, image_count = 1, ret, go;
+  unsigned char *images[3] = {NULL, NULL, NULL}, *merged;
+  size_t image_sizes[3] = {0, 0, 0}, merged_size;
+  hio_manifest_t manifest = *manifest_out;
+  MPI_Request reqs[2];
 
   if (hioi_context_using_mpi (context)) {
     MPI_Comm_size (comm, &c_size);
     MPI_Comm_rank (comm, &c_rank);
 
     parent = (c_rank - 1) >> 1;
-    left = c_rank * 2 + 1;
-    right = left + 1;
+    children[0] = c_rank * 2 + 1;
+    children[1] = children[0] + 1;
 
     /* the needs of this routine are a little more complicated than MPI_Reduce. the data size may
      * grow as the results are reduced. this function implements a basic reduction algorithm on
      * the hio dataset. prepost receives for child sizes. */
-
-    if (right < c_size) {
-      MPI_Irecv (&recv_size_right, 1, MPI_LONG, right, 1001, comm, reqs + 1);
-      ++nreqs;
-    }
-
-    if (left < c_size) {
-      MPI_Irecv (&recv_size_left, 1, MPI_LONG, left, 1001, comm, reqs);
-      ++nreqs;
+    for (int i = 0 ; i < 2 ; ++i) {
+      if (children[i] < c_size) {
+        MPI_Irecv (recv_sizes + i, 1, MPI_LONG, children[i], 1001, comm, reqs + nreqs++);
+      }
     }
   }
 
   if (1 == c_size) {
-    return HIO_SUCCESS;
+    return rc;
+  }
+
+  /* manifest data is reduced as packed binary records. segment runs from this rank and its
+   * children are merged directly without creating any json objects. if a json manifest is
+   * needed it is generated from the final image at the root. every rank takes part in the
+   * whole exchange even after a failure so no rank is left waiting on a message. a failed
+   * subtree is reported to the parent as a negative size and sends no data. */
+  if (HIO_SUCCESS == rc) {
+    rc = hioi_manifest_take_binary (manifest, images, image_sizes);
   }
 
   if (nreqs) {
@@ -54,68 +59,81 @@ int hioi_manifest_gather_comm (hio_manifest_t *manifest_out, MPI_Comm comm) {
 
     hioi_timed_call(MPI_Waitall (nreqs, reqs, MPI_STATUSES_IGNORE));
 
-    alloc_size = recv_size_right > recv_size_left ? recv_size_right : recv_size_left;
-    if (0 >= alloc_size) {
-      /* internal error for now */
-      return HIO_ERROR;
-    }
+    for (int i = 0 ; i < nreqs ; ++i) {
+      if (0 >= recv_sizes[i]) {
+        /* the child's subtree failed. nothing follows */
+        if (HIO_SUCCESS == rc) {
+          rc = HIO_ERROR;
+        }
+        continue;
+      }
 
-    remote_data = malloc (alloc_size);
-    if (NULL == remote_data) {
-      return HIO_ERR_OUT_OF_RESOURCE;
-    }
+      /* tell the child whether to send its data. it is not wanted if this subtree has
+       * already failed */
+      images[image_count] = (HIO_SUCCESS == rc) ? malloc (recv_sizes[i]) : NULL;
+      if (HIO_SUCCESS == rc && NULL == images[image_count]) {
+        rc = HIO_ERR_OUT_OF_RESOURCE;
+      }
 
-    if (right < c_size) {
-      hioi_log (context, HIO_VERBOSE_DEBUG_LOW, "receiving %lu bytes of manifest data from %d", recv_size_right,
-                right);
-      hioi_timed_call(MPI_Recv (remote_data, recv_size_right, MPI_CHAR, right, 1002, comm, MPI_STATUS_IGNORE));
-      hioi_log (context, HIO_VERBOSE_DEBUG_LOW, "merging manifest data from %d", right);
-      rc = hioi_manifest_deserialize (context, remote_data, recv_size_right, &manifest2);
-      if (HIO_SUCCESS != rc) {
-        return rc;
+      go = NULL != images[image_count];
+      MPI_Send (&go, 1, MPI_INT, children[i], 1003, comm);
+      if (!go) {
+        continue;
       }
 
-      hioi_timed_call(hioi_manifest_merge_data (manifest, manifest2));
-      hioi_manifest_release (manifest2);
+      hioi_log (context, HIO_VERBOSE_DEBUG_LOW, "receiving %lu bytes of manifest data from %d", recv_sizes[i],
+                children[i]);
+      hioi_timed_call(MPI_Recv (images[image_count], recv_sizes[i], MPI_CHAR, children[i], 1002, comm,
+                                MPI_STATUS_IGNORE));
+      image_sizes[image_count++] = recv_sizes[i];
     }
 
-    hioi_log (context, HIO_VERBOSE_DEBUG_LOW, "receiving %lu bytes of manifest data from %d", recv_size_left,
-              left);
-    hioi_timed_call(MPI_Recv (remote_data, recv_size_left, MPI_CHAR, left, 1002, comm, MPI_STATUS_IGNORE));
-    hioi_log (context, HIO_VERBOSE_DEBUG_LOW, "merging manifest data from %d", left);
+    if (HIO_SUCCESS == rc) {
+      hioi_log (context, HIO_VERBOSE_DEBUG_LOW, "merging manifest data from %d children", nreqs);
+      hioi_timed_call(rc = hioi_manifest_binary_merge ((const unsigned char **) images, image_sizes, image_count,
+                                                       &merged, &merged_size));
+    }
 
-    rc = hioi_manifest_deserialize (context, remote_data, recv_size_left, &manifest2);
-    if (HIO_SUCCESS != rc) {
-      return rc;
+    for (int i = 1 ; i < image_count ; ++i) {
+      free (images[i]);
     }
 
-    hioi_timed_call(hioi_manifest_merge_data (manifest, manifest2));
-    hioi_manifest_release (manifest2);
-    free (remote_data);
+    if (HIO_SUCCESS == rc) {
+      free (images[0]);
+      images[0] = merged;
+      image_sizes[0] = merged_size;
+    }
   }
 
   if (parent >= 0) {
-    unsigned char *my_data;
-    size_t my_data_size;
-
-    rc = hioi_manifest_serialize (manifest, &my_data, &my_data_size, false);
-    if (HIO_SUCCESS != rc) {
-      return rc;
+    if (HIO_SUCCESS == rc) {
+      send_size = image_sizes[0];
     }
 
-    send_size = my_data_size;
-    hioi_log (context, HIO_VERBOSE_DEBUG_LOW, "sending %lu bytes of manifest data from %d to %d", send_size,
+    hioi_log (context, HIO_VERBOSE_DEBUG_LOW, "sending %ld bytes of manifest data from %d to %d", send_size,
               c_rank, parent);
 
     MPI_Ssend (&send_size, 1, MPI_LONG, parent, 1001, comm);
-    MPI_Send (my_data, send_size, MPI_CHAR, parent, 1002, comm);
+    if (0 < send_size) {
+      MPI_Recv (&go, 1, MPI_INT, parent, 1003, comm, MPI_STATUS_IGNORE);
+      if (go) {
+        MPI_Send (images[0], send_size, MPI_CHAR, parent, 1002, comm);
+      }
+    }
 
-    free (my_data);
+    free (images[0]);
+  } else if (HIO_SUCCESS == rc) {
+    /* the root's manifest is now backed by the merged image */
+    hioi_manifest_set_binary (manifest, images[0], image_sizes[0]);
   } else {
-    *manifest_out = manifest;
+    free (images[0]);
   }
 
-  return HIO_SUCCESS;
+  /* the result is only known at the root after the reduction. make sure every rank agrees */
+  ret = rc;
+  MPI_Allreduce (&ret, &rc, 1, MPI_INT, MPI_MIN, comm);
+
+  return rc;
 }
 
 #endif /* HIO_MPI_HAVE(1) */
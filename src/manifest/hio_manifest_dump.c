@@ -37,6 +37,7 @@ static struct hioi_key_mapping_t hioi_key_mapping[] = {
   {.key = HIO_SEGMENT_KEY_APP_OFFSET0, .value = "Offset"},
   {.key = HIO_SEGMENT_KEY_LENGTH, .value = "Length"},
   {.key = HIO_SEGMENT_KEY_FILE_INDEX, .value = "File index"},
+  {.key = HIO_SEGMENT_KEY_CHECKSUM, .value = "Checksum"},
   {.key = NULL},
 };
 
@@ -159,5 +160,11 @@ int hioi_manifest_dump_file (hio_context_t context, const char *path, uint32_t f
 }
 
 int hioi_manifest_dump (hio_manifest_t manifest, uint32_t flags, int rank, FILE *fh) {
-  return hioi_manifest_dump_2_0 (manifest->context, manifest->json_object, flags, rank, fh);
+  json_object *object = hioi_manifest_get_json (manifest);
+
+  if (NULL == object) {
+    return HIO_ERR_BAD_PARAM;
+  }
+
+  return hioi_manifest_dump_2_0 (manifest->context, object, flags, rank, fh);
 }
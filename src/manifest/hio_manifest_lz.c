@@ -0,0 +1,247 @@
+/* -*- Mode: C; c-basic-offset:2 ; indent-tabs-mode:nil -*- */
+/*
+ * Copyright (c) 2017      Los Alamos National Security, LLC.  All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/**
+ * @file hio_manifest_lz.c
+ * @brief Fast LZ77 codec for manifest data
+ *
+ * This is a small single-pass LZ77 compressor that emits the LZ4 block format
+ * (token, literal run, 16-bit little-endian offset, match run). It trades
+ * compression ratio for speed: manifests (which are mostly repeated json keys
+ * and monotonic offsets) compress several times faster than with bzip2 and
+ * decompress at memory bandwidth. Because the block format is the same as LZ4
+ * the payload can be decoded by liblz4 (LZ4_decompress_safe) if needed.
+ *
+ * The block format has no framing. The caller is responsible for recording the
+ * uncompressed size (see hio_manifest_codec.c).
+ */
+
+#include "hio_manifest.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define HIO_LZ_HASH_BITS    14
+#define HIO_LZ_MIN_MATCH    4
+#define HIO_LZ_MAX_OFFSET   65535
+/* the last match must start at least 12 bytes before the end of the input */
+#define HIO_LZ_MF_LIMIT     12
+/* the last 5 bytes of the input are always literals */
+#define HIO_LZ_LAST_LITERALS 5
+
+static inline uint32_t hioi_lz_read32 (const unsigned char *p) {
+  uint32_t value;
+  memcpy (&value, p, sizeof (value));
+  return value;
+}
+
+static inline uint32_t hioi_lz_hash (uint32_t value) {
+  return (value * 2654435761u) >> (32 - HIO_LZ_HASH_BITS);
+}
+
+static inline unsigned char *hioi_lz_write_length (unsigned char *op, size_t length) {
+  while (length >= 255) {
+    *op++ = 255;
+    length -= 255;
+  }
+
+  *op++ = (unsigned char) length;
+
+  return op;
+}
+
+/**
+ * @brief Copy a match to the output
+ *
+ * A match that starts at least length bytes back does not overlap and is copied
+ * with a single memcpy. An overlapping match repeats the last offset bytes of the
+ * output. The pattern is first doubled until it is at least 8 bytes long and the
+ * rest is copied in 8-byte chunks.
+ */
+static inline void hioi_lz_copy_match (unsigned char *op, const unsigned char *match, size_t length) {
+  size_t chunk;
+
+  if ((size_t) (op - match) >= length) {
+    memcpy (op, match, length);
+    return;
+  }
+
+  /* op - match stays a multiple of the original offset so the copy source is always
+   * an earlier repetition of the pattern */
+  while ((size_t) (op - match) < 8 && length) {
+    chunk = op - match;
+    chunk = (chunk < length) ? chunk : length;
+    memcpy (op, match, chunk);
+    op += chunk;
+    length -= chunk;
+  }
+
+  for ( ; length >= 8 ; length -= 8, op += 8, match += 8) {
+    memcpy (op, match, 8);
+  }
+
+  while (length--) {
+    *op++ = *match++;
+  }
+}
+
+size_t hioi_lz_compress_bound (size_t size) {
+  return size + size / 255 + 16;
+}
+
+int hioi_lz_compress (const unsigned char *src, size_t src_size, unsigned char *dst, size_t *dst_size) {
+  const unsigned char *ip = src, *anchor = src, *iend = src + src_size;
+  const unsigned char *mflimit = iend - HIO_LZ_MF_LIMIT, *matchlimit = iend - HIO_LZ_LAST_LITERALS;
+  unsigned char *op = dst, *token;
+  size_t literals;
+  uint32_t *table;
+
+  if (*dst_size < hioi_lz_compress_bound (src_size)) {
+    return HIO_ERR_BAD_PARAM;
+  }
+
+  table = calloc (1 << HIO_LZ_HASH_BITS, sizeof (*table));
+  if (NULL == table) {
+    return HIO_ERR_OUT_OF_RESOURCE;
+  }
+
+  if (src_size > HIO_LZ_MF_LIMIT) {
+    while (ip < mflimit) {
+      uint32_t value = hioi_lz_read32 (ip), hash = hioi_lz_hash (value);
+      const unsigned char *ref = src + table[hash];
+      size_t match_length;
+
+      table[hash] = (uint32_t) (ip - src);
+
+      if (ref >= ip || ip - ref > HIO_LZ_MAX_OFFSET || hioi_lz_read32 (ref) != value) {
+        ++ip;
+        continue;
+      }
+
+      /* extend the match forward */
+      match_length = HIO_LZ_MIN_MATCH;
+      while (ip + match_length < matchlimit && ref[match_length] == ip[match_length]) {
+        ++match_length;
+      }
+
+      /* emit the sequence: token, literal run, offset, match run */
+      literals = ip - anchor;
+      token = op++;
+      if (literals >= 15) {
+        *token = 15 << 4;
+        op = hioi_lz_write_length (op, literals - 15);
+      } else {
+        *token = (unsigned char) (literals << 4);
+      }
+
+      memcpy (op, anchor, literals);
+      op += literals;
+
+      *op++ = (unsigned char) ((ip - ref) & 0xff);
+      *op++ = (unsigned char) ((ip - ref) >> 8);
+
+      if (match_length - HIO_LZ_MIN_MATCH >= 15) {
+        *token |= 15;
+        op = hioi_lz_write_length (op, match_length - HIO_LZ_MIN_MATCH - 15);
+      } else {
+        *token |= (unsigned char) (match_length - HIO_LZ_MIN_MATCH);
+      }
+
+      ip += match_length;
+      anchor = ip;
+    }
+  }
+
+  /* last literal run */
+  literals = iend - anchor;
+  token = op++;
+  if (literals >= 15) {
+    *token = 15 << 4;
+    op = hioi_lz_write_length (op, literals - 15);
+  } else {
+    *token = (unsigned char) (literals << 4);
+  }
+
+  memcpy (op, anchor, literals);
+  op += literals;
+
+  free (table);
+
+  *dst_size = op - dst;
+
+  return HIO_SUCCESS;
+}
+
+int hioi_lz_decompress (const unsigned char *src, size_t src_size, unsigned char *dst, size_t dst_size) {
+  const unsigned char *ip = src, *iend = src + src_size;
+  unsigned char *op = dst, *oend = dst + dst_size;
+
+  while (ip < iend) {
+    unsigned token = *ip++;
+    size_t length = token >> 4, offset;
+
+    if (15 == length) {
+      unsigned char byte;
+      do {
+        if (ip >= iend) {
+          return HIO_ERR_BAD_PARAM;
+        }
+        byte = *ip++;
+        length += byte;
+      } while (255 == byte);
+    }
+
+    if ((size_t) (iend - ip) < length || (size_t) (oend - op) < length) {
+      return HIO_ERR_BAD_PARAM;
+    }
+
+    memcpy (op, ip, length);
+    ip += length;
+    op += length;
+
+    if (ip == iend) {
+      /* the last sequence only has literals */
+      break;
+    }
+
+    if (iend - ip < 2) {
+      return HIO_ERR_BAD_PARAM;
+    }
+
+    offset = ip[0] | ((size_t) ip[1] << 8);
+    ip += 2;
+    if (0 == offset || offset > (size_t) (op - dst)) {
+      return HIO_ERR_BAD_PARAM;
+    }
+
+    length = token & 15;
+    if (15 == length) {
+      unsigned char byte;
+      do {
+        if (ip >= iend) {
+          return HIO_ERR_BAD_PARAM;
+        }
+        byte = *ip++;
+        length += byte;
+      } while (255 == byte);
+    }
+
+    length += HIO_LZ_MIN_MATCH;
+    if ((size_t) (oend - op) < length) {
+      return HIO_ERR_BAD_PARAM;
+    }
+
+    hioi_lz_copy_match (op, op - offset, length);
+    op += length;
+  }
+
+  return (op == oend) ? HIO_SUCCESS : HIO_ERR_BAD_PARAM;
+}
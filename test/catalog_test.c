@@ -0,0 +1,214 @@
+/* -*- Mode: C; c-basic-offset:2 ; indent-tabs-mode:nil -*- */
+/*
+ * Copyright (c) 2017      Los Alamos National Security, LLC.  All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/* Dataset catalog test. Writes several ids of a dataset and checks that the catalog
+ * kept in the dataset name directory lists them once the ids have been listed, that
+ * closing and unlinking a dataset keep it up to date, and that HIO_DATASET_ID_HIGHEST
+ * and HIO_DATASET_ID_NEWEST resolve to the right id when the catalog is current,
+ * missing, corrupt, or when the directory holds an incomplete dataset. Requires a
+ * single posix data root. */
+
+#include "test_support.h"
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* catalog layout: 8 byte magic, 32-bit version, 32-bit record size, 64-bit record
+ * count, then fixed-size records that start with the 64-bit dataset id */
+#define TEST_CATALOG_HEADER_SIZE 24
+#define TEST_CATALOG_MAX_IDS     16
+
+static char catalog_path[1024];
+
+/* read the ids in the catalog. returns the number of ids or -1 if the catalog is
+ * missing or invalid */
+static int catalog_ids (int64_t *ids) {
+  unsigned char header[TEST_CATALOG_HEADER_SIZE];
+  uint32_t record_size;
+  uint64_t count;
+  FILE *fh;
+
+  fh = fopen (catalog_path, "r");
+  if (NULL == fh) {
+    return -1;
+  }
+
+  if (1 != fread (header, sizeof (header), 1, fh) || memcmp (header, "HIOCATLG", 8)) {
+    fclose (fh);
+    return -1;
+  }
+
+  memcpy (&record_size, header + 12, sizeof (record_size));
+  memcpy (&count, header + 16, sizeof (count));
+
+  if (count > TEST_CATALOG_MAX_IDS || record_size < sizeof (int64_t)) {
+    fclose (fh);
+    return -1;
+  }
+
+  for (uint64_t i = 0 ; i < count ; ++i) {
+    if (0 != fseek (fh, TEST_CATALOG_HEADER_SIZE + i * record_size, SEEK_SET) ||
+        1 != fread (ids + i, sizeof (ids[0]), 1, fh)) {
+      fclose (fh);
+      return -1;
+    }
+  }
+
+  fclose (fh);
+
+  return (int) count;
+}
+
+/* check that the catalog holds exactly the given ids (in order) */
+static int check_catalog (const char *when, const int64_t *expected, int expected_count) {
+  int64_t ids[TEST_CATALOG_MAX_IDS];
+  int count;
+
+  if (0 != test_rank) {
+    return 0;
+  }
+
+  count = catalog_ids (ids);
+  if (count != expected_count || (count > 0 && memcmp (ids, expected, count * sizeof (ids[0])))) {
+    fprintf (stderr, "%d: catalog has %d ids %s. expected %d\n", test_rank, count, when, expected_count);
+    for (int i = 0 ; i < count ; ++i) {
+      fprintf (stderr, "%d:   id %ld\n", test_rank, (long) ids[i]);
+    }
+    return 1;
+  }
+
+  return 0;
+}
+
+static int write_id (hio_context_t context, int64_t id) {
+  hio_dataset_t dataset;
+  int errors;
+
+  if (HIO_SUCCESS != test_dataset_open (context, &dataset, "catalog", id, HIO_FLAG_CREAT | HIO_FLAG_WRITE |
+                                        HIO_FLAG_TRUNC, HIO_SET_ELEMENT_UNIQUE, NULL)) {
+    return 1;
+  }
+
+  errors = test_element_write (dataset, "element", id, 0, 1024);
+  test_dataset_close (&dataset);
+
+  return errors;
+}
+
+/* open the dataset with a special id and check which id was opened */
+static int check_open (hio_context_t context, int64_t special, int64_t expected, const char *when) {
+  const char *which = (HIO_DATASET_ID_HIGHEST == special) ? "highest" : "newest";
+  hio_dataset_t dataset;
+  int64_t id = -1;
+  int errors = 0;
+
+  if (HIO_SUCCESS != test_dataset_open (context, &dataset, "catalog", special, HIO_FLAG_READ,
+                                        HIO_SET_ELEMENT_UNIQUE, NULL)) {
+    fprintf (stderr, "%d: could not open the %s dataset %s\n", test_rank, which, when);
+    return 1;
+  }
+
+  hio_dataset_get_id (dataset, &id);
+  if (expected != id) {
+    fprintf (stderr, "%d: %s dataset %s is %ld. expected %ld\n", test_rank, which, when, (long) id,
+             (long) expected);
+    ++errors;
+  } else {
+    errors += test_element_check (dataset, "element", id, 0, 1024);
+  }
+
+  test_dataset_close (&dataset);
+
+  return errors;
+}
+
+int main (int argc, char *argv[]) {
+  const int64_t all_ids[] = {1, 2, 3, 4}, some_ids[] = {1, 2, 3};
+  char root[512], incomplete[1100];
+  hio_context_t context;
+  int errors = 0;
+
+  if (HIO_SUCCESS != test_init (&argc, &argv, "catalog_test", &context)) {
+    return EXIT_FAILURE;
+  }
+
+  if (!test_posix_root (context, root, sizeof (root))) {
+    return test_skip (&context, "catalog_test", "requires a single posix data root");
+  }
+
+  snprintf (catalog_path, sizeof (catalog_path), "%s/catalog_test.hio/catalog/.catalog", root);
+  snprintf (incomplete, sizeof (incomplete), "%s/catalog_test.hio/catalog/9", root);
+
+  for (int64_t id = 1 ; id <= 4 ; ++id) {
+    errors += write_id (context, id);
+  }
+
+  /* the catalog is created the first time the ids are listed */
+  errors += check_open (context, HIO_DATASET_ID_HIGHEST, 4, "after writing");
+  errors += check_catalog ("after writing", all_ids, 4);
+  errors += check_open (context, HIO_DATASET_ID_NEWEST, 4, "after writing");
+
+  /* closing a dataset updates its record. mtime has a resolution of one second */
+  sleep (2);
+  errors += write_id (context, 2);
+  errors += check_catalog ("after rewriting id 2", all_ids, 4);
+  errors += check_open (context, HIO_DATASET_ID_NEWEST, 2, "after rewriting id 2");
+  errors += check_open (context, HIO_DATASET_ID_HIGHEST, 4, "after rewriting id 2");
+
+  /* unlinking a dataset removes it from the catalog */
+  test_barrier ();
+  if (0 == test_rank) {
+    hio_dataset_unlink (context, "catalog", 4, HIO_UNLINK_MODE_FIRST);
+  }
+  test_barrier ();
+  errors += check_catalog ("after unlinking id 4", some_ids, 3);
+  errors += check_open (context, HIO_DATASET_ID_HIGHEST, 3, "after unlinking id 4");
+
+  /* a missing catalog is rebuilt from the dataset directories */
+  if (0 == test_rank) {
+    unlink (catalog_path);
+  }
+  test_barrier ();
+  errors += check_open (context, HIO_DATASET_ID_NEWEST, 2, "without a catalog");
+  errors += check_catalog ("after rebuilding a missing catalog", some_ids, 3);
+
+  /* so is a corrupt one */
+  test_barrier ();
+  if (0 == test_rank) {
+    FILE *fh = fopen (catalog_path, "w");
+    if (NULL != fh) {
+      fprintf (fh, "not a catalog");
+      fclose (fh);
+    }
+  }
+  test_barrier ();
+  errors += check_open (context, HIO_DATASET_ID_HIGHEST, 3, "with a corrupt catalog");
+  errors += check_catalog ("after rebuilding a corrupt catalog", some_ids, 3);
+
+  /* a dataset directory without a manifest is never added to the catalog */
+  test_barrier ();
+  if (0 == test_rank) {
+    mkdir (incomplete, 0755);
+  }
+  test_barrier ();
+  errors += check_open (context, HIO_DATASET_ID_NEWEST, 2, "with an incomplete dataset");
+  errors += check_catalog ("with an incomplete dataset", some_ids, 3);
+
+  test_barrier ();
+  if (0 == test_rank) {
+    rmdir (incomplete);
+    for (int64_t id = 1 ; id <= 3 ; ++id) {
+      hio_dataset_unlink (context, "catalog", id, HIO_UNLINK_MODE_FIRST);
+    }
+  }
+
+  return test_fini (&context, "catalog_test", errors);
+}
@@ -0,0 +1,187 @@
+/* -*- Mode: C; c-basic-offset:2 ; indent-tabs-mode:nil -*- */
+/*
+ * Copyright (c) 2017      Los Alamos National Security, LLC.  All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/* Checkpoint recommendation test. Checks that a dataset that has not been written is
+ * recommended immediately, that writing a dataset records its bandwidth, that no
+ * checkpoint is recommended before the interval computed from the interrupt rates has
+ * elapsed, that one is recommended after it has, and that none is recommended past the
+ * job end time. Also checks that the recorded bandwidth is stored correctly in the json
+ * manifest of the next dataset. */
+
+#include "test_support.h"
+#include "hio_manifest.h"
+
+#include <unistd.h>
+
+#define TEST_DATA_SIZE (1 << 20)
+
+static int write_dataset (hio_context_t context, int64_t id) {
+  hio_dataset_t dataset;
+  int errors;
+
+  if (HIO_SUCCESS != test_dataset_open (context, &dataset, "checkpoint", id, HIO_FLAG_CREAT | HIO_FLAG_WRITE |
+                                        HIO_FLAG_TRUNC, HIO_SET_ELEMENT_UNIQUE, NULL)) {
+    return 1;
+  }
+
+  errors = test_element_write (dataset, "element", id, 0, TEST_DATA_SIZE);
+  test_dataset_close (&dataset);
+
+  return errors;
+}
+
+static int check_recommendation (hio_context_t context, hio_recommendation_t expected, const char *when) {
+  hio_recommendation_t recommendation;
+  int hint = -1, errors = 0;
+
+  recommendation = hio_dataset_should_checkpoint (context, "checkpoint");
+  if (expected != recommendation) {
+    fprintf (stderr, "%d: dataset recommendation %s is %d. expected %d\n", test_rank, when, recommendation,
+             expected);
+    ++errors;
+  }
+
+  if (HIO_SUCCESS != hio_should_checkpoint (context, &hint) || (int) expected != hint) {
+    fprintf (stderr, "%d: context recommendation %s is %d. expected %d\n", test_rank, when, hint, expected);
+    ++errors;
+  }
+
+  return errors;
+}
+
+/* bandwidth recorded for the dataset. only rank 0 keeps the write model */
+static double write_bandwidth (hio_context_t context) {
+  hio_dataset_t dataset;
+  double bandwidth = 0.0;
+
+  if (HIO_SUCCESS != test_dataset_open (context, &dataset, "checkpoint", 1, HIO_FLAG_READ,
+                                        HIO_SET_ELEMENT_UNIQUE, NULL)) {
+    return -1.0;
+  }
+
+  (void) hio_perf_get_value (&dataset->ds_object, "dataset_write_bandwidth", &bandwidth, sizeof (bandwidth));
+  test_dataset_close (&dataset);
+
+  return bandwidth;
+}
+
+/* check the bandwidth stored in a manifest. the streaming writer prints variables with
+ * six decimal places */
+static int check_bandwidth (hio_manifest_t manifest, double bandwidth, const char *which) {
+  json_object *object, *perf, *value;
+  double saved;
+
+  object = hioi_manifest_get_json (manifest);
+  if (NULL == object || !json_object_object_get_ex (object, HIO_MANIFEST_KEY_PERF, &perf) ||
+      !json_object_object_get_ex (perf, "dataset_write_bandwidth", &value)) {
+    fprintf (stderr, "%d: dataset_write_bandwidth missing from the %s manifest\n", test_rank, which);
+    return 1;
+  }
+
+  saved = json_object_get_double (value);
+  if (saved < bandwidth * 0.9999 || saved > bandwidth * 1.0001) {
+    fprintf (stderr, "%d: dataset_write_bandwidth in the %s manifest is %g. expected %g\n", test_rank, which,
+             saved, bandwidth);
+    return 1;
+  }
+
+  return 0;
+}
+
+/* check the bandwidth in the json manifest of a new dataset both in memory and saved */
+static int check_manifest (hio_context_t context, double bandwidth) {
+  hio_manifest_t manifest;
+  hio_dataset_t dataset;
+  char path[256];
+  int rc, errors = 0;
+
+  if (HIO_SUCCESS != test_dataset_open (context, &dataset, "checkpoint", 2, HIO_FLAG_CREAT | HIO_FLAG_WRITE |
+                                        HIO_FLAG_TRUNC, HIO_SET_ELEMENT_UNIQUE, NULL)) {
+    return 1;
+  }
+
+  if (0 == test_rank) {
+    rc = hioi_manifest_generate (dataset, true, &manifest);
+    if (HIO_SUCCESS != rc) {
+      fprintf (stderr, "%d: could not generate the dataset manifest. rc: %d\n", test_rank, rc);
+      ++errors;
+    } else {
+      errors += check_bandwidth (manifest, bandwidth, "generated");
+      hioi_manifest_release (manifest);
+    }
+
+    snprintf (path, sizeof (path), "checkpoint_test.tmp.%d", test_rank);
+
+    rc = hioi_manifest_save_dataset (dataset, HIO_MANIFEST_FORMAT_JSON, HIO_MANIFEST_CODEC_NONE, path, NULL);
+    if (HIO_SUCCESS == rc) {
+      rc = hioi_manifest_read (context, path, &manifest);
+      unlink (path);
+    }
+
+    if (HIO_SUCCESS != rc) {
+      fprintf (stderr, "%d: could not save the dataset manifest. rc: %d\n", test_rank, rc);
+      ++errors;
+    } else {
+      errors += check_bandwidth (manifest, bandwidth, "saved");
+      hioi_manifest_release (manifest);
+    }
+  }
+
+  test_dataset_close (&dataset);
+
+  return errors;
+}
+
+int main (int argc, char *argv[]) {
+  hio_context_t context;
+  char end_time[32];
+  double bandwidth;
+  int errors = 0;
+
+  if (HIO_SUCCESS != test_init (&argc, &argv, "checkpoint_test", &context)) {
+    return EXIT_FAILURE;
+  }
+
+  /* nothing has been written so there is no measurement of the write time */
+  errors += check_recommendation (context, HIO_SCP_MUST_CHECKPOINT, "before writing");
+
+  errors += write_dataset (context, 1);
+
+  bandwidth = write_bandwidth (context);
+  if (0 == test_rank && !(bandwidth > 0.0)) {
+    fprintf (stderr, "%d: dataset_write_bandwidth is %g after writing\n", test_rank, bandwidth);
+    ++errors;
+  }
+
+  /* the default interrupt rates give an interval of hours */
+  errors += check_recommendation (context, HIO_SCP_NOT_NOW, "after writing");
+
+  /* a mean time to interrupt of one second */
+  hio_config_set_value (&context->c_object, "job_sys_int_rate", "3600000000000");
+  sleep (2);
+  errors += check_recommendation (context, HIO_SCP_MUST_CHECKPOINT, "after the interval");
+
+  /* never past the end of the job */
+  snprintf (end_time, sizeof (end_time), "%lu", (unsigned long) time (NULL) - 10);
+  hio_config_set_value (&context->c_object, "end_time", end_time);
+  errors += check_recommendation (context, HIO_SCP_NOT_NOW, "past the end time");
+  hio_config_set_value (&context->c_object, "end_time", "0");
+
+  errors += check_manifest (context, bandwidth);
+
+  test_barrier ();
+  if (0 == test_rank) {
+    hio_dataset_unlink (context, "checkpoint", 1, HIO_UNLINK_MODE_FIRST);
+    hio_dataset_unlink (context, "checkpoint", 2, HIO_UNLINK_MODE_FIRST);
+  }
+
+  return test_fini (&context, "checkpoint_test", errors);
+}
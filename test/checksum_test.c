@@ -0,0 +1,207 @@
+/* -*- Mode: C; c-basic-offset:2 ; indent-tabs-mode:nil -*- */
+/*
+ * Copyright (c) 2017      Los Alamos National Security, LLC.  All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/* Data checksum test. Writes a dataset with dataset_data_checksum enabled and checks
+ * that clean reads are verified, then corrupts the data file behind the library's back
+ * and checks that whole-segment reads fail and are counted in checksum_error_count.
+ * Requires a single posix data root. */
+
+#include "test_support.h"
+
+#include <unistd.h>
+#include <fcntl.h>
+
+#define TEST_BLOCK_COUNT 16
+#define TEST_BLOCK_SIZE  65536
+
+static int write_dataset (hio_context_t context, const char *format, const unsigned char *data) {
+  hio_dataset_t dataset;
+  hio_element_t element;
+  int rc, errors = 0;
+
+  rc = test_dataset_open (context, &dataset, format, 1, HIO_FLAG_CREAT | HIO_FLAG_WRITE | HIO_FLAG_TRUNC,
+                          HIO_SET_ELEMENT_UNIQUE, "dataset_file_mode", "file_per_node",
+                          "dataset_manifest_format", format, "dataset_data_checksum", "true", NULL);
+  if (HIO_SUCCESS != rc) {
+    return 1;
+  }
+
+  /* blocks are written out of order so the element has several segments */
+  hio_element_open (dataset, &element, "element", HIO_FLAG_WRITE | HIO_FLAG_CREAT);
+  for (int k = 0 ; k < TEST_BLOCK_COUNT ; ++k) {
+    int i = (k * 7) % TEST_BLOCK_COUNT;
+
+    if (TEST_BLOCK_SIZE != hio_element_write (element, (off_t) i * TEST_BLOCK_SIZE, 0, data + i * TEST_BLOCK_SIZE,
+                                              1, TEST_BLOCK_SIZE)) {
+      fprintf (stderr, "%d: error writing block %d of %s dataset\n", test_rank, i, format);
+      ++errors;
+    }
+  }
+  hio_element_close (&element);
+
+  if (TEST_BLOCK_COUNT * TEST_BLOCK_SIZE != test_perf_value (&dataset->ds_object, "checksum_bytes")) {
+    fprintf (stderr, "%d: %s dataset checksummed %lu bytes on write\n", test_rank, format,
+             (unsigned long) test_perf_value (&dataset->ds_object, "checksum_bytes"));
+    ++errors;
+  }
+
+  test_dataset_close (&dataset);
+
+  return errors;
+}
+
+/* read the element back with one blocking read and one request per block. returns the
+ * number of reads that failed */
+static int read_dataset (hio_context_t context, const char *format, unsigned char *out, uint64_t *verified,
+                         uint64_t *mismatches) {
+  hio_request_t requests[TEST_BLOCK_COUNT];
+  ssize_t transferred[TEST_BLOCK_COUNT];
+  hio_dataset_t dataset;
+  hio_element_t element;
+  int rc, failures = 0;
+  ssize_t count;
+
+  rc = test_dataset_open (context, &dataset, format, 1, HIO_FLAG_READ, HIO_SET_ELEMENT_UNIQUE, NULL);
+  if (HIO_SUCCESS != rc) {
+    return -1;
+  }
+
+  hio_element_open (dataset, &element, "element", HIO_FLAG_READ);
+
+  memset (out, 0, TEST_BLOCK_COUNT * TEST_BLOCK_SIZE);
+  count = hio_element_read (element, 0, 0, out, 1, TEST_BLOCK_COUNT * TEST_BLOCK_SIZE);
+  if (TEST_BLOCK_COUNT * TEST_BLOCK_SIZE != count) {
+    ++failures;
+    if (HIO_ERR_IO_PERMANENT != count) {
+      fprintf (stderr, "%d: read of %s dataset returned %ld\n", test_rank, format, (long) count);
+    }
+  }
+
+  for (int i = 0 ; i < TEST_BLOCK_COUNT ; ++i) {
+    requests[i] = HIO_OBJECT_NULL;
+    hio_element_read_nb (element, requests + i, (off_t) i * TEST_BLOCK_SIZE, 0, out + i * TEST_BLOCK_SIZE, 1,
+                         TEST_BLOCK_SIZE);
+  }
+
+  (void) hio_request_wait (requests, TEST_BLOCK_COUNT, transferred);
+  for (int i = 0 ; i < TEST_BLOCK_COUNT ; ++i) {
+    failures += TEST_BLOCK_SIZE != transferred[i];
+  }
+
+  hio_element_close (&element);
+
+  *verified = test_perf_value (&dataset->ds_object, "checksum_bytes");
+  *mismatches = test_perf_value (&dataset->ds_object, "checksum_error_count");
+
+  test_dataset_close (&dataset);
+
+  return failures;
+}
+
+/* flip a byte in every half block of the node's data file */
+static int corrupt_data (const char *root, const char *format) {
+  unsigned char c;
+  char path[1024];
+  off_t size;
+  int fd;
+
+  snprintf (path, sizeof (path), "%s/checksum_test.hio/%s/1/data/data.0", root, format);
+  fd = open (path, O_RDWR);
+  if (0 > fd) {
+    fprintf (stderr, "%d: could not open data file %s\n", test_rank, path);
+    return 1;
+  }
+
+  size = lseek (fd, 0, SEEK_END);
+  for (off_t offset = 100 ; offset < size ; offset += TEST_BLOCK_SIZE / 2) {
+    if (1 != pread (fd, &c, 1, offset)) {
+      break;
+    }
+    c ^= 0x5a;
+    (void) pwrite (fd, &c, 1, offset);
+  }
+
+  close (fd);
+
+  return 0;
+}
+
+static int test_format (hio_context_t context, const char *root, const char *format, const unsigned char *data,
+                        unsigned char *out) {
+  uint64_t verified, mismatches;
+  int failures, errors = 0;
+
+  errors += write_dataset (context, format, data);
+
+  failures = read_dataset (context, format, out, &verified, &mismatches);
+  if (failures || memcmp (out, data, TEST_BLOCK_COUNT * TEST_BLOCK_SIZE) || mismatches || 0 == verified) {
+    fprintf (stderr, "%d: clean read of %s dataset failed. failures: %d, verified: %lu, mismatches: %lu\n",
+             test_rank, format, failures, (unsigned long) verified, (unsigned long) mismatches);
+    ++errors;
+  }
+
+  test_barrier ();
+  if (0 == test_rank) {
+    errors += corrupt_data (root, format);
+  }
+  test_barrier ();
+
+  /* only test_rank 0 is guaranteed to have its data in the corrupted file. ranks on other
+   * nodes still read clean data */
+  failures = read_dataset (context, format, out, &verified, &mismatches);
+  if (0 == test_rank && (failures <= 0 || 0 == mismatches)) {
+    fprintf (stderr, "%d: corruption of %s dataset was not detected. failures: %d, mismatches: %lu\n",
+             test_rank, format, failures, (unsigned long) mismatches);
+    ++errors;
+  }
+
+  test_barrier ();
+  if (0 == test_rank) {
+    hio_dataset_unlink (context, format, 1, HIO_UNLINK_MODE_FIRST);
+  }
+  test_barrier ();
+
+  return errors;
+}
+
+int main (int argc, char *argv[]) {
+  const size_t data_size = TEST_BLOCK_COUNT * TEST_BLOCK_SIZE;
+  unsigned char *data, *out;
+  hio_context_t context;
+  char root[512];
+  int errors = 0;
+
+  if (HIO_SUCCESS != test_init (&argc, &argv, "checksum_test", &context)) {
+    return EXIT_FAILURE;
+  }
+
+  /* the data file is corrupted directly so its location must be known */
+  if (!test_posix_root (context, root, sizeof (root))) {
+    return test_skip (&context, "checksum_test", "requires a single posix data root");
+  }
+
+  data = malloc (data_size);
+  out = malloc (data_size);
+  if (NULL == data || NULL == out) {
+    fprintf (stderr, "Could not allocate buffers\n");
+    return EXIT_FAILURE;
+  }
+
+  test_fill (data, 0, 0, data_size);
+
+  errors += test_format (context, root, "json", data, out);
+  errors += test_format (context, root, "binary", data, out);
+
+  free (data);
+  free (out);
+
+  return test_fini (&context, "checksum_test", errors);
+}
@@ -0,0 +1,214 @@
+/* -*- Mode: C; c-basic-offset:2 ; indent-tabs-mode:nil -*- */
+/*
+ * Copyright (c) 2017      Los Alamos National Security, LLC.  All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/* hio_dataset_construct() test. Writes interleaved blocks with holes to shared and
+ * unique datasets, reconstructs them as plain files, and checks the contents and sizes
+ * of the output files. */
+
+#include "test_support.h"
+
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#define TEST_BLOCK_SIZE  4096
+#define TEST_BLOCK_COUNT 32
+#define TEST_DESTINATION "construct_test.out"
+
+/* offset of a block in an element. every other block is left as a hole */
+static off_t block_offset (int mode, int block) {
+  if (HIO_SET_ELEMENT_SHARED == mode) {
+    return ((off_t) block * test_size + test_rank) * TEST_BLOCK_SIZE * 2;
+  }
+
+  return (off_t) block * TEST_BLOCK_SIZE * 2;
+}
+
+static void output_path (char *path, size_t path_size, int mode, int element) {
+  if (HIO_SET_ELEMENT_SHARED == mode) {
+    snprintf (path, path_size, TEST_DESTINATION "/element%d", element);
+  } else {
+    snprintf (path, path_size, TEST_DESTINATION "/element%d.%d", element, test_rank);
+  }
+}
+
+static void remove_output (int mode) {
+  char path[256];
+
+  for (int e = 0 ; e < 2 ; ++e) {
+    output_path (path, sizeof (path), mode, e);
+    (void) unlink (path);
+  }
+}
+
+static int write_dataset (hio_context_t context, const char *name, int mode) {
+  hio_dataset_t dataset;
+  char element[16];
+  int rc, errors = 0;
+
+  rc = test_dataset_open (context, &dataset, name, 1, HIO_FLAG_CREAT | HIO_FLAG_WRITE | HIO_FLAG_TRUNC, mode,
+                          "dataset_file_mode", "file_per_node", NULL);
+  if (HIO_SUCCESS != rc) {
+    return 1;
+  }
+
+  for (int b = 0 ; b < TEST_BLOCK_COUNT ; ++b) {
+    for (int e = 0 ; e < 2 ; ++e) {
+      snprintf (element, sizeof (element), "element%d", e);
+      errors += test_element_write (dataset, element, e, block_offset (mode, b), TEST_BLOCK_SIZE);
+    }
+  }
+
+  test_dataset_close (&dataset);
+
+  return errors;
+}
+
+static int construct_dataset (hio_context_t context, const char *name, int mode) {
+  hio_dataset_t dataset;
+  int rc, errors = 0;
+
+  rc = test_dataset_open (context, &dataset, name, 1, HIO_FLAG_READ, mode, NULL);
+  if (HIO_SUCCESS != rc) {
+    return 1;
+  }
+
+  rc = hio_dataset_construct (dataset, TEST_DESTINATION, 0);
+  if (HIO_SUCCESS != rc) {
+    fprintf (stderr, "%d: could not construct dataset %s. rc: %d\n", test_rank, name, rc);
+    hio_err_print_all (context, stderr, "construct_test");
+    ++errors;
+  }
+
+  /* existing output files must not be overwritten */
+  rc = hio_dataset_construct (dataset, TEST_DESTINATION, 0);
+  if (HIO_ERR_EXISTS != rc) {
+    fprintf (stderr, "%d: constructing %s over existing files returned %d\n", test_rank, name, rc);
+    ++errors;
+  }
+
+  test_dataset_close (&dataset);
+
+  return errors;
+}
+
+static int verify_output (int mode) {
+  unsigned char buffer[2 * TEST_BLOCK_SIZE];
+  struct stat statinfo;
+  int errors = 0, fd;
+  off_t expected;
+  char path[256];
+
+  /* make sure all ranks have finished writing before checking the files */
+  test_barrier ();
+
+  for (int e = 0 ; e < 2 ; ++e) {
+    output_path (path, sizeof (path), mode, e);
+    fd = open (path, O_RDONLY);
+    if (0 > fd) {
+      fprintf (stderr, "%d: output file %s is missing. errno: %d\n", test_rank, path, errno);
+      ++errors;
+      continue;
+    }
+
+    for (int b = 0 ; b < TEST_BLOCK_COUNT ; ++b) {
+      off_t offset = block_offset (mode, b);
+      /* the last block in the file is not followed by a hole */
+      bool last = b == TEST_BLOCK_COUNT - 1 && (HIO_SET_ELEMENT_UNIQUE == mode || test_rank == test_size - 1);
+      size_t length = last ? TEST_BLOCK_SIZE : sizeof (buffer);
+
+      if ((ssize_t) length != pread (fd, buffer, length, offset)) {
+        fprintf (stderr, "%d: short read from block %d of %s\n", test_rank, b, path);
+        ++errors;
+        continue;
+      }
+
+      if (!test_check (buffer, e, offset, TEST_BLOCK_SIZE)) {
+        fprintf (stderr, "%d: data mismatch in block %d of %s\n", test_rank, b, path);
+        ++errors;
+      }
+
+      for (size_t i = TEST_BLOCK_SIZE ; i < length ; ++i) {
+        if (buffer[i]) {
+          fprintf (stderr, "%d: hole after block %d of %s is not empty\n", test_rank, b, path);
+          ++errors;
+          break;
+        }
+      }
+    }
+
+    expected = block_offset (mode, TEST_BLOCK_COUNT - 1) + TEST_BLOCK_SIZE;
+    if (HIO_SET_ELEMENT_SHARED == mode) {
+      /* the last block was written by the highest rank */
+      expected = ((off_t) (TEST_BLOCK_COUNT - 1) * test_size + test_size - 1) * TEST_BLOCK_SIZE * 2 +
+        TEST_BLOCK_SIZE;
+    }
+
+    if (0 != fstat (fd, &statinfo) || statinfo.st_size != expected) {
+      fprintf (stderr, "%d: %s has size %ld. expected %ld\n", test_rank, path, (long) statinfo.st_size,
+               (long) expected);
+      ++errors;
+    }
+
+    close (fd);
+  }
+
+  return errors;
+}
+
+static int test_mode (hio_context_t context, const char *name, int mode) {
+  int errors;
+
+  if (0 == test_rank || HIO_SET_ELEMENT_UNIQUE == mode) {
+    remove_output (mode);
+  }
+  test_barrier ();
+
+  errors = write_dataset (context, name, mode);
+  errors += construct_dataset (context, name, mode);
+  errors += verify_output (mode);
+
+  test_barrier ();
+  if (0 == errors && (0 == test_rank || HIO_SET_ELEMENT_UNIQUE == mode)) {
+    remove_output (mode);
+  }
+
+  if (0 == test_rank) {
+    hio_dataset_unlink (context, name, 1, HIO_UNLINK_MODE_FIRST);
+  }
+
+  return errors;
+}
+
+int main (int argc, char *argv[]) {
+  hio_context_t context;
+  int rc, errors = 0;
+
+  if (HIO_SUCCESS != test_init (&argc, &argv, "construct_test", &context)) {
+    return EXIT_FAILURE;
+  }
+
+  if (0 == test_rank && 0 != mkdir (TEST_DESTINATION, 0755) && EEXIST != errno) {
+    fprintf (stderr, "Could not create output directory %s. errno: %d\n", TEST_DESTINATION, errno);
+    ++errors;
+  }
+
+  errors += test_mode (context, "shared", HIO_SET_ELEMENT_SHARED);
+  errors += test_mode (context, "unique", HIO_SET_ELEMENT_UNIQUE);
+
+  rc = test_fini (&context, "construct_test", errors);
+  if (0 == test_rank && EXIT_SUCCESS == rc) {
+    (void) rmdir (TEST_DESTINATION);
+  }
+
+  return rc;
+}
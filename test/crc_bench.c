@@ -0,0 +1,151 @@
+/* -*- Mode: C; c-basic-offset:2 ; indent-tabs-mode:nil -*- */
+/*
+ * Copyright (c) 2017      Los Alamos National Security, LLC.  All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/*
+ * Check the libhio checksum functions against bitwise reference implementations
+ * then measure their throughput.
+ *
+ * usage: crc_bench.x [buffer size in MiB (default: 64)] [iterations (default: 4)]
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include "hio_internal.h"
+
+static uint32_t ref_crc32 (const uint8_t *buf, size_t length, uint32_t crc, uint32_t poly) {
+  for (size_t i = 0 ; i < length ; ++i) {
+    crc ^= buf[i];
+    for (int j = 0 ; j < 8 ; ++j) {
+      crc = (crc & 1) ? (crc >> 1) ^ poly : crc >> 1;
+    }
+  }
+
+  return crc;
+}
+
+static uint64_t ref_crc64 (const uint8_t *buf, size_t length) {
+  uint64_t crc = 0;
+
+  for (size_t i = 0 ; i < length ; ++i) {
+    crc ^= buf[i];
+    for (int j = 0 ; j < 8 ; ++j) {
+      crc = (crc & 1) ? (crc >> 1) ^ 0xC96C5795D7870F42ul : crc >> 1;
+    }
+  }
+
+  return crc;
+}
+
+static double wtime (void) {
+  struct timeval tv;
+
+  gettimeofday (&tv, NULL);
+  return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+static int check (uint8_t *buf) {
+  /* lengths around the alignment and stream boundaries of the implementations */
+  const size_t lengths[] = {0, 1, 7, 8, 9, 63, 4095, 12288, 12289, 24577, 65536 + 13, 300000};
+  const size_t offsets[] = {0, 1, 3, 8};
+  int errors = 0;
+
+  if (0xE3069283 != hioi_crc32c (0, "123456789", 9)) {
+    fprintf (stderr, "crc32c check value mismatch: 0x%08x\n", hioi_crc32c (0, "123456789", 9));
+    ++errors;
+  }
+
+  for (size_t i = 0 ; i < sizeof (lengths) / sizeof (lengths[0]) ; ++i) {
+    for (size_t j = 0 ; j < sizeof (offsets) / sizeof (offsets[0]) ; ++j) {
+      uint8_t *data = buf + offsets[j];
+      size_t length = lengths[i], half = length / 3;
+      uint32_t crc32c = ~ref_crc32 (data, length, ~0u, 0x82F63B78);
+
+      if (crc32c != hioi_crc32c (0, data, length) || crc32c != hioi_crc32c_software (0, data, length) ||
+          crc32c != hioi_crc32c (hioi_crc32c (0, data, half), data + half, length - half)) {
+        fprintf (stderr, "crc32c mismatch. length: %lu, offset: %lu\n", (unsigned long) length,
+                 (unsigned long) offsets[j]);
+        ++errors;
+      }
+
+      if (ref_crc32 (data, length, 0, 0x04C11DB7) != hioi_crc32 (data, length)) {
+        fprintf (stderr, "crc32 mismatch. length: %lu, offset: %lu\n", (unsigned long) length,
+                 (unsigned long) offsets[j]);
+        ++errors;
+      }
+
+      if (ref_crc64 (data, length) != hioi_crc64 (data, length)) {
+        fprintf (stderr, "crc64 mismatch. length: %lu, offset: %lu\n", (unsigned long) length,
+                 (unsigned long) offsets[j]);
+        ++errors;
+      }
+    }
+  }
+
+  return errors;
+}
+
+int main (int argc, char *argv[]) {
+  size_t size = (size_t) (argc > 1 ? atoi (argv[1]) : 64) << 20;
+  int iterations = argc > 2 ? atoi (argv[2]) : 4;
+  volatile uint64_t sink = 0;
+  uint8_t *buf;
+  double start;
+
+  buf = malloc (size + 8);
+  if (NULL == buf || size < 300008) {
+    fprintf (stderr, "invalid buffer size\n");
+    return EXIT_FAILURE;
+  }
+
+  srand (12345);
+  for (size_t i = 0 ; i < size + 8 ; ++i) {
+    buf[i] = rand ();
+  }
+
+  if (check (buf)) {
+    free (buf);
+    return EXIT_FAILURE;
+  }
+
+  printf ("crc32c hardware acceleration: %s\n", hioi_crc32c_accelerated () ? "yes" : "no");
+
+  start = wtime ();
+  for (int i = 0 ; i < iterations ; ++i) {
+    sink += hioi_crc32c (0, buf, size);
+  }
+  printf ("crc32c:          %8.2f MB/s\n", (double) size * iterations / (wtime () - start) / 1e6);
+
+  start = wtime ();
+  for (int i = 0 ; i < iterations ; ++i) {
+    sink += hioi_crc32c_software (0, buf, size);
+  }
+  printf ("crc32c software: %8.2f MB/s\n", (double) size * iterations / (wtime () - start) / 1e6);
+
+  start = wtime ();
+  for (int i = 0 ; i < iterations ; ++i) {
+    sink += hioi_crc64 (buf, size);
+  }
+  printf ("crc64:           %8.2f MB/s\n", (double) size * iterations / (wtime () - start) / 1e6);
+
+  start = wtime ();
+  for (int i = 0 ; i < iterations ; ++i) {
+    sink += hioi_crc32 (buf, size);
+  }
+  printf ("crc32:           %8.2f MB/s\n", (double) size * iterations / (wtime () - start) / 1e6);
+
+  (void) sink;
+  free (buf);
+
+  return EXIT_SUCCESS;
+}
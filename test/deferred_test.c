@@ -0,0 +1,176 @@
+/* -*- Mode: C; c-basic-offset:2 ; indent-tabs-mode:nil -*- */
+/*
+ * Copyright (c) 2017      Los Alamos National Security, LLC.  All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/* Deferred read test. Reads an element back with many small non-blocking reads issued
+ * in shuffled order and completed by hio_complete() or hio_request_wait(), and checks
+ * that every buffer holds the right data once the reads complete. */
+
+#include "test_support.h"
+
+#define TEST_BLOCK_COUNT 512
+#define TEST_BLOCK_SIZE  1000
+
+/* visit every block exactly once in a scattered order */
+static int shuffle (int k) {
+  return (k * 37) % TEST_BLOCK_COUNT;
+}
+
+static int test_mode (hio_context_t context, int mode, const char *file_mode, unsigned char *data,
+                      unsigned char *out) {
+  const size_t data_size = TEST_BLOCK_COUNT * TEST_BLOCK_SIZE;
+  const char *name = (HIO_SET_ELEMENT_SHARED == mode) ? "shared" : "unique";
+  off_t base = (HIO_SET_ELEMENT_SHARED == mode) ? (off_t) test_rank * data_size : 0;
+  hio_request_t requests[TEST_BLOCK_COUNT];
+  ssize_t transferred[TEST_BLOCK_COUNT];
+  hio_dataset_t dataset;
+  hio_element_t element;
+  int rc, errors = 0;
+
+  rc = test_dataset_open (context, &dataset, name, 1, HIO_FLAG_CREAT | HIO_FLAG_WRITE | HIO_FLAG_TRUNC, mode,
+                          "dataset_file_mode", file_mode, NULL);
+  if (HIO_SUCCESS != rc) {
+    return 1;
+  }
+
+  hio_element_open (dataset, &element, "element", HIO_FLAG_WRITE | HIO_FLAG_CREAT);
+  if ((ssize_t) data_size != hio_element_write (element, base, 0, data, TEST_BLOCK_COUNT, TEST_BLOCK_SIZE)) {
+    fprintf (stderr, "%d: error writing %s element\n", test_rank, name);
+    ++errors;
+  }
+  hio_element_close (&element);
+  test_dataset_close (&dataset);
+
+  rc = test_dataset_open (context, &dataset, name, 1, HIO_FLAG_READ, mode, NULL);
+  if (HIO_SUCCESS != rc) {
+    return errors + 1;
+  }
+
+  hio_element_open (dataset, &element, "element", HIO_FLAG_READ);
+
+  /* reads without requests completed by hio_complete(). every fifth block is skipped
+   * and must not be touched */
+  memset (out, 0, data_size);
+  for (int k = 0 ; k < TEST_BLOCK_COUNT ; ++k) {
+    int i = shuffle (k);
+
+    if (3 == i % 5) {
+      continue;
+    }
+
+    rc = hio_element_read_nb (element, NULL, base + (off_t) i * TEST_BLOCK_SIZE, 0, out + i * TEST_BLOCK_SIZE,
+                              1, TEST_BLOCK_SIZE);
+    if (HIO_SUCCESS != rc) {
+      fprintf (stderr, "%d: could not start read of block %d. rc: %d\n", test_rank, i, rc);
+      ++errors;
+    }
+  }
+
+  rc = hio_complete (element);
+  if (HIO_SUCCESS != rc) {
+    fprintf (stderr, "%d: hio_complete failed on %s %s element. rc: %d\n", test_rank, file_mode, name, rc);
+    ++errors;
+  }
+
+  for (int i = 0 ; i < TEST_BLOCK_COUNT ; ++i) {
+    for (int j = 0 ; j < TEST_BLOCK_SIZE ; ++j) {
+      size_t index = (size_t) i * TEST_BLOCK_SIZE + j;
+
+      if (out[index] != ((3 == i % 5) ? 0 : data[index])) {
+        fprintf (stderr, "%d: data mismatch in block %d of %s %s element after hio_complete\n", test_rank, i,
+                 file_mode, name);
+        ++errors;
+        break;
+      }
+    }
+  }
+
+  /* reads with requests completed by hio_request_wait() */
+  memset (out, 0, data_size);
+  for (int k = 0 ; k < TEST_BLOCK_COUNT ; ++k) {
+    int i = shuffle (k);
+
+    requests[i] = HIO_OBJECT_NULL;
+    rc = hio_element_read_nb (element, requests + i, base + (off_t) i * TEST_BLOCK_SIZE, 0,
+                              out + i * TEST_BLOCK_SIZE, 1, TEST_BLOCK_SIZE);
+    if (HIO_SUCCESS != rc) {
+      fprintf (stderr, "%d: could not start read of block %d. rc: %d\n", test_rank, i, rc);
+      ++errors;
+    }
+  }
+
+  rc = hio_request_wait (requests, TEST_BLOCK_COUNT, transferred);
+  if (HIO_SUCCESS != rc) {
+    fprintf (stderr, "%d: hio_request_wait failed on %s %s element. rc: %d\n", test_rank, file_mode, name, rc);
+    ++errors;
+  }
+
+  for (int i = 0 ; i < TEST_BLOCK_COUNT ; ++i) {
+    if (TEST_BLOCK_SIZE != transferred[i]) {
+      fprintf (stderr, "%d: request %d transferred %ld bytes\n", test_rank, i, (long) transferred[i]);
+      ++errors;
+    }
+  }
+
+  if (memcmp (out, data, data_size)) {
+    fprintf (stderr, "%d: data mismatch in %s %s element after hio_request_wait\n", test_rank, file_mode, name);
+    ++errors;
+  }
+
+  /* reads still queued when the element is closed are completed by the close */
+  memset (out, 0, TEST_BLOCK_SIZE);
+  hio_element_read_nb (element, NULL, base, 0, out, 1, TEST_BLOCK_SIZE);
+  hio_element_close (&element);
+  if (memcmp (out, data, TEST_BLOCK_SIZE)) {
+    fprintf (stderr, "%d: queued read was not completed by hio_element_close\n", test_rank);
+    ++errors;
+  }
+
+  test_dataset_close (&dataset);
+
+  if (0 == test_rank) {
+    hio_dataset_unlink (context, name, 1, HIO_UNLINK_MODE_FIRST);
+  }
+
+  test_barrier ();
+
+  return errors;
+}
+
+int main (int argc, char *argv[]) {
+  const char *file_modes[] = {"basic", "file_per_node"};
+  const size_t data_size = TEST_BLOCK_COUNT * TEST_BLOCK_SIZE;
+  unsigned char *data, *out;
+  hio_context_t context;
+  int errors = 0;
+
+  if (HIO_SUCCESS != test_init (&argc, &argv, "deferred_test", &context)) {
+    return EXIT_FAILURE;
+  }
+
+  data = malloc (data_size);
+  out = malloc (data_size);
+  if (NULL == data || NULL == out) {
+    fprintf (stderr, "Could not allocate buffers\n");
+    return EXIT_FAILURE;
+  }
+
+  test_fill (data, 0, 0, data_size);
+
+  for (int i = 0 ; i < 2 ; ++i) {
+    errors += test_mode (context, HIO_SET_ELEMENT_UNIQUE, file_modes[i], data, out);
+    errors += test_mode (context, HIO_SET_ELEMENT_SHARED, file_modes[i], data, out);
+  }
+
+  free (data);
+  free (out);
+
+  return test_fini (&context, "deferred_test", errors);
+}
@@ -0,0 +1,226 @@
+/* -*- Mode: C; c-basic-offset:2 ; indent-tabs-mode:nil -*- */
+/*
+ * Copyright (c) 2017      Los Alamos National Security, LLC.  All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/* Dataset history test. Writes a dataset, checks the history file saved in the context
+ * directory, then creates a new context and checks that the dataset write model and
+ * the data root statistics are restored from it. Also checks that a version 1 history
+ * file is accepted and that its data root failure counts are ignored. Requires a single
+ * posix data root. */
+
+#include "test_support.h"
+
+#include <dirent.h>
+#include <unistd.h>
+
+#define TEST_DATA_SIZE (1 << 20)
+
+static char history_path[1024];
+
+static int write_dataset (hio_context_t context, int64_t id) {
+  hio_dataset_t dataset;
+  int errors;
+
+  if (HIO_SUCCESS != test_dataset_open (context, &dataset, "history", id, HIO_FLAG_CREAT | HIO_FLAG_WRITE |
+                                        HIO_FLAG_TRUNC, HIO_SET_ELEMENT_UNIQUE, NULL)) {
+    return 1;
+  }
+
+  errors = test_element_write (dataset, "element", id, 0, TEST_DATA_SIZE);
+  test_dataset_close (&dataset);
+
+  return errors;
+}
+
+/* open the last dataset (creating the data root modules) and return the bandwidth
+ * recorded for it. only rank 0 keeps the write model */
+static double write_bandwidth (hio_context_t context) {
+  hio_dataset_t dataset;
+  double bandwidth = 0.0;
+
+  if (HIO_SUCCESS != test_dataset_open (context, &dataset, "history", 2, HIO_FLAG_READ,
+                                        HIO_SET_ELEMENT_UNIQUE, NULL)) {
+    return -1.0;
+  }
+
+  if (0 != test_element_check (dataset, "element", 2, 0, TEST_DATA_SIZE)) {
+    bandwidth = -1.0;
+  } else {
+    (void) hio_perf_get_value (&dataset->ds_object, "dataset_write_bandwidth", &bandwidth, sizeof (bandwidth));
+  }
+
+  test_dataset_close (&dataset);
+
+  return bandwidth;
+}
+
+/* parse the history file. returns the number of errors found */
+static int check_history (const char *data_root, double *root_bandwidth, double *dataset_bandwidth) {
+  char line[2048], name[1024];
+  unsigned long long latency, dummy;
+  long long last_id, completion;
+  int version = 0, roots = 0, datasets = 0, errors = 0;
+  FILE *fh;
+
+  fh = fopen (history_path, "r");
+  if (NULL == fh) {
+    fprintf (stderr, "%d: no history saved at %s\n", test_rank, history_path);
+    return 1;
+  }
+
+  if (NULL == fgets (line, sizeof (line), fh) || 1 != sscanf (line, "hio_history %d", &version) || 2 != version) {
+    fprintf (stderr, "%d: history has version %d. expected 2\n", test_rank, version);
+    ++errors;
+  }
+
+  while (NULL != fgets (line, sizeof (line), fh)) {
+    line[strcspn (line, "\n")] = '\0';
+
+    /* version 2 does not save the failure count of a data root */
+    if (3 == sscanf (line, "root %lf %llu %1023[^\n]", root_bandwidth, &latency, name)) {
+      if (strcmp (name, data_root)) {
+        fprintf (stderr, "%d: unexpected data root in history: %s\n", test_rank, line);
+        ++errors;
+      }
+      ++roots;
+    } else if (7 == sscanf (line, "dataset %lld %lld %llu %llu %llu %lf %1023[^\n]", &last_id, &completion, &dummy,
+                            &dummy, &dummy, dataset_bandwidth, name)) {
+      if (strcmp (name, "history") || 2 != last_id || 0 == completion) {
+        fprintf (stderr, "%d: unexpected dataset in history: %s\n", test_rank, line);
+        ++errors;
+      }
+      ++datasets;
+    } else {
+      fprintf (stderr, "%d: unexpected line in history: %s\n", test_rank, line);
+      ++errors;
+    }
+  }
+
+  fclose (fh);
+
+  if (1 != roots || 1 != datasets) {
+    fprintf (stderr, "%d: history has %d data roots and %d datasets. expected 1 and 1\n", test_rank, roots,
+             datasets);
+    ++errors;
+  }
+
+  return errors;
+}
+
+/* the temporary file used to save the history is renamed into place */
+static int check_tmp_files (const char *root) {
+  char path[1024];
+  struct dirent *entry;
+  int errors = 0;
+  DIR *dir;
+
+  snprintf (path, sizeof (path), "%s/history_test.hio", root);
+  dir = opendir (path);
+  if (NULL == dir) {
+    return 1;
+  }
+
+  while (NULL != (entry = readdir (dir))) {
+    if (0 == strncmp (entry->d_name, ".history", 8) && strcmp (entry->d_name, ".history")) {
+      fprintf (stderr, "%d: temporary history file %s left behind\n", test_rank, entry->d_name);
+      ++errors;
+    }
+  }
+
+  closedir (dir);
+
+  return errors;
+}
+
+int main (int argc, char *argv[]) {
+  const char *config_file = (argc > 1) ? argv[1] : NULL;
+  double root_bandwidth = 0.0, dataset_bandwidth = 0.0, bandwidth;
+  char root[512];
+  hio_context_t context;
+  int errors = 0;
+
+  if (HIO_SUCCESS != test_init (&argc, &argv, "history_test", &context)) {
+    return EXIT_FAILURE;
+  }
+
+  if (!test_posix_root (context, root, sizeof (root))) {
+    return test_skip (&context, "history_test", "requires a single posix data root");
+  }
+
+  snprintf (history_path, sizeof (history_path), "%s/history_test.hio/.history", root);
+
+  errors += write_dataset (context, 1);
+  errors += write_dataset (context, 2);
+  bandwidth = write_bandwidth (context);
+
+  if (0 == test_rank) {
+    errors += check_history (root, &root_bandwidth, &dataset_bandwidth);
+    errors += check_tmp_files (root);
+
+    if (bandwidth != dataset_bandwidth || !(root_bandwidth > 0.0)) {
+      fprintf (stderr, "%d: history has dataset bandwidth %g and data root bandwidth %g. expected %g and > 0\n",
+               test_rank, dataset_bandwidth, root_bandwidth, bandwidth);
+      ++errors;
+    }
+  }
+
+  /* a new context starts with the statistics of the previous one */
+  hio_fini (&context);
+  if (HIO_SUCCESS != test_context_init ("history_test", config_file, &context)) {
+    return test_fini (NULL, "history_test", errors + 1);
+  }
+
+  /* without the history a dataset that was never written is recommended */
+  if (HIO_SCP_NOT_NOW != hio_dataset_should_checkpoint (context, "history")) {
+    fprintf (stderr, "%d: checkpoint recommended right after the dataset history was loaded\n", test_rank);
+    ++errors;
+  }
+
+  bandwidth = write_bandwidth (context);
+  if (0 == test_rank && (bandwidth != dataset_bandwidth ||
+                         root_bandwidth != context->c_module_stats[0].ms_bandwidth)) {
+    fprintf (stderr, "%d: restored dataset bandwidth %g and data root bandwidth %g. expected %g and %g\n",
+             test_rank, bandwidth, context->c_module_stats[0].ms_bandwidth, dataset_bandwidth, root_bandwidth);
+    ++errors;
+  }
+
+  /* version 1 history files also recorded failure counts */
+  hio_fini (&context);
+  test_barrier ();
+  if (0 == test_rank) {
+    FILE *fh = fopen (history_path, "w");
+    if (NULL != fh) {
+      fprintf (fh, "hio_history 1\nroot 1234.5 10 5 %s\n", root);
+      fclose (fh);
+    }
+  }
+  test_barrier ();
+
+  if (HIO_SUCCESS != test_context_init ("history_test", config_file, &context)) {
+    return test_fini (NULL, "history_test", errors + 1);
+  }
+
+  (void) write_bandwidth (context);
+  if (0 == test_rank && (1234.5 != context->c_module_stats[0].ms_bandwidth ||
+                         0 != context->c_module_stats[0].ms_failures)) {
+    fprintf (stderr, "%d: version 1 history restored data root bandwidth %g and %d failures. expected 1234.5 "
+             "and 0\n", test_rank, context->c_module_stats[0].ms_bandwidth, context->c_module_stats[0].ms_failures);
+    ++errors;
+  }
+
+  test_barrier ();
+  if (0 == test_rank) {
+    hio_dataset_unlink (context, "history", 1, HIO_UNLINK_MODE_FIRST);
+    hio_dataset_unlink (context, "history", 2, HIO_UNLINK_MODE_FIRST);
+    unlink (history_path);
+  }
+
+  return test_fini (&context, "history_test", errors);
+}
@@ -0,0 +1,186 @@
+/* -*- Mode: C; c-basic-offset:2 ; indent-tabs-mode:nil -*- */
+/*
+ * Copyright (c) 2017      Los Alamos National Security, LLC.  All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/* Latency histogram test. Checks the percentiles reported for a known distribution,
+ * that concurrent threads recording into the same histogram lose no operations, and
+ * that the latency performance variables of a dataset count every write on each rank
+ * and in the aggregate of all ranks. */
+
+#include "test_support.h"
+
+#include <pthread.h>
+
+#define TEST_THREADS         4
+#define TEST_THREAD_RECORDS  100000
+#define TEST_WRITE_COUNT     64
+#define TEST_WRITE_SIZE      1024
+
+static hio_latency_histogram_t shared_histogram;
+
+/* reported percentiles are the upper bound of the bucket (within 12.5%) */
+static int check_percentile (const char *name, uint64_t value, uint64_t expected) {
+  if (value < expected || value > expected + expected / 8) {
+    fprintf (stderr, "%d: %s is %lu. expected %lu to %lu\n", test_rank, name, (unsigned long) value,
+             (unsigned long) expected, (unsigned long) (expected + expected / 8));
+    return 1;
+  }
+
+  return 0;
+}
+
+static int check_distribution (void) {
+  hio_latency_histogram_t histogram;
+  hio_latency_summary_t summary;
+  int errors = 0;
+
+  memset (&histogram, 0, sizeof (histogram));
+
+  /* 1 usec to 1 msec in 1 usec steps */
+  for (uint64_t i = 1000 ; i >= 1 ; --i) {
+    hioi_latency_record (&histogram, i * 1000);
+  }
+
+  hioi_latency_summarize (&histogram, &summary);
+
+  if (1000 != summary.ls_count || 1000000 != summary.ls_max) {
+    fprintf (stderr, "%d: histogram has %lu operations with maximum %lu. expected 1000 and 1000000\n", test_rank,
+             (unsigned long) summary.ls_count, (unsigned long) summary.ls_max);
+    ++errors;
+  }
+
+  errors += check_percentile ("p50", summary.ls_p50, 500000);
+  errors += check_percentile ("p90", summary.ls_p90, 900000);
+  errors += check_percentile ("p99", summary.ls_p99, 990000);
+
+  /* small latencies have a bucket each */
+  memset (&histogram, 0, sizeof (histogram));
+  for (int i = 0 ; i < 10 ; ++i) {
+    hioi_latency_record (&histogram, 5);
+  }
+
+  hioi_latency_summarize (&histogram, &summary);
+  if (10 != summary.ls_count || 5 != summary.ls_p50 || 5 != summary.ls_p99 || 5 != summary.ls_max) {
+    fprintf (stderr, "%d: histogram of small latencies has count %lu, p50 %lu, p99 %lu, max %lu. expected 10, 5, "
+             "5, 5\n", test_rank, (unsigned long) summary.ls_count, (unsigned long) summary.ls_p50,
+             (unsigned long) summary.ls_p99, (unsigned long) summary.ls_max);
+    ++errors;
+  }
+
+  return errors;
+}
+
+static void *record_thread (void *arg) {
+  uint64_t base = (uint64_t) (intptr_t) arg;
+
+  for (uint64_t i = 0 ; i < TEST_THREAD_RECORDS ; ++i) {
+    hioi_latency_record (&shared_histogram, base + i);
+  }
+
+  return NULL;
+}
+
+static int check_threads (void) {
+  pthread_t threads[TEST_THREADS];
+  hio_latency_summary_t summary;
+  int errors = 0;
+
+  memset (&shared_histogram, 0, sizeof (shared_histogram));
+
+  for (int i = 0 ; i < TEST_THREADS ; ++i) {
+    pthread_create (threads + i, NULL, record_thread, (void *) (intptr_t) ((i + 1) * 1000));
+  }
+
+  for (int i = 0 ; i < TEST_THREADS ; ++i) {
+    pthread_join (threads[i], NULL);
+  }
+
+  hioi_latency_summarize (&shared_histogram, &summary);
+
+  if (TEST_THREADS * TEST_THREAD_RECORDS != summary.ls_count ||
+      TEST_THREADS * 1000 + TEST_THREAD_RECORDS - 1 != summary.ls_max) {
+    fprintf (stderr, "%d: threads recorded %lu operations with maximum %lu. expected %d and %d\n", test_rank,
+             (unsigned long) summary.ls_count, (unsigned long) summary.ls_max, TEST_THREADS * TEST_THREAD_RECORDS,
+             TEST_THREADS * 1000 + TEST_THREAD_RECORDS - 1);
+    ++errors;
+  }
+
+  return errors;
+}
+
+/* check the summary perf vars of an operation */
+static int check_perf (hio_dataset_t dataset, const char *prefix, const char *op, uint64_t count) {
+  uint64_t values[5];
+  const char *suffixes[] = {"count", "p50_nsec", "p90_nsec", "p99_nsec", "max_nsec"};
+  char name[128];
+
+  for (int i = 0 ; i < 5 ; ++i) {
+    snprintf (name, sizeof (name), "%s%s_latency_%s", prefix, op, suffixes[i]);
+    values[i] = test_perf_value (&dataset->ds_object, name);
+  }
+
+  if (count != values[0] || 0 == values[4] || values[1] > values[2] || values[2] > values[3] ||
+      values[3] > values[4]) {
+    fprintf (stderr, "%d: %s%s latency count: %lu, p50: %lu, p90: %lu, p99: %lu, max: %lu. expected count %lu\n",
+             test_rank, prefix, op, (unsigned long) values[0], (unsigned long) values[1], (unsigned long) values[2],
+             (unsigned long) values[3], (unsigned long) values[4], (unsigned long) count);
+    return 1;
+  }
+
+  return 0;
+}
+
+static int check_dataset (hio_context_t context) {
+  hio_dataset_t dataset;
+  int errors = 0;
+
+  if (HIO_SUCCESS != test_dataset_open (context, &dataset, "latency", 1, HIO_FLAG_CREAT | HIO_FLAG_WRITE |
+                                        HIO_FLAG_TRUNC, HIO_SET_ELEMENT_UNIQUE, NULL)) {
+    return 1;
+  }
+
+  for (int i = 0 ; i < TEST_WRITE_COUNT ; ++i) {
+    errors += test_element_write (dataset, "element", 1, (off_t) i * TEST_WRITE_SIZE, TEST_WRITE_SIZE);
+  }
+
+  errors += check_perf (dataset, "", "open", 1);
+  errors += check_perf (dataset, "", "append", TEST_WRITE_COUNT);
+
+  /* the histograms of all ranks are summed on rank 0 */
+  hioi_dataset_latency_aggregate (dataset);
+  if (0 == test_rank) {
+    errors += check_perf (dataset, "aggregate_", "open", test_size);
+    errors += check_perf (dataset, "aggregate_", "append", TEST_WRITE_COUNT * test_size);
+  }
+
+  test_dataset_close (&dataset);
+
+  return errors;
+}
+
+int main (int argc, char *argv[]) {
+  hio_context_t context;
+  int errors = 0;
+
+  if (HIO_SUCCESS != test_init (&argc, &argv, "latency_test", &context)) {
+    return EXIT_FAILURE;
+  }
+
+  errors += check_distribution ();
+  errors += check_threads ();
+  errors += check_dataset (context);
+
+  test_barrier ();
+  if (0 == test_rank) {
+    hio_dataset_unlink (context, "latency", 1, HIO_UNLINK_MODE_FIRST);
+  }
+
+  return test_fini (&context, "latency_test", errors);
+}
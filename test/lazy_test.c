@@ -0,0 +1,166 @@
+/* -*- Mode: C; c-basic-offset:2 ; indent-tabs-mode:nil -*- */
+/*
+ * Copyright (c) 2017      Los Alamos National Security, LLC.  All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/* Lazy element loading test. Writes datasets with many elements using json and binary
+ * manifests in basic and file_per_node mode, then opens them read-only and checks that
+ * no element is loaded until it is opened, that opening an element loads only that
+ * element, and that the data read through lazily loaded elements is correct. */
+
+#include "test_support.h"
+
+#define TEST_ELEMENT_COUNT 64
+#define TEST_ELEMENT_SIZE  8192
+
+/* number of elements the dataset has loaded */
+static int loaded_elements (hio_dataset_t dataset) {
+  hio_element_t element;
+  int count = 0;
+
+  hioi_object_lock (&dataset->ds_object);
+  hioi_list_foreach (element, dataset->ds_elist, struct hio_element, e_list) {
+    ++count;
+  }
+  hioi_object_unlock (&dataset->ds_object);
+
+  return count;
+}
+
+static int write_dataset (hio_context_t context, const char *format, const char *file_mode) {
+  hio_dataset_t dataset;
+  char name[32];
+  int rc, errors = 0;
+
+  rc = test_dataset_open (context, &dataset, format, 1, HIO_FLAG_CREAT | HIO_FLAG_WRITE | HIO_FLAG_TRUNC,
+                          HIO_SET_ELEMENT_UNIQUE, "dataset_manifest_format", format, "dataset_file_mode", file_mode,
+                          NULL);
+  if (HIO_SUCCESS != rc) {
+    return 1;
+  }
+
+  for (int e = 0 ; e < TEST_ELEMENT_COUNT ; ++e) {
+    snprintf (name, sizeof (name), "element%d", e);
+    errors += test_element_write (dataset, name, e, 0, TEST_ELEMENT_SIZE);
+  }
+
+  test_dataset_close (&dataset);
+
+  return errors;
+}
+
+static int read_dataset (hio_context_t context, const char *format, bool basic) {
+  hio_dataset_t dataset;
+  hio_element_t element;
+  int rc, count, errors = 0;
+  char name[32];
+
+  rc = test_dataset_open (context, &dataset, format, 1, HIO_FLAG_READ, HIO_SET_ELEMENT_UNIQUE, NULL);
+  if (HIO_SUCCESS != rc) {
+    return 1;
+  }
+
+  count = loaded_elements (dataset);
+  if (0 != count) {
+    fprintf (stderr, "%d: %d elements of the %s dataset were loaded at open\n", test_rank, count, format);
+    ++errors;
+  }
+
+  errors += test_element_check (dataset, "element7", 7, 0, TEST_ELEMENT_SIZE);
+
+  count = loaded_elements (dataset);
+  if (1 != count) {
+    fprintf (stderr, "%d: %d elements of the %s dataset are loaded after opening one\n", test_rank, count,
+             format);
+    ++errors;
+  }
+
+  /* opening the element again must not load a second copy */
+  errors += test_element_check (dataset, "element7", 7, 0, TEST_ELEMENT_SIZE);
+  if (1 != loaded_elements (dataset)) {
+    fprintf (stderr, "%d: reopening an element of the %s dataset loaded it again\n", test_rank, format);
+    ++errors;
+  }
+
+  for (int e = TEST_ELEMENT_COUNT - 1 ; e >= 0 ; --e) {
+    int64_t size = 0;
+
+    snprintf (name, sizeof (name), "element%d", e);
+    rc = hio_element_open (dataset, &element, name, HIO_FLAG_READ);
+    if (HIO_SUCCESS != rc) {
+      fprintf (stderr, "%d: could not open %s of the %s dataset. rc: %d\n", test_rank, name, format, rc);
+      ++errors;
+      continue;
+    }
+
+    hio_element_size (element, &size);
+    hio_element_close (&element);
+    if (TEST_ELEMENT_SIZE != size) {
+      fprintf (stderr, "%d: %s of the %s dataset has size %ld\n", test_rank, name, format, (long) size);
+      ++errors;
+    }
+
+    errors += test_element_check (dataset, name, e, 0, TEST_ELEMENT_SIZE);
+  }
+
+  count = loaded_elements (dataset);
+  if (TEST_ELEMENT_COUNT != count) {
+    fprintf (stderr, "%d: %d elements of the %s dataset are loaded after opening all %d\n", test_rank, count,
+             format, TEST_ELEMENT_COUNT);
+    ++errors;
+  }
+
+  /* an element that is not in the manifest. there is no element file to look for in
+   * file_per_node mode so the element is opened empty */
+  rc = hio_element_open (dataset, &element, "missing", HIO_FLAG_READ);
+  if (HIO_SUCCESS == rc) {
+    int64_t size = -1;
+
+    hio_element_size (element, &size);
+    hio_element_close (&element);
+    if (basic || 0 != size) {
+      fprintf (stderr, "%d: opened a missing element of the %s dataset with size %ld\n", test_rank, format,
+               (long) size);
+      ++errors;
+    }
+  } else if (HIO_ERR_NOT_FOUND != rc) {
+    fprintf (stderr, "%d: opening a missing element of the %s dataset returned %d\n", test_rank, format, rc);
+    ++errors;
+  }
+
+  test_dataset_close (&dataset);
+
+  return errors;
+}
+
+int main (int argc, char *argv[]) {
+  const char *formats[] = {"json", "binary"};
+  const char *file_modes[] = {"basic", "file_per_node"};
+  hio_context_t context;
+  int errors = 0;
+
+  if (HIO_SUCCESS != test_init (&argc, &argv, "lazy_test", &context)) {
+    return EXIT_FAILURE;
+  }
+
+  for (int i = 0 ; i < 4 ; ++i) {
+    const char *format = formats[i & 1];
+
+    errors += write_dataset (context, format, file_modes[i >> 1]);
+    errors += read_dataset (context, format, 0 == (i >> 1));
+
+    test_barrier ();
+    if (0 == test_rank) {
+      hio_dataset_unlink (context, format, 1, HIO_UNLINK_MODE_FIRST);
+    }
+    test_barrier ();
+  }
+
+  return test_fini (&context, "lazy_test", errors);
+}
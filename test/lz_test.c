@@ -0,0 +1,234 @@
+/* -*- Mode: C; c-basic-offset:2 ; indent-tabs-mode:nil -*- */
+/*
+ * Copyright (c) 2017      Los Alamos National Security, LLC.  All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/*
+ * LZ manifest codec round-trip test. Runs buffers of various sizes and contents through
+ * the raw codec, the manifest compression interface, and the streaming manifest encoder
+ * and checks that the data comes back unchanged.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include "hio_internal.h"
+#include "hio_manifest.h"
+
+#define TEST_MAX_SIZE (3 * 1024 * 1024 + 17)
+
+/* fill a buffer. kind 0: random, 1: repeated text, 2: runs of a single byte, 3: mixed,
+ * 4: short repeating patterns (periods 2-11) */
+static void fill (unsigned char *buffer, size_t size, int kind) {
+  const char *text = "{\"name\": \"element\", \"size\": 1048576, \"segments\": [";
+  const size_t text_length = strlen (text);
+
+  for (size_t i = 0 ; i < size ; ++i) {
+    switch (kind) {
+    case 0:
+      buffer[i] = (unsigned char) random ();
+      break;
+    case 1:
+      buffer[i] = text[i % text_length];
+      break;
+    case 2:
+      buffer[i] = (unsigned char) (i / 1000);
+      break;
+    case 4:
+      buffer[i] = (unsigned char) (i % (i / 3000 % 10 + 2));
+      break;
+    default:
+      buffer[i] = ((i / 4096) & 1) ? (unsigned char) random () : text[i % text_length];
+    }
+  }
+}
+
+static int check_raw (const unsigned char *data, size_t size, int kind) {
+  size_t bound = hioi_lz_compress_bound (size), coded_size = bound;
+  unsigned char *coded, *decoded;
+  int rc;
+
+  coded = malloc (bound);
+  decoded = malloc (size + 1);
+  if (NULL == coded || NULL == decoded) {
+    free (coded);
+    free (decoded);
+    return HIO_ERR_OUT_OF_RESOURCE;
+  }
+
+  rc = hioi_lz_compress (data, size, coded, &coded_size);
+  if (HIO_SUCCESS == rc && coded_size > bound) {
+    rc = HIO_ERROR;
+  }
+
+  if (HIO_SUCCESS == rc) {
+    rc = hioi_lz_decompress (coded, coded_size, decoded, size);
+  }
+
+  if (HIO_SUCCESS == rc && memcmp (data, decoded, size)) {
+    rc = HIO_ERROR;
+  }
+
+  /* the decoder must reject an output buffer that does not match the original size */
+  if (HIO_SUCCESS == rc && HIO_SUCCESS == hioi_lz_decompress (coded, coded_size, decoded, size + 1)) {
+    rc = HIO_ERROR;
+  }
+
+  if (HIO_SUCCESS == rc && 1 == kind && size > 4096 && coded_size > size / 4) {
+    fprintf (stderr, "lz_test: repetitive data compressed poorly: %lu -> %lu\n", (unsigned long) size,
+             (unsigned long) coded_size);
+    rc = HIO_ERROR;
+  }
+
+  if (HIO_SUCCESS != rc) {
+    fprintf (stderr, "lz_test: raw round trip failed. size: %lu, kind: %d, rc: %d\n", (unsigned long) size,
+             kind, rc);
+  }
+
+  free (coded);
+  free (decoded);
+
+  return rc;
+}
+
+static int check_manifest_codec (const unsigned char *data, size_t size) {
+  unsigned char *coded = NULL, *decoded = NULL;
+  size_t coded_size = 0, decoded_size = 0;
+  int rc;
+
+  rc = hioi_manifest_compress (HIO_MANIFEST_CODEC_LZ, data, size, &coded, &coded_size, NULL);
+  if (HIO_SUCCESS == rc && HIO_MANIFEST_CODEC_LZ != hioi_manifest_codec_detect (coded, coded_size)) {
+    rc = HIO_ERROR;
+  }
+
+  if (HIO_SUCCESS == rc) {
+    rc = hioi_manifest_decompress (coded, coded_size, &decoded, &decoded_size, NULL);
+  }
+
+  if (HIO_SUCCESS == rc && (decoded_size != size || memcmp (data, decoded, size))) {
+    rc = HIO_ERROR;
+  }
+
+  /* a truncated payload must be rejected */
+  if (HIO_SUCCESS == rc && coded_size > 1) {
+    unsigned char *tmp = NULL;
+    size_t tmp_size = 0;
+
+    if (HIO_SUCCESS == hioi_manifest_decompress (coded, coded_size - 1, &tmp, &tmp_size, NULL)) {
+      fprintf (stderr, "lz_test: truncated payload was not detected\n");
+      rc = HIO_ERROR;
+    }
+    free (tmp);
+  }
+
+  if (HIO_SUCCESS != rc) {
+    fprintf (stderr, "lz_test: manifest codec round trip failed. size: %lu, rc: %d\n", (unsigned long) size, rc);
+  }
+
+  free (coded);
+  free (decoded);
+
+  return rc;
+}
+
+static int check_encoder (const unsigned char *data, size_t size, size_t piece) {
+  char path[] = "lz_test.tmp.XXXXXX";
+  hio_manifest_codec_stats_t stats = {.cs_raw_bytes = 0};
+  hio_manifest_encoder_t *encoder;
+  unsigned char *coded = NULL, *decoded = NULL;
+  size_t coded_size = 0, decoded_size = 0;
+  off_t file_size;
+  int fd, rc;
+
+  fd = mkstemp (path);
+  if (0 > fd) {
+    return HIO_ERROR;
+  }
+  unlink (path);
+
+  rc = hioi_manifest_encoder_open (HIO_MANIFEST_CODEC_LZ, fd, &stats, &encoder);
+  for (size_t offset = 0 ; HIO_SUCCESS == rc && offset < size ; offset += piece) {
+    rc = hioi_manifest_encoder_write (encoder, data + offset, (size - offset < piece) ? size - offset : piece);
+  }
+
+  if (HIO_SUCCESS == rc) {
+    rc = hioi_manifest_encoder_close (encoder);
+  }
+
+  if (HIO_SUCCESS == rc && stats.cs_raw_bytes != size) {
+    rc = HIO_ERROR;
+  }
+
+  if (HIO_SUCCESS == rc) {
+    file_size = lseek (fd, 0, SEEK_END);
+    coded_size = (size_t) file_size;
+    coded = malloc (coded_size + 1);
+    if (0 > file_size || NULL == coded || coded_size != (size_t) pread (fd, coded, coded_size, 0)) {
+      rc = HIO_ERROR;
+    }
+  }
+
+  if (HIO_SUCCESS == rc) {
+    rc = hioi_manifest_decompress (coded, coded_size, &decoded, &decoded_size, NULL);
+  }
+
+  if (HIO_SUCCESS == rc && (decoded_size != size || memcmp (data, decoded, size))) {
+    rc = HIO_ERROR;
+  }
+
+  if (HIO_SUCCESS != rc) {
+    fprintf (stderr, "lz_test: encoder round trip failed. size: %lu, piece: %lu, rc: %d\n", (unsigned long) size,
+             (unsigned long) piece, rc);
+  }
+
+  close (fd);
+  free (coded);
+  free (decoded);
+
+  return rc;
+}
+
+int main (int argc, char *argv[]) {
+  /* sizes around the codec's minimum match and the encoder's chunk boundaries */
+  const size_t sizes[] = {0, 1, 5, 12, 13, 64, 4095, 65536 + 7, 256 * 1024, 256 * 1024 + 1, TEST_MAX_SIZE};
+  const size_t pieces[] = {1000, 256 * 1024, TEST_MAX_SIZE};
+  unsigned char *data;
+  int errors = 0;
+
+  data = malloc (TEST_MAX_SIZE);
+  if (NULL == data) {
+    return EXIT_FAILURE;
+  }
+
+  srandom (1234);
+
+  for (int kind = 0 ; kind < 5 ; ++kind) {
+    for (size_t i = 0 ; i < sizeof (sizes) / sizeof (sizes[0]) ; ++i) {
+      fill (data, sizes[i], kind);
+      errors += HIO_SUCCESS != check_raw (data, sizes[i], kind);
+      if (sizes[i]) {
+        errors += HIO_SUCCESS != check_manifest_codec (data, sizes[i]);
+      }
+    }
+
+    fill (data, TEST_MAX_SIZE, kind);
+    for (size_t i = 0 ; i < sizeof (pieces) / sizeof (pieces[0]) ; ++i) {
+      errors += HIO_SUCCESS != check_encoder (data, TEST_MAX_SIZE, pieces[i]);
+    }
+  }
+
+  free (data);
+
+  printf ("lz_test: %d errors\n", errors);
+
+  return errors ? EXIT_FAILURE : EXIT_SUCCESS;
+}
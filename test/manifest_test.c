@@ -0,0 +1,164 @@
+/* -*- Mode: C; c-basic-offset:2 ; indent-tabs-mode:nil -*- */
+/*
+ * Copyright (c) 2017      Los Alamos National Security, LLC.  All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/* Binary manifest round-trip test. Writes a dataset with binary manifests, checks
+ * that the binary images survive a conversion to json and back, then reads the
+ * dataset back through the binary manifests. */
+
+#include "test_support.h"
+#include "hio_manifest.h"
+
+#define TEST_BLOCK_SIZE  1024
+#define TEST_BLOCK_COUNT 64
+
+/* convert a binary image to json and back and make sure nothing was lost */
+static int test_image_round_trip (const char *what, unsigned char *image, size_t image_size) {
+  unsigned char *image2 = NULL;
+  size_t image2_size = 0;
+  json_object *object;
+  int rc;
+
+  rc = hioi_manifest_binary_to_json (image, image_size, &object);
+  if (HIO_SUCCESS != rc) {
+    fprintf (stderr, "%d: could not convert %s binary manifest to json. rc: %d\n", test_rank, what, rc);
+    return rc;
+  }
+
+  rc = hioi_manifest_serialize_binary (object, &image2, &image2_size);
+  json_object_put (object);
+  if (HIO_SUCCESS != rc) {
+    fprintf (stderr, "%d: could not convert %s json manifest to binary. rc: %d\n", test_rank, what, rc);
+    return rc;
+  }
+
+  if (image_size != image2_size || memcmp (image, image2, image_size)) {
+    fprintf (stderr, "%d: %s binary manifest changed after a round trip through json. size %lu -> %lu\n",
+             test_rank, what, (unsigned long) image_size, (unsigned long) image2_size);
+    rc = HIO_ERROR;
+  }
+
+  free (image2);
+
+  return rc;
+}
+
+/* read a manifest file written by the library and run it through the round trip */
+static int test_file_round_trip (hio_context_t context, const char *path) {
+  unsigned char *image = NULL;
+  hio_manifest_t manifest;
+  size_t image_size = 0;
+  int rc;
+
+  rc = hioi_manifest_read (context, path, &manifest);
+  if (HIO_SUCCESS != rc) {
+    fprintf (stderr, "%d: could not read manifest %s. rc: %d\n", test_rank, path, rc);
+    return rc;
+  }
+
+  rc = hioi_manifest_take_binary (manifest, &image, &image_size);
+  hioi_manifest_release (manifest);
+  if (HIO_SUCCESS == rc) {
+    rc = test_image_round_trip (path, image, image_size);
+    free (image);
+  }
+
+  return rc;
+}
+
+int main (int argc, char *argv[]) {
+  char root[512], path[1024];
+  hio_context_t context;
+  hio_dataset_t dataset;
+  unsigned char *image;
+  size_t image_size;
+  int rc, errors = 0;
+  FILE *fh;
+
+  if (HIO_SUCCESS != test_init (&argc, &argv, "manifest_test", &context)) {
+    return EXIT_FAILURE;
+  }
+
+  rc = test_dataset_open (context, &dataset, "binary", 1, HIO_FLAG_CREAT | HIO_FLAG_WRITE | HIO_FLAG_TRUNC,
+                          HIO_SET_ELEMENT_UNIQUE, "dataset_file_mode", "file_per_node",
+                          "dataset_manifest_format", "binary", NULL);
+  if (HIO_SUCCESS != rc) {
+    return test_fini (&context, "manifest_test", 1);
+  }
+
+  /* write every other block so each element has many segments */
+  for (int e = 0 ; e < 2 ; ++e) {
+    snprintf (path, sizeof (path), "element%d", e);
+    for (int b = 0 ; b < TEST_BLOCK_COUNT ; b += 2) {
+      errors += test_element_write (dataset, path, e, (off_t) b * TEST_BLOCK_SIZE, TEST_BLOCK_SIZE);
+    }
+  }
+
+  /* the in-memory manifest of the open dataset */
+  rc = hioi_manifest_generate_binary_image (dataset, false, &image, &image_size);
+  if (HIO_SUCCESS == rc) {
+    rc = test_image_round_trip ("generated", image, image_size);
+    free (image);
+  }
+
+  if (HIO_SUCCESS != rc) {
+    ++errors;
+  }
+
+  test_dataset_close (&dataset);
+
+  /* the manifests written at close. only checked with a single posix data root since the
+   * dataset may otherwise land on any of the roots */
+  if (test_posix_root (context, root, sizeof (root))) {
+    snprintf (path, sizeof (path), "%s/manifest_test.hio/binary/1/manifest.hbin", root);
+    if (0 == test_rank && HIO_SUCCESS != test_file_round_trip (context, path)) {
+      ++errors;
+    }
+
+    snprintf (path, sizeof (path), "%s/manifest_test.hio/binary/1/manifest.%x.hbin", root, test_rank);
+    fh = fopen (path, "r");
+    if (NULL != fh) {
+      fclose (fh);
+      if (HIO_SUCCESS != test_file_round_trip (context, path)) {
+        ++errors;
+      }
+    }
+  }
+
+  /* read the data back through the binary manifests */
+  rc = test_dataset_open (context, &dataset, "binary", 1, HIO_FLAG_READ, HIO_SET_ELEMENT_UNIQUE, NULL);
+  if (HIO_SUCCESS != rc) {
+    return test_fini (&context, "manifest_test", errors + 1);
+  }
+
+  for (int e = 0 ; e < 2 ; ++e) {
+    hio_element_t element;
+    int64_t size;
+
+    snprintf (path, sizeof (path), "element%d", e);
+    hio_element_open (dataset, &element, path, HIO_FLAG_READ);
+    hio_element_size (element, &size);
+    hio_element_close (&element);
+    if ((TEST_BLOCK_COUNT - 1) * TEST_BLOCK_SIZE != size) {
+      fprintf (stderr, "%d: unexpected size of %s: %lld\n", test_rank, path, (long long) size);
+      ++errors;
+    }
+
+    for (int b = 0 ; b < TEST_BLOCK_COUNT ; b += 2) {
+      errors += test_element_check (dataset, path, e, (off_t) b * TEST_BLOCK_SIZE, TEST_BLOCK_SIZE);
+    }
+  }
+
+  hio_dataset_close (dataset);
+  hio_dataset_unlink (context, "binary", 1, HIO_UNLINK_MODE_FIRST);
+  hio_dataset_free (&dataset);
+
+  return test_fini (&context, "manifest_test", errors);
+}
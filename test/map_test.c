@@ -0,0 +1,154 @@
+/* -*- Mode: C; c-basic-offset:2 ; indent-tabs-mode:nil -*- */
+/*
+ * Copyright (c) 2017      Los Alamos National Security, LLC.  All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/* Segment map test. Writes interleaved blocks from every rank to shared elements in
+ * file_per_node mode and reads back the blocks written by a different rank with each
+ * dataset_map_engine (hash and range). Also reads every rank's blocks with a single
+ * large read so the range engine has to resolve a run of segments at once. Segments are
+ * only looked up in the map when they were written on another node so run with more than
+ * one node to cover the remote lookups. */
+
+#include "test_support.h"
+
+#define TEST_BLOCK_SIZE    4096
+#define TEST_BLOCK_COUNT   16
+#define TEST_ELEMENT_COUNT 3
+
+/* offset of a block written by a rank */
+static off_t block_offset (int rank, int block) {
+  return ((off_t) block * test_size + rank) * TEST_BLOCK_SIZE;
+}
+
+static int write_dataset (hio_context_t context, const char *engine) {
+  hio_dataset_t dataset;
+  char element[32];
+  int rc, errors = 0;
+
+  rc = test_dataset_open (context, &dataset, engine, 1, HIO_FLAG_CREAT | HIO_FLAG_WRITE | HIO_FLAG_TRUNC,
+                          HIO_SET_ELEMENT_SHARED, "dataset_file_mode", "file_per_node", NULL);
+  if (HIO_SUCCESS != rc) {
+    return 1;
+  }
+
+  for (int e = 0 ; e < TEST_ELEMENT_COUNT ; ++e) {
+    snprintf (element, sizeof (element), "element%d", e);
+    for (int b = 0 ; b < TEST_BLOCK_COUNT ; ++b) {
+      errors += test_element_write (dataset, element, e, block_offset (test_rank, b), TEST_BLOCK_SIZE);
+    }
+  }
+
+  test_dataset_close (&dataset);
+
+  return errors;
+}
+
+static int read_dataset (hio_context_t context, const char *engine, unsigned char *buffer) {
+  const size_t element_size = (size_t) TEST_BLOCK_COUNT * test_size * TEST_BLOCK_SIZE;
+  int other = (test_rank + 1) % test_size;
+  hio_dataset_t dataset;
+  hio_element_t element;
+  char name[32], *value;
+  int rc, errors = 0;
+  ssize_t count;
+
+  rc = test_dataset_open (context, &dataset, engine, 1, HIO_FLAG_READ, HIO_SET_ELEMENT_SHARED,
+                          "dataset_map_engine", engine, NULL);
+  if (HIO_SUCCESS != rc) {
+    return 1;
+  }
+
+  value = test_config_value (&dataset->ds_object, "dataset_map_engine");
+  if (NULL == value || strcmp (value, engine)) {
+    fprintf (stderr, "%d: dataset_map_engine is %s. expected %s\n", test_rank, value ? value : "(null)", engine);
+    ++errors;
+  }
+  free (value);
+
+  for (int e = 0 ; e < TEST_ELEMENT_COUNT ; ++e) {
+    snprintf (name, sizeof (name), "element%d", e);
+    rc = hio_element_open (dataset, &element, name, HIO_FLAG_READ);
+    if (HIO_SUCCESS != rc) {
+      fprintf (stderr, "%d: could not open element %s. rc: %d\n", test_rank, name, rc);
+      ++errors;
+      continue;
+    }
+
+    /* blocks written by the next rank, in reverse order */
+    for (int b = TEST_BLOCK_COUNT - 1 ; b >= 0 ; --b) {
+      memset (buffer, 0, TEST_BLOCK_SIZE);
+      count = hio_element_read (element, block_offset (other, b), 0, buffer, 1, TEST_BLOCK_SIZE);
+      if (TEST_BLOCK_SIZE != count ||
+          !test_check_rank (buffer, other, e, block_offset (other, b), TEST_BLOCK_SIZE)) {
+        fprintf (stderr, "%d: bad data in block %d of %s written by rank %d using the %s engine. count: %ld\n",
+                 test_rank, b, name, other, engine, (long) count);
+        ++errors;
+      }
+    }
+
+    /* the whole element in one read */
+    memset (buffer, 0, element_size);
+    count = hio_element_read (element, 0, 0, buffer, 1, element_size);
+    if ((ssize_t) element_size != count) {
+      fprintf (stderr, "%d: read of all of %s returned %ld using the %s engine\n", test_rank, name, (long) count,
+               engine);
+      ++errors;
+    } else {
+      for (int b = 0 ; b < TEST_BLOCK_COUNT ; ++b) {
+        for (int r = 0 ; r < test_size ; ++r) {
+          off_t offset = block_offset (r, b);
+
+          if (!test_check_rank (buffer + offset, r, e, offset, TEST_BLOCK_SIZE)) {
+            fprintf (stderr, "%d: bad data in block %d of %s written by rank %d using the %s engine\n",
+                     test_rank, b, name, r, engine);
+            ++errors;
+          }
+        }
+      }
+    }
+
+    hio_element_close (&element);
+  }
+
+  test_dataset_close (&dataset);
+
+  return errors;
+}
+
+int main (int argc, char *argv[]) {
+  const char *engines[] = {"hash", "range"};
+  hio_context_t context;
+  unsigned char *buffer;
+  int errors = 0;
+
+  if (HIO_SUCCESS != test_init (&argc, &argv, "map_test", &context)) {
+    return EXIT_FAILURE;
+  }
+
+  buffer = malloc ((size_t) TEST_BLOCK_COUNT * test_size * TEST_BLOCK_SIZE);
+  if (NULL == buffer) {
+    fprintf (stderr, "Could not allocate buffer\n");
+    return EXIT_FAILURE;
+  }
+
+  for (int i = 0 ; i < 2 ; ++i) {
+    errors += write_dataset (context, engines[i]);
+    errors += read_dataset (context, engines[i], buffer);
+
+    test_barrier ();
+    if (0 == test_rank) {
+      hio_dataset_unlink (context, engines[i], 1, HIO_UNLINK_MODE_FIRST);
+    }
+  }
+
+  free (buffer);
+
+  return test_fini (&context, "map_test", errors);
+}
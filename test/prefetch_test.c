@@ -0,0 +1,186 @@
+/* -*- Mode: C; c-basic-offset:2 ; indent-tabs-mode:nil -*- */
+/*
+ * Copyright (c) 2017      Los Alamos National Security, LLC.  All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/* Datawarp prefetch test. Writes several dataset ids to the PFS, then restarts with
+ * datawarp in front of the PFS and datawarp_prefetch enabled and checks that the newest
+ * id is staged into the burst buffer and that reads return the same data before and
+ * after the prefetch completes. Requires the datawarp emulation (--with-datawarp=emulate)
+ * and a single posix data root. */
+
+#include "test_support.h"
+
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define TEST_ELEMENT_SIZE (1024 * 1024)
+#define TEST_ID_COUNT     3
+#define TEST_MAX_WAIT     60
+
+#if HIO_USE_DATAWARP && HIO_DATAWARP_EMULATE
+
+static int write_dataset (hio_context_t context, int64_t id) {
+  hio_dataset_t dataset;
+  int rc, errors;
+
+  rc = test_dataset_open (context, &dataset, "prefetch", id, HIO_FLAG_CREAT | HIO_FLAG_WRITE | HIO_FLAG_TRUNC,
+                          HIO_SET_ELEMENT_UNIQUE, NULL);
+  if (HIO_SUCCESS != rc) {
+    return 1;
+  }
+
+  errors = test_element_write (dataset, "element", id, 0, TEST_ELEMENT_SIZE);
+  test_dataset_close (&dataset);
+
+  return errors;
+}
+
+/* open the newest id and check its contents. the data root the id was read from is
+ * returned in from_bb */
+static int read_newest (hio_context_t context, const char *bb_path, bool *from_bb) {
+  hio_dataset_t dataset;
+  int64_t id = -1;
+  int rc, errors = 0;
+
+  rc = test_dataset_open (context, &dataset, "prefetch", HIO_DATASET_ID_NEWEST, HIO_FLAG_READ,
+                          HIO_SET_ELEMENT_UNIQUE, NULL);
+  if (HIO_SUCCESS != rc) {
+    return 1;
+  }
+
+  hio_dataset_get_id (dataset, &id);
+  if (TEST_ID_COUNT != id) {
+    fprintf (stderr, "%d: newest dataset id is %ld. expected %d\n", test_rank, (long) id, TEST_ID_COUNT);
+    ++errors;
+  }
+
+  *from_bb = 0 == strncmp (dataset->ds_module->data_root, bb_path, strlen (bb_path));
+
+  if (test_element_check (dataset, "element", id, 0, TEST_ELEMENT_SIZE)) {
+    fprintf (stderr, "%d: bad data in dataset id %ld read from %s\n", test_rank, (long) id,
+             dataset->ds_module->data_root);
+    ++errors;
+  }
+
+  test_dataset_close (&dataset);
+
+  return errors;
+}
+
+/* wait for the prefetch of the newest id to be moved into place on the burst buffer */
+static int wait_prefetch (const char *bb_path) {
+  char path[1024];
+  int found = 0;
+
+  if (0 == test_rank) {
+    snprintf (path, sizeof (path), "%s/prefetch_test.hio/prefetch/%d", bb_path, TEST_ID_COUNT);
+    for (int i = 0 ; i < TEST_MAX_WAIT && !found ; ++i) {
+      found = 0 == access (path, F_OK);
+      if (!found) {
+        sleep (1);
+      }
+    }
+
+    if (!found) {
+      fprintf (stderr, "%d: dataset was not prefetched into %s\n", test_rank, path);
+    }
+  }
+
+#if HIO_MPI_HAVE(1)
+  MPI_Bcast (&found, 1, MPI_INT, 0, MPI_COMM_WORLD);
+#endif
+
+  return !found;
+}
+
+static int test_prefetch (const char *config_file, const char *pfs_path) {
+  char bb_path[600], roots[600];
+  hio_context_t context;
+  bool from_bb = false;
+  int rc, errors = 0;
+
+  snprintf (bb_path, sizeof (bb_path), "%s/prefetch_test.bb", pfs_path);
+  snprintf (roots, sizeof (roots), "datawarp,posix:%s", pfs_path);
+
+  if (0 == test_rank && 0 != mkdir (bb_path, 0755) && EEXIST != errno) {
+    fprintf (stderr, "Could not create burst buffer directory %s. errno: %d\n", bb_path, errno);
+    return 1;
+  }
+  test_barrier ();
+
+  rc = test_context_init ("prefetch_test", config_file, &context);
+  if (HIO_SUCCESS != rc) {
+    return 1;
+  }
+
+  /* the io modules are created on first use so the data roots can still be changed */
+  hio_config_set_value (&context->c_object, "datawarp_root", bb_path);
+  hio_config_set_value (&context->c_object, "datawarp_prefetch", "1");
+  hio_config_set_value (&context->c_object, "data_roots", roots);
+
+  /* the first open starts the prefetch. the data must be correct whether it is read
+   * from the PFS or from a completed prefetch */
+  errors += read_newest (context, bb_path, &from_bb);
+
+  errors += wait_prefetch (bb_path);
+  test_barrier ();
+
+  errors += read_newest (context, bb_path, &from_bb);
+  if (!from_bb) {
+    fprintf (stderr, "%d: prefetched dataset was not read from the burst buffer\n", test_rank);
+    ++errors;
+  }
+
+  /* remove every copy of the test datasets from both data roots */
+  test_barrier ();
+  if (0 == test_rank) {
+    for (int64_t id = 1 ; id <= TEST_ID_COUNT ; ++id) {
+      hio_dataset_unlink (context, "prefetch", id, HIO_UNLINK_MODE_ALL);
+    }
+  }
+
+  hio_fini (&context);
+
+  return errors;
+}
+
+int main (int argc, char *argv[]) {
+  hio_context_t context;
+  char pfs_path[512];
+  int errors = 0;
+
+  if (HIO_SUCCESS != test_init (&argc, &argv, "prefetch_test", &context)) {
+    return EXIT_FAILURE;
+  }
+
+  if (!test_posix_root (context, pfs_path, sizeof (pfs_path))) {
+    return test_skip (&context, "prefetch_test", "requires a single posix data root");
+  }
+
+  for (int64_t id = 1 ; id <= TEST_ID_COUNT ; ++id) {
+    errors += write_dataset (context, id);
+  }
+
+  hio_fini (&context);
+
+  errors += test_prefetch (argv[1], pfs_path);
+
+  return test_fini (NULL, "prefetch_test", errors);
+}
+
+#else
+
+int main (int argc, char *argv[]) {
+  printf ("prefetch_test: skipped. requires the datawarp emulation\n");
+  return TEST_SKIPPED;
+}
+
+#endif
@@ -0,0 +1,147 @@
+/* -*- Mode: C; c-basic-offset:2 ; indent-tabs-mode:nil -*- */
+/*
+ * Copyright (c) 2017      Los Alamos National Security, LLC.  All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/* Data root selection test. Splits the posix data root into two data roots and checks
+ * that new datasets try each data root once before the measured statistics are used,
+ * that a dataset whose create fails on one data root is written to the other, that a
+ * data root that keeps failing is no longer selected, and that every dataset can be
+ * read back. Requires a single posix data root. */
+
+#include "test_support.h"
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define TEST_DATA_SIZE 65536
+
+static char roots[2][600];
+
+/* data root the dataset directory was created in or -1 */
+static int dataset_root (const char *name, int64_t id) {
+  char path[1024];
+  struct stat info;
+
+  for (int i = 0 ; i < 2 ; ++i) {
+    snprintf (path, sizeof (path), "%s/root_test.hio/%s/%ld", roots[i], name, (long) id);
+    if (0 == stat (path, &info) && S_ISDIR(info.st_mode)) {
+      return i;
+    }
+  }
+
+  return -1;
+}
+
+static int write_dataset (hio_context_t context, const char *name, int64_t id, int expected) {
+  hio_dataset_t dataset;
+  int selected, root, errors = 0;
+
+  if (HIO_SUCCESS != test_dataset_open (context, &dataset, name, id, HIO_FLAG_CREAT | HIO_FLAG_WRITE |
+                                        HIO_FLAG_TRUNC, HIO_SET_ELEMENT_UNIQUE, NULL)) {
+    return 1;
+  }
+
+  selected = (int) test_perf_value (&context->c_object, "data_root_selected");
+  errors += test_element_write (dataset, "element", id, 0, TEST_DATA_SIZE);
+  test_dataset_close (&dataset);
+
+  root = dataset_root (name, id);
+  if ((-1 != expected && expected != selected) || root != selected) {
+    fprintf (stderr, "%d: dataset %s:%ld was written to data root %d. selected: %d, expected: %d\n", test_rank,
+             name, (long) id, root, selected, expected);
+    ++errors;
+  }
+
+  return errors;
+}
+
+static int read_dataset (hio_context_t context, const char *name, int64_t id) {
+  hio_dataset_t dataset;
+  int errors;
+
+  if (HIO_SUCCESS != test_dataset_open (context, &dataset, name, id, HIO_FLAG_READ, HIO_SET_ELEMENT_UNIQUE, NULL)) {
+    return 1;
+  }
+
+  errors = test_element_check (dataset, "element", id, 0, TEST_DATA_SIZE);
+  test_dataset_close (&dataset);
+
+  return errors;
+}
+
+int main (int argc, char *argv[]) {
+  char root[512], data_roots[1300], blocker[700];
+  hio_context_t context;
+  int errors = 0;
+
+  if (HIO_SUCCESS != test_init (&argc, &argv, "root_test", &context)) {
+    return EXIT_FAILURE;
+  }
+
+  if (!test_posix_root (context, root, sizeof (root))) {
+    return test_skip (&context, "root_test", "requires a single posix data root");
+  }
+
+  for (int i = 0 ; i < 2 ; ++i) {
+    snprintf (roots[i], sizeof (roots[i]), "%s/root_test.%d", root, i);
+    if (0 == test_rank) {
+      mkdir (roots[i], 0755);
+    }
+  }
+
+  /* the data roots are used once the first dataset is allocated */
+  snprintf (data_roots, sizeof (data_roots), "posix:%s,posix:%s", roots[0], roots[1]);
+  hio_config_set_value (&context->c_object, "data_roots", data_roots);
+  test_barrier ();
+
+  /* data roots without measurements are tried first */
+  errors += write_dataset (context, "data", 1, 0);
+  errors += write_dataset (context, "data", 2, 1);
+
+  /* a file in place of the dataset name directory makes every create on the second data
+   * root fail */
+  snprintf (blocker, sizeof (blocker), "%s/root_test.hio/fail", roots[1]);
+  if (0 == test_rank) {
+    FILE *fh = fopen (blocker, "w");
+    if (NULL != fh) {
+      fclose (fh);
+    }
+  }
+  test_barrier ();
+
+  for (int64_t id = 1 ; id <= 4 ; ++id) {
+    errors += write_dataset (context, "fail", id, 0);
+  }
+
+  /* rank 0 keeps the statistics. the failing data root is skipped after two failures */
+  if (0 == test_rank && 2 < context->c_module_stats[1].ms_failures) {
+    fprintf (stderr, "%d: the failing data root was tried %d times\n", test_rank,
+             context->c_module_stats[1].ms_failures);
+    ++errors;
+  }
+
+  errors += read_dataset (context, "data", 1);
+  errors += read_dataset (context, "data", 2);
+  for (int64_t id = 1 ; id <= 4 ; ++id) {
+    errors += read_dataset (context, "fail", id);
+  }
+
+  test_barrier ();
+  if (0 == test_rank) {
+    unlink (blocker);
+    hio_dataset_unlink (context, "data", 1, HIO_UNLINK_MODE_ALL);
+    hio_dataset_unlink (context, "data", 2, HIO_UNLINK_MODE_ALL);
+    for (int64_t id = 1 ; id <= 4 ; ++id) {
+      hio_dataset_unlink (context, "fail", id, HIO_UNLINK_MODE_ALL);
+    }
+  }
+
+  return test_fini (&context, "root_test", errors);
+}
@@ -0,0 +1,179 @@
+/* -*- Mode: C; c-basic-offset:2 ; indent-tabs-mode:nil -*- */
+/*
+ * Copyright (c) 2017      Los Alamos National Security, LLC.  All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/* Parallel data manifest read test. Every rank writes interleaved blocks to shared
+ * elements in file_per_node mode (so each rank leaves a data manifest) with one element
+ * written only by the odd ranks. The dataset is then opened with different values of
+ * dataset_manifest_read_threads and the merged view of every element is checked. */
+
+#include "test_support.h"
+
+#define TEST_BLOCK_SIZE  1024
+#define TEST_BLOCK_COUNT 32
+
+static const char *elements[] = {"all", "odd"};
+
+static off_t block_offset (int rank, int block) {
+  return ((off_t) block * test_size + rank) * TEST_BLOCK_SIZE;
+}
+
+static bool element_writer (int e, int rank) {
+  return 0 == e || (rank & 1);
+}
+
+static int write_dataset (hio_context_t context) {
+  hio_dataset_t dataset;
+  int rc, errors = 0;
+
+  rc = test_dataset_open (context, &dataset, "scatter", 1, HIO_FLAG_CREAT | HIO_FLAG_WRITE | HIO_FLAG_TRUNC,
+                          HIO_SET_ELEMENT_SHARED, "dataset_file_mode", "file_per_node", NULL);
+  if (HIO_SUCCESS != rc) {
+    return 1;
+  }
+
+  for (int e = 0 ; e < 2 ; ++e) {
+    if (!element_writer (e, test_rank)) {
+      continue;
+    }
+
+    /* reverse order so each data manifest has to be sorted */
+    for (int b = TEST_BLOCK_COUNT - 1 ; b >= 0 ; --b) {
+      errors += test_element_write (dataset, elements[e], e, block_offset (test_rank, b), TEST_BLOCK_SIZE);
+    }
+  }
+
+  test_dataset_close (&dataset);
+
+  return errors;
+}
+
+static int read_dataset (hio_context_t context, const char *threads, unsigned char *buffer) {
+  const size_t element_size = (size_t) TEST_BLOCK_COUNT * test_size * TEST_BLOCK_SIZE;
+  hio_dataset_t dataset;
+  hio_element_t element;
+  int rc, errors = 0;
+  char *value;
+
+  rc = test_dataset_open (context, &dataset, "scatter", 1, HIO_FLAG_READ, HIO_SET_ELEMENT_SHARED,
+                          "dataset_manifest_read_threads", threads, NULL);
+  if (HIO_SUCCESS != rc) {
+    return 1;
+  }
+
+  value = test_config_value (&dataset->ds_object, "dataset_manifest_read_threads");
+  if (NULL == value || strcmp (value, threads)) {
+    fprintf (stderr, "%d: dataset_manifest_read_threads is %s. expected %s\n", test_rank, value ? value : "(null)",
+             threads);
+    ++errors;
+  }
+  free (value);
+
+  /* the first rank on the node reads the data manifests */
+  if (0 == test_rank && 0 == test_perf_value (&dataset->ds_object, "manifest_read_time_usec")) {
+    fprintf (stderr, "%d: manifest_read_time_usec was not set with %s threads\n", test_rank, threads);
+    ++errors;
+  }
+
+  for (int e = 0 ; e < 2 ; ++e) {
+    ssize_t count;
+
+    rc = hio_element_open (dataset, &element, elements[e], HIO_FLAG_READ);
+    if (HIO_SUCCESS != rc) {
+      if (1 < test_size || 0 == e) {
+        fprintf (stderr, "%d: could not open element %s with %s threads. rc: %d\n", test_rank, elements[e],
+                 threads, rc);
+        ++errors;
+      }
+      continue;
+    }
+
+    /* the whole element in one read. the odd element starts with a block that was not
+     * written and reads stop at the first block that was not written */
+    if (0 == e) {
+      memset (buffer, 0, element_size);
+      count = hio_element_read (element, 0, 0, buffer, 1, element_size);
+      if ((ssize_t) element_size != count) {
+        fprintf (stderr, "%d: read of all of %s returned %ld with %s threads\n", test_rank, elements[e],
+                 (long) count, threads);
+        ++errors;
+      }
+
+      for (int b = 0 ; b < TEST_BLOCK_COUNT && (ssize_t) element_size == count ; ++b) {
+        for (int r = 0 ; r < test_size ; ++r) {
+          off_t offset = block_offset (r, b);
+
+          if (!test_check_rank (buffer + offset, r, e, offset, TEST_BLOCK_SIZE)) {
+            fprintf (stderr, "%d: bad data in block %d of %s written by rank %d with %s threads\n", test_rank,
+                     b, elements[e], r, threads);
+            ++errors;
+          }
+        }
+      }
+    }
+
+    /* every block on its own */
+    for (int b = 0 ; b < TEST_BLOCK_COUNT ; ++b) {
+      for (int r = 0 ; r < test_size ; ++r) {
+        off_t offset = block_offset (r, b);
+
+        if (!element_writer (e, r)) {
+          continue;
+        }
+
+        memset (buffer, 0, TEST_BLOCK_SIZE);
+        count = hio_element_read (element, offset, 0, buffer, 1, TEST_BLOCK_SIZE);
+        if (TEST_BLOCK_SIZE != count || !test_check_rank (buffer, r, e, offset, TEST_BLOCK_SIZE)) {
+          fprintf (stderr, "%d: bad data in block %d of %s written by rank %d with %s threads. count: %ld\n",
+                   test_rank, b, elements[e], r, threads, (long) count);
+          ++errors;
+        }
+      }
+    }
+
+    hio_element_close (&element);
+  }
+
+  test_dataset_close (&dataset);
+
+  return errors;
+}
+
+int main (int argc, char *argv[]) {
+  const char *threads[] = {"1", "2", "8"};
+  hio_context_t context;
+  unsigned char *buffer;
+  int errors = 0;
+
+  if (HIO_SUCCESS != test_init (&argc, &argv, "scatter_test", &context)) {
+    return EXIT_FAILURE;
+  }
+
+  buffer = malloc ((size_t) TEST_BLOCK_COUNT * test_size * TEST_BLOCK_SIZE);
+  if (NULL == buffer) {
+    fprintf (stderr, "Could not allocate buffer\n");
+    return EXIT_FAILURE;
+  }
+
+  errors += write_dataset (context);
+
+  for (int i = 0 ; i < 3 ; ++i) {
+    errors += read_dataset (context, threads[i], buffer);
+  }
+
+  free (buffer);
+
+  test_barrier ();
+  if (0 == test_rank) {
+    hio_dataset_unlink (context, "scatter", 1, HIO_UNLINK_MODE_FIRST);
+  }
+
+  return test_fini (&context, "scatter_test", errors);
+}
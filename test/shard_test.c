@@ -0,0 +1,189 @@
+/* -*- Mode: C; c-basic-offset:2 ; indent-tabs-mode:nil -*- */
+/*
+ * Copyright (c) 2017      Los Alamos National Security, LLC.  All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/* Dataset statistics shard test. Updates the statistics of a dataset from more threads
+ * than there are shards and checks that no update is lost, then writes a separate
+ * element from each of several threads and checks that the byte and call counts are
+ * the sums of the writes of all threads and that every element reads back. */
+
+#include "test_support.h"
+
+#include <pthread.h>
+
+#define TEST_STAT_THREADS  (HIO_STAT_SHARDS + 8)
+#define TEST_STAT_UPDATES  100000
+#define TEST_IO_THREADS    8
+#define TEST_WRITE_COUNT   8
+#define TEST_WRITE_SIZE    (1024 * 1024)
+
+typedef struct test_thread_t {
+  pthread_t thread;
+  hio_dataset_t dataset;
+  hio_element_t element;
+  int index;
+  int errors;
+} test_thread_t;
+
+static void *stat_thread (void *arg) {
+  test_thread_t *thread = (test_thread_t *) arg;
+
+  for (int i = 0 ; i < TEST_STAT_UPDATES ; ++i) {
+    hioi_dataset_stat_add (thread->dataset, HIO_STAT_RCOUNT, 1);
+    hioi_dataset_stat_add (thread->dataset, HIO_STAT_CKBYTES, thread->index + 1);
+  }
+
+  return NULL;
+}
+
+static void *write_thread (void *arg) {
+  test_thread_t *thread = (test_thread_t *) arg;
+  unsigned char *buffer = malloc (TEST_WRITE_SIZE);
+
+  if (NULL == buffer) {
+    thread->errors = 1;
+    return NULL;
+  }
+
+  for (int i = 0 ; i < TEST_WRITE_COUNT ; ++i) {
+    off_t offset = (off_t) i * TEST_WRITE_SIZE;
+
+    test_fill (buffer, thread->index, offset, TEST_WRITE_SIZE);
+    if (TEST_WRITE_SIZE != hio_element_write (thread->element, offset, 0, buffer, 1, TEST_WRITE_SIZE)) {
+      fprintf (stderr, "%d: thread %d could not write block %d\n", test_rank, thread->index, i);
+      ++thread->errors;
+    }
+  }
+
+  free (buffer);
+
+  return NULL;
+}
+
+static int check_stats (hio_context_t context) {
+  test_thread_t threads[TEST_STAT_THREADS];
+  uint64_t count, bytes, expected_bytes = 0;
+  hio_dataset_t dataset;
+
+  if (HIO_SUCCESS != test_dataset_open (context, &dataset, "shard", 1, HIO_FLAG_CREAT | HIO_FLAG_WRITE |
+                                        HIO_FLAG_TRUNC, HIO_SET_ELEMENT_UNIQUE, NULL)) {
+    return 1;
+  }
+
+  for (int i = 0 ; i < TEST_STAT_THREADS ; ++i) {
+    threads[i].dataset = dataset;
+    threads[i].index = i;
+    pthread_create (&threads[i].thread, NULL, stat_thread, threads + i);
+    expected_bytes += (uint64_t) (i + 1) * TEST_STAT_UPDATES;
+  }
+
+  for (int i = 0 ; i < TEST_STAT_THREADS ; ++i) {
+    pthread_join (threads[i].thread, NULL);
+  }
+
+  count = test_perf_value (&dataset->ds_object, "read_count");
+  bytes = test_perf_value (&dataset->ds_object, "checksum_bytes");
+
+  test_dataset_close (&dataset);
+
+  if ((uint64_t) TEST_STAT_THREADS * TEST_STAT_UPDATES != count || expected_bytes != bytes) {
+    fprintf (stderr, "%d: statistics updated by %d threads: count %lu, bytes %lu. expected %lu and %lu\n",
+             test_rank, TEST_STAT_THREADS, (unsigned long) count, (unsigned long) bytes,
+             (unsigned long) TEST_STAT_THREADS * TEST_STAT_UPDATES, (unsigned long) expected_bytes);
+    return 1;
+  }
+
+  return 0;
+}
+
+static int check_writes (hio_context_t context) {
+  const uint64_t expected = (uint64_t) TEST_IO_THREADS * TEST_WRITE_COUNT;
+  test_thread_t threads[TEST_IO_THREADS];
+  hio_dataset_t dataset;
+  uint64_t count, bytes;
+  char name[32];
+  int errors = 0;
+
+  if (HIO_SUCCESS != test_dataset_open (context, &dataset, "shard", 2, HIO_FLAG_CREAT | HIO_FLAG_WRITE |
+                                        HIO_FLAG_TRUNC, HIO_SET_ELEMENT_UNIQUE, NULL)) {
+    return 1;
+  }
+
+  /* elements are opened before the threads start */
+  for (int i = 0 ; i < TEST_IO_THREADS ; ++i) {
+    snprintf (name, sizeof (name), "element%d", i);
+    threads[i].index = i;
+    threads[i].errors = 0;
+    if (HIO_SUCCESS != hio_element_open (dataset, &threads[i].element, name, HIO_FLAG_WRITE | HIO_FLAG_CREAT)) {
+      fprintf (stderr, "%d: could not open element %s\n", test_rank, name);
+      test_dataset_close (&dataset);
+      return 1;
+    }
+  }
+
+  for (int i = 0 ; i < TEST_IO_THREADS ; ++i) {
+    pthread_create (&threads[i].thread, NULL, write_thread, threads + i);
+  }
+
+  for (int i = 0 ; i < TEST_IO_THREADS ; ++i) {
+    pthread_join (threads[i].thread, NULL);
+    errors += threads[i].errors;
+  }
+
+  /* writes of this size are not buffered so every byte has been counted */
+  count = test_perf_value (&dataset->ds_object, "write_count");
+  bytes = test_perf_value (&dataset->ds_object, "bytes_written");
+  if (expected != count || expected * TEST_WRITE_SIZE != bytes) {
+    fprintf (stderr, "%d: %d threads wrote %lu times and %lu bytes. expected %lu and %lu\n", test_rank,
+             TEST_IO_THREADS, (unsigned long) count, (unsigned long) bytes, (unsigned long) expected,
+             (unsigned long) expected * TEST_WRITE_SIZE);
+    ++errors;
+  }
+
+  for (int i = 0 ; i < TEST_IO_THREADS ; ++i) {
+    hio_element_close (&threads[i].element);
+  }
+
+  test_dataset_close (&dataset);
+
+  if (HIO_SUCCESS != test_dataset_open (context, &dataset, "shard", 2, HIO_FLAG_READ, HIO_SET_ELEMENT_UNIQUE,
+                                        NULL)) {
+    return errors + 1;
+  }
+
+  for (int i = 0 ; i < TEST_IO_THREADS ; ++i) {
+    snprintf (name, sizeof (name), "element%d", i);
+    errors += test_element_check (dataset, name, i, 0, (size_t) TEST_WRITE_COUNT * TEST_WRITE_SIZE);
+  }
+
+  test_dataset_close (&dataset);
+
+  return errors;
+}
+
+int main (int argc, char *argv[]) {
+  hio_context_t context;
+  int errors = 0;
+
+  if (HIO_SUCCESS != test_init (&argc, &argv, "shard_test", &context)) {
+    return EXIT_FAILURE;
+  }
+
+  errors += check_stats (context);
+  errors += check_writes (context);
+
+  test_barrier ();
+  if (0 == test_rank) {
+    hio_dataset_unlink (context, "shard", 1, HIO_UNLINK_MODE_FIRST);
+    hio_dataset_unlink (context, "shard", 2, HIO_UNLINK_MODE_FIRST);
+  }
+
+  return test_fini (&context, "shard_test", errors);
+}
@@ -0,0 +1,214 @@
+/* -*- Mode: C; c-basic-offset:2 ; indent-tabs-mode:nil -*- */
+/*
+ * Copyright (c) 2017      Los Alamos National Security, LLC.  All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/* Datawarp stage tracker test. Writes dataset ids to datawarp in front of the PFS with
+ * immediate stage out and datawarp_keep_last set to 1 while the emulated stages are
+ * slowed down. Checks that the stage of the first id is tracked, that closing the second
+ * id defers the removal of the first one instead of waiting for its stage, that the
+ * tracker removes it from the burst buffer once its stage completes, and that the staged
+ * copies can be read back from the PFS. Requires the datawarp emulation
+ * (--with-datawarp=emulate) and a single posix data root. */
+
+#include "test_support.h"
+
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define TEST_ELEMENT_SIZE (1024 * 1024)
+#define TEST_MAX_WAIT     60
+
+#if HIO_USE_DATAWARP && HIO_DATAWARP_EMULATE
+
+static char bb_path[600], pfs_path[512];
+
+static bool bb_resident (int64_t id) {
+  char path[1024];
+
+  snprintf (path, sizeof (path), "%s/stage_test.hio/stage/%ld", bb_path, (long) id);
+
+  return 0 == access (path, F_OK);
+}
+
+static int write_dataset (hio_context_t context, int64_t id, int active) {
+  hio_dataset_t dataset;
+  int rc, errors = 0;
+
+  rc = test_dataset_open (context, &dataset, "stage", id, HIO_FLAG_CREAT | HIO_FLAG_WRITE | HIO_FLAG_TRUNC,
+                          HIO_SET_ELEMENT_UNIQUE, "datawarp_stage_mode", "immediate", "datawarp_keep_last", "1",
+                          "datawarp_stage_poll_interval", "50", NULL);
+  if (HIO_SUCCESS != rc) {
+    return 1;
+  }
+
+  /* rank 0 follows the stages */
+  if (0 == test_rank && active != (int) test_perf_value (&dataset->ds_object, "stage_active_count")) {
+    fprintf (stderr, "%d: %d stages in progress when opening dataset id %ld. expected %d\n", test_rank,
+             (int) test_perf_value (&dataset->ds_object, "stage_active_count"), (long) id, active);
+    ++errors;
+  }
+
+  errors += test_element_write (dataset, "element", id, 0, TEST_ELEMENT_SIZE);
+  test_dataset_close (&dataset);
+
+  return errors;
+}
+
+/* wait until the tracker reports that every stage has finished. the statistics are
+ * read from a dataset that is not staged */
+static int wait_stages (hio_context_t context) {
+  int active = 1, complete = 0, deferred = 0, failed = 0;
+  hio_dataset_t dataset;
+  int rc, errors = 0;
+
+  for (int i = 0 ; i < TEST_MAX_WAIT && active ; ++i) {
+    rc = test_dataset_open (context, &dataset, "stage", 3, HIO_FLAG_CREAT | HIO_FLAG_WRITE | HIO_FLAG_TRUNC,
+                            HIO_SET_ELEMENT_UNIQUE, "datawarp_stage_mode", "disable", NULL);
+    if (HIO_SUCCESS != rc) {
+      return 1;
+    }
+
+    if (0 == test_rank) {
+      active = (int) test_perf_value (&dataset->ds_object, "stage_active_count");
+      complete = (int) test_perf_value (&dataset->ds_object, "stage_complete_count");
+      deferred = (int) test_perf_value (&dataset->ds_object, "stage_deferred_unlink_count");
+      failed = (int) test_perf_value (&dataset->ds_object, "stage_failed_count");
+    }
+
+    test_dataset_close (&dataset);
+
+#if HIO_MPI_HAVE(1)
+    MPI_Bcast (&active, 1, MPI_INT, 0, MPI_COMM_WORLD);
+#endif
+    if (active) {
+      sleep (1);
+    }
+  }
+
+  if (0 == test_rank && (active || 2 != complete || deferred || failed)) {
+    fprintf (stderr, "%d: stages active: %d, complete: %d, failed: %d, deferred unlinks: %d. expected 0, 2, 0, 0\n",
+             test_rank, active, complete, failed, deferred);
+    ++errors;
+  }
+
+  return errors;
+}
+
+static int read_dataset (hio_context_t context, int64_t id) {
+  hio_dataset_t dataset;
+  int errors;
+
+  if (HIO_SUCCESS != test_dataset_open (context, &dataset, "stage", id, HIO_FLAG_READ, HIO_SET_ELEMENT_UNIQUE,
+                                        NULL)) {
+    fprintf (stderr, "%d: could not open dataset id %ld\n", test_rank, (long) id);
+    return 1;
+  }
+
+  errors = test_element_check (dataset, "element", id, 0, TEST_ELEMENT_SIZE);
+  test_dataset_close (&dataset);
+
+  return errors;
+}
+
+static int test_stage (const char *config_file) {
+  hio_context_t context;
+  char roots[600];
+  int rc, errors = 0;
+
+  snprintf (bb_path, sizeof (bb_path), "%s/stage_test.bb", pfs_path);
+  snprintf (roots, sizeof (roots), "datawarp,posix:%s", pfs_path);
+
+  if (0 == test_rank && 0 != mkdir (bb_path, 0755) && EEXIST != errno) {
+    fprintf (stderr, "Could not create burst buffer directory %s. errno: %d\n", bb_path, errno);
+    return 1;
+  }
+  test_barrier ();
+
+  rc = test_context_init ("stage_test", config_file, &context);
+  if (HIO_SUCCESS != rc) {
+    return 1;
+  }
+
+  hio_config_set_value (&context->c_object, "datawarp_root", bb_path);
+  hio_config_set_value (&context->c_object, "data_roots", roots);
+
+  errors += write_dataset (context, 1, 0);
+
+  /* the PFS has not been measured so it would be tried next. keep every id on the burst
+   * buffer (rank 0 selects the data root) */
+  if (0 == test_rank) {
+    context->c_module_stats[1].ms_latency = UINT64_MAX >> 1;
+  }
+
+  errors += write_dataset (context, 2, 1);
+
+  /* keep_last asked for id 1 to be removed while its stage is still running */
+  if (0 == test_rank && !bb_resident (1)) {
+    fprintf (stderr, "%d: dataset id 1 was removed from the burst buffer before its stage completed\n",
+             test_rank);
+    ++errors;
+  }
+
+  errors += wait_stages (context);
+
+  if (0 == test_rank && (bb_resident (1) || !bb_resident (2))) {
+    fprintf (stderr, "%d: burst buffer holds dataset id 1: %d, id 2: %d. expected only id 2\n", test_rank,
+             bb_resident (1), bb_resident (2));
+    ++errors;
+  }
+
+  /* id 1 is only on the PFS now */
+  errors += read_dataset (context, 1);
+  errors += read_dataset (context, 2);
+
+  test_barrier ();
+  if (0 == test_rank) {
+    for (int64_t id = 1 ; id <= 3 ; ++id) {
+      hio_dataset_unlink (context, "stage", id, HIO_UNLINK_MODE_ALL);
+    }
+  }
+
+  hio_fini (&context);
+
+  return errors;
+}
+
+int main (int argc, char *argv[]) {
+  hio_context_t context;
+  int errors = 0;
+
+  /* slow the emulated stages down (MB/s) so they are still running when the next id is
+   * written */
+  setenv ("HIO_DW_EMULATE_BANDWIDTH", "2", 0);
+
+  if (HIO_SUCCESS != test_init (&argc, &argv, "stage_test", &context)) {
+    return EXIT_FAILURE;
+  }
+
+  if (!test_posix_root (context, pfs_path, sizeof (pfs_path))) {
+    return test_skip (&context, "stage_test", "requires a single posix data root");
+  }
+
+  hio_fini (&context);
+
+  errors += test_stage (argv[1]);
+
+  return test_fini (NULL, "stage_test", errors);
+}
+
+#else
+
+int main (int argc, char *argv[]) {
+  printf ("stage_test: skipped. requires the datawarp emulation\n");
+  return TEST_SKIPPED;
+}
+
+#endif
@@ -0,0 +1,212 @@
+/* -*- Mode: C; c-basic-offset:2 ; indent-tabs-mode:nil -*- */
+/*
+ * Copyright (c) 2017      Los Alamos National Security, LLC.  All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/* Streaming manifest writer test. Writes an element with enough segments that its
+ * manifest is larger than the encoder buffer, then saves the manifest of the open
+ * dataset with every codec and checks that each file decodes to the same elements as
+ * the in-memory manifest. The datasets are then closed (writing their manifests with
+ * the streaming writer) and read back. */
+
+#include "test_support.h"
+#include "hio_manifest.h"
+
+#include <unistd.h>
+
+#define TEST_SEGMENT_COUNT 12000
+#define TEST_SEGMENT_SIZE  16
+
+static const char *codecs[] = {"none", "bzip2", "lz"};
+
+/* json text of the element list of a manifest */
+static char *elements_string (json_object *object) {
+  json_object *elements;
+
+  if (!json_object_object_get_ex (object, HIO_MANIFEST_KEY_ELEMENTS, &elements)) {
+    return NULL;
+  }
+
+  return strdup (json_object_to_json_string (elements));
+}
+
+/* number of segments in the first element of a manifest */
+static int segment_count (json_object *object) {
+  json_object *elements, *segments;
+
+  if (!json_object_object_get_ex (object, HIO_MANIFEST_KEY_ELEMENTS, &elements) ||
+      0 == json_object_array_length (elements) ||
+      !json_object_object_get_ex (json_object_array_get_idx (elements, 0), HIO_MANIFEST_KEY_SEGMENTS, &segments)) {
+    return -1;
+  }
+
+  return json_object_array_length (segments);
+}
+
+/* save the manifest of the open dataset and compare the file with the in-memory manifest */
+static int check_save (hio_context_t context, hio_dataset_t dataset, int format, int codec, const char *expected) {
+  hio_manifest_t manifest;
+  json_object *object;
+  char path[256], *saved = NULL;
+  int rc, errors = 0;
+
+  snprintf (path, sizeof (path), "stream_test.tmp.%d.%d.%d", format, codec, test_rank);
+
+  rc = hioi_manifest_save_dataset (dataset, format, codec, path, NULL);
+  if (HIO_SUCCESS != rc) {
+    fprintf (stderr, "%d: could not save manifest with codec %s. rc: %d\n", test_rank, codecs[codec], rc);
+    return 1;
+  }
+
+  rc = hioi_manifest_read (context, path, &manifest);
+  if (HIO_SUCCESS != rc) {
+    fprintf (stderr, "%d: could not read manifest saved with codec %s. rc: %d\n", test_rank, codecs[codec], rc);
+    unlink (path);
+    return 1;
+  }
+
+  object = hioi_manifest_get_json (manifest);
+  if (NULL != object) {
+    saved = elements_string (object);
+    if (TEST_SEGMENT_COUNT != segment_count (object)) {
+      fprintf (stderr, "%d: manifest saved with codec %s has %d segments\n", test_rank, codecs[codec],
+               segment_count (object));
+      ++errors;
+    }
+  }
+
+  if (NULL == saved || strcmp (saved, expected)) {
+    fprintf (stderr, "%d: elements in the %s manifest saved with codec %s do not match the dataset\n", test_rank,
+             (HIO_MANIFEST_FORMAT_BINARY == format) ? "binary" : "json", codecs[codec]);
+    ++errors;
+  }
+
+  free (saved);
+  hioi_manifest_release (manifest);
+  unlink (path);
+
+  return errors;
+}
+
+static int write_dataset (hio_context_t context, int64_t id) {
+  unsigned char buffer[TEST_SEGMENT_SIZE];
+  hio_dataset_t dataset;
+  hio_element_t element;
+  unsigned char *image;
+  json_object *object;
+  size_t image_size;
+  char *expected;
+  int rc, errors = 0;
+
+  rc = test_dataset_open (context, &dataset, "stream", id, HIO_FLAG_CREAT | HIO_FLAG_WRITE | HIO_FLAG_TRUNC,
+                          HIO_SET_ELEMENT_UNIQUE, "dataset_file_mode", "file_per_node", "dataset_use_bzip",
+                          codecs[id - 1], NULL);
+  if (HIO_SUCCESS != rc) {
+    return 1;
+  }
+
+  /* every other block so no two segments can be merged */
+  hio_element_open (dataset, &element, "element", HIO_FLAG_WRITE | HIO_FLAG_CREAT);
+  for (int i = 0 ; i < TEST_SEGMENT_COUNT ; ++i) {
+    off_t offset = (off_t) i * TEST_SEGMENT_SIZE * 2;
+
+    test_fill (buffer, id, offset, TEST_SEGMENT_SIZE);
+    if (TEST_SEGMENT_SIZE != hio_element_write (element, offset, 0, buffer, 1, TEST_SEGMENT_SIZE)) {
+      fprintf (stderr, "%d: error writing segment %d\n", test_rank, i);
+      ++errors;
+      break;
+    }
+  }
+  hio_element_close (&element);
+
+  rc = hioi_manifest_generate_binary_image (dataset, false, &image, &image_size);
+  if (HIO_SUCCESS == rc) {
+    rc = hioi_manifest_binary_to_json (image, image_size, &object);
+    free (image);
+  }
+
+  if (HIO_SUCCESS != rc) {
+    fprintf (stderr, "%d: could not generate the manifest of the open dataset. rc: %d\n", test_rank, rc);
+    test_dataset_close (&dataset);
+    return errors + 1;
+  }
+
+  expected = elements_string (object);
+  json_object_put (object);
+
+  for (int codec = 0 ; codec < 3 ; ++codec) {
+    errors += check_save (context, dataset, HIO_MANIFEST_FORMAT_JSON, codec, expected);
+  }
+  errors += check_save (context, dataset, HIO_MANIFEST_FORMAT_BINARY, HIO_MANIFEST_CODEC_NONE, expected);
+
+  free (expected);
+
+  test_dataset_close (&dataset);
+
+  return errors;
+}
+
+static int read_dataset (hio_context_t context, int64_t id) {
+  unsigned char buffer[TEST_SEGMENT_SIZE];
+  hio_dataset_t dataset;
+  hio_element_t element;
+  int rc, errors = 0;
+
+  rc = test_dataset_open (context, &dataset, "stream", id, HIO_FLAG_READ, HIO_SET_ELEMENT_UNIQUE, NULL);
+  if (HIO_SUCCESS != rc) {
+    return 1;
+  }
+
+  rc = hio_element_open (dataset, &element, "element", HIO_FLAG_READ);
+  if (HIO_SUCCESS != rc) {
+    fprintf (stderr, "%d: could not open element of dataset id %ld. rc: %d\n", test_rank, (long) id, rc);
+    test_dataset_close (&dataset);
+    return 1;
+  }
+
+  for (int i = 0 ; i < TEST_SEGMENT_COUNT ; ++i) {
+    off_t offset = (off_t) i * TEST_SEGMENT_SIZE * 2;
+
+    memset (buffer, 0, sizeof (buffer));
+    if (TEST_SEGMENT_SIZE != hio_element_read (element, offset, 0, buffer, 1, TEST_SEGMENT_SIZE) ||
+        !test_check (buffer, id, offset, TEST_SEGMENT_SIZE)) {
+      fprintf (stderr, "%d: bad data in segment %d of dataset id %ld (codec %s)\n", test_rank, i, (long) id,
+               codecs[id - 1]);
+      ++errors;
+      break;
+    }
+  }
+
+  hio_element_close (&element);
+  test_dataset_close (&dataset);
+
+  return errors;
+}
+
+int main (int argc, char *argv[]) {
+  hio_context_t context;
+  int errors = 0;
+
+  if (HIO_SUCCESS != test_init (&argc, &argv, "stream_test", &context)) {
+    return EXIT_FAILURE;
+  }
+
+  /* dataset id n is written with codec n - 1 */
+  for (int64_t id = 1 ; id <= 3 ; ++id) {
+    errors += write_dataset (context, id);
+    errors += read_dataset (context, id);
+
+    test_barrier ();
+    if (0 == test_rank) {
+      hio_dataset_unlink (context, "stream", id, HIO_UNLINK_MODE_FIRST);
+    }
+  }
+
+  return test_fini (&context, "stream_test", errors);
+}
@@ -0,0 +1,187 @@
+/* -*- Mode: C; c-basic-offset:2 ; indent-tabs-mode:nil -*- */
+/*
+ * Copyright (c) 2017      Los Alamos National Security, LLC.  All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/* Data root striping test. Splits the posix data root into two data roots and writes a
+ * file_per_node dataset with dataset_stripe_data_roots enabled. Checks that both data
+ * roots are recorded in the dataset, that the secondary data root only holds the hidden
+ * stripe directory, that the data reads back, and that unlinking the dataset removes
+ * the stripe directory. Each node writes its data file to one data root so run with
+ * more than one node to cover reads from the secondary data root. Requires a single
+ * posix data root. */
+
+#include "test_support.h"
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define TEST_BLOCK_SIZE  4096
+#define TEST_BLOCK_COUNT 16
+
+static char roots[2][600];
+
+static off_t block_offset (int rank, int block) {
+  return ((off_t) block * test_size + rank) * TEST_BLOCK_SIZE;
+}
+
+static bool is_directory (const char *root, const char *entry) {
+  char path[1024];
+  struct stat info;
+
+  snprintf (path, sizeof (path), "%s/stripe_test.hio/stripe/%s", root, entry);
+
+  return 0 == stat (path, &info) && S_ISDIR(info.st_mode);
+}
+
+/* check that dataset_data_roots lists the primary data root followed by the other one */
+static int check_data_roots (hio_dataset_t dataset, int primary, const char *when) {
+  char *value = test_config_value (&dataset->ds_object, "dataset_data_roots");
+  char expected[1300];
+  int errors = 0;
+
+  snprintf (expected, sizeof (expected), "%s,%s", roots[primary], roots[!primary]);
+  if (NULL == value || strcmp (value, expected)) {
+    fprintf (stderr, "%d: dataset_data_roots %s is %s. expected %s\n", test_rank, when, value ? value : "(null)",
+             expected);
+    ++errors;
+  }
+
+  free (value);
+
+  return errors;
+}
+
+static int write_dataset (hio_context_t context, int *primary) {
+  hio_dataset_t dataset;
+  int rc, errors = 0;
+
+  rc = test_dataset_open (context, &dataset, "stripe", 1, HIO_FLAG_CREAT | HIO_FLAG_WRITE | HIO_FLAG_TRUNC,
+                          HIO_SET_ELEMENT_SHARED, "dataset_file_mode", "file_per_node", "dataset_stripe_data_roots",
+                          "true", NULL);
+  if (HIO_SUCCESS != rc) {
+    return 1;
+  }
+
+  *primary = (int) test_perf_value (&context->c_object, "data_root_selected");
+  errors += check_data_roots (dataset, *primary, "after create");
+
+  for (int b = 0 ; b < TEST_BLOCK_COUNT ; ++b) {
+    errors += test_element_write (dataset, "element", 0, block_offset (test_rank, b), TEST_BLOCK_SIZE);
+  }
+
+  test_dataset_close (&dataset);
+
+  return errors;
+}
+
+static int read_dataset (hio_context_t context, int primary, unsigned char *buffer) {
+  const size_t element_size = (size_t) TEST_BLOCK_COUNT * test_size * TEST_BLOCK_SIZE;
+  hio_dataset_t dataset;
+  hio_element_t element;
+  int rc, errors = 0;
+  ssize_t count;
+
+  rc = test_dataset_open (context, &dataset, "stripe", HIO_DATASET_ID_HIGHEST, HIO_FLAG_READ,
+                          HIO_SET_ELEMENT_SHARED, NULL);
+  if (HIO_SUCCESS != rc) {
+    fprintf (stderr, "%d: could not open the highest dataset id. rc: %d\n", test_rank, rc);
+    return 1;
+  }
+
+  errors += check_data_roots (dataset, primary, "after open");
+
+  rc = hio_element_open (dataset, &element, "element", HIO_FLAG_READ);
+  if (HIO_SUCCESS != rc) {
+    fprintf (stderr, "%d: could not open element. rc: %d\n", test_rank, rc);
+    test_dataset_close (&dataset);
+    return errors + 1;
+  }
+
+  memset (buffer, 0, element_size);
+  count = hio_element_read (element, 0, 0, buffer, 1, element_size);
+  hio_element_close (&element);
+
+  if ((ssize_t) element_size != count) {
+    fprintf (stderr, "%d: read of the element returned %ld\n", test_rank, (long) count);
+    ++errors;
+  } else {
+    for (int b = 0 ; b < TEST_BLOCK_COUNT ; ++b) {
+      for (int r = 0 ; r < test_size ; ++r) {
+        off_t offset = block_offset (r, b);
+
+        if (!test_check_rank (buffer + offset, r, 0, offset, TEST_BLOCK_SIZE)) {
+          fprintf (stderr, "%d: bad data in block %d written by rank %d\n", test_rank, b, r);
+          ++errors;
+        }
+      }
+    }
+  }
+
+  test_dataset_close (&dataset);
+
+  return errors;
+}
+
+int main (int argc, char *argv[]) {
+  char root[512], data_roots[1300];
+  int primary = 0, errors = 0;
+  hio_context_t context;
+  unsigned char *buffer;
+
+  if (HIO_SUCCESS != test_init (&argc, &argv, "stripe_test", &context)) {
+    return EXIT_FAILURE;
+  }
+
+  if (!test_posix_root (context, root, sizeof (root))) {
+    return test_skip (&context, "stripe_test", "requires a single posix data root");
+  }
+
+  buffer = malloc ((size_t) TEST_BLOCK_COUNT * test_size * TEST_BLOCK_SIZE);
+  if (NULL == buffer) {
+    fprintf (stderr, "Could not allocate buffer\n");
+    return EXIT_FAILURE;
+  }
+
+  for (int i = 0 ; i < 2 ; ++i) {
+    snprintf (roots[i], sizeof (roots[i]), "%s/stripe_test.%d", root, i);
+    if (0 == test_rank) {
+      mkdir (roots[i], 0755);
+    }
+  }
+
+  /* the data roots are used once the first dataset is allocated */
+  snprintf (data_roots, sizeof (data_roots), "posix:%s,posix:%s", roots[0], roots[1]);
+  hio_config_set_value (&context->c_object, "data_roots", data_roots);
+  test_barrier ();
+
+  errors += write_dataset (context, &primary);
+
+  /* the dataset id is only visible on the primary data root */
+  if (0 == test_rank && (!is_directory (roots[primary], "1") || is_directory (roots[!primary], "1") ||
+                         !is_directory (roots[!primary], ".stripe.1/data"))) {
+    fprintf (stderr, "%d: unexpected dataset layout across the data roots\n", test_rank);
+    ++errors;
+  }
+
+  errors += read_dataset (context, primary, buffer);
+
+  test_barrier ();
+  if (0 == test_rank) {
+    hio_dataset_unlink (context, "stripe", 1, HIO_UNLINK_MODE_FIRST);
+    if (is_directory (roots[primary], "1") || is_directory (roots[!primary], ".stripe.1")) {
+      fprintf (stderr, "%d: unlinking the dataset did not remove its data from every data root\n", test_rank);
+      ++errors;
+    }
+  }
+
+  free (buffer);
+
+  return test_fini (&context, "stripe_test", errors);
+}
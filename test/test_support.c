@@ -0,0 +1,244 @@
+/* -*- Mode: C; c-basic-offset:2 ; indent-tabs-mode:nil -*- */
+/*
+ * Copyright (c) 2017      Los Alamos National Security, LLC.  All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+#include "test_support.h"
+
+#include <stdarg.h>
+
+int test_rank = 0;
+int test_size = 1;
+
+int test_context_init (const char *name, const char *config_file, hio_context_t *context) {
+  int rc;
+
+#if HIO_MPI_HAVE(1)
+  rc = hio_init_mpi (context, NULL, config_file, "#HIO.", name);
+#else
+  rc = hio_init_single (context, config_file, "#HIO.", name);
+#endif
+  if (HIO_SUCCESS != rc) {
+    fprintf (stderr, "%d: could not initialize hio context. rc: %d\n", test_rank, rc);
+  }
+
+  return rc;
+}
+
+int test_init (int *argc, char ***argv, const char *name, hio_context_t *context) {
+#if HIO_MPI_HAVE(1)
+  MPI_Init (argc, argv);
+  MPI_Comm_rank (MPI_COMM_WORLD, &test_rank);
+  MPI_Comm_size (MPI_COMM_WORLD, &test_size);
+#endif
+
+  return test_context_init (name, (*argc > 1) ? (*argv)[1] : NULL, context);
+}
+
+int test_fini (hio_context_t *context, const char *name, int errors) {
+  if (context) {
+    hio_fini (context);
+  }
+
+#if HIO_MPI_HAVE(1)
+  MPI_Allreduce (MPI_IN_PLACE, &errors, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+  MPI_Finalize ();
+#endif
+
+  if (0 == test_rank) {
+    printf ("%s: %d errors\n", name, errors);
+  }
+
+  return errors ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+int test_skip (hio_context_t *context, const char *name, const char *reason) {
+  if (0 == test_rank) {
+    printf ("%s: skipped. %s\n", name, reason);
+  }
+
+  if (context) {
+    hio_fini (context);
+  }
+
+#if HIO_MPI_HAVE(1)
+  MPI_Finalize ();
+#endif
+
+  return TEST_SKIPPED;
+}
+
+void test_barrier (void) {
+#if HIO_MPI_HAVE(1)
+  MPI_Barrier (MPI_COMM_WORLD);
+#endif
+}
+
+bool test_posix_root (hio_context_t context, char *path, size_t size) {
+  char *roots = NULL;
+  bool found = false;
+  int rc;
+
+  rc = hio_config_get_value (&context->c_object, "data_roots", &roots);
+  if (HIO_SUCCESS == rc && 0 == strncmp (roots, "posix:", 6) && NULL == strchr (roots, ',')) {
+    snprintf (path, size, "%s", roots + 6);
+    found = true;
+  }
+
+  free (roots);
+
+  return found;
+}
+
+static unsigned char test_rank_value (int rank, int64_t seed, size_t offset) {
+  return (unsigned char) (offset * 7 + offset / 251 + seed * 13 + rank * 17);
+}
+
+unsigned char test_value (int64_t seed, size_t offset) {
+  return test_rank_value (test_rank, seed, offset);
+}
+
+void test_fill (unsigned char *buffer, int64_t seed, size_t offset, size_t size) {
+  for (size_t i = 0 ; i < size ; ++i) {
+    buffer[i] = test_value (seed, offset + i);
+  }
+}
+
+bool test_check_rank (const unsigned char *buffer, int rank, int64_t seed, size_t offset, size_t size) {
+  for (size_t i = 0 ; i < size ; ++i) {
+    if (buffer[i] != test_rank_value (rank, seed, offset + i)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool test_check (const unsigned char *buffer, int64_t seed, size_t offset, size_t size) {
+  return test_check_rank (buffer, test_rank, seed, offset, size);
+}
+
+int test_dataset_open (hio_context_t context, hio_dataset_t *dataset, const char *name, int64_t id, int flags,
+                       hio_dataset_mode_t mode, ...) {
+  const char *variable;
+  va_list ap;
+  int rc;
+
+  rc = hio_dataset_alloc (context, dataset, name, id, flags, mode);
+  if (HIO_SUCCESS != rc) {
+    fprintf (stderr, "%d: could not allocate dataset %s:%ld. rc: %d\n", test_rank, name, (long) id, rc);
+    return rc;
+  }
+
+  va_start (ap, mode);
+  while (NULL != (variable = va_arg (ap, const char *))) {
+    (void) hio_config_set_value (&(*dataset)->ds_object, (char *) variable, va_arg (ap, const char *));
+  }
+  va_end (ap);
+
+  rc = hio_dataset_open (*dataset);
+  if (HIO_SUCCESS != rc) {
+    if (HIO_ERR_NOT_FOUND != rc) {
+      fprintf (stderr, "%d: could not open dataset %s:%ld. rc: %d\n", test_rank, name, (long) id, rc);
+      hio_err_print_all (context, stderr, "test_dataset_open");
+    }
+    hio_dataset_free (dataset);
+  }
+
+  return rc;
+}
+
+void test_dataset_close (hio_dataset_t *dataset) {
+  hio_dataset_close (*dataset);
+  hio_dataset_free (dataset);
+}
+
+int test_element_write (hio_dataset_t dataset, const char *name, int64_t seed, off_t offset, size_t size) {
+  hio_element_t element;
+  unsigned char *buffer;
+  int rc, errors = 0;
+
+  buffer = malloc (size);
+  if (NULL == buffer) {
+    return 1;
+  }
+
+  test_fill (buffer, seed, offset, size);
+
+  rc = hio_element_open (dataset, &element, name, HIO_FLAG_WRITE | HIO_FLAG_CREAT);
+  if (HIO_SUCCESS != rc) {
+    fprintf (stderr, "%d: could not open element %s for writing. rc: %d\n", test_rank, name, rc);
+    free (buffer);
+    return 1;
+  }
+
+  if ((ssize_t) size != hio_element_write (element, offset, 0, buffer, 1, size)) {
+    fprintf (stderr, "%d: error writing %lu bytes at offset %ld of element %s\n", test_rank,
+             (unsigned long) size, (long) offset, name);
+    ++errors;
+  }
+
+  hio_element_close (&element);
+  free (buffer);
+
+  return errors;
+}
+
+int test_element_check (hio_dataset_t dataset, const char *name, int64_t seed, off_t offset, size_t size) {
+  hio_element_t element;
+  unsigned char *buffer;
+  int rc, errors = 0;
+  ssize_t count;
+
+  buffer = calloc (1, size);
+  if (NULL == buffer) {
+    return 1;
+  }
+
+  rc = hio_element_open (dataset, &element, name, HIO_FLAG_READ);
+  if (HIO_SUCCESS != rc) {
+    fprintf (stderr, "%d: could not open element %s for reading. rc: %d\n", test_rank, name, rc);
+    free (buffer);
+    return 1;
+  }
+
+  count = hio_element_read (element, offset, 0, buffer, 1, size);
+  if ((ssize_t) size != count) {
+    fprintf (stderr, "%d: reading %lu bytes at offset %ld of element %s returned %ld\n", test_rank,
+             (unsigned long) size, (long) offset, name, (long) count);
+    ++errors;
+  } else if (!test_check (buffer, seed, offset, size)) {
+    fprintf (stderr, "%d: data mismatch in %lu bytes at offset %ld of element %s\n", test_rank,
+             (unsigned long) size, (long) offset, name);
+    ++errors;
+  }
+
+  hio_element_close (&element);
+  free (buffer);
+
+  return errors;
+}
+
+char *test_config_value (hio_object_t object, const char *name) {
+  char *value = NULL;
+
+  if (HIO_SUCCESS != hio_config_get_value (object, (char *) name, &value)) {
+    return NULL;
+  }
+
+  return value;
+}
+
+uint64_t test_perf_value (hio_object_t object, const char *name) {
+  uint64_t value = 0;
+
+  (void) hio_perf_get_value (object, (char *) name, &value, sizeof (value));
+
+  return value;
+}
@@ -0,0 +1,156 @@
+/* -*- Mode: C; c-basic-offset:2 ; indent-tabs-mode:nil -*- */
+/*
+ * Copyright (c) 2017      Los Alamos National Security, LLC.  All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/**
+ * @file test_support.h
+ * @brief Common code for the C tests
+ *
+ * Each test is run by a run script as <test>.x <config file> [args]. The config file
+ * sets the data roots. Tests report "<test>: N errors" from rank 0 and exit with 0 on
+ * success, 1 on failure, and 77 if they were skipped.
+ */
+
+#if !defined(TEST_SUPPORT_H)
+#define TEST_SUPPORT_H
+
+#include "hio_internal.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** exit code of a skipped test */
+#define TEST_SKIPPED 77
+
+/** rank of this process in MPI_COMM_WORLD (0 without MPI) */
+extern int test_rank;
+
+/** size of MPI_COMM_WORLD (1 without MPI) */
+extern int test_size;
+
+/**
+ * @brief Initialize MPI and an hio context for a test
+ *
+ * @param[in,out] argc     argument count from main
+ * @param[in,out] argv     arguments from main. argv[1] is the config file
+ * @param[in]     name     test name (used as the context name)
+ * @param[out]    context  new hio context
+ *
+ * Sets test_rank and test_size.
+ */
+int test_init (int *argc, char ***argv, const char *name, hio_context_t *context);
+
+/**
+ * @brief Create another hio context for a test
+ *
+ * Used by tests that need to start over with a new context after test_init().
+ */
+int test_context_init (const char *name, const char *config_file, hio_context_t *context);
+
+/**
+ * @brief Finish a test
+ *
+ * @param[in,out] context  hio context (finalized if not NULL)
+ * @param[in]     name     test name
+ * @param[in]     errors   number of errors on this rank
+ *
+ * Sums the errors over all ranks, prints the result on rank 0, and finalizes MPI.
+ *
+ * @returns the exit code for the test
+ */
+int test_fini (hio_context_t *context, const char *name, int errors);
+
+/**
+ * @brief Skip a test
+ *
+ * Prints the reason on rank 0, finalizes the context and MPI.
+ *
+ * @returns TEST_SKIPPED
+ */
+int test_skip (hio_context_t *context, const char *name, const char *reason);
+
+/** barrier on MPI_COMM_WORLD (no-op without MPI) */
+void test_barrier (void);
+
+/**
+ * @brief Get the path of the only data root of a context
+ *
+ * @returns true if the data roots are a single posix directory. tests that look at the
+ * files hio writes are skipped otherwise
+ */
+bool test_posix_root (hio_context_t context, char *path, size_t size);
+
+/**
+ * @brief Test data
+ *
+ * @param[in] seed    distinguishes the data written to different elements or datasets
+ * @param[in] offset  offset of the byte in the element
+ *
+ * The value also depends on the rank so misplaced data from another rank is detected.
+ */
+unsigned char test_value (int64_t seed, size_t offset);
+
+/** fill a buffer with the test data for an element range */
+void test_fill (unsigned char *buffer, int64_t seed, size_t offset, size_t size);
+
+/**
+ * @brief Check a buffer against the test data for an element range
+ *
+ * @returns true if the buffer holds the expected data
+ */
+bool test_check (const unsigned char *buffer, int64_t seed, size_t offset, size_t size);
+
+/** check a buffer against the test data written by another rank */
+bool test_check_rank (const unsigned char *buffer, int rank, int64_t seed, size_t offset, size_t size);
+
+/**
+ * @brief Allocate and open a dataset
+ *
+ * @param[in]  context  hio context
+ * @param[out] dataset  open dataset
+ * @param[in]  name     dataset name
+ * @param[in]  id       dataset id
+ * @param[in]  flags    open flags
+ * @param[in]  mode     dataset mode
+ * @param[in]  ...      dataset config variable names and values terminated by NULL
+ *
+ * Prints the error stack if the dataset can not be opened.
+ */
+int test_dataset_open (hio_context_t context, hio_dataset_t *dataset, const char *name, int64_t id, int flags,
+                       hio_dataset_mode_t mode, ...);
+
+/** close and free a dataset */
+void test_dataset_close (hio_dataset_t *dataset);
+
+/**
+ * @brief Write test data to an element
+ *
+ * Writes size bytes at offset with a single hio_element_write().
+ *
+ * @returns the number of errors
+ */
+int test_element_write (hio_dataset_t dataset, const char *name, int64_t seed, off_t offset, size_t size);
+
+/**
+ * @brief Read test data from an element and check it
+ *
+ * @returns the number of errors
+ */
+int test_element_check (hio_dataset_t dataset, const char *name, int64_t seed, off_t offset, size_t size);
+
+/** get the value of a config variable as a string. the caller frees the result. returns NULL if
+ * the variable does not exist */
+char *test_config_value (hio_object_t object, const char *name);
+
+/** get the value of an integer performance variable (0 if it does not exist) */
+uint64_t test_perf_value (hio_object_t object, const char *name);
+
+#endif /* TEST_SUPPORT_H */
@@ -0,0 +1,247 @@
+/* -*- Mode: C; c-basic-offset:2 ; indent-tabs-mode:nil -*- */
+/*
+ * Copyright (c) 2017      Los Alamos National Security, LLC.  All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/* Trace decode test. Writes a dataset with enable_tracing set and decodes each rank's
+ * binary trace file to text and Chrome trace events, checking that the element writes
+ * in the trace account for all of the data written. Rank 0 copies its trace file to
+ * the file named by the second argument (if given) so the run script can decode it
+ * with hio_dump --trace. Requires a single posix data root. */
+
+#include "test_support.h"
+
+#include <inttypes.h>
+
+#define TEST_BLOCK_COUNT 8
+#define TEST_BLOCK_SIZE  4096
+
+static int write_dataset (hio_context_t context) {
+  hio_dataset_t dataset;
+  int rc, errors = 0;
+
+  rc = test_dataset_open (context, &dataset, "trace", 1, HIO_FLAG_CREAT | HIO_FLAG_WRITE | HIO_FLAG_TRUNC,
+                          HIO_SET_ELEMENT_UNIQUE, NULL);
+  if (HIO_SUCCESS != rc) {
+    return 1;
+  }
+
+  for (int i = 0 ; i < TEST_BLOCK_COUNT ; ++i) {
+    errors += test_element_write (dataset, "element", 0, (off_t) i * TEST_BLOCK_SIZE, TEST_BLOCK_SIZE);
+  }
+
+  test_dataset_close (&dataset);
+
+  return errors;
+}
+
+/* decode a trace file to text. each line is rank:thread:name::id:event:value:value2:start:stop:duration */
+static int check_text (const char *path) {
+  char line[1024], event[64], name[64];
+  uint64_t value, value2, start, stop;
+  int line_rank, lines = 0, errors = 0;
+  uint64_t written = 0;
+  unsigned int thread;
+  int64_t id;
+  FILE *fh;
+
+  fh = tmpfile ();
+  if (NULL == fh) {
+    return 1;
+  }
+
+  if (HIO_SUCCESS != hio_trace_dump (&path, 1, false, fh)) {
+    fprintf (stderr, "%d: could not decode trace file %s\n", test_rank, path);
+    fclose (fh);
+    return 1;
+  }
+
+  rewind (fh);
+  while (NULL != fgets (line, sizeof (line), fh)) {
+    if (9 != sscanf (line, "%d:%u:%63[^:]::%" SCNd64 ":%63[^:]:%" SCNu64 ":%" SCNu64 ":%" SCNu64 ":%" SCNu64,
+                     &line_rank, &thread, name, &id, event, &value, &value2, &start, &stop)) {
+      fprintf (stderr, "%d: malformed trace line: %s", test_rank, line);
+      ++errors;
+      continue;
+    }
+
+    if (line_rank != test_rank || strcmp (name, "trace") || 1 != id || stop < start) {
+      fprintf (stderr, "%d: unexpected trace line: %s", test_rank, line);
+      ++errors;
+    }
+
+    if (0 == lines++ && strcmp (event, "trace_begin")) {
+      fprintf (stderr, "%d: trace does not start with trace_begin: %s", test_rank, line);
+      ++errors;
+    }
+
+    /* buffered writes may be traced as fewer, larger element writes */
+    if (0 == strcmp (event, "element_write")) {
+      if (value + value2 > TEST_BLOCK_COUNT * TEST_BLOCK_SIZE) {
+        fprintf (stderr, "%d: unexpected element write: %s", test_rank, line);
+        ++errors;
+      }
+      written += value2;
+    }
+  }
+
+  if (lines && strcmp (event, "trace_end")) {
+    fprintf (stderr, "%d: trace does not end with trace_end: %s", test_rank, line);
+    ++errors;
+  }
+
+  if (TEST_BLOCK_COUNT * TEST_BLOCK_SIZE != written) {
+    fprintf (stderr, "%d: trace shows %" PRIu64 " bytes written by element writes\n", test_rank, written);
+    ++errors;
+  }
+
+  fclose (fh);
+
+  return errors;
+}
+
+/* decode a trace file to Chrome trace events */
+static int check_chrome (const char *path) {
+  const char *header = "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n";
+  char line[1024];
+  int events = 0, writes = 0, errors = 0;
+  FILE *fh;
+
+  fh = tmpfile ();
+  if (NULL == fh) {
+    return 1;
+  }
+
+  if (HIO_SUCCESS != hio_trace_dump (&path, 1, true, fh)) {
+    fprintf (stderr, "%d: could not convert trace file %s\n", test_rank, path);
+    fclose (fh);
+    return 1;
+  }
+
+  rewind (fh);
+  if (NULL == fgets (line, sizeof (line), fh) || strcmp (line, header)) {
+    fprintf (stderr, "%d: unexpected start of chrome trace\n", test_rank);
+    ++errors;
+  }
+
+  while (NULL != fgets (line, sizeof (line), fh)) {
+    if (0 == strcmp (line, "]}\n")) {
+      break;
+    }
+
+    ++events;
+    if (strstr (line, "\"name\": \"element_write\", \"cat\": \"trace\", \"ph\": \"X\"")) {
+      ++writes;
+    }
+  }
+
+  if (0 != strcmp (line, "]}\n")) {
+    fprintf (stderr, "%d: chrome trace is not terminated\n", test_rank);
+    ++errors;
+  }
+
+  if (0 == writes || writes > events) {
+    fprintf (stderr, "%d: chrome trace has %d element writes in %d events\n", test_rank, writes, events);
+    ++errors;
+  }
+
+  fclose (fh);
+
+  return errors;
+}
+
+/* a file that is not a trace must be rejected */
+static int check_invalid (const char *path) {
+  FILE *fh;
+  int rc;
+
+  fh = tmpfile ();
+  if (NULL == fh) {
+    return 1;
+  }
+
+  rc = hio_trace_dump (&path, 1, false, fh);
+  fclose (fh);
+
+  if (HIO_SUCCESS == rc) {
+    fprintf (stderr, "%d: %s was decoded as a trace file\n", test_rank, path);
+    return 1;
+  }
+
+  return 0;
+}
+
+static int copy_file (const char *from, const char *to) {
+  char buffer[4096];
+  FILE *in, *out;
+  size_t count;
+  int rc = 0;
+
+  in = fopen (from, "r");
+  out = fopen (to, "w");
+  if (NULL == in || NULL == out) {
+    rc = 1;
+  }
+
+  while (0 == rc && 0 < (count = fread (buffer, 1, sizeof (buffer), in))) {
+    rc = count != fwrite (buffer, 1, count, out);
+  }
+
+  if (in) {
+    fclose (in);
+  }
+  if (out) {
+    fclose (out);
+  }
+
+  return rc;
+}
+
+int main (int argc, char *argv[]) {
+  char root[512], path[1024], dataset_path[600];
+  hio_context_t context;
+  int errors = 0;
+
+  if (HIO_SUCCESS != test_init (&argc, &argv, "trace_test", &context)) {
+    return EXIT_FAILURE;
+  }
+
+  /* the trace files are written under the dataset directory */
+  if (!test_posix_root (context, root, sizeof (root))) {
+    return test_skip (&context, "trace_test", "requires a single posix data root");
+  }
+
+  snprintf (dataset_path, sizeof (dataset_path), "%s/trace_test.hio/trace/1", root);
+
+  hio_config_set_value (&context->c_object, "enable_tracing", "true");
+
+  errors += write_dataset (context);
+
+  snprintf (path, sizeof (path), "%s/trace/posix/trace.%d.bin", dataset_path, test_rank);
+  errors += check_text (path);
+  errors += check_chrome (path);
+
+  if (0 == test_rank && argc > 2 && copy_file (path, argv[2])) {
+    fprintf (stderr, "%d: could not copy %s to %s\n", test_rank, path, argv[2]);
+    ++errors;
+  }
+
+  snprintf (path, sizeof (path), "%s/manifest.json", dataset_path);
+  if (0 == test_rank) {
+    errors += check_invalid (path);
+  }
+
+  test_barrier ();
+
+  if (0 == test_rank) {
+    hio_dataset_unlink (context, "trace", 1, HIO_UNLINK_MODE_FIRST);
+  }
+
+  return test_fini (&context, "trace_test", errors);
+}
@@ -0,0 +1,226 @@
+/* -*- Mode: C; c-basic-offset:2 ; indent-tabs-mode:nil -*- */
+/*
+ * Copyright (c) 2017      Los Alamos National Security, LLC.  All rights
+ *                         reserved.
+ * $COPYRIGHT$
+ *
+ * Additional copyrights may follow
+ *
+ * $HEADER$
+ */
+
+/* Dataset unlink test. Writes several dataset ids then removes them in the background
+ * and checks that they disappear from view immediately and from the filesystem once
+ * hio_dataset_unlink_wait() returns. Also removes dataset ids collectively using all
+ * ranks. */
+
+#include "test_support.h"
+
+#include <unistd.h>
+#include <dirent.h>
+
+#define TEST_ELEMENT_COUNT 16
+#define TEST_ELEMENT_SIZE  4096
+
+/* context directory on the data root. empty if the data root is not a single posix directory */
+static char context_path[512];
+
+static int write_dataset (hio_context_t context, int64_t id) {
+  hio_dataset_t dataset;
+  char name[32];
+  int rc, errors = 0;
+
+  rc = test_dataset_open (context, &dataset, "unlink", id, HIO_FLAG_CREAT | HIO_FLAG_WRITE | HIO_FLAG_TRUNC,
+                          HIO_SET_ELEMENT_UNIQUE, NULL);
+  if (HIO_SUCCESS != rc) {
+    return rc;
+  }
+
+  for (int i = 0 ; i < TEST_ELEMENT_COUNT ; ++i) {
+    snprintf (name, sizeof (name), "element%d", i);
+    errors += test_element_write (dataset, name, id, 0, TEST_ELEMENT_SIZE);
+  }
+
+  test_dataset_close (&dataset);
+
+  return errors ? HIO_ERROR : HIO_SUCCESS;
+}
+
+/* check that a dataset id can (or can not) be opened for reading */
+static int check_visible (hio_context_t context, int64_t id, bool expected) {
+  hio_dataset_t dataset;
+  int rc;
+
+  rc = test_dataset_open (context, &dataset, "unlink", id, HIO_FLAG_READ, HIO_SET_ELEMENT_UNIQUE, NULL);
+  if (HIO_SUCCESS == rc) {
+    test_dataset_close (&dataset);
+  }
+
+  if (expected != (HIO_SUCCESS == rc)) {
+    fprintf (stderr, "%d: dataset id %ld is %svisible after unlink. rc: %d\n", test_rank, (long) id,
+             expected ? "not " : "", rc);
+    return HIO_ERROR;
+  }
+
+  return HIO_SUCCESS;
+}
+
+/* check what is left of a dataset id on the filesystem. the trash entries that hold
+ * trees being removed start with .trash. */
+static int check_removed (int64_t id, bool allow_trash) {
+  char path[1024];
+  struct dirent *entry;
+  int rc = HIO_SUCCESS;
+  DIR *dir;
+
+  if ('\0' == context_path[0] || 0 != test_rank) {
+    return HIO_SUCCESS;
+  }
+
+  snprintf (path, sizeof (path), "%s/unlink/%ld", context_path, (long) id);
+  if (0 == access (path, F_OK)) {
+    fprintf (stderr, "%d: %s still exists after unlink\n", test_rank, path);
+    rc = HIO_ERROR;
+  }
+
+  snprintf (path, sizeof (path), "%s/unlink", context_path);
+  dir = opendir (path);
+  if (NULL == dir) {
+    return rc;
+  }
+
+  while (!allow_trash && NULL != (entry = readdir (dir))) {
+    if (0 == strncmp (entry->d_name, ".trash.", 7)) {
+      fprintf (stderr, "%d: trash entry %s/%s was not removed\n", test_rank, path, entry->d_name);
+      rc = HIO_ERROR;
+    }
+  }
+
+  closedir (dir);
+
+  return rc;
+}
+
+static int test_async (hio_context_t context) {
+  int rc, pending, errors = 0;
+
+  errors += HIO_SUCCESS != write_dataset (context, 1);
+  errors += HIO_SUCCESS != write_dataset (context, 2);
+  test_barrier ();
+
+  if (0 == test_rank) {
+    rc = hio_dataset_unlink (context, "unlink", 1, HIO_UNLINK_MODE_FIRST | HIO_UNLINK_MODE_ASYNC);
+    if (HIO_SUCCESS != rc) {
+      fprintf (stderr, "%d: asynchronous unlink failed. rc: %d\n", test_rank, rc);
+      ++errors;
+    }
+
+    /* the dataset must be out of view as soon as the call returns */
+    errors += HIO_SUCCESS != check_removed (1, true);
+
+    rc = hio_dataset_unlink_pending (context, &pending);
+    if (HIO_SUCCESS != rc || 0 > pending || 1 < pending) {
+      fprintf (stderr, "%d: unexpected pending unlink count %d. rc: %d\n", test_rank, pending, rc);
+      ++errors;
+    }
+
+    rc = hio_dataset_unlink_wait (context);
+    if (HIO_SUCCESS != rc) {
+      fprintf (stderr, "%d: waiting for asynchronous unlink failed. rc: %d\n", test_rank, rc);
+      ++errors;
+    }
+
+    rc = hio_dataset_unlink_pending (context, &pending);
+    if (HIO_SUCCESS != rc || 0 != pending) {
+      fprintf (stderr, "%d: %d unlinks still pending after wait. rc: %d\n", test_rank, pending, rc);
+      ++errors;
+    }
+
+    errors += HIO_SUCCESS != check_removed (1, false);
+
+    /* a removed dataset can not be removed again */
+    if (HIO_ERR_NOT_FOUND != hio_dataset_unlink (context, "unlink", 1, HIO_UNLINK_MODE_FIRST |
+                                                 HIO_UNLINK_MODE_ASYNC)) {
+      fprintf (stderr, "%d: unlinking a removed dataset did not return HIO_ERR_NOT_FOUND\n", test_rank);
+      ++errors;
+    }
+  } else if (HIO_SUCCESS == hio_dataset_unlink (context, "unlink", 1, HIO_UNLINK_MODE_FIRST |
+                                                HIO_UNLINK_MODE_ASYNC)) {
+    fprintf (stderr, "%d: non-collective unlink succeeded on a test_rank other than 0\n", test_rank);
+    ++errors;
+  }
+
+  test_barrier ();
+
+  errors += HIO_SUCCESS != check_visible (context, 1, false);
+  errors += HIO_SUCCESS != check_visible (context, 2, true);
+
+  /* the async and collective modifiers can not be combined */
+  if (HIO_ERR_BAD_PARAM != hio_dataset_unlink (context, "unlink", 2, HIO_UNLINK_MODE_FIRST | HIO_UNLINK_MODE_ASYNC |
+                                               HIO_UNLINK_MODE_COLLECTIVE)) {
+    fprintf (stderr, "%d: invalid unlink mode was accepted\n", test_rank);
+    ++errors;
+  }
+
+  if (0 == test_rank) {
+    hio_dataset_unlink (context, "unlink", 2, HIO_UNLINK_MODE_FIRST);
+  }
+  test_barrier ();
+
+  return errors;
+}
+
+static int test_collective (hio_context_t context) {
+  int rc, errors = 0;
+
+  errors += HIO_SUCCESS != write_dataset (context, 3);
+  errors += HIO_SUCCESS != write_dataset (context, 4);
+  test_barrier ();
+
+  rc = hio_dataset_unlink (context, "unlink", 3, HIO_UNLINK_MODE_FIRST | HIO_UNLINK_MODE_COLLECTIVE);
+  if (HIO_SUCCESS != rc) {
+    fprintf (stderr, "%d: collective unlink failed. rc: %d\n", test_rank, rc);
+    ++errors;
+  }
+
+  /* all files have been removed by the time the collective call returns */
+  errors += HIO_SUCCESS != check_removed (3, false);
+  errors += HIO_SUCCESS != check_visible (context, 3, false);
+  errors += HIO_SUCCESS != check_visible (context, 4, true);
+
+  /* every test_rank must see the same error for a dataset that does not exist */
+  rc = hio_dataset_unlink (context, "unlink", 3, HIO_UNLINK_MODE_FIRST | HIO_UNLINK_MODE_COLLECTIVE);
+  if (HIO_ERR_NOT_FOUND != rc) {
+    fprintf (stderr, "%d: collective unlink of a removed dataset returned %d\n", test_rank, rc);
+    ++errors;
+  }
+
+  rc = hio_dataset_unlink (context, "unlink", 4, HIO_UNLINK_MODE_ALL | HIO_UNLINK_MODE_COLLECTIVE);
+  if (HIO_SUCCESS != rc) {
+    fprintf (stderr, "%d: collective unlink of all instances failed. rc: %d\n", test_rank, rc);
+    ++errors;
+  }
+
+  errors += HIO_SUCCESS != check_removed (4, false);
+
+  return errors;
+}
+
+int main (int argc, char *argv[]) {
+  hio_context_t context;
+  char root[512];
+  int errors = 0;
+
+  if (HIO_SUCCESS != test_init (&argc, &argv, "unlink_test", &context)) {
+    return EXIT_FAILURE;
+  }
+
+  if (test_posix_root (context, root, sizeof (root))) {
+    snprintf (context_path, sizeof (context_path), "%s/unlink_test.hio", root);
+  }
+
+  errors += test_async (context);
+  errors += test_collective (context);
+
+  return test_fini (&context, "unlink_test", errors);
+}
@@ -33,6 +33,11 @@
 #ifdef HIO
 #include "hio.h"
 #include "hio_config.h"
+#if HIO_USE_DATAWARP && HIO_DATAWARP_EMULATE
+  // The DataWarp emulation only provides the staging calls used inside libhio
+  #undef HIO_USE_DATAWARP
+  #define HIO_USE_DATAWARP 0
+#endif // HIO_DATAWARP_EMULATE
 #if HIO_USE_DATAWARP
 #include <datawarp.h>
 #ifndef DW_PH_2
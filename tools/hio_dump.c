@@ -19,7 +19,8 @@
 
 static void print_usage (void) {
   printf ("Usage: hio_dump [options] <data root> <context name> [dataset name [dataset id]]\n");
-  printf ("Dump metadata associated with libhio dataset(s).\n");
+  printf ("       hio_dump --trace [--chrome] <trace file> [trace file ...]\n");
+  printf ("Dump metadata associated with libhio dataset(s) or convert libhio trace files.\n");
 
   exit (EXIT_FAILURE);
 }
@@ -42,19 +43,23 @@ int main (int argc, char *argv[]) {
   int opt, opt_index, list_rank = -1;
   int64_t dataset_id = -1;
   uint32_t flags = 0;
+  bool trace = false, chrome = false;
 
   struct option long_options[] = {
     {.name = "all", .has_arg = no_argument, .flag = NULL, .val = 'a'},
+    {.name = "chrome", .has_arg = no_argument, .flag = NULL, .val = 'C'},
     {.name = "config", .has_arg = no_argument, .flag = NULL, .val = 'c'},
     {.name = "elements", .has_arg = no_argument, .flag = NULL, .val = 'e'},
     {.name = "help", .has_arg = no_argument, .flag = NULL, .val = 'h'},
     {.name = "perform", .has_arg = no_argument, .flag = NULL, .val = 'p'},
     {.name = "rank", .has_arg = required_argument, .flag = NULL, .val = 'r'},
+    {.name = "trace", .has_arg = no_argument, .flag = NULL, .val = 't'},
     {.name = "version", .has_arg = no_argument, .flag = NULL, .val = 'v'},
+    {.name = NULL},
   };
 
   do {
-    opt = getopt_long (argc, argv, "aer:hvcp", long_options, &opt_index);
+    opt = getopt_long (argc, argv, "aer:hvcptC", long_options, &opt_index);
     if (-1 == opt) {
       break;
     }
@@ -66,6 +71,9 @@ int main (int argc, char *argv[]) {
     case 'c':
       flags |= HIO_DUMP_FLAG_CONFIG;
       break;
+    case 'C':
+      chrome = true;
+      break;
     case 'e':
       flags |= HIO_DUMP_FLAG_ELEMENTS;
       break;
@@ -78,6 +86,9 @@ int main (int argc, char *argv[]) {
     case 'r':
       list_rank = strtol (optarg, NULL, 0);
       break;
+    case 't':
+      trace = true;
+      break;
     case 'v':
       print_version ();
       break;
@@ -87,6 +98,15 @@ int main (int argc, char *argv[]) {
     }
   } while (1);
 
+  if (trace) {
+    if (argc == optind) {
+      print_usage ();
+    }
+
+    return HIO_SUCCESS == hio_trace_dump ((const char **) argv + optind, argc - optind, chrome, stdout) ?
+      EXIT_SUCCESS : EXIT_FAILURE;
+  }
+
   if (argc - optind < 2) {
     print_usage ();
   }